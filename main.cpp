@@ -1,26 +1,276 @@
-#include <iostream>
+#include <cstdio>
 #include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <boost/optional.hpp>
 #include "src/main/logging/logger.hpp"
+#include "src/main/util/mmap-input-stream.hpp"
 #include "src/main/util/stdin-output-stream.hpp"
 #include "src/main/lexer/lexer.hpp"
+#include "src/main/lexer/pipelined-lexer.hpp"
+#include "src/main/lexer/simd-lexer.hpp"
+#include "src/main/parser/binary-script.hpp"
+#include "src/main/parser/compact-parser.hpp"
+#include "src/main/parser/constant-folder.hpp"
+#include "src/main/parser/parallel-parser.hpp"
 #include "src/main/parser/parser.hpp"
 #include "src/main/interpreter/interpreter.hpp"
 
-int main() {
-    std::ifstream in("/home/agata/CLionProjects/TKOM/src/test.lang");
-    std::cin.rdbuf(in.rdbuf());
+namespace {
+    struct Options {
+        std::string lexer = "flex";
+        std::string engine = "tree";
+        bool pipeline = false;
+        bool lazy = false;
+        unsigned jobs = 1;
+        const char *scriptPath = nullptr;
+        const char *compilePath = nullptr;
+        const char *cachePath = nullptr;
+        const char *emitCppPath = nullptr;
+        const char *nativePath = nullptr;
+    };
 
-    try {
+    std::unique_ptr<lang::parser::ScriptNode> parseScript(lang::lexer::Lexer &lexer, const Options &options) {
         lang::logging::Logger logger;
-        lang::util::StdinOutputStream inputFile;
-        lang::lexer::Lexer lexer(inputFile);
+        if (options.lazy) {
+            lang::parser::Parser parser(logger, lexer);
+            return parser.preParse();
+        }
+        if (options.jobs != 1) {
+            lang::parser::ParallelParser parser(
+                    logger, lexer.getSource(), lexer.getSymbols(), options.jobs,
+                    [&options](lang::parser::SourceChunk chunk, std::shared_ptr<lang::lexer::SymbolTable> symbols) {
+                        if (options.lexer == "simd")
+                            return std::unique_ptr<lang::lexer::Lexer>(
+                                    new lang::lexer::SimdLexer(chunk.text, chunk.firstLine, move(symbols)));
+                        return std::unique_ptr<lang::lexer::Lexer>(
+                                new lang::lexer::Lexer(chunk.text, chunk.firstLine, move(symbols)));
+                    });
+            return parser.getTree();
+        }
+        if (options.pipeline) {
+            lang::lexer::PipelinedLexer lexemes(lexer);
+            lang::parser::Parser parser(logger, lexemes, lexemes.getSymbols());
+            return parser.getTree();
+        }
         lang::parser::Parser parser(logger, lexer);
-        auto script = parser.getTree();
-        lang::interpreter::Interpreter interpreter(*script);
-        interpreter.execute("main");
-    } catch (std::exception e) {
+        return parser.getTree();
+    }
+
+
+    /**
+     * Parses the script and folds its constant expressions.
+     */
+    std::unique_ptr<lang::parser::ScriptNode> parse(lang::lexer::Lexer &lexer, const Options &options) {
+        auto script = parseScript(lexer, options);
+        lang::parser::foldConstants(*script);
+        return script;
+    }
+
+    /**
+     * Parses the script straight into the pools of a binary script.
+     */
+    lang::parser::CompactTree parseCompact(lang::lexer::Lexer &lexer, const Options &options) {
+        lang::logging::Logger logger;
+        if (options.pipeline) {
+            lang::lexer::PipelinedLexer lexemes(lexer);
+            lang::parser::CompactParser parser(logger, lexemes, lexemes.getSymbols());
+            return parser.getTree();
+        }
+        lang::parser::CompactParser parser(logger, lexer);
+        return parser.getTree();
+    }
+
+    /**
+     * Recreates the node graph of the compact tree and folds its constant expressions.
+     */
+    std::unique_ptr<lang::parser::ScriptNode> expand(const lang::parser::CompactTree &tree) {
+        auto script = tree.expand();
+        lang::parser::foldConstants(*script);
+        return script;
+    }
+
+    template<typename Input>
+    std::unique_ptr<lang::lexer::Lexer> makeLexer(const Options &options, Input &input) {
+        if (options.lexer == "simd")
+            return std::unique_ptr<lang::lexer::Lexer>(new lang::lexer::SimdLexer(input));
+        return std::unique_ptr<lang::lexer::Lexer>(new lang::lexer::Lexer(input));
+    }
+
+    /**
+     * @param sourceHash Hash the binary script has to be compiled from, none to take it as it is.
+     * @return Tree of the binary script, or null if it was compiled from other source.
+     */
+    std::unique_ptr<lang::parser::ScriptNode> loadBinary(
+            const std::string &path,
+            boost::optional<std::uint64_t> sourceHash
+    ) {
+        lang::util::MmapInputStream file(path);
+        const boost::string_view data(file.data(), file.size());
+        if (sourceHash && lang::parser::readSourceHash(data) != *sourceHash)
+            return nullptr;
+        return expand(lang::parser::readBinaryScript(data));
+    }
+
+    /**
+     * Binary script is written next to its destination first, so a reader never maps half written file.
+     */
+    void writeBinary(const std::string &path, const lang::parser::CompactTree &tree, std::uint64_t sourceHash) {
+        const std::string temporaryPath = path + ".tmp";
+        {
+            std::ofstream output(temporaryPath, std::ios::binary);
+            lang::parser::writeBinaryScript(output, tree, sourceHash);
+            if (!output)
+                throw lang::util::IoException("cannot write " + temporaryPath);
+        }
+        if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+            throw lang::util::IoException("cannot replace " + path);
+    }
+
+    std::unique_ptr<lang::parser::ScriptNode> loadScript(const Options &options) {
+        if (!options.scriptPath) {
+            if (options.compilePath)
+                throw std::invalid_argument("--compile needs a script file");
+            if (options.cachePath)
+                return loadBinary(options.cachePath, boost::none);
+            lang::util::StdinOutputStream inputFile;
+            return parse(*makeLexer(options, inputFile), options);
+        }
+
+        lang::util::MmapInputStream inputFile(options.scriptPath);
+        if (!options.compilePath && !options.cachePath)
+            return parse(*makeLexer(options, inputFile), options);
+
+        const auto sourceHash = lang::parser::hashSource(boost::string_view(inputFile.data(), inputFile.size()));
+        if (options.cachePath && !options.compilePath) {
+            try {
+                if (auto script = loadBinary(options.cachePath, sourceHash))
+                    return script;
+            } catch (const lang::util::IoException &) {
+                // No cache yet.
+            } catch (const lang::parser::BinaryScriptException &) {
+                // Cache of other version or damaged, it is rebuilt below.
+            }
+        }
+
+        const auto tree = parseCompact(*makeLexer(options, inputFile), options);
+        if (options.compilePath) {
+            writeBinary(options.compilePath, tree, sourceHash);
+            return nullptr;
+        }
+        writeBinary(options.cachePath, tree, sourceHash);
+        return expand(tree);
+    }
+
+    /**
+     * Unlike std::stoul, takes neither sign nor spaces and names the option when it fails.
+     */
+    unsigned parseJobs(const std::string &value) {
+        if (value.empty())
+            throw std::invalid_argument("--jobs needs a number of threads");
+        unsigned long long jobs = 0;
+        for (char c : value) {
+            if (c < '0' || c > '9')
+                throw std::invalid_argument("--jobs needs a number of threads, got " + value);
+            jobs = jobs * 10 + (c - '0');
+            if (jobs > std::numeric_limits<unsigned>::max())
+                throw std::invalid_argument("--jobs is out of range: " + value);
+        }
+        return static_cast<unsigned>(jobs);
+    }
+
+    /**
+     * @throws std::invalid_argument for unknown option or invalid value of an option.
+     */
+    Options parseOptions(int argc, char **argv) {
+        const std::string lexerOption = "--lexer=";
+        const std::string jobsOption = "--jobs=";
+        const std::string compileOption = "--compile=";
+        const std::string cacheOption = "--cache=";
+        const std::string engineOption = "--engine=";
+        const std::string emitCppOption = "--emit-cpp=";
+        const std::string nativeOption = "--native=";
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string argument = argv[i];
+            if (argument.compare(0, lexerOption.size(), lexerOption) == 0)
+                options.lexer = argument.substr(lexerOption.size());
+            else if (argument.compare(0, jobsOption.size(), jobsOption) == 0)
+                options.jobs = parseJobs(argument.substr(jobsOption.size()));
+            else if (argument.compare(0, compileOption.size(), compileOption) == 0)
+                options.compilePath = argv[i] + compileOption.size();
+            else if (argument.compare(0, cacheOption.size(), cacheOption) == 0)
+                options.cachePath = argv[i] + cacheOption.size();
+            else if (argument.compare(0, engineOption.size(), engineOption) == 0)
+                options.engine = argument.substr(engineOption.size());
+            else if (argument.compare(0, emitCppOption.size(), emitCppOption) == 0)
+                options.emitCppPath = argv[i] + emitCppOption.size();
+            else if (argument.compare(0, nativeOption.size(), nativeOption) == 0)
+                options.nativePath = argv[i] + nativeOption.size();
+            else if (argument == "--pipeline")
+                options.pipeline = true;
+            else if (argument == "--lazy")
+                options.lazy = true;
+            else if (argument.compare(0, 2, "--") == 0)
+                throw std::invalid_argument("unknown option " + argument);
+            else
+                options.scriptPath = argv[i];
+        }
+        if (options.lexer != "flex" && options.lexer != "simd")
+            throw std::invalid_argument("--lexer has to be flex or simd, got " + options.lexer);
+        if (options.engine != "tree" && options.engine != "vm" && options.engine != "closure")
+            throw std::invalid_argument("--engine has to be tree, vm or closure, got " + options.engine);
+        return options;
+    }
+}
+
+/**
+ * Usage: runner [--lexer=flex|simd] [--pipeline | --jobs=N | --lazy] [--compile=binary | --cache=binary]
+ *               [--engine=tree|vm|closure] [--emit-cpp=file | --native=library] [script]
+ *
+ * Script file is mapped into memory and scanned in place; without it script is read from standard input.
+ * With --pipeline lexer runs on separate thread, overlapping with the parser.
+ * With --jobs top level functions are parsed on N threads, zero meaning all hardware threads.
+ * With --lazy only function signatures are parsed up front, each body is parsed when first called;
+ * binary scripts are always compiled from fully parsed script, on one thread.
+ * With --compile parsed script is only written as binary script. With --cache binary script is used
+ * instead of parsing as long as it was compiled from the same source, and rewritten otherwise;
+ * without script file the binary script is run as it is.
+ * With --engine=vm functions are compiled to bytecode on first call and run by the virtual machine
+ * instead of walking their trees. With --engine=closure they are compiled to closures bound to their operands.
+ * With --emit-cpp the script is only translated to C++ source of a native module, to be built as a shared object:
+ *     c++ -std=c++14 -O2 -shared -fPIC -Isrc/main file -o library
+ * With --native functions of such library replace interpreted ones; it has to be built from the same script.
+ * Unknown options and values other than the listed ones are rejected.
+ */
+int main(int argc, char **argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        auto script = loadScript(options);
+        if (!options.compilePath) {
+            auto engine = lang::interpreter::Engine::TREE;
+            if (options.engine == "vm")
+                engine = lang::interpreter::Engine::VM;
+            else if (options.engine == "closure")
+                engine = lang::interpreter::Engine::CLOSURE;
+            lang::interpreter::Interpreter interpreter(*script, engine);
+            if (options.emitCppPath) {
+                std::ofstream out(options.emitCppPath);
+                interpreter.emitCpp(out);
+                if (!out)
+                    throw std::runtime_error(std::string("cannot write ") + options.emitCppPath);
+                return 0;
+            }
+            if (options.nativePath)
+                interpreter.loadNative(options.nativePath);
+            interpreter.execute("main");
+        }
+    } catch (const std::exception &e) {
         std::cerr << "Error occurred: " << e.what() << std::endl;
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
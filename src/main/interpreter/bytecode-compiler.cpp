@@ -0,0 +1,431 @@
+#include "bytecode-compiler.hpp"
+#include <algorithm>
+#include <limits>
+#include "../parser/node-visitor.hpp"
+#include "evaluation-order.hpp"
+#include "exceptions.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            using parser::Binding;
+
+            class Compiler : public parser::NodeVisitor {
+                Chunk chunk;
+                std::uint32_t nextRegister;
+                std::uint32_t nextRef = 0;
+
+            public:
+                explicit Compiler(std::uint32_t frameSize)
+                        : nextRegister(frameSize) {
+                    chunk.registerCount = frameSize;
+                    checkRegister(frameSize);
+                }
+
+                Chunk finish() {
+                    emit(OpCode::RETURN);
+                    return std::move(chunk);
+                }
+
+                void visit(const parser::ScriptNode &node) override {
+                    unsupported("script");
+                }
+
+                void visit(const parser::FunctionDefNode &node) override {
+                    unsupported("function definition");
+                }
+
+                void visit(const parser::FunctionDefParamsNode &node) override {
+                    unsupported("function parameters");
+                }
+
+                void visit(const parser::HtmlTemplateNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeListNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::TextContentNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::InjectedValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::ReturnExpressionNode &node) override {
+                    node.returnValue->visit(*this);
+                }
+
+                void visit(const parser::BlockNode &node) override {
+                    node.value->visit(*this);
+                }
+
+                void visit(const parser::DeclarationExpressionNode &node) override {
+                    if (node.value) {
+                        node.value->visit(*this);
+                    } else {
+                        emit(OpCode::LOAD_UNDEFINED);
+                    }
+                    store(node.identifier->binding);
+                }
+
+                void visit(const parser::ForExpressionNode &node) override {
+                    if (!node.expression->variable)
+                        throw InterpreterFailure("for loop has no variable to update");
+
+                    node.iterator->visit(*this);
+                    const auto start = position();
+                    node.condition->visit(*this);
+                    const auto exit = emit(OpCode::JUMP_IF_FALSE);
+                    node.expression->visit(*this);
+                    node.block->visit(*this);
+                    emit(OpCode::JUMP, 0, start);
+                    patch(exit);
+                }
+
+                void visit(const parser::AssignExpressionNode &node) override {
+                    node.value->visit(*this);
+                    const auto &indices = node.variable->indices;
+                    if (indices.empty()) {
+                        store(node.variable->identifier->binding);
+                        return;
+                    }
+
+                    const auto value = allocateRegister();
+                    spill(value, indices.front()->value.get());
+                    // Indices are evaluated before looking up the target, which copies arrays shared meanwhile.
+                    const auto firstIndex = nextRegister;
+                    for (auto &index : indices) {
+                        index->value->visit(*this);
+                        emit(OpCode::STORE_REGISTER, allocateRegister());
+                    }
+                    const auto ref = allocateRef();
+                    const auto &binding = node.variable->identifier->binding;
+                    switch (binding.kind) {
+                        case Binding::Kind::LOCAL:
+                            emit(OpCode::REF_REGISTER, ref, binding.index);
+                            break;
+                        case Binding::Kind::GLOBAL:
+                            emit(OpCode::REF_GLOBAL, ref, binding.index);
+                            break;
+                        case Binding::Kind::UNRESOLVED:
+                            emit(OpCode::REF_UNRESOLVED, ref);
+                            break;
+                    }
+                    for (std::size_t i = 0; i < indices.size(); ++i) {
+                        emit(OpCode::LOAD_REGISTER, 0, firstIndex + i);
+                        emit(OpCode::REF_ELEMENT, ref);
+                    }
+                    emit(OpCode::STORE_REF, ref, value);
+                    --nextRef;
+                    nextRegister = value;
+                }
+
+                void visit(const parser::IfExpressionNode &node) override {
+                    node.condition->visit(*this);
+                    const auto otherwise = emit(OpCode::JUMP_IF_FALSE);
+                    node.ifBlock->visit(*this);
+                    if (!node.elseBlock) {
+                        patch(otherwise);
+                        return;
+                    }
+                    const auto end = emit(OpCode::JUMP);
+                    patch(otherwise);
+                    node.elseBlock->visit(*this);
+                    patch(end);
+                }
+
+                void visit(const parser::BinaryOperationNode &node) override {
+                    using parser::BinaryOperator;
+
+                    if (node.op == BinaryOperator::OR || node.op == BinaryOperator::AND) {
+                        node.left->visit(*this);
+                        const auto end = emit(node.op == BinaryOperator::OR ? OpCode::JUMP_IF_TRUE
+                                                                            : OpCode::JUMP_IF_FALSE);
+                        node.right->visit(*this);
+                        patch(end);
+                        return;
+                    }
+
+                    // Locals and literals are read in place, as long as the right operand neither changes them
+                    // nor reads the left value from the accumulator.
+                    std::uint32_t leftIndex = 0;
+                    std::uint32_t rightIndex = 0;
+                    if (isOperand(node.left.get()) && isOperand(node.right.get())) {
+                        const auto flags = operand(node.left.get(), leftIndex, OperandFlags::LEFT_CONSTANT)
+                                           | operand(node.right.get(), rightIndex, OperandFlags::RIGHT_CONSTANT)
+                                           | OperandFlags::RIGHT_OPERAND;
+                        emit(operationOf(node.op), flags, leftIndex, rightIndex);
+                        return;
+                    }
+                    if (isOperand(node.left.get()) && !mayAssign(node.right.get())
+                        && !readsPreviousResult(node.right.get())) {
+                        const auto flags = operand(node.left.get(), leftIndex, OperandFlags::LEFT_CONSTANT);
+                        node.right->visit(*this);
+                        emit(operationOf(node.op), flags, leftIndex);
+                        return;
+                    }
+
+                    node.left->visit(*this);
+                    if (isOperand(node.right.get())) {
+                        const auto flags = operand(node.right.get(), rightIndex, OperandFlags::RIGHT_CONSTANT);
+                        emit(operationOf(node.op), flags | OperandFlags::LEFT_ACCUMULATOR | OperandFlags::RIGHT_OPERAND,
+                             0, rightIndex);
+                        return;
+                    }
+                    const auto left = allocateRegister();
+                    spill(left, node.right.get());
+                    node.right->visit(*this);
+                    emit(operationOf(node.op), 0, left);
+                    --nextRegister;
+                }
+
+                void visit(const parser::UnaryOperationNode &node) override {
+                    node.operand->visit(*this);
+                    emit(node.op == parser::UnaryOperator::NEGATE ? OpCode::NEGATE : OpCode::NOT);
+                }
+
+                void visit(const parser::FunctionCallNode &node) override {
+                    const auto first = nextRegister;
+                    for (std::size_t i = 0; i < node.value.size(); ++i) {
+                        node.value[i]->visit(*this);
+                        const auto next = i + 1 < node.value.size() ? node.value[i + 1].get() : nullptr;
+                        spill(allocateRegister(), next);
+                    }
+                    const auto count = static_cast<std::uint32_t>(node.value.size());
+                    const auto &binding = node.identifier->binding;
+                    if (binding.kind == Binding::Kind::GLOBAL) {
+                        emit(OpCode::CALL_GLOBAL, count, first, binding.index);
+                    } else {
+                        load(binding);
+                        emit(OpCode::CALL, 0, first, count);
+                    }
+                    nextRegister = first;
+                }
+
+                void visit(const parser::ObjectFieldNode &node) override {
+                    // Value of the field name only matters to an expression reading it.
+                    if (readsPreviousResult(node.expression.get()))
+                        load(node.identifier->binding);
+                    node.expression->visit(*this);
+                }
+
+                void visit(const parser::ObjectLiteralNode &node) override {
+                    // Like Executor, calls the last value with values of the fields.
+                    const auto first = nextRegister;
+                    for (std::size_t i = 0; i < node.injection.size(); ++i) {
+                        node.injection[i]->visit(*this);
+                        // Fields start by looking up their names, only the last value is used again.
+                        const bool last = i + 1 == node.injection.size();
+                        emit(last ? OpCode::STORE_REGISTER : OpCode::MOVE_REGISTER, allocateRegister());
+                    }
+                    emit(OpCode::CALL, 0, first, static_cast<std::uint32_t>(node.injection.size()));
+                    nextRegister = first;
+                }
+
+                void visit(const parser::VariableNode &node) override {
+                    load(node.identifier->binding);
+                    if (node.indices.empty())
+                        return;
+
+                    const auto current = allocateRegister();
+                    spill(current, node.indices.front()->value.get());
+                    for (std::size_t i = 0; i < node.indices.size(); ++i) {
+                        node.indices[i]->value->visit(*this);
+                        emit(i + 1 < node.indices.size() ? OpCode::ELEMENT_INTO : OpCode::ELEMENT, 0, current);
+                    }
+                    --nextRegister;
+                }
+
+                void visit(const parser::IndexExpressionNode &node) override {
+                    node.value->visit(*this);
+                }
+
+                void visit(const parser::IdentifierNode &node) override {
+                    load(node.binding);
+                }
+
+                void visit(const parser::AnyTextNode &node) override {
+                    loadConstant(Variable(node.text));
+                }
+
+                void visit(const parser::StringLiteralNode &node) override {
+                    loadConstant(Variable(node.value));
+                }
+
+                void visit(const parser::NumberLiteralNode &node) override {
+                    double value[] = {node.value};
+                    loadConstant(Variable(value, 1));
+                }
+
+                void visit(const parser::BooleanLiteralNode &node) override {
+                    loadConstant(Variable(node.value));
+                }
+
+            private:
+                [[noreturn]] static void unsupported(const std::string &what) {
+                    throw InterpreterFailure(what + " cannot be executed");
+                }
+
+                static void checkRegister(std::uint32_t count) {
+                    if (count > std::numeric_limits<std::uint16_t>::max())
+                        throw InterpreterFailure("function needs too many registers");
+                }
+
+                static OpCode operationOf(parser::BinaryOperator op) {
+                    using parser::BinaryOperator;
+                    switch (op) {
+                        case BinaryOperator::EQUAL:
+                            return OpCode::EQUAL;
+                        case BinaryOperator::NOT_EQUAL:
+                            return OpCode::NOT_EQUAL;
+                        case BinaryOperator::LESS:
+                            return OpCode::LESS;
+                        case BinaryOperator::GREATER:
+                            return OpCode::GREATER;
+                        case BinaryOperator::LESS_EQUAL:
+                            return OpCode::LESS_EQUAL;
+                        case BinaryOperator::GREATER_EQUAL:
+                            return OpCode::GREATER_EQUAL;
+                        case BinaryOperator::ADD:
+                            return OpCode::ADD;
+                        case BinaryOperator::SUBTRACT:
+                            return OpCode::SUBTRACT;
+                        case BinaryOperator::MULTIPLY:
+                            return OpCode::MULTIPLY;
+                        case BinaryOperator::DIVIDE:
+                            return OpCode::DIVIDE;
+                        default:
+                            throw InterpreterFailure();
+                    }
+                }
+
+                std::uint32_t position() const {
+                    return static_cast<std::uint32_t>(chunk.code.size());
+                }
+
+                std::uint32_t emit(OpCode op, std::uint32_t a = 0, std::uint32_t b = 0, std::uint32_t c = 0) {
+                    chunk.code.push_back(Instruction{op, static_cast<std::uint16_t>(a), b, c});
+                    return position() - 1;
+                }
+
+                /**
+                 * Makes the jump at given instruction continue at the next one emitted.
+                 */
+                void patch(std::uint32_t jump) {
+                    chunk.code[jump].b = position();
+                }
+
+                std::uint32_t allocateRegister() {
+                    const auto result = nextRegister++;
+                    checkRegister(nextRegister);
+                    chunk.registerCount = std::max(chunk.registerCount, nextRegister);
+                    return result;
+                }
+
+                std::uint32_t allocateRef() {
+                    const auto result = nextRef++;
+                    checkRegister(nextRef);
+                    chunk.refCount = std::max(chunk.refCount, nextRef);
+                    return result;
+                }
+
+                /**
+                 * Saves the accumulator to the register. Its value is moved there, unless the next expression
+                 * still reads it.
+                 */
+                void spill(std::uint32_t reg, const parser::ExpressionNode *next) {
+                    emit(readsPreviousResult(next) ? OpCode::STORE_REGISTER : OpCode::MOVE_REGISTER, reg);
+                }
+
+                std::uint32_t addConstant(Variable value) {
+                    chunk.constants.push_back(std::move(value));
+                    return static_cast<std::uint32_t>(chunk.constants.size() - 1);
+                }
+
+                void loadConstant(Variable value) {
+                    emit(OpCode::LOAD_CONSTANT, 0, addConstant(std::move(value)));
+                }
+
+                /**
+                 * Whether the expression is a literal or a local variable, which operations can read directly.
+                 */
+                static bool isOperand(const parser::ExpressionNode *node) {
+                    if (auto variable = dynamic_cast<const parser::VariableNode *>(node))
+                        return variable->indices.empty() && variable->identifier->binding.kind == Binding::Kind::LOCAL;
+                    return dynamic_cast<const parser::NumberLiteralNode *>(node)
+                           || dynamic_cast<const parser::StringLiteralNode *>(node)
+                           || dynamic_cast<const parser::BooleanLiteralNode *>(node);
+                }
+
+                /**
+                 * Sets index to register or constant holding value of the operand.
+                 * @return constantFlag if it is a constant, zero otherwise
+                 */
+                std::uint32_t operand(const parser::ExpressionNode *node, std::uint32_t &index, std::uint32_t constantFlag) {
+                    if (auto variable = dynamic_cast<const parser::VariableNode *>(node)) {
+                        index = variable->identifier->binding.index;
+                        return 0;
+                    }
+                    if (auto number = dynamic_cast<const parser::NumberLiteralNode *>(node)) {
+                        double value[] = {number->value};
+                        index = addConstant(Variable(value, 1));
+                    } else if (auto string = dynamic_cast<const parser::StringLiteralNode *>(node)) {
+                        index = addConstant(Variable(string->value));
+                    } else {
+                        index = addConstant(Variable(static_cast<const parser::BooleanLiteralNode *>(node)->value));
+                    }
+                    return constantFlag;
+                }
+
+                void load(const Binding &binding) {
+                    switch (binding.kind) {
+                        case Binding::Kind::LOCAL:
+                            emit(OpCode::LOAD_REGISTER, 0, binding.index);
+                            return;
+                        case Binding::Kind::GLOBAL:
+                            emit(OpCode::LOAD_GLOBAL, 0, binding.index);
+                            return;
+                        case Binding::Kind::UNRESOLVED:
+                            emit(OpCode::LOAD_UNDEFINED);
+                            return;
+                    }
+                }
+
+                /**
+                 * Stores the accumulator to the variable, keeping it in the accumulator.
+                 */
+                void store(const Binding &binding) {
+                    switch (binding.kind) {
+                        case Binding::Kind::LOCAL:
+                            emit(OpCode::STORE_REGISTER, binding.index);
+                            return;
+                        case Binding::Kind::GLOBAL:
+                            emit(OpCode::STORE_GLOBAL, 0, binding.index);
+                            return;
+                        case Binding::Kind::UNRESOLVED:
+                            // Executor assigns to a scratch variable, nothing to do.
+                            return;
+                    }
+                }
+            };
+        }
+
+        Chunk compileFunction(const parser::FunctionDefNode &function) {
+            Compiler compiler(function.frameSize);
+            function.value->visit(compiler);
+            return compiler.finish();
+        }
+    }
+}
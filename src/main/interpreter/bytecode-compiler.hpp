@@ -0,0 +1,20 @@
+#ifndef INTERPRETER_BYTECODE_COMPILER_HPP
+#define INTERPRETER_BYTECODE_COMPILER_HPP
+
+#include "../parser/node.hpp"
+#include "bytecode.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Compiles body of the function for the virtual machine. Names in it have to be resolved already,
+         * their slots become the first registers.
+         * Instructions leave the accumulator with the same value Executor leaves in its result,
+         * so the function behaves the same on both engines.
+         * @throws InterpreterFailure if the body contains nodes which cannot be executed
+         */
+        Chunk compileFunction(const parser::FunctionDefNode &function);
+    }
+}
+
+#endif // INTERPRETER_BYTECODE_COMPILER_HPP
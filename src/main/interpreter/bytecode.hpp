@@ -0,0 +1,115 @@
+#ifndef INTERPRETER_BYTECODE_HPP
+#define INTERPRETER_BYTECODE_HPP
+
+#include <cstdint>
+#include <vector>
+#include "variable.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Operations of the virtual machine. Most of them read or write the accumulator, which holds
+         * the value of the last evaluated expression, like `result` of the tree walking interpreter.
+         * Registers start with slots of the call frame, temporaries follow them.
+         */
+        enum class OpCode : std::uint8_t {
+            /** acc = constants[b] */
+            LOAD_CONSTANT,
+            /** acc = undefined */
+            LOAD_UNDEFINED,
+            /** acc = registers[b] */
+            LOAD_REGISTER,
+            /** acc = globals[b] */
+            LOAD_GLOBAL,
+            /** registers[a] = acc */
+            STORE_REGISTER,
+            /** registers[a] = acc, moving the value as the accumulator is written before it is read again */
+            MOVE_REGISTER,
+            /** globals[b] = acc */
+            STORE_GLOBAL,
+
+            /** refs[a] = &registers[b] */
+            REF_REGISTER,
+            /** refs[a] = &globals[b] */
+            REF_GLOBAL,
+            /** refs[a] = scratch variable whose value is dropped */
+            REF_UNRESOLVED,
+            /** refs[a] = &refs[a]->getArrayItem(acc) */
+            REF_ELEMENT,
+            /** *refs[a] = registers[b] */
+            STORE_REF,
+
+            /** acc = registers[b].getItem(acc) */
+            ELEMENT,
+            /** registers[b] = registers[b].getItem(acc) */
+            ELEMENT_INTO,
+
+            /**
+             * acc = left op right. Left is registers[b], constants[b] with OperandFlags::LEFT_CONSTANT in a,
+             * or acc with OperandFlags::LEFT_ACCUMULATOR. Right is acc, or with OperandFlags::RIGHT_OPERAND
+             * registers[c] or constants[c].
+             */
+            EQUAL,
+            NOT_EQUAL,
+            LESS,
+            GREATER,
+            LESS_EQUAL,
+            GREATER_EQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
+
+            /** acc = op acc */
+            NEGATE,
+            NOT,
+
+            /** Continues at instruction b. */
+            JUMP,
+            /** Continues at instruction b if acc is false. */
+            JUMP_IF_FALSE,
+            /** Continues at instruction b if acc is true. */
+            JUMP_IF_TRUE,
+
+            /** acc = acc(registers[b], ..., registers[b + c - 1]), arguments are moved out of registers. */
+            CALL,
+            /** acc = globals[c](registers[b], ..., registers[b + a - 1]), without copying the function first. */
+            CALL_GLOBAL,
+
+            /** Ends the function, its result is acc. */
+            RETURN,
+        };
+
+        /**
+         * Where binary operations take their operands from.
+         */
+        namespace OperandFlags {
+            enum : std::uint16_t {
+                LEFT_CONSTANT = 1,
+                RIGHT_OPERAND = 2,
+                RIGHT_CONSTANT = 4,
+                LEFT_ACCUMULATOR = 8,
+            };
+        }
+
+        struct Instruction {
+            OpCode op;
+            std::uint16_t a;
+            std::uint32_t b;
+            std::uint32_t c;
+        };
+
+        /**
+         * Compiled body of a function.
+         */
+        struct Chunk {
+            std::vector<Instruction> code;
+            std::vector<Variable> constants;
+            /** Slots of the call frame and temporaries. */
+            std::uint32_t registerCount = 0;
+            std::uint32_t refCount = 0;
+        };
+    }
+}
+
+#endif // INTERPRETER_BYTECODE_HPP
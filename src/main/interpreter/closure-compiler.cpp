@@ -0,0 +1,525 @@
+#include "closure-compiler.hpp"
+#include "../parser/node-visitor.hpp"
+#include "evaluation-order.hpp"
+#include "exceptions.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            using parser::Binding;
+
+            struct Equal {
+                Variable operator()(const Variable &left, const Variable &right) const { return left == right; }
+            };
+
+            struct NotEqual {
+                Variable operator()(const Variable &left, const Variable &right) const { return left != right; }
+            };
+
+            struct Less {
+                Variable operator()(const Variable &left, const Variable &right) const { return left < right; }
+            };
+
+            struct Greater {
+                Variable operator()(const Variable &left, const Variable &right) const { return left > right; }
+            };
+
+            struct LessEqual {
+                Variable operator()(const Variable &left, const Variable &right) const { return left <= right; }
+            };
+
+            struct GreaterEqual {
+                Variable operator()(const Variable &left, const Variable &right) const { return left >= right; }
+            };
+
+            struct Add {
+                Variable operator()(const Variable &left, const Variable &right) const { return left + right; }
+            };
+
+            struct Subtract {
+                Variable operator()(const Variable &left, const Variable &right) const { return left - right; }
+            };
+
+            struct Multiply {
+                Variable operator()(const Variable &left, const Variable &right) const { return left * right; }
+            };
+
+            struct Divide {
+                Variable operator()(const Variable &left, const Variable &right) const { return left / right; }
+            };
+
+            /**
+             * Operand of binary operation: local or literal read in place, or any other expression.
+             */
+            struct Operand {
+                enum class Kind {
+                    SLOT,
+                    CONSTANT,
+                    EXPRESSION,
+                };
+
+                Kind kind;
+                std::uint32_t slot = 0;
+                Variable constant;
+                Closure closure;
+            };
+
+            template<typename Op>
+            Closure binary(const Operand &left, const Operand &right) {
+                using Kind = Operand::Kind;
+                const auto l = left.slot;
+                const auto r = right.slot;
+
+                if (left.kind == Kind::SLOT && right.kind == Kind::CONSTANT) {
+                    const auto constant = right.constant;
+                    return [l, constant](ClosureFrame &frame) { return Op()(frame.slots[l], constant); };
+                }
+                if (left.kind == Kind::SLOT && right.kind == Kind::SLOT)
+                    return [l, r](ClosureFrame &frame) { return Op()(frame.slots[l], frame.slots[r]); };
+                if (left.kind == Kind::CONSTANT && right.kind == Kind::SLOT) {
+                    const auto constant = left.constant;
+                    return [constant, r](ClosureFrame &frame) { return Op()(constant, frame.slots[r]); };
+                }
+                if (left.kind == Kind::CONSTANT && right.kind == Kind::CONSTANT) {
+                    const auto first = left.constant;
+                    const auto second = right.constant;
+                    return [first, second](ClosureFrame &) { return Op()(first, second); };
+                }
+                if (left.kind == Kind::SLOT) {
+                    const auto evaluate = right.closure;
+                    return [l, evaluate](ClosureFrame &frame) {
+                        const Variable value = evaluate(frame);
+                        return Op()(frame.slots[l], value);
+                    };
+                }
+                if (left.kind == Kind::CONSTANT) {
+                    const auto constant = left.constant;
+                    const auto evaluate = right.closure;
+                    return [constant, evaluate](ClosureFrame &frame) { return Op()(constant, evaluate(frame)); };
+                }
+                if (right.kind == Kind::SLOT) {
+                    // The left operand may assign to the slot, so it is evaluated first.
+                    const auto evaluate = left.closure;
+                    return [evaluate, r](ClosureFrame &frame) {
+                        const Variable value = evaluate(frame);
+                        return Op()(value, frame.slots[r]);
+                    };
+                }
+                if (right.kind == Kind::CONSTANT) {
+                    const auto evaluate = left.closure;
+                    const auto constant = right.constant;
+                    return [evaluate, constant](ClosureFrame &frame) { return Op()(evaluate(frame), constant); };
+                }
+                const auto first = left.closure;
+                const auto second = right.closure;
+                return [first, second](ClosureFrame &frame) {
+                    const Variable value = first(frame);
+                    return Op()(value, second(frame));
+                };
+            }
+
+            Closure binary(parser::BinaryOperator op, const Operand &left, const Operand &right) {
+                using parser::BinaryOperator;
+                switch (op) {
+                    case BinaryOperator::EQUAL:
+                        return binary<Equal>(left, right);
+                    case BinaryOperator::NOT_EQUAL:
+                        return binary<NotEqual>(left, right);
+                    case BinaryOperator::LESS:
+                        return binary<Less>(left, right);
+                    case BinaryOperator::GREATER:
+                        return binary<Greater>(left, right);
+                    case BinaryOperator::LESS_EQUAL:
+                        return binary<LessEqual>(left, right);
+                    case BinaryOperator::GREATER_EQUAL:
+                        return binary<GreaterEqual>(left, right);
+                    case BinaryOperator::ADD:
+                        return binary<Add>(left, right);
+                    case BinaryOperator::SUBTRACT:
+                        return binary<Subtract>(left, right);
+                    case BinaryOperator::MULTIPLY:
+                        return binary<Multiply>(left, right);
+                    case BinaryOperator::DIVIDE:
+                        return binary<Divide>(left, right);
+                    default:
+                        throw InterpreterFailure();
+                }
+            }
+
+            /**
+             * Keeps value of the closure for the next expression, if that reads it.
+             */
+            Closure sequenced(Closure closure, const parser::ExpressionNode *next) {
+                if (!readsPreviousResult(next))
+                    return closure;
+                return [closure](ClosureFrame &frame) {
+                    frame.previous = closure(frame);
+                    return frame.previous;
+                };
+            }
+
+            class ClosureCompiler : public parser::NodeVisitor {
+                Closure compiled;
+
+            public:
+                Closure compile(const parser::Node &node) {
+                    node.visit(*this);
+                    return std::move(compiled);
+                }
+
+                void visit(const parser::ScriptNode &node) override {
+                    unsupported("script");
+                }
+
+                void visit(const parser::FunctionDefNode &node) override {
+                    unsupported("function definition");
+                }
+
+                void visit(const parser::FunctionDefParamsNode &node) override {
+                    unsupported("function parameters");
+                }
+
+                void visit(const parser::HtmlTemplateNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeListNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::TextContentNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::InjectedValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::ReturnExpressionNode &node) override {
+                    compiled = compile(*node.returnValue);
+                }
+
+                void visit(const parser::BlockNode &node) override {
+                    compiled = compile(*node.value);
+                }
+
+                void visit(const parser::DeclarationExpressionNode &node) override {
+                    Closure value = node.value ? compile(*node.value) : constant(Variable());
+                    compiled = store(node.identifier->binding, std::move(value));
+                }
+
+                void visit(const parser::ForExpressionNode &node) override {
+                    if (!node.expression->variable)
+                        throw InterpreterFailure("for loop has no variable to update");
+
+                    const auto condition = node.condition.get();
+                    const auto iterator = sequenced(compile(*node.iterator), condition);
+                    const auto test = sequenced(compile(*condition), node.expression.get());
+                    const auto step = sequenced(compile(*node.expression), node.block.get());
+                    const auto block = sequenced(compile(*node.block), condition);
+                    compiled = [iterator, test, step, block](ClosureFrame &frame) {
+                        iterator(frame);
+                        for (;;) {
+                            Variable result = test(frame);
+                            if (!result)
+                                return result;
+                            step(frame);
+                            block(frame);
+                        }
+                    };
+                }
+
+                void visit(const parser::AssignExpressionNode &node) override {
+                    const auto &indices = node.variable->indices;
+                    const auto &binding = node.variable->identifier->binding;
+                    if (indices.empty()) {
+                        compiled = store(binding, compile(*node.value));
+                        return;
+                    }
+
+                    const auto value = sequenced(compile(*node.value), indices.front()->value.get());
+                    const auto steps = compileIndices(indices);
+                    compiled = [binding, value, steps](ClosureFrame &frame) {
+                        const Variable assigned = value(frame);
+                        std::vector<Variable> indices;
+                        indices.reserve(steps.size());
+                        for (auto &step : steps)
+                            indices.push_back(step(frame));
+
+                        Variable unresolved;
+                        Variable *target = &unresolved;
+                        if (binding.kind == Binding::Kind::LOCAL)
+                            target = &frame.slots[binding.index];
+                        else if (binding.kind == Binding::Kind::GLOBAL)
+                            target = &frame.globals[binding.index];
+                        for (auto &index : indices)
+                            target = &target->getArrayItem(index.getNumberAsSize());
+                        *target = assigned;
+                        return indices.back();
+                    };
+                }
+
+                void visit(const parser::IfExpressionNode &node) override {
+                    const auto condition = sequenced(compile(*node.condition), node.ifBlock.get());
+                    const auto ifBlock = compile(*node.ifBlock);
+                    if (!node.elseBlock) {
+                        compiled = [condition, ifBlock](ClosureFrame &frame) {
+                            Variable result = condition(frame);
+                            return result ? ifBlock(frame) : result;
+                        };
+                        return;
+                    }
+
+                    const auto elseBlock = compile(*node.elseBlock);
+                    if (readsPreviousResult(node.elseBlock.get())) {
+                        const auto evaluate = compile(*node.condition);
+                        compiled = [evaluate, ifBlock, elseBlock](ClosureFrame &frame) {
+                            frame.previous = evaluate(frame);
+                            return frame.previous ? ifBlock(frame) : elseBlock(frame);
+                        };
+                        return;
+                    }
+                    compiled = [condition, ifBlock, elseBlock](ClosureFrame &frame) {
+                        return condition(frame) ? ifBlock(frame) : elseBlock(frame);
+                    };
+                }
+
+                void visit(const parser::BinaryOperationNode &node) override {
+                    using parser::BinaryOperator;
+
+                    if (node.op == BinaryOperator::OR || node.op == BinaryOperator::AND) {
+                        const auto left = sequenced(compile(*node.left), node.right.get());
+                        const auto right = compile(*node.right);
+                        if (node.op == BinaryOperator::OR) {
+                            compiled = [left, right](ClosureFrame &frame) {
+                                Variable result = left(frame);
+                                return !result ? right(frame) : result;
+                            };
+                        } else {
+                            compiled = [left, right](ClosureFrame &frame) {
+                                Variable result = left(frame);
+                                return result ? right(frame) : result;
+                            };
+                        }
+                        return;
+                    }
+
+                    // Locals and literals are read in place, as long as the right operand neither changes them
+                    // nor reads the left value as the previous result.
+                    Operand right = operand(*node.right);
+                    const bool inPlace = right.kind != Operand::Kind::EXPRESSION
+                                         || (!mayAssign(node.right.get()) && !readsPreviousResult(node.right.get()));
+                    Operand left = inPlace ? operand(*node.left) : Operand{Operand::Kind::EXPRESSION};
+                    if (left.kind == Operand::Kind::EXPRESSION)
+                        left.closure = sequenced(compile(*node.left), node.right.get());
+                    compiled = binary(node.op, left, right);
+                }
+
+                void visit(const parser::UnaryOperationNode &node) override {
+                    const auto operand = compile(*node.operand);
+                    if (node.op == parser::UnaryOperator::NEGATE) {
+                        compiled = [operand](ClosureFrame &frame) { return -operand(frame); };
+                    } else {
+                        compiled = [operand](ClosureFrame &frame) { return !operand(frame); };
+                    }
+                }
+
+                void visit(const parser::FunctionCallNode &node) override {
+                    std::vector<Closure> arguments;
+                    for (std::size_t i = 0; i < node.value.size(); ++i) {
+                        const auto next = i + 1 < node.value.size() ? node.value[i + 1].get() : nullptr;
+                        arguments.push_back(sequenced(compile(*node.value[i]), next));
+                    }
+
+                    const auto binding = node.identifier->binding;
+                    compiled = [arguments, binding](ClosureFrame &frame) {
+                        ArgumentList values;
+                        for (auto &argument : arguments)
+                            values.push(argument(frame));
+                        switch (binding.kind) {
+                            case Binding::Kind::LOCAL:
+                                return frame.slots[binding.index](values.arguments());
+                            case Binding::Kind::GLOBAL:
+                                return frame.globals[binding.index](values.arguments());
+                            case Binding::Kind::UNRESOLVED:
+                                break;
+                        }
+                        return Variable()(values.arguments());
+                    };
+                }
+
+                void visit(const parser::ObjectFieldNode &node) override {
+                    const auto value = compile(*node.expression);
+                    if (!readsPreviousResult(node.expression.get())) {
+                        compiled = value;
+                        return;
+                    }
+                    // Executor looks the field name up as a variable first, and the expression reads that value.
+                    const auto name = load(node.identifier->binding);
+                    compiled = [name, value](ClosureFrame &frame) {
+                        frame.previous = name(frame);
+                        return value(frame);
+                    };
+                }
+
+                void visit(const parser::ObjectLiteralNode &node) override {
+                    // Like Executor, calls the last value with values of the fields.
+                    if (node.injection.empty()) {
+                        compiled = [](ClosureFrame &frame) { return frame.previous(Arguments()); };
+                        return;
+                    }
+
+                    std::vector<Closure> fields;
+                    for (auto &field : node.injection)
+                        fields.push_back(compile(*field));
+                    compiled = [fields](ClosureFrame &frame) {
+                        ArgumentList values;
+                        for (auto &field : fields)
+                            values.push(field(frame));
+                        const auto arguments = values.arguments();
+                        const Variable callee = arguments[arguments.size() - 1];
+                        return callee(arguments);
+                    };
+                }
+
+                void visit(const parser::VariableNode &node) override {
+                    const auto variable = load(node.identifier->binding);
+                    if (node.indices.empty()) {
+                        compiled = variable;
+                        return;
+                    }
+
+                    const auto start = sequenced(variable, node.indices.front()->value.get());
+                    const auto steps = compileIndices(node.indices);
+                    compiled = [start, steps](ClosureFrame &frame) {
+                        Variable current = start(frame);
+                        for (auto &step : steps)
+                            current = current.getItem(step(frame).getNumberAsSize());
+                        return current;
+                    };
+                }
+
+                void visit(const parser::IndexExpressionNode &node) override {
+                    compiled = compile(*node.value);
+                }
+
+                void visit(const parser::IdentifierNode &node) override {
+                    compiled = load(node.binding);
+                }
+
+                void visit(const parser::AnyTextNode &node) override {
+                    compiled = constant(Variable(node.text));
+                }
+
+                void visit(const parser::StringLiteralNode &node) override {
+                    compiled = constant(Variable(node.value));
+                }
+
+                void visit(const parser::NumberLiteralNode &node) override {
+                    double value[] = {node.value};
+                    compiled = constant(Variable(value, 1));
+                }
+
+                void visit(const parser::BooleanLiteralNode &node) override {
+                    compiled = constant(Variable(node.value));
+                }
+
+            private:
+                [[noreturn]] static void unsupported(const std::string &what) {
+                    throw InterpreterFailure(what + " cannot be executed");
+                }
+
+                static Closure constant(Variable value) {
+                    return [value](ClosureFrame &) { return value; };
+                }
+
+                static bool literal(const parser::ExpressionNode &node, Variable &value) {
+                    if (auto number = dynamic_cast<const parser::NumberLiteralNode *>(&node)) {
+                        double numeric[] = {number->value};
+                        value = Variable(numeric, 1);
+                    } else if (auto string = dynamic_cast<const parser::StringLiteralNode *>(&node)) {
+                        value = Variable(string->value);
+                    } else if (auto boolean = dynamic_cast<const parser::BooleanLiteralNode *>(&node)) {
+                        value = Variable(boolean->value);
+                    } else {
+                        return false;
+                    }
+                    return true;
+                }
+
+                static Closure load(const Binding &binding) {
+                    const auto index = binding.index;
+                    switch (binding.kind) {
+                        case Binding::Kind::LOCAL:
+                            return [index](ClosureFrame &frame) { return frame.slots[index]; };
+                        case Binding::Kind::GLOBAL:
+                            return [index](ClosureFrame &frame) { return frame.globals[index]; };
+                        case Binding::Kind::UNRESOLVED:
+                            break;
+                    }
+                    return constant(Variable());
+                }
+
+                /**
+                 * Stores value of the closure to the variable, returning the value.
+                 */
+                static Closure store(const Binding &binding, Closure value) {
+                    const auto index = binding.index;
+                    switch (binding.kind) {
+                        case Binding::Kind::LOCAL:
+                            return [index, value](ClosureFrame &frame) { return frame.slots[index] = value(frame); };
+                        case Binding::Kind::GLOBAL:
+                            return [index, value](ClosureFrame &frame) { return frame.globals[index] = value(frame); };
+                        case Binding::Kind::UNRESOLVED:
+                            break;
+                    }
+                    return value;
+                }
+
+                /**
+                 * Literal or local variable without indices, read in place; any other expression is compiled.
+                 */
+                Operand operand(const parser::ExpressionNode &node) {
+                    Operand result{Operand::Kind::EXPRESSION};
+                    if (auto variable = dynamic_cast<const parser::VariableNode *>(&node)) {
+                        const auto &binding = variable->identifier->binding;
+                        if (variable->indices.empty() && binding.kind == Binding::Kind::LOCAL) {
+                            result.kind = Operand::Kind::SLOT;
+                            result.slot = binding.index;
+                            return result;
+                        }
+                    } else if (literal(node, result.constant)) {
+                        result.kind = Operand::Kind::CONSTANT;
+                        return result;
+                    }
+                    result.closure = compile(node);
+                    return result;
+                }
+
+                /**
+                 * Closures of index expressions, each keeping its value for the next one if that reads it.
+                 */
+                std::vector<Closure> compileIndices(const std::vector<std::unique_ptr<parser::IndexExpressionNode>> &indices) {
+                    std::vector<Closure> result;
+                    for (std::size_t i = 0; i < indices.size(); ++i) {
+                        const auto next = i + 1 < indices.size() ? indices[i + 1]->value.get() : nullptr;
+                        result.push_back(sequenced(compile(*indices[i]), next));
+                    }
+                    return result;
+                }
+            };
+        }
+
+        Closure compileClosure(const parser::FunctionDefNode &function) {
+            return ClosureCompiler().compile(*function.value);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef INTERPRETER_CLOSURE_COMPILER_HPP
+#define INTERPRETER_CLOSURE_COMPILER_HPP
+
+#include <functional>
+#include <vector>
+#include "../parser/node.hpp"
+#include "variable.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Variables of one call of a function compiled to closures.
+         */
+        struct ClosureFrame {
+            std::vector<Variable> &globals;
+            std::vector<Variable> &slots;
+            /**
+             * Value of the expression evaluated before an empty object literal, which calls it.
+             * Only written by closures whose value is read this way.
+             */
+            Variable previous;
+
+            ClosureFrame(std::vector<Variable> &globals, std::vector<Variable> &slots)
+                    : globals(globals), slots(slots) {
+            }
+        };
+
+        /**
+         * Evaluates an expression, returning the value Executor would leave in its result.
+         */
+        using Closure = std::function<Variable(ClosureFrame &)>;
+
+        /**
+         * Converts body of the function to a tree of closures, with operands of every node bound
+         * when it is compiled: slots, globals and literals are captured directly, and operations on them
+         * get closures of their own. Names in the function have to be resolved already.
+         * @throws InterpreterFailure if the body contains nodes which cannot be executed
+         */
+        Closure compileClosure(const parser::FunctionDefNode &function);
+    }
+}
+
+#endif // INTERPRETER_CLOSURE_COMPILER_HPP
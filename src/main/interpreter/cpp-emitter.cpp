@@ -0,0 +1,507 @@
+#include "cpp-emitter.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+#include <unordered_set>
+#include "../parser/node-visitor.hpp"
+#include "evaluation-order.hpp"
+#include "exceptions.hpp"
+#include "native-module.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            using parser::Binding;
+
+            std::string quote(const std::string &text) {
+                std::string result = "\"";
+                for (unsigned char c : text) {
+                    if (c == '"' || c == '\\' || c == '?') {
+                        result += '\\';
+                        result += static_cast<char>(c);
+                    } else if (c >= 0x20 && c < 0x7f) {
+                        result += static_cast<char>(c);
+                    } else {
+                        // Always three octal digits, so following characters are not taken as part of the escape.
+                        char escape[5];
+                        std::snprintf(escape, sizeof(escape), "\\%03o", c);
+                        result += escape;
+                    }
+                }
+                return result + "\"";
+            }
+
+            /**
+             * Expression of a std::string with the text, given with its length so embedded zeros are kept.
+             */
+            std::string stringLiteral(const std::string &text) {
+                return "std::string(" + quote(text) + ", " + std::to_string(text.size()) + ")";
+            }
+
+            std::string numberLiteral(double value) {
+                if (std::isnan(value))
+                    return "std::numeric_limits<double>::quiet_NaN()";
+                if (std::isinf(value))
+                    return value < 0 ? "-std::numeric_limits<double>::infinity()"
+                                     : "std::numeric_limits<double>::infinity()";
+                char text[32];
+                std::snprintf(text, sizeof(text), "%.17g", value);
+                return text;
+            }
+
+            /**
+             * Emits body of one function as statements which do what Executor does with its result,
+             * keeping it in a local named `result`.
+             */
+            class FunctionEmitter : public parser::NodeVisitor {
+                std::ostringstream &out;
+                std::vector<std::string> &constants;
+                unsigned depth = 1;
+                unsigned temporaries = 0;
+
+            public:
+                FunctionEmitter(std::ostringstream &out, std::vector<std::string> &constants)
+                        : out(out), constants(constants) {
+                }
+
+                void emitFunction(const parser::FunctionDefNode &function, const std::string &name) {
+                    out << "    Variable " << name << "(std::vector<Variable> &globals, Arguments arguments) {\n";
+                    line("Variable frame[" + std::to_string(function.frameSize ? function.frameSize : 1) + "];");
+                    const auto &params = function.params->params;
+                    for (std::size_t i = 0; i < params.size(); ++i) {
+                        line("if (arguments.size() > " + std::to_string(i) + ")");
+                        line("    frame[" + std::to_string(params[i]->binding.index) + "] = std::move(arguments["
+                             + std::to_string(i) + "]);");
+                    }
+                    line("Variable result;");
+                    function.value->visit(*this);
+                    line("return result;");
+                    out << "    }\n\n";
+                }
+
+                void visit(const parser::ScriptNode &node) override {
+                    unsupported("script");
+                }
+
+                void visit(const parser::FunctionDefNode &node) override {
+                    unsupported("function definition");
+                }
+
+                void visit(const parser::FunctionDefParamsNode &node) override {
+                    unsupported("function parameters");
+                }
+
+                void visit(const parser::HtmlTemplateNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::AttributeListNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::TextContentNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::InjectedValueNode &node) override {
+                    unsupported("template");
+                }
+
+                void visit(const parser::ReturnExpressionNode &node) override {
+                    node.returnValue->visit(*this);
+                }
+
+                void visit(const parser::BlockNode &node) override {
+                    node.value->visit(*this);
+                }
+
+                void visit(const parser::DeclarationExpressionNode &node) override {
+                    if (node.value)
+                        node.value->visit(*this);
+                    else
+                        line("result = Variable();");
+                    store(node.identifier->binding);
+                }
+
+                void visit(const parser::ForExpressionNode &node) override {
+                    if (!node.expression->variable)
+                        throw InterpreterFailure("for loop has no variable to update");
+
+                    node.iterator->visit(*this);
+                    open("for (;;) {");
+                    node.condition->visit(*this);
+                    line("if (!result)");
+                    line("    break;");
+                    node.expression->visit(*this);
+                    node.block->visit(*this);
+                    close();
+                }
+
+                void visit(const parser::AssignExpressionNode &node) override {
+                    node.value->visit(*this);
+                    const auto &indices = node.variable->indices;
+                    const auto &binding = node.variable->identifier->binding;
+                    if (indices.empty()) {
+                        store(binding);
+                        return;
+                    }
+
+                    open("{");
+                    const auto value = temporary("value");
+                    const auto target = temporary("target");
+                    line("Variable " + value + " = result;");
+                    // Indices are evaluated before looking up the target, the last one stays in the result.
+                    std::vector<std::string> values;
+                    for (std::size_t i = 0; i < indices.size(); ++i) {
+                        indices[i]->visit(*this);
+                        values.push_back(i + 1 < indices.size() ? temporary("index") : "result");
+                        if (i + 1 < indices.size())
+                            line("Variable " + values.back() + " = result;");
+                    }
+                    if (binding.kind == Binding::Kind::UNRESOLVED) {
+                        const auto unresolved = temporary("unresolved");
+                        line("Variable " + unresolved + ";");
+                        line("Variable *" + target + " = &" + unresolved + ";");
+                    } else {
+                        line("Variable *" + target + " = &" + slot(binding) + ";");
+                    }
+                    for (auto &index : values)
+                        line(target + " = &" + target + "->getArrayItem(" + index + ".getNumberAsSize());");
+                    line("*" + target + " = " + value + ";");
+                    close();
+                }
+
+                void visit(const parser::IfExpressionNode &node) override {
+                    node.condition->visit(*this);
+                    open("if (result) {");
+                    node.ifBlock->visit(*this);
+                    if (node.elseBlock) {
+                        --depth;
+                        line("} else {");
+                        ++depth;
+                        node.elseBlock->visit(*this);
+                    }
+                    close();
+                }
+
+                void visit(const parser::BinaryOperationNode &node) override {
+                    using parser::BinaryOperator;
+
+                    if (node.op == BinaryOperator::OR || node.op == BinaryOperator::AND) {
+                        node.left->visit(*this);
+                        open(node.op == BinaryOperator::OR ? "if (!result) {" : "if (result) {");
+                        node.right->visit(*this);
+                        close();
+                        return;
+                    }
+
+                    const auto op = binaryOperator(node.op);
+                    // Locals and literals are read in place, as long as the right operand neither changes them
+                    // nor reads the left value as the previous result.
+                    std::string left;
+                    std::string right;
+                    if (operand(*node.right, right)) {
+                        if (operand(*node.left, left)) {
+                            line("result = " + left + " " + op + " " + right + ";");
+                        } else {
+                            node.left->visit(*this);
+                            line("result = result " + op + " " + right + ";");
+                        }
+                        return;
+                    }
+                    if (!mayAssign(node.right.get()) && !readsPreviousResult(node.right.get()) && operand(*node.left, left)) {
+                        node.right->visit(*this);
+                        line("result = " + left + " " + op + " result;");
+                        return;
+                    }
+
+                    open("{");
+                    node.left->visit(*this);
+                    left = temporary("left");
+                    line("Variable " + left + " = result;");
+                    node.right->visit(*this);
+                    line("result = " + left + " " + op + " result;");
+                    close();
+                }
+
+                void visit(const parser::UnaryOperationNode &node) override {
+                    node.operand->visit(*this);
+                    line(node.op == parser::UnaryOperator::NEGATE ? "result = -result;" : "result = !result;");
+                }
+
+                void visit(const parser::FunctionCallNode &node) override {
+                    // Arguments are counted when emitting, so they live in an array on the stack of the caller.
+                    const auto &binding = node.identifier->binding;
+                    const auto callee = binding.kind == Binding::Kind::UNRESOLVED ? "Variable()" : slot(binding);
+                    const auto count = std::to_string(node.value.size());
+                    if (node.value.empty()) {
+                        line("result = " + callee + "(Arguments());");
+                        return;
+                    }
+                    open("{");
+                    const auto arguments = temporary("arguments");
+                    line("Variable " + arguments + "[" + count + "];");
+                    for (std::size_t i = 0; i < node.value.size(); ++i) {
+                        node.value[i]->visit(*this);
+                        // The callee is looked up after the arguments, so only the next argument can read the result.
+                        const bool read = i + 1 < node.value.size() && readsPreviousResult(node.value[i + 1].get());
+                        line(arguments + "[" + std::to_string(i) + "] = " + (read ? "result" : "std::move(result)") + ";");
+                    }
+                    line("result = " + callee + "(Arguments(" + arguments + ", " + count + "));");
+                    close();
+                }
+
+                void visit(const parser::ObjectFieldNode &node) override {
+                    // Executor looks the field name up as a variable first, only the expression can read that.
+                    if (readsPreviousResult(node.expression.get()))
+                        node.identifier->visit(*this);
+                    node.expression->visit(*this);
+                }
+
+                void visit(const parser::ObjectLiteralNode &node) override {
+                    // Like Executor, calls the last value with values of the fields.
+                    if (node.injection.empty()) {
+                        line("result = result(Arguments());");
+                        return;
+                    }
+
+                    open("{");
+                    const auto fields = temporary("fields");
+                    const auto count = std::to_string(node.injection.size());
+                    line("Variable " + fields + "[" + count + "];");
+                    for (std::size_t i = 0; i < node.injection.size(); ++i) {
+                        node.injection[i]->visit(*this);
+                        line(fields + "[" + std::to_string(i) + "] = result;");
+                    }
+                    line("result = result(Arguments(" + fields + ", " + count + "));");
+                    close();
+                }
+
+                void visit(const parser::VariableNode &node) override {
+                    node.identifier->visit(*this);
+                    if (node.indices.empty())
+                        return;
+
+                    open("{");
+                    const auto current = temporary("current");
+                    line("Variable " + current + " = result;");
+                    for (auto &index : node.indices) {
+                        index->visit(*this);
+                        line(current + " = " + current + ".getItem(result.getNumberAsSize());");
+                    }
+                    line("result = std::move(" + current + ");");
+                    close();
+                }
+
+                void visit(const parser::IndexExpressionNode &node) override {
+                    node.value->visit(*this);
+                }
+
+                void visit(const parser::IdentifierNode &node) override {
+                    if (node.binding.kind == Binding::Kind::UNRESOLVED)
+                        line("result = Variable();");
+                    else
+                        line("result = " + slot(node.binding) + ";");
+                }
+
+                void visit(const parser::AnyTextNode &node) override {
+                    line("result = " + constant("Variable(" + stringLiteral(node.text) + ")") + ";");
+                }
+
+                void visit(const parser::StringLiteralNode &node) override {
+                    line("result = " + constant("Variable(" + stringLiteral(node.value) + ")") + ";");
+                }
+
+                void visit(const parser::NumberLiteralNode &node) override {
+                    line("result = " + constant("native::number(" + numberLiteral(node.value) + ")") + ";");
+                }
+
+                void visit(const parser::BooleanLiteralNode &node) override {
+                    line("result = " + constant(node.value ? "Variable(true)" : "Variable(false)") + ";");
+                }
+
+            private:
+                [[noreturn]] static void unsupported(const std::string &what) {
+                    throw InterpreterFailure(what + " cannot be executed");
+                }
+
+                static std::string binaryOperator(parser::BinaryOperator op) {
+                    using parser::BinaryOperator;
+                    switch (op) {
+                        case BinaryOperator::EQUAL:
+                            return "==";
+                        case BinaryOperator::NOT_EQUAL:
+                            return "!=";
+                        case BinaryOperator::LESS:
+                            return "<";
+                        case BinaryOperator::GREATER:
+                            return ">";
+                        case BinaryOperator::LESS_EQUAL:
+                            return "<=";
+                        case BinaryOperator::GREATER_EQUAL:
+                            return ">=";
+                        case BinaryOperator::ADD:
+                            return "+";
+                        case BinaryOperator::SUBTRACT:
+                            return "-";
+                        case BinaryOperator::MULTIPLY:
+                            return "*";
+                        case BinaryOperator::DIVIDE:
+                            return "/";
+                        default:
+                            throw InterpreterFailure();
+                    }
+                }
+
+                static std::string slot(const Binding &binding) {
+                    return (binding.kind == Binding::Kind::LOCAL ? "frame[" : "globals[")
+                           + std::to_string(binding.index) + "]";
+                }
+
+                void store(const Binding &binding) {
+                    // Like Executor, assignments to unresolved names are dropped.
+                    if (binding.kind != Binding::Kind::UNRESOLVED)
+                        line(slot(binding) + " = result;");
+                }
+
+                /**
+                 * Expression for a literal or a local variable without indices, if the node is one.
+                 */
+                bool operand(const parser::ExpressionNode &node, std::string &expression) {
+                    if (auto variable = dynamic_cast<const parser::VariableNode *>(&node)) {
+                        const auto &binding = variable->identifier->binding;
+                        if (!variable->indices.empty() || binding.kind != Binding::Kind::LOCAL)
+                            return false;
+                        expression = slot(binding);
+                    } else if (auto number = dynamic_cast<const parser::NumberLiteralNode *>(&node)) {
+                        expression = constant("native::number(" + numberLiteral(number->value) + ")");
+                    } else if (auto string = dynamic_cast<const parser::StringLiteralNode *>(&node)) {
+                        expression = constant("Variable(" + stringLiteral(string->value) + ")");
+                    } else if (auto boolean = dynamic_cast<const parser::BooleanLiteralNode *>(&node)) {
+                        expression = constant(boolean->value ? "Variable(true)" : "Variable(false)");
+                    } else {
+                        return false;
+                    }
+                    return true;
+                }
+
+                /**
+                 * Name of a module level constant with the value, built once when the module is loaded.
+                 */
+                std::string constant(const std::string &initializer) {
+                    auto existing = std::find(constants.begin(), constants.end(), initializer);
+                    if (existing == constants.end())
+                        existing = constants.insert(existing, initializer);
+                    return "constant" + std::to_string(existing - constants.begin());
+                }
+
+                std::string temporary(const std::string &name) {
+                    return name + std::to_string(temporaries++);
+                }
+
+                void line(const std::string &text) {
+                    out << std::string(4 * (depth + 1), ' ') << text << '\n';
+                }
+
+                void open(const std::string &text) {
+                    line(text);
+                    ++depth;
+                }
+
+                void close() {
+                    --depth;
+                    line("}");
+                }
+            };
+
+            bool isIdentifier(const std::string &name) {
+                for (unsigned char c : name) {
+                    if (!std::isalnum(c) && c != '_')
+                        return false;
+                }
+                return true;
+            }
+        }
+
+        void emitCpp(
+                const parser::ScriptNode &script,
+                const std::vector<std::string> &globalNames,
+                std::ostream &out,
+                const std::string &moduleName
+        ) {
+            if (!isIdentifier(moduleName))
+                throw InterpreterFailure("module name has to be an identifier");
+
+            std::vector<std::string> constants;
+            std::ostringstream functions;
+            std::vector<std::pair<std::string, std::string>> entries;
+            std::unordered_set<std::string> emitted;
+            for (auto &function : script.functions) {
+                // Calls by name reach the first function of the name only.
+                if (!emitted.insert(function->name).second)
+                    continue;
+
+                std::ostringstream body;
+                std::vector<std::string> bodyConstants = constants;
+                const auto name = "function" + std::to_string(entries.size());
+                try {
+                    FunctionEmitter(body, bodyConstants).emitFunction(*function, name);
+                } catch (const InterpreterFailure &) {
+                    continue;
+                }
+                functions << body.str();
+                constants = move(bodyConstants);
+                entries.emplace_back(function->name, name);
+            }
+
+            out << "// Generated by runner --emit-cpp; build as a shared object against src/main and load with --native.\n"
+                << "#include <limits>\n"
+                << "#include <string>\n"
+                << "#include <utility>\n"
+                << "#include <vector>\n"
+                << "#include \"interpreter/native-module.hpp\"\n"
+                << "\n"
+                << "namespace {\n"
+                << "namespace module" << moduleName << " {\n"
+                << "    using namespace lang::interpreter;\n"
+                << "\n";
+            for (std::size_t i = 0; i < constants.size(); ++i)
+                out << "    const Variable constant" << i << " = " << constants[i] << ";\n";
+            if (!constants.empty())
+                out << "\n";
+            out << functions.str();
+
+            out << "    const char *const globalNames[] = {\n";
+            for (auto &name : globalNames)
+                out << "            " << quote(name) << ",\n";
+            out << "            nullptr\n"
+                << "    };\n"
+                << "\n"
+                << "    const NativeFunctionEntry functions[] = {\n";
+            for (auto &entry : entries)
+                out << "            {" << quote(entry.first) << ", " << entry.second << "},\n";
+            out << "            {nullptr, nullptr}\n"
+                << "    };\n"
+                << "}\n"
+                << "}\n"
+                << "\n"
+                << "extern \"C\" {\n"
+                << "    extern const lang::interpreter::NativeModule " << NATIVE_MODULE_SYMBOL << moduleName << ";\n"
+                << "    const lang::interpreter::NativeModule " << NATIVE_MODULE_SYMBOL << moduleName << " = {\n"
+                << "            sizeof(lang::interpreter::Variable), module" << moduleName << "::globalNames, "
+                << globalNames.size() << ", module" << moduleName << "::functions, " << entries.size() << "\n"
+                << "    };\n"
+                << "}\n";
+        }
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef INTERPRETER_CPP_EMITTER_HPP
+#define INTERPRETER_CPP_EMITTER_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "../parser/node.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Translates functions of the script to C++ source of a native module, see native-module.hpp.
+         * Names have to be resolved against the globals, given in order of their indices.
+         * Emitted functions leave the same results as Executor and call other functions through globals,
+         * so they are interchangeable with interpreted ones. Functions which cannot be executed, like templates,
+         * are left out and stay interpreted.
+         * Module name becomes part of the exported symbol and of the namespace of everything else, so modules
+         * of several scripts can be compiled into one shared object, even as one translation unit.
+         */
+        void emitCpp(
+                const parser::ScriptNode &script,
+                const std::vector<std::string> &globalNames,
+                std::ostream &out,
+                const std::string &moduleName = ""
+        );
+    }
+}
+
+#endif // INTERPRETER_CPP_EMITTER_HPP
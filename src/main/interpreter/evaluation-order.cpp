@@ -0,0 +1,60 @@
+#include "evaluation-order.hpp"
+
+namespace lang {
+    namespace interpreter {
+        bool readsPreviousResult(const parser::ExpressionNode *node) {
+            if (!node)
+                return false;
+            if (auto literal = dynamic_cast<const parser::ObjectLiteralNode *>(node))
+                // Otherwise the first field starts by looking up its name.
+                return literal->injection.empty();
+            if (auto operation = dynamic_cast<const parser::BinaryOperationNode *>(node))
+                return readsPreviousResult(operation->left.get());
+            if (auto operation = dynamic_cast<const parser::UnaryOperationNode *>(node))
+                return readsPreviousResult(operation->operand.get());
+            if (auto call = dynamic_cast<const parser::FunctionCallNode *>(node))
+                return !call->value.empty() && readsPreviousResult(call->value.front().get());
+            if (auto block = dynamic_cast<const parser::BlockNode *>(node))
+                return readsPreviousResult(block->value.get());
+            if (auto expression = dynamic_cast<const parser::ReturnExpressionNode *>(node))
+                return readsPreviousResult(expression->returnValue.get());
+            if (auto expression = dynamic_cast<const parser::IfExpressionNode *>(node))
+                return readsPreviousResult(expression->condition.get());
+            if (auto expression = dynamic_cast<const parser::DeclarationExpressionNode *>(node))
+                return readsPreviousResult(expression->value.get());
+            if (auto expression = dynamic_cast<const parser::AssignExpressionNode *>(node))
+                return readsPreviousResult(expression->value.get());
+            if (auto expression = dynamic_cast<const parser::ForExpressionNode *>(node))
+                return readsPreviousResult(expression->iterator.get());
+            return false;
+        }
+
+        bool mayAssign(const parser::ExpressionNode *node) {
+            if (!node)
+                return false;
+            if (auto variable = dynamic_cast<const parser::VariableNode *>(node))
+                return !variable->indices.empty();
+            if (auto operation = dynamic_cast<const parser::BinaryOperationNode *>(node))
+                return mayAssign(operation->left.get()) || mayAssign(operation->right.get());
+            if (auto operation = dynamic_cast<const parser::UnaryOperationNode *>(node))
+                return mayAssign(operation->operand.get());
+            if (auto call = dynamic_cast<const parser::FunctionCallNode *>(node)) {
+                for (auto &argument : call->value) {
+                    if (mayAssign(argument.get()))
+                        return true;
+                }
+                return false;
+            }
+            if (auto literal = dynamic_cast<const parser::ObjectLiteralNode *>(node)) {
+                for (auto &field : literal->injection) {
+                    if (mayAssign(field->expression.get()))
+                        return true;
+                }
+                return false;
+            }
+            return !dynamic_cast<const parser::LiteralNode *>(node)
+                   && !dynamic_cast<const parser::StringLiteralNode *>(node)
+                   && !dynamic_cast<const parser::NumberLiteralNode *>(node);
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef INTERPRETER_EVALUATION_ORDER_HPP
+#define INTERPRETER_EVALUATION_ORDER_HPP
+
+#include "../parser/node.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Whether evaluation of the expression uses the value of the expression evaluated just before it,
+         * before computing any value of its own. Only an empty object literal does: Executor calls its `result`
+         * with no arguments. Expressions which start by evaluating such a literal inherit this.
+         */
+        bool readsPreviousResult(const parser::ExpressionNode *node);
+
+        /**
+         * Whether evaluation of the expression may assign to a local. Assignments only reach operator
+         * expressions through index expressions, so any index counts.
+         */
+        bool mayAssign(const parser::ExpressionNode *node);
+    }
+}
+
+#endif // INTERPRETER_EVALUATION_ORDER_HPP
@@ -1,41 +1,73 @@
 #include "interpreter.hpp"
+#include "../parser/constant-folder.hpp"
 #include "../parser/node-visitor.hpp"
+#include "../parser/parser.hpp"
+#include "bytecode-compiler.hpp"
+#include "closure-compiler.hpp"
+#include "cpp-emitter.hpp"
 #include "exceptions.hpp"
+#include "resolver.hpp"
+#include "virtual-machine.hpp"
 #include <algorithm>
+#include <cstring>
+#include <dlfcn.h>
 #include <iostream>
 #include <cassert>
 
 namespace lang {
     namespace interpreter {
         namespace {
+            /**
+             * Variables of one call: slots of the called function and globals of the script.
+             */
             struct ExecutionContext {
-                Scope &globalScope;
-                std::vector<Scope> currentScope;
-
-                ExecutionContext(Scope &globalScope, Scope currentScope)
-                        : globalScope(globalScope) {
-                    this->currentScope.push_back(std::move(currentScope));
-                }
-
-                void push() {
-                    currentScope.push_back(Scope());
+                std::vector<Variable> &globals;
+                std::vector<Variable> &frame;
+                /** Target of assignments to unresolved names, whose values are dropped. */
+                Variable unresolved;
+
+                ExecutionContext(std::vector<Variable> &globals, std::vector<Variable> &frame)
+                        : globals(globals), frame(frame) {
+                }
+
+                Variable &resolve(const parser::Binding &binding) {
+                    switch (binding.kind) {
+                        case parser::Binding::Kind::LOCAL:
+                            return frame[binding.index];
+                        case parser::Binding::Kind::GLOBAL:
+                            return globals[binding.index];
+                        case parser::Binding::Kind::UNRESOLVED:
+                            break;
+                    }
+                    unresolved = Variable();
+                    return unresolved;
                 }
+            };
 
-                void pop() {
-                    currentScope.pop_back();
+            /**
+             * Slots of one call, taken from the pool of the interpreter and returned to it cleared when the call ends,
+             * so that their storage is allocated only when calls nest deeper than before.
+             */
+            class PooledFrame {
+                std::vector<std::vector<Variable>> &pool;
+                std::vector<Variable> frame;
+
+            public:
+                PooledFrame(std::vector<std::vector<Variable>> &pool, std::size_t size) : pool(pool) {
+                    if (!pool.empty()) {
+                        frame = std::move(pool.back());
+                        pool.pop_back();
+                    }
+                    frame.resize(size);
                 }
 
-                Variable &resolve(const std::string &name) {
-                    for (auto it = currentScope.rbegin(); it != currentScope.rend(); ++it) {
-                        auto &maybeResult = it->get(name);
-                        if (maybeResult.getType() != VariableType::Undefined)
-                            return maybeResult;
-                    }
-                    return globalScope.get(name);
+                ~PooledFrame() {
+                    frame.clear();
+                    pool.push_back(std::move(frame));
                 }
 
-                Scope &top() {
-                    return currentScope.back();
+                std::vector<Variable> &slots() {
+                    return frame;
                 }
             };
 
@@ -73,12 +105,12 @@ namespace lang {
                 }
 
                 void visit(const parser::AttributeListNode &node) override {
-                    std::vector<Variable> value;
+                    ArgumentList value;
                     for (auto &arg : node.value) {
                         arg->visit(*this);
-                        value.push_back(result);
+                        value.push(result);
                     }
-                    result = result(move(value));
+                    result = result(value.arguments());
                 }
 
                 void visit(const parser::TextContentNode &node) override {
@@ -104,7 +136,7 @@ namespace lang {
                     } else {
                         result = Variable();
                     }
-                    context.top().put(node.identifier->name, result);
+                    context.resolve(node.identifier->binding) = result;
                 }
 
                 void visit(const parser::ForExpressionNode &node) override {
@@ -118,11 +150,15 @@ namespace lang {
                 void visit(const parser::AssignExpressionNode &node) override {
                     node.value->visit(*this);
                     Variable value = result;
-                    Variable *target = &context.resolve(node.variable->identifier->name);
+                    // Indices are evaluated before looking up the target, which copies arrays shared meanwhile.
+                    std::vector<Variable> indices;
                     for (auto &idx : node.variable->indices) {
                         idx->value->visit(*this);
-                        target = &target->getArrayItem(result.getNumberAsSize());
+                        indices.push_back(result);
                     }
+                    Variable *target = &context.resolve(node.variable->identifier->binding);
+                    for (auto &index : indices)
+                        target = &target->getArrayItem(index.getNumberAsSize());
                     (*target) = value;
                 }
 
@@ -135,125 +171,72 @@ namespace lang {
                     }
                 }
 
-                void visit(const parser::MathExpressionAddNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left + result;
-                }
+                void visit(const parser::BinaryOperationNode &node) override {
+                    using parser::BinaryOperator;
 
-                void visit(const parser::MathExpressionSubtractNode &node) override {
                     node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left - result;
-                }
-
-                void visit(const parser::MathExpressionSingleNode &node) override {
-                    node.value->visit(*this);
-                }
-
-                void visit(const parser::MultiplyExpressionNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left * result;
-                }
+                    if (node.op == BinaryOperator::OR) {
+                        if (!result)
+                            node.right->visit(*this);
+                        return;
+                    }
+                    if (node.op == BinaryOperator::AND) {
+                        if (result)
+                            node.right->visit(*this);
+                        return;
+                    }
 
-                void visit(const parser::DivideExpressionNode &node) override {
-                    node.left->visit(*this);
                     Variable left = result;
                     node.right->visit(*this);
-                    result = left / result;
-                }
-
-                void visit(const parser::MultiplicativeExpressionSingleNode &node) override {
-                    node.value->visit(*this);
+                    switch (node.op) {
+                        case BinaryOperator::EQUAL:
+                            result = left == result;
+                            break;
+                        case BinaryOperator::NOT_EQUAL:
+                            result = left != result;
+                            break;
+                        case BinaryOperator::LESS:
+                            result = left < result;
+                            break;
+                        case BinaryOperator::GREATER:
+                            result = left > result;
+                            break;
+                        case BinaryOperator::LESS_EQUAL:
+                            result = left <= result;
+                            break;
+                        case BinaryOperator::GREATER_EQUAL:
+                            result = left >= result;
+                            break;
+                        case BinaryOperator::ADD:
+                            result = left + result;
+                            break;
+                        case BinaryOperator::SUBTRACT:
+                            result = left - result;
+                            break;
+                        case BinaryOperator::MULTIPLY:
+                            result = left * result;
+                            break;
+                        case BinaryOperator::DIVIDE:
+                            result = left / result;
+                            break;
+                        default:
+                            throw InterpreterFailure();
+                    }
                 }
 
-                void visit(const parser::BaseMathExpressionNode &node) override {
-                    // node.value->visit(*this);
-                    if (node.negate)
-                        result = -result;
+                void visit(const parser::UnaryOperationNode &node) override {
+                    node.operand->visit(*this);
+                    result = node.op == parser::UnaryOperator::NEGATE ? -result : !result;
                 }
 
                 void visit(const parser::FunctionCallNode &node) override {
-                    std::vector<Variable> value;
+                    ArgumentList value;
                     for (auto &arg : node.value) {
                         arg->visit(*this);
-                        value.push_back(result);
+                        value.push(result);
                     }
                     node.identifier->visit(*this);
-                    result = result(move(value));
-                }
-
-                void visit(const parser::ParenthesisExpressionNode &node) override {
-                    node.expression->visit(*this);
-                }
-
-                void visit(const parser::LogicExpressionOrNode &node) override {
-                    node.left->visit(*this);
-                    if (!result) {
-                        node.right->visit(*this);
-                    }
-                }
-
-                void visit(const parser::LogicExpressionSingleNode &node) override {
-                    node.value->visit(*this);
-                }
-
-                void visit(const parser::LogicExpressionAndAndNode &node) override {
-                    node.left->visit(*this);
-                    if (!result) {
-                        node.right->visit(*this);
-                    }
-                }
-
-                void visit(const parser::LogicExpressionAndSingleNode &node) override {
-                    node.value->visit(*this);
-                }
-
-                void visit(const parser::LogicExpressionEqualEqualNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left == result;
-                }
-
-                void visit(const parser::LogicExpressionEqualSingleNode &node) override {
-                    node.value->visit(*this);
-                }
-
-                void visit(const parser::LogicExpressionRelationalLessNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left < result;
-                }
-
-                void visit(const parser::LogicExpressionRelationalGreaterNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left > result;
-                }
-
-                void visit(const parser::LogicExpressionRelationalLessEqualNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left <= result;
-                }
-
-                void visit(const parser::LogicExpressionRelationalGreaterEqualNode &node) override {
-                    node.left->visit(*this);
-                    Variable left = result;
-                    node.right->visit(*this);
-                    result = left >= result;
-                }
-
-                void visit(const parser::LogicExpressionRelationalSingleNode &node) override {
-                    node.value->visit(*this);
+                    result = result(value.arguments());
                 }
 
                 void visit(const parser::ObjectFieldNode &node) override {
@@ -262,12 +245,12 @@ namespace lang {
                 }
 
                 void visit(const parser::ObjectLiteralNode &node) override {
-                    std::vector<Variable> injection;
+                    ArgumentList injection;
                     for (auto &arg : node.injection) {
                         arg->visit(*this);
-                        injection.push_back(result);
+                        injection.push(result);
                     }
-                    result = result(move(injection));
+                    result = result(injection.arguments());
                 }
 
                 void visit(const parser::VariableNode &node) override {
@@ -275,7 +258,7 @@ namespace lang {
                     Variable current = result;
                     for (auto &idx : node.indices) {
                         idx->visit(*this);
-                        current = current.getArrayItem(result.getNumberAsSize());
+                        current = current.getItem(result.getNumberAsSize());
                     }
                     result = current;
                 }
@@ -285,21 +268,11 @@ namespace lang {
                 }
 
                 void visit(const parser::IdentifierNode &node) override {
-                    result = context.resolve(node.name);
-                }
-
-                void visit(const parser::AnyCharNode &node) override {
-                    node.identifier->visit(*this);
-                    node.number->visit(*this);
+                    result = context.resolve(node.binding);
                 }
 
                 void visit(const parser::AnyTextNode &node) override {
-                    std::vector<Variable> chars;
-                    for (auto &arg : node.chars) {
-                        arg->visit(*this);
-                        chars.push_back(result);
-                    }
-                    result = result(move(chars));
+                    result = node.text;
                 }
 
                 void visit(const parser::StringLiteralNode &node) override {
@@ -317,73 +290,180 @@ namespace lang {
             };
         }
 
-        Interpreter::Interpreter(parser::ScriptNode &script) : script(script) {
-            prepareGlobalScope();
+        Interpreter::Interpreter(parser::ScriptNode &script, Engine engine)
+                : script(script), engine(engine), nativeLibrary(nullptr, dlclose) {
+            prepareGlobals();
+            for (auto &function : script.functions) {
+                if (!function->deferred)
+                    resolveNames(*function, globalIndices);
+            }
         }
 
         Variable Interpreter::execute(
                 const std::string &function,
                 std::vector<Variable> arguments
         ) {
-            callFrames.push(Scope());
-            auto &func = getFunction(function);
+            return call(getFunction(function), arguments);
+        }
+
+        void Interpreter::emitCpp(std::ostream &out, const std::string &moduleName) {
+            for (auto &function : script.functions)
+                prepareFunction(*function);
+            interpreter::emitCpp(script, globalNames(), out, moduleName);
+        }
+
+        void Interpreter::loadNative(const std::string &path, const std::string &moduleName) {
+            std::unique_ptr<void, int (*)(void *)> library(dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL), dlclose);
+            if (!library)
+                throw InterpreterFailure(std::string("cannot load native module: ") + dlerror());
+            const auto symbol = NATIVE_MODULE_SYMBOL + moduleName;
+            const auto module = static_cast<const NativeModule *>(dlsym(library.get(), symbol.c_str()));
+            if (!module)
+                throw InterpreterFailure("no native module " + symbol + " in " + path);
+
+            const auto names = globalNames();
+            bool sameGlobals = module->variableSize == sizeof(Variable) && module->globalCount == names.size();
+            for (std::size_t i = 0; sameGlobals && i < names.size(); ++i)
+                sameGlobals = names[i] == module->globalNames[i];
+            if (!sameGlobals)
+                throw InterpreterFailure("native module " + path + " was built for another script or interpreter");
+
+            std::unordered_map<const parser::FunctionDefNode *, NativeFunction> functions;
+            for (std::size_t i = 0; i < module->functionCount; ++i) {
+                const auto &entry = module->functions[i];
+                functions[&getFunction(entry.name)] = entry.function;
+            }
+            natives = move(functions);
+            nativeLibrary = move(library);
+        }
+
+        Variable Interpreter::call(parser::FunctionDefNode &function, Arguments arguments) {
+            if (!natives.empty()) {
+                const auto native = natives.find(&function);
+                if (native != natives.end())
+                    return native->second(globals, arguments);
+            }
+
+            prepareFunction(function);
+            const Chunk *chunk = engine == Engine::VM ? &getChunk(function) : nullptr;
+
+            PooledFrame pooled(framePool, chunk ? chunk->registerCount : function.frameSize);
+            auto &frame = pooled.slots();
+            const auto &params = function.params->params;
+            for (std::size_t i = 0; i < params.size() && i < arguments.size(); ++i) {
+                frame[params[i]->binding.index] = std::move(arguments[i]);
+            }
 
-            for (std::size_t i = 0; i < func.params->params.size(); ++i) {
-                callFrames.top().put(func.params->params[i]->name, arguments[i]);
+            if (chunk)
+                return runChunk(*chunk, globals, frame);
+
+            if (engine == Engine::CLOSURE) {
+                const Closure &closure = getClosure(function);
+                ClosureFrame closureFrame(globals, frame);
+                return closure(closureFrame);
             }
 
-            ExecutionContext context = ExecutionContext(globalScope, callFrames.top());
+            ExecutionContext context(globals, frame);
             Executor executor(context);
 
-            func.value->visit(executor);
-            callFrames.pop();
+            function.value->visit(executor);
 
             return executor.result;
         }
 
-        void Interpreter::prepareGlobalScope() {
+        const Chunk &Interpreter::getChunk(const parser::FunctionDefNode &function) {
+            auto chunk = chunks.find(&function);
+            if (chunk == chunks.end())
+                chunk = chunks.emplace(&function, compileFunction(function)).first;
+            return chunk->second;
+        }
+
+        const Closure &Interpreter::getClosure(const parser::FunctionDefNode &function) {
+            auto closure = closures.find(&function);
+            if (closure == closures.end())
+                closure = closures.emplace(&function, compileClosure(function)).first;
+            return closure->second;
+        }
+
+        void Interpreter::addGlobal(const std::string &name, Variable value) {
+            if (globalIndices.emplace(name, static_cast<std::uint32_t>(globals.size())).second)
+                globals.push_back(std::move(value));
+        }
+
+        void Interpreter::prepareGlobals() {
             for (auto &func : script.functions) {
-                globalScope.put(func->name, Variable(std::bind(
-                        &Interpreter::execute,
-                        this,
-                        func->name,
-                        std::placeholders::_1
+                parser::FunctionDefNode *function = func.get();
+                addGlobal(func->name, Variable(std::function<Variable(Arguments)>(
+                        [this, function](Arguments arguments) {
+                            return call(*function, arguments);
+                        }
                 )));
             }
 
-            using ftype = std::function<Variable(std::vector<Variable>)>;
+            using ftype = std::function<Variable(Arguments)>;
 
-            globalScope.put("print", ftype([](std::vector<Variable> args) -> Variable {
+            addGlobal("print", Variable(ftype([](Arguments args) -> Variable {
                 for (auto &a : args)
                     std::cout << a.toString();
                 std::cout << std::endl;
                 return Variable();
-            }));
+            })));
 
-            globalScope.put("len", ftype([](std::vector<Variable> args) -> Variable {
+            addGlobal("len", Variable(ftype([](Arguments args) -> Variable {
                 if (args.size() != 1)
                     throw ArgumentException("invalid argument count for len");
                 double value[] = {static_cast<double>(args[0].getLength())};
                 return Variable(value, 1);
-            }));
+            })));
 
-            globalScope.put("array", ftype([](std::vector<Variable> args) -> Variable {
-                return args;
-            }));
+            addGlobal("array", Variable(ftype([](Arguments args) -> Variable {
+                return std::vector<Variable>(std::make_move_iterator(args.begin()), std::make_move_iterator(args.end()));
+            })));
 
-            globalScope.put("push", ftype([](std::vector<Variable> args) -> Variable {
+            addGlobal("push", Variable(ftype([](Arguments args) -> Variable {
                 if (args.size() < 2)
                     throw ArgumentException("nothing to push to array");
-                args[0].getArray().insert(args[0].getArray().end(), args.begin() + 1, args.end());
-                return args[0];
-            }));
+                // Appends in place when the array is not shared, as when it is built by nested calls.
+                auto &array = args[0].getArray();
+                array.insert(array.end(), std::make_move_iterator(args.begin() + 1), std::make_move_iterator(args.end()));
+                return std::move(args[0]);
+            })));
+
+            for (std::size_t length = 2; length <= 4; ++length) {
+                const auto name = "vec" + std::to_string(length);
+                addGlobal(name, Variable(ftype([length, name](Arguments args) -> Variable {
+                    if (args.size() != length)
+                        throw ArgumentException("invalid argument count for " + name);
+                    double components[4];
+                    for (std::size_t i = 0; i < length; ++i)
+                        components[i] = args[i].getNumeric();
+                    return Variable(components, length);
+                })));
+            }
+        }
+
+        std::vector<std::string> Interpreter::globalNames() const {
+            std::vector<std::string> names(globals.size());
+            for (auto &global : globalIndices)
+                names[global.second] = global.first;
+            return names;
         }
 
         parser::FunctionDefNode &Interpreter::getFunction(const std::string &name) {
-            for (auto &f : script.functions)
+            for (auto &f : script.functions) {
                 if (f->name == name)
                     return *f;
+            }
             assert(false);
         }
+
+        void Interpreter::prepareFunction(parser::FunctionDefNode &function) {
+            if (!function.deferred)
+                return;
+            logging::Logger logger;
+            parser::parseDeferred(function, logger);
+            parser::foldConstants(function);
+            resolveNames(function, globalIndices);
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,31 +1,82 @@
 #ifndef INTERPRETER_INTERPRETER_HPP
 #define INTERPRETER_INTERPRETER_HPP
 
-#include <stack>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
 #include "../parser/node.hpp"
-#include "scope.hpp"
+#include "bytecode.hpp"
+#include "closure-compiler.hpp"
+#include "native-module.hpp"
 #include "variable.hpp"
 
 namespace lang {
     namespace interpreter {
+        /**
+         * How function bodies are executed: by walking their trees, or compiled on first call
+         * for the virtual machine or to closures.
+         */
+        enum class Engine {
+            TREE,
+            VM,
+            CLOSURE,
+        };
+
         class Interpreter {
-            Scope globalScope;
-            std::stack<Scope> callFrames;
+            /** Functions of the script and builtins, indexed as in bindings of names. */
+            std::vector<Variable> globals;
+            std::unordered_map<std::string, std::uint32_t> globalIndices;
 
             parser::ScriptNode &script;
+            const Engine engine;
+            std::unordered_map<const parser::FunctionDefNode *, Chunk> chunks;
+            std::unordered_map<const parser::FunctionDefNode *, Closure> closures;
+            /** Functions replaced by the loaded native module, called whatever the engine is. */
+            std::unordered_map<const parser::FunctionDefNode *, NativeFunction> natives;
+            std::unique_ptr<void, int (*)(void *)> nativeLibrary;
+            /** Slots of finished calls, kept for the next ones. */
+            std::vector<std::vector<Variable>> framePool;
 
         public:
-            explicit Interpreter(parser::ScriptNode &script);
+            explicit Interpreter(parser::ScriptNode &script, Engine engine = Engine::TREE);
 
             Variable execute(
                     const std::string &functionName,
                     std::vector<Variable> arguments = std::vector<Variable>()
             );
 
+            /**
+             * Writes all functions of the script as C++ source of a native module, see emitCpp.
+             */
+            void emitCpp(std::ostream &out, const std::string &moduleName = "");
+
+            /**
+             * Loads shared object built from C++ emitted for the same script, its functions replace interpreted ones.
+             * @throws InterpreterFailure if the library cannot be loaded, or was built for another script
+             */
+            void loadNative(const std::string &path, const std::string &moduleName = "");
+
         private:
-            void prepareGlobalScope();
+            void prepareGlobals();
+
+            void addGlobal(const std::string &name, Variable value);
+
+            /** Names of globals, in order of their indices. */
+            std::vector<std::string> globalNames() const;
+
+            Variable call(parser::FunctionDefNode &function, Arguments arguments);
+
+            const Chunk &getChunk(const parser::FunctionDefNode &function);
+
+            const Closure &getClosure(const parser::FunctionDefNode &function);
 
             parser::FunctionDefNode &getFunction(const std::string &name);
+
+            /**
+             * Parses the function if its body was deferred, and resolves names in it.
+             */
+            void prepareFunction(parser::FunctionDefNode &function);
         };
     }
 }
@@ -0,0 +1,50 @@
+#ifndef INTERPRETER_NATIVE_MODULE_HPP
+#define INTERPRETER_NATIVE_MODULE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "exceptions.hpp"
+#include "variable.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Function of the script compiled to C++. Gets globals of the interpreter, indexed as in bindings of names,
+         * and its arguments.
+         */
+        using NativeFunction = Variable (*)(std::vector<Variable> &globals, Arguments arguments);
+
+        struct NativeFunctionEntry {
+            const char *name;
+            NativeFunction function;
+        };
+
+        /**
+         * Everything shared object built from emitted C++ exports. Globals it was compiled against have to match
+         * globals of the interpreter loading it, as bindings of names are compiled in.
+         */
+        struct NativeModule {
+            std::size_t variableSize;
+            const char *const *globalNames;
+            std::size_t globalCount;
+            const NativeFunctionEntry *functions;
+            std::size_t functionCount;
+        };
+
+        /** Name of the exported module, followed by name of the module given when emitting it. */
+        constexpr const char *NATIVE_MODULE_SYMBOL = "langNativeModule";
+
+        namespace native {
+            /**
+             * Helpers of the emitted code.
+             */
+            inline Variable number(double value) {
+                double numeric[] = {value};
+                return Variable(numeric, 1);
+            }
+        }
+    }
+}
+
+#endif // INTERPRETER_NATIVE_MODULE_HPP
@@ -0,0 +1,170 @@
+#include "resolver.hpp"
+#include "../parser/node-visitor.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            /**
+             * Collects names declared and used in a function body. Templates are not executed,
+             * so names in them are left unresolved.
+             */
+            struct NameCollector : parser::NodeVisitor {
+                std::vector<const parser::IdentifierNode *> declared;
+                std::vector<const parser::IdentifierNode *> used;
+
+                void visit(const parser::ScriptNode &node) override {
+                }
+
+                void visit(const parser::FunctionDefNode &node) override {
+                }
+
+                void visit(const parser::FunctionDefParamsNode &node) override {
+                }
+
+                void visit(const parser::HtmlTemplateNode &node) override {
+                }
+
+                void visit(const parser::AttributeNode &node) override {
+                }
+
+                void visit(const parser::AttributeValueNode &node) override {
+                }
+
+                void visit(const parser::AttributeListNode &node) override {
+                }
+
+                void visit(const parser::TextContentNode &node) override {
+                }
+
+                void visit(const parser::InjectedValueNode &node) override {
+                }
+
+                void visit(const parser::ReturnExpressionNode &node) override {
+                    visitOptional(node.returnValue);
+                }
+
+                void visit(const parser::BlockNode &node) override {
+                    visitOptional(node.value);
+                }
+
+                void visit(const parser::DeclarationExpressionNode &node) override {
+                    declared.push_back(node.identifier.get());
+                    visitOptional(node.value);
+                }
+
+                void visit(const parser::ForExpressionNode &node) override {
+                    visitOptional(node.iterator);
+                    visitOptional(node.condition);
+                    visitOptional(node.expression);
+                    visitOptional(node.block);
+                }
+
+                void visit(const parser::AssignExpressionNode &node) override {
+                    visitOptional(node.variable);
+                    visitOptional(node.value);
+                }
+
+                void visit(const parser::IfExpressionNode &node) override {
+                    visitOptional(node.condition);
+                    visitOptional(node.ifBlock);
+                    visitOptional(node.elseBlock);
+                }
+
+                void visit(const parser::BinaryOperationNode &node) override {
+                    visitOptional(node.left);
+                    visitOptional(node.right);
+                }
+
+                void visit(const parser::UnaryOperationNode &node) override {
+                    visitOptional(node.operand);
+                }
+
+                void visit(const parser::FunctionCallNode &node) override {
+                    visitOptional(node.identifier);
+                    for (auto &argument : node.value)
+                        visitOptional(argument);
+                }
+
+                void visit(const parser::ObjectLiteralNode &node) override {
+                    for (auto &field : node.injection)
+                        visitOptional(field);
+                }
+
+                void visit(const parser::ObjectFieldNode &node) override {
+                    // Identifier of a field names the field, not a variable.
+                    visitOptional(node.expression);
+                }
+
+                void visit(const parser::VariableNode &node) override {
+                    visitOptional(node.identifier);
+                    for (auto &index : node.indices)
+                        visitOptional(index);
+                }
+
+                void visit(const parser::IndexExpressionNode &node) override {
+                    visitOptional(node.value);
+                }
+
+                void visit(const parser::IdentifierNode &node) override {
+                    used.push_back(&node);
+                }
+
+                void visit(const parser::AnyTextNode &node) override {
+                }
+
+                void visit(const parser::StringLiteralNode &node) override {
+                }
+
+                void visit(const parser::NumberLiteralNode &node) override {
+                }
+
+                void visit(const parser::BooleanLiteralNode &node) override {
+                }
+
+            private:
+                template<typename T>
+                void visitOptional(const std::unique_ptr<T> &child) {
+                    if (child)
+                        child->visit(*this);
+                }
+            };
+        }
+
+        void resolveNames(
+                parser::FunctionDefNode &function,
+                const std::unordered_map<std::string, std::uint32_t> &globals
+        ) {
+            using parser::Binding;
+
+            NameCollector collector;
+            if (function.value)
+                function.value->visit(collector);
+
+            std::unordered_map<std::uint32_t, std::uint32_t> slots;
+            auto declare = [&slots](const parser::IdentifierNode &identifier) {
+                const auto slot = static_cast<std::uint32_t>(slots.size());
+                const auto inserted = slots.emplace(identifier.name.getId(), slot).first->second;
+                identifier.binding = Binding{Binding::Kind::LOCAL, inserted};
+            };
+            if (function.params) {
+                for (auto &param : function.params->params)
+                    declare(*param);
+            }
+            for (auto identifier : collector.declared)
+                declare(*identifier);
+            function.frameSize = static_cast<std::uint32_t>(slots.size());
+
+            for (auto identifier : collector.used) {
+                const auto local = slots.find(identifier->name.getId());
+                if (local != slots.end()) {
+                    identifier->binding = Binding{Binding::Kind::LOCAL, local->second};
+                    continue;
+                }
+                const auto global = globals.find(identifier->name.str());
+                identifier->binding = global != globals.end()
+                                      ? Binding{Binding::Kind::GLOBAL, global->second}
+                                      : Binding();
+            }
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef INTERPRETER_RESOLVER_HPP
+#define INTERPRETER_RESOLVER_HPP
+
+#include <string>
+#include <unordered_map>
+#include "../parser/node.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Binds every name used in body of the function to a slot of its call frame, or to a global.
+         * Parameters come first, then names declared with `let`; a name declared anywhere in the body is local
+         * in all of it, as there are no nested scopes. Other names are looked up in globals, and stay unresolved
+         * when they are not there. Sets frameSize of the function.
+         */
+        void resolveNames(
+                parser::FunctionDefNode &function,
+                const std::unordered_map<std::string, std::uint32_t> &globals
+        );
+    }
+}
+
+#endif // INTERPRETER_RESOLVER_HPP
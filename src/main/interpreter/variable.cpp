@@ -4,29 +4,155 @@
 #include <boost/algorithm/string/join.hpp>
 #include <boost/range/adaptor/transformed.hpp>
 #include <cmath>
+#include <memory>
 #include "exceptions.hpp"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 namespace lang {
     namespace interpreter {
         namespace {
+            using Function = std::function<Variable(Arguments)>;
+
+            /**
+             * Characters of a string: prefix of a buffer shared by strings concatenated from each other.
+             * The buffer is only ever appended to, so the prefix never changes.
+             */
+            struct StringSlice {
+                std::shared_ptr<std::string> buffer;
+                std::size_t length;
+
+                const char *data() const {
+                    return buffer->data();
+                }
+
+                bool isTip() const {
+                    return buffer->size() == length;
+                }
+
+                bool equals(const StringSlice &other) const {
+                    return length == other.length && std::equal(data(), data() + length, other.data());
+                }
+            };
+
+            /** Numbers of a vector; only as many are used as its type has. */
+            struct Components {
+                double values[4];
+            };
+
             const std::string variableTypeToStr[] = {
                     "undefined",
                     "number",
                     "string",
                     "boolean",
                     "function",
-                    "array"
+                    "array",
+                    "vec2",
+                    "vec3",
+                    "vec4"
+            };
+
+            std::size_t componentCount(VariableType type) {
+                return static_cast<std::size_t>(type) - static_cast<std::size_t>(VariableType::Vec2) + 2;
+            }
+
+            struct Add {
+                static double apply(double a, double b) { return a + b; }
+#ifdef __SSE2__
+                static __m128d apply(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+#endif
+            };
+
+            struct Subtract {
+                static double apply(double a, double b) { return a - b; }
+#ifdef __SSE2__
+                static __m128d apply(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+#endif
+            };
+
+            struct Multiply {
+                static double apply(double a, double b) { return a * b; }
+#ifdef __SSE2__
+                static __m128d apply(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+#endif
             };
 
-            const std::size_t typeToLen[] = {
-                    0, // undefined
-                    1, // number
-                    0, // string
-                    0, // boolean,
-                    0, // function
-                    0, // array
+            struct Divide {
+                static double apply(double a, double b) { return a / b; }
+#ifdef __SSE2__
+                static __m128d apply(__m128d a, __m128d b) { return _mm_div_pd(a, b); }
+#endif
             };
 
+            /**
+             * Applies OP to the first N components of both vectors, two at a time with SSE2, then one by one,
+             * storing them straight into the result. N is known when compiled, so each length gets only
+             * the instructions it needs.
+             */
+            template<std::size_t N, typename OP>
+            void combine(const double *left, const double *right, double *result) {
+                std::size_t i = 0;
+#ifdef __SSE2__
+                for (; i + 2 <= N; i += 2)
+                    _mm_storeu_pd(result + i, OP::apply(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+#endif
+                for (; i < N; ++i)
+                    result[i] = OP::apply(left[i], right[i]);
+            }
+
+            /**
+             * Freed blocks of vector components of the thread, linked through their first bytes. Vector
+             * arithmetic takes its results from here, so it does not go to the allocator once values are
+             * recycled; at most maxCount blocks are kept.
+             */
+            class ComponentBlocks {
+                struct FreeBlock {
+                    FreeBlock *next;
+                };
+
+                static const std::size_t maxCount = 4096;
+
+                FreeBlock *head = nullptr;
+                std::size_t count = 0;
+
+            public:
+                ComponentBlocks() = default;
+
+                ComponentBlocks(const ComponentBlocks &) = delete;
+
+                ComponentBlocks &operator=(const ComponentBlocks &) = delete;
+
+                ~ComponentBlocks() {
+                    while (head) {
+                        auto next = head->next;
+                        ::operator delete(head);
+                        head = next;
+                    }
+                }
+
+                void *take(std::size_t size) {
+                    if (!head)
+                        return ::operator new(size);
+                    auto block = head;
+                    head = block->next;
+                    --count;
+                    return block;
+                }
+
+                void give(void *block) {
+                    if (count == maxCount) {
+                        ::operator delete(block);
+                        return;
+                    }
+                    head = new(block) FreeBlock{head};
+                    ++count;
+                }
+            };
+
+            thread_local ComponentBlocks componentBlocks;
+
             namespace detail {
 #pragma clang diagnostic push
 #pragma ide diagnostic ignored "InfiniteRecursion"
@@ -50,50 +176,130 @@ namespace lang {
                     throw TypeException("Type " + variableTypeToStr[(int) type] + " is not valid for operation");
                 }
             }
+        }
 
-            template<typename OP>
-            Variable vectorOp(VariableType type, const double first[], const double second[], OP op) {
-                double result[4];
-                const std::size_t len = typeToLen[(int) type];
-                for (std::size_t i = 0; i < len; ++i) {
-                    result[i] = op(first[i], second[i]);
-                }
-                return Variable(result, len);
+        template<typename T>
+        struct Variable::SharedValue : HeapObject {
+            T value;
+
+            explicit SharedValue(T value) : value(std::move(value)) {
+            }
+        };
+
+        /**
+         * Components are left uninitialized, to be written in place, and blocks are recycled by the thread.
+         */
+        template<>
+        struct Variable::SharedValue<Components> : HeapObject {
+            Components value;
+
+            static void *operator new(std::size_t size) {
+                return componentBlocks.take(size);
+            }
+
+            static void operator delete(void *block) {
+                componentBlocks.give(block);
+            }
+        };
+
+        template<typename OP>
+        Variable Variable::combineVectors(VariableType type, const double *left, const double *right) {
+            auto object = new SharedValue<Components>;
+            Variable result(type, object);
+            switch (type) {
+                case VariableType::Vec2:
+                    combine<2, OP>(left, right, object->value.values);
+                    return result;
+
+                case VariableType::Vec3:
+                    combine<3, OP>(left, right, object->value.values);
+                    return result;
+
+                case VariableType::Vec4:
+                    combine<4, OP>(left, right, object->value.values);
+                    return result;
+
+                default:
+                    throw InterpreterFailure();
             }
         }
 
-        Variable::Variable(double *numeric, std::size_t len) {
+        Variable::Variable(double *numeric, std::size_t len) : type(VariableType::Number) {
             assert(numeric);
-            assert(len > 0 && len <= 4);
+            assert(len >= 1 && len <= 4);
 
-            const VariableType typeMap[] = {
-                    VariableType::Undefined,
-                    VariableType::Number,
-            };
+            if (len == 1) {
+                payload.number = numeric[0];
+                return;
+            }
+            type = static_cast<VariableType>(static_cast<std::size_t>(VariableType::Vec2) + len - 2);
+            auto object = new SharedValue<Components>;
+            std::copy(numeric, numeric + len, object->value.values);
+            payload.object = object;
+        }
 
-            type = typeMap[len];
-            std::copy(numeric, numeric + len, this->numeric);
+        Variable::Variable(std::function<Variable(Arguments)> function)
+                : type(VariableType::Function) {
+            payload.object = new SharedValue<Function>(move(function));
         }
 
-        Variable::Variable(std::function<Variable(std::vector<Variable>)> function)
-                : type(VariableType::Function), function(move(function)) {
+        Variable::Variable(std::string string) : type(VariableType::String) {
+            const auto length = string.size();
+            payload.object = new SharedValue<StringSlice>(
+                    StringSlice{std::make_shared<std::string>(move(string)), length});
         }
 
-        Variable::Variable(std::string string) : type(VariableType::String), string(move(string)) {
+        Variable::Variable(std::vector<Variable> array) : type(VariableType::Array) {
+            payload.object = new SharedValue<std::vector<Variable>>(move(array));
         }
 
-        Variable::Variable(std::vector<Variable> array) : type(VariableType::Array), array(move(array)) {
+        Variable::Variable(bool boolean) : type(VariableType::Boolean) {
+            payload.boolean = boolean;
         }
 
-        Variable::Variable(bool boolean) : type(VariableType::Boolean), boolean(boolean) {
+        Variable::Variable(VariableType type, HeapObject *object) : type(type) {
+            payload.object = object;
         }
 
-        Variable::Variable(const Variable &other) noexcept {
-            *this = other;
+        void Variable::destroyHeap() {
+            switch (type) {
+                case VariableType::String:
+                    delete static_cast<SharedValue<StringSlice> *>(payload.object);
+                    break;
+
+                case VariableType::Array:
+                    delete static_cast<SharedValue<std::vector<Variable>> *>(payload.object);
+                    break;
+
+                case VariableType::Function:
+                    delete static_cast<SharedValue<Function> *>(payload.object);
+                    break;
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4:
+                    delete static_cast<SharedValue<Components> *>(payload.object);
+                    break;
+
+                default:
+                    break;
+            }
         }
 
-        Variable::Variable(Variable &&other) noexcept {
-            *this = std::move(other);
+        template<typename T>
+        const T &Variable::heapValue() const {
+            return static_cast<const SharedValue<T> *>(payload.object)->value;
+        }
+
+        template<typename T>
+        T &Variable::uniqueHeapValue() {
+            auto object = static_cast<SharedValue<T> *>(payload.object);
+            if (object->references > 1) {
+                auto copy = new SharedValue<T>(object->value);
+                --object->references;
+                payload.object = object = copy;
+            }
+            return object->value;
         }
 
         VariableType Variable::getType() const {
@@ -103,46 +309,94 @@ namespace lang {
         std::size_t Variable::getNumberAsSize() const {
             if (getType() != VariableType::Number)
                 throw TypeException("expected number");
-            if (ceil(numeric[0]) != numeric[0])
+            if (ceil(payload.number) != payload.number)
                 throw TypeException("expected integer");
-            if (numeric[0] < 0.)
+            if (payload.number < 0.)
                 throw IndexOutOfBoundException("value is lower than zero");
 
-            return (size_t) numeric[0];
+            return (size_t) payload.number;
         }
 
-        Variable Variable::operator()(std::vector<Variable> arguments) const {
+        Variable Variable::operator()(Arguments arguments) const {
             checkIfOneOf(type, VariableType::Function);
-            return function(arguments);
+            // Keeps the function alive while it runs, even if the value is assigned meanwhile.
+            const Variable self = *this;
+            return self.heapValue<Function>()(arguments);
         }
 
         Variable &Variable::getArrayItem(std::size_t index) {
+            static_cast<const Variable *>(this)->getArrayItem(index);
+            return uniqueHeapValue<std::vector<Variable>>()[index];
+        }
+
+        const Variable &Variable::getArrayItem(std::size_t index) const {
             if (getType() != VariableType::Array)
                 throw TypeException("expected array");
-            if (array.size() < index)
+            const auto &array = heapValue<std::vector<Variable>>();
+            if (array.size() <= index)
                 throw IndexOutOfBoundException(std::to_string(index));
 
             return array[index];
         }
 
+        Variable Variable::getItem(std::size_t index) const {
+            switch (type) {
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4: {
+                    if (componentCount(type) <= index)
+                        throw IndexOutOfBoundException(std::to_string(index));
+                    double component[] = {heapValue<Components>().values[index]};
+                    return Variable(component, 1);
+                }
+
+                default:
+                    return getArrayItem(index);
+            }
+        }
+
         Variable::operator bool() const {
             checkIfOneOf(type, VariableType::Boolean);
-            return boolean;
+            return payload.boolean;
         }
 
         Variable Variable::operator+(const Variable &other) const {
             checkSameType(other);
             checkIfOneOf(type,
                          VariableType::Number,
-                         VariableType::String
+                         VariableType::String,
+                         VariableType::Vec2,
+                         VariableType::Vec3,
+                         VariableType::Vec4
             );
 
             switch (type) {
-                case VariableType::Number:
-                    return vectorOp(type, numeric, other.numeric, [](auto a, auto b) { return a + b; });
+                case VariableType::Number: {
+                    double result[] = {payload.number + other.payload.number};
+                    return Variable(result, 1);
+                }
 
-                case VariableType::String:
-                    return Variable(string + other.string);
+                case VariableType::String: {
+                    const auto &left = heapValue<StringSlice>();
+                    const auto &right = other.heapValue<StringSlice>();
+                    if (left.isTip()) {
+                        // Other strings sharing the buffer are its prefixes, so they do not see the new characters.
+                        left.buffer->append(right.data(), right.length);
+                        return Variable(VariableType::String, new SharedValue<StringSlice>(
+                                StringSlice{left.buffer, left.length + right.length}));
+                    }
+                    auto buffer = std::make_shared<std::string>();
+                    buffer->reserve(left.length + right.length);
+                    buffer->append(left.data(), left.length).append(right.data(), right.length);
+                    const auto length = buffer->size();
+                    return Variable(VariableType::String, new SharedValue<StringSlice>(StringSlice{move(buffer), length}));
+                }
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4:
+                    return combineVectors<Add>(type, heapValue<Components>().values,
+                                               other.heapValue<Components>().values);
 
                 default:
                     throw InterpreterFailure();
@@ -151,18 +405,29 @@ namespace lang {
 
         Variable Variable::operator-(const Variable &other) const {
             checkSameType(other);
-            checkIfOneOf(type, VariableType::Number);
+            checkIfOneOf(type, VariableType::Number, VariableType::Vec2, VariableType::Vec3, VariableType::Vec4);
 
-            return (*this) + (-other);
+            if (type == VariableType::Number)
+                return (*this) + (-other);
+            return combineVectors<Subtract>(type, heapValue<Components>().values,
+                                            other.heapValue<Components>().values);
         }
 
         Variable Variable::operator*(const Variable &other) const {
             checkSameType(other);
-            checkIfOneOf(type, VariableType::Number);
+            checkIfOneOf(type, VariableType::Number, VariableType::Vec2, VariableType::Vec3, VariableType::Vec4);
 
             switch (type) {
-                case VariableType::Number:
-                    return vectorOp(type, numeric, other.numeric, [](auto a, auto b) { return a * b; });
+                case VariableType::Number: {
+                    double result[] = {payload.number * other.payload.number};
+                    return Variable(result, 1);
+                }
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4:
+                    return combineVectors<Multiply>(type, heapValue<Components>().values,
+                                              other.heapValue<Components>().values);
 
                 default:
                     throw InterpreterFailure();
@@ -171,11 +436,19 @@ namespace lang {
 
         Variable Variable::operator/(const Variable &other) const {
             checkSameType(other);
-            checkIfOneOf(type, VariableType::Number);
+            checkIfOneOf(type, VariableType::Number, VariableType::Vec2, VariableType::Vec3, VariableType::Vec4);
 
             switch (type) {
-                case VariableType::Number:
-                    return vectorOp(type, numeric, other.numeric, [](auto a, auto b) { return a / b; });
+                case VariableType::Number: {
+                    double result[] = {payload.number / other.payload.number};
+                    return Variable(result, 1);
+                }
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4:
+                    return combineVectors<Divide>(type, heapValue<Components>().values,
+                                              other.heapValue<Components>().values);
 
                 default:
                     throw InterpreterFailure();
@@ -183,12 +456,19 @@ namespace lang {
         }
 
         Variable Variable::operator-() const {
-            checkIfOneOf(type, VariableType::Number);
+            checkIfOneOf(type, VariableType::Number, VariableType::Vec2, VariableType::Vec3, VariableType::Vec4);
 
             switch (type) {
                 case VariableType::Number: {
-                    double result[1] = {-numeric[0]};
-                    return Variable(result, typeToLen[(int) type]);
+                    double result[] = {-payload.number};
+                    return Variable(result, 1);
+                }
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4: {
+                    const Components zero{};
+                    return combineVectors<Subtract>(type, zero.values, heapValue<Components>().values);
                 }
 
                 default:
@@ -198,7 +478,7 @@ namespace lang {
 
         Variable Variable::operator!() const {
             checkIfOneOf(type, VariableType::Boolean);
-            return !boolean;
+            return !payload.boolean;
         }
 
         Variable Variable::operator==(const Variable &other) const {
@@ -207,22 +487,31 @@ namespace lang {
 
 
             switch (type) {
-                case VariableType::Number: {
-                    const std::size_t len = typeToLen[(int) type];
-                    return std::equal(numeric, numeric + len, other.numeric, other.numeric + len);
-                }
+                case VariableType::Number:
+                    return payload.number == other.payload.number;
 
                 case VariableType::String:
-                    return string == other.string;
+                    return payload.object == other.payload.object
+                           || heapValue<StringSlice>().equals(other.heapValue<StringSlice>());
 
                 case VariableType::Boolean:
-                    return boolean == other.boolean;
+                    return payload.boolean == other.payload.boolean;
 
                 case VariableType::Function:
                     return false;
 
                 case VariableType::Array: {
-                    return std::equal(array.begin(), array.end(), other.array.begin(), other.array.end());
+                    const auto &array = heapValue<std::vector<Variable>>();
+                    const auto &otherArray = other.heapValue<std::vector<Variable>>();
+                    return std::equal(array.begin(), array.end(), otherArray.begin(), otherArray.end());
+                }
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4: {
+                    const auto &components = heapValue<Components>().values;
+                    return std::equal(components, components + componentCount(type),
+                                      other.heapValue<Components>().values);
                 }
 
                 default:
@@ -269,20 +558,30 @@ namespace lang {
                     return "undefined";
 
                 case VariableType::Number:
-                    return std::to_string(numeric[0]);
+                    return std::to_string(payload.number);
 
                 case VariableType::Boolean:
-                    return boolean ? "true" : "false";
+                    return payload.boolean ? "true" : "false";
 
                 case VariableType::Function:
                     return "function";
 
                 case VariableType::Array: {
-                    return "[" + join(array | transformed(bind(&Variable::toString, _1)), ", ") + "]";
+                    return "[" + join(heapValue<std::vector<Variable>>() | transformed(bind(&Variable::toString, _1)), ", ") + "]";
                 }
 
                 case VariableType::String:
-                    return string;
+                    return std::string(heapValue<StringSlice>().data(), heapValue<StringSlice>().length);
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4: {
+                    const auto &components = heapValue<Components>().values;
+                    std::string text = variableTypeToStr[(int) type] + "(";
+                    for (std::size_t i = 0; i < componentCount(type); ++i)
+                        text += (i ? ", " : "") + std::to_string(components[i]);
+                    return text + ")";
+                }
 
                 default:
                     throw InterpreterFailure();
@@ -291,10 +590,11 @@ namespace lang {
 
         template<typename OP>
         Variable Variable::compareRelation(const Variable &other, OP op) const {
+            checkSameType(other);
             checkIfOneOf(type, VariableType::Number);
             switch (type) {
                 case VariableType::Number:
-                    return op(numeric[0], other.numeric[0]);
+                    return op(payload.number, other.payload.number);
 
                 default:
                     throw InterpreterFailure();
@@ -303,18 +603,29 @@ namespace lang {
 
         double Variable::getNumeric() const {
             checkIfOneOf(type, VariableType::Number);
-            return numeric[0];
+            return payload.number;
         }
 
         std::size_t Variable::getLength() const {
-            checkIfOneOf(type, VariableType::String, VariableType::Array);
+            checkIfOneOf(type,
+                         VariableType::String,
+                         VariableType::Array,
+                         VariableType::Vec2,
+                         VariableType::Vec3,
+                         VariableType::Vec4
+            );
 
             switch (type) {
                 case VariableType::String:
-                    return string.length();
+                    return heapValue<StringSlice>().length;
 
                 case VariableType::Array:
-                    return array.size();
+                    return heapValue<std::vector<Variable>>().size();
+
+                case VariableType::Vec2:
+                case VariableType::Vec3:
+                case VariableType::Vec4:
+                    return componentCount(type);
 
                 default:
                     throw InterpreterFailure();
@@ -323,69 +634,7 @@ namespace lang {
 
         std::vector<Variable> &Variable::getArray() {
             checkIfOneOf(type, VariableType::Array);
-            return array;
-        }
-
-        Variable &Variable::operator=(const Variable &other) noexcept {
-            if (this == &other)
-                return *this;
-
-            type = other.type;
-            switch (other.type) {
-                case VariableType::Number:
-                    std::copy(other.numeric, other.numeric, numeric);
-                    return *this;
-
-                case VariableType::String:
-                    string = other.string;
-                    return *this;
-
-                case VariableType::Boolean:
-                    boolean = other.boolean;
-                    return *this;
-
-                case VariableType::Function:
-                    function = other.function;
-                    return *this;
-
-                case VariableType::Array:
-                    array = other.array;
-                    return *this;
-
-                default:
-                    return *this;
-            }
-        }
-
-        Variable &Variable::operator=(Variable &&other) noexcept {
-            if (this == &other)
-                return *this;
-
-            type = other.type;
-            switch (other.type) {
-                case VariableType::Number:
-                    std::copy(other.numeric, other.numeric, numeric);
-                    return *this;
-
-                case VariableType::String:
-                    string = std::move(other.string);
-                    return *this;
-
-                case VariableType::Boolean:
-                    boolean = other.boolean;
-                    return *this;
-
-                case VariableType::Function:
-                    function = std::move(other.function);
-                    return *this;
-
-                case VariableType::Array:
-                    array = std::move(other.array);
-                    return *this;
-
-                default:
-                    return *this;
-            };
+            return uniqueHeapValue<std::vector<Variable>>();
         }
     }
 }
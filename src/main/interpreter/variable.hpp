@@ -2,6 +2,8 @@
 #define INTERPRETER_VARIABLE_HPP
 
 #include <functional>
+#include <iterator>
+#include <string>
 #include <vector>
 
 namespace lang {
@@ -13,24 +15,51 @@ namespace lang {
             String,
             Boolean,
             Function,
-            Array
+            Array,
+            Vec2,
+            Vec3,
+            Vec4
         };
 
+        class Arguments;
+
+        /**
+         * Value of the script: a type tag and an 8 byte payload. Numbers and booleans are stored in place
+         * and copied as they are. Strings, arrays and functions live on the heap, shared by all copies
+         * of the value and counted; an array is copied only when it is changed while shared, so values
+         * behave as if every copy was a deep one. A string is a prefix of a buffer, which concatenation
+         * extends in place when the string ends where the buffer does, so building a string piece by piece
+         * takes linear time. Vectors of two to four numbers are stored on the heap as well, and never change;
+         * their blocks are recycled, so arithmetic on vectors does not allocate.
+         * Reference counts are not atomic, values must not be shared between threads.
+         */
         class Variable {
+            /** Header of every value on the heap. */
+            struct HeapObject {
+                std::size_t references = 1;
+            };
+
+            /** Value of type T on the heap. */
+            template<typename T>
+            struct SharedValue;
+
             VariableType type = VariableType::Undefined;
 
-            double numeric[4];
-            std::function<Variable(std::vector<Variable>)> function;
-            std::string string;
-            std::vector<Variable> array;
-            bool boolean;
+            union Payload {
+                double number;
+                bool boolean;
+                HeapObject *object;
+            } payload{};
 
         public:
             Variable() = default;
 
+            /**
+             * Number for a single value, vector of len numbers for two to four values.
+             */
             Variable(double numeric[], std::size_t len);
 
-            Variable(std::function<Variable(std::vector<Variable>)> function);
+            explicit Variable(std::function<Variable(Arguments)> function);
 
             Variable(std::string string);
 
@@ -42,15 +71,27 @@ namespace lang {
 
             Variable(Variable &&other) noexcept;
 
+            ~Variable();
+
             operator bool() const;
 
             VariableType getType() const;
 
+            /**
+             * Item of the array to be changed, which is first copied if the array is shared.
+             */
             Variable &getArrayItem(std::size_t index);
 
+            const Variable &getArrayItem(std::size_t index) const;
+
+            /**
+             * Item of the array or component of the vector, as a number.
+             */
+            Variable getItem(std::size_t index) const;
+
             std::size_t getNumberAsSize() const;
 
-            Variable operator()(std::vector<Variable> arguments) const;
+            Variable operator()(Arguments arguments) const;
 
             Variable operator+(const Variable &other) const;
 
@@ -82,6 +123,9 @@ namespace lang {
 
             std::size_t getLength() const;
 
+            /**
+             * Items of the array to be changed, which are first copied if the array is shared.
+             */
             std::vector<Variable> &getArray();
 
             Variable &operator=(const Variable &other) noexcept;
@@ -89,10 +133,147 @@ namespace lang {
             Variable &operator=(Variable &&other) noexcept;
 
         private:
+            Variable(VariableType type, HeapObject *object);
+
+            bool isOnHeap() const;
+
+            void release();
+
+            void destroyHeap();
+
+            template<typename T>
+            const T &heapValue() const;
+
+            template<typename T>
+            T &uniqueHeapValue();
+
             void checkSameType(const Variable &other) const;
 
             template<typename OP>
             Variable compareRelation(const Variable &other, OP op) const;
+
+            /**
+             * Vector of the type holding OP applied to the components of both vectors.
+             */
+            template<typename OP>
+            static Variable combineVectors(VariableType type, const double *left, const double *right);
+        };
+
+        // Copies and moves are inline, so that numbers and booleans are copied without a call
+        // and other values only update their reference count.
+
+        inline bool Variable::isOnHeap() const {
+            return type != VariableType::Undefined && type != VariableType::Number && type != VariableType::Boolean;
+        }
+
+        inline void Variable::release() {
+            if (--payload.object->references == 0)
+                destroyHeap();
+        }
+
+        inline Variable::Variable(const Variable &other) noexcept : type(other.type), payload(other.payload) {
+            if (isOnHeap())
+                ++payload.object->references;
+        }
+
+        inline Variable::Variable(Variable &&other) noexcept : type(other.type), payload(other.payload) {
+            if (isOnHeap())
+                other.type = VariableType::Undefined;
+        }
+
+        inline Variable::~Variable() {
+            if (isOnHeap())
+                release();
+        }
+
+        inline Variable &Variable::operator=(const Variable &other) noexcept {
+            // The other value may be an item of this one, so it is counted before this one is released.
+            const auto otherType = other.type;
+            const auto otherPayload = other.payload;
+            if (other.isOnHeap())
+                ++otherPayload.object->references;
+            if (isOnHeap())
+                release();
+            type = otherType;
+            payload = otherPayload;
+            return *this;
+        }
+
+        inline Variable &Variable::operator=(Variable &&other) noexcept {
+            if (this == &other)
+                return *this;
+
+            const auto otherType = other.type;
+            const auto otherPayload = other.payload;
+            if (other.isOnHeap())
+                other.type = VariableType::Undefined;
+            if (isOnHeap())
+                release();
+            type = otherType;
+            payload = otherPayload;
+            return *this;
+        }
+
+        /**
+         * Arguments of a call: a span over values owned by the caller, which the callee may move from.
+         * Only valid until the call returns.
+         */
+        class Arguments {
+            Variable *first = nullptr;
+            std::size_t count = 0;
+
+        public:
+            Arguments() = default;
+
+            Arguments(Variable *first, std::size_t count) : first(first), count(count) {
+            }
+
+            Arguments(std::vector<Variable> &values) : first(values.data()), count(values.size()) {
+            }
+
+            std::size_t size() const {
+                return count;
+            }
+
+            Variable *begin() const {
+                return first;
+            }
+
+            Variable *end() const {
+                return first + count;
+            }
+
+            Variable &operator[](std::size_t index) const {
+                return first[index];
+            }
+        };
+
+        /**
+         * Arguments built by the caller before a call. Up to four of them are stored in place,
+         * so that calls with few arguments do not allocate.
+         */
+        class ArgumentList {
+            static constexpr std::size_t INLINE_COUNT = 4;
+
+            Variable inlineValues[INLINE_COUNT];
+            std::vector<Variable> values;
+            std::size_t count = 0;
+
+        public:
+            void push(Variable value) {
+                if (count < INLINE_COUNT) {
+                    inlineValues[count++] = std::move(value);
+                    return;
+                }
+                if (count == INLINE_COUNT)
+                    values.assign(std::make_move_iterator(inlineValues), std::make_move_iterator(inlineValues + count));
+                values.push_back(std::move(value));
+                ++count;
+            }
+
+            Arguments arguments() {
+                return count <= INLINE_COUNT ? Arguments(inlineValues, count) : Arguments(values);
+            }
         };
     }
 }
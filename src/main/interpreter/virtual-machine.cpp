@@ -0,0 +1,156 @@
+#include "virtual-machine.hpp"
+#include <cassert>
+#include <iterator>
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            inline const Variable &left(
+                    const Instruction &instruction,
+                    const Chunk &chunk,
+                    const std::vector<Variable> &registers,
+                    const Variable &acc
+            ) {
+                if (instruction.a & OperandFlags::LEFT_ACCUMULATOR)
+                    return acc;
+                return instruction.a & OperandFlags::LEFT_CONSTANT ? chunk.constants[instruction.b]
+                                                                   : registers[instruction.b];
+            }
+
+            inline const Variable &right(
+                    const Instruction &instruction,
+                    const Chunk &chunk,
+                    const std::vector<Variable> &registers,
+                    const Variable &acc
+            ) {
+                if (!(instruction.a & OperandFlags::RIGHT_OPERAND))
+                    return acc;
+                return instruction.a & OperandFlags::RIGHT_CONSTANT ? chunk.constants[instruction.c]
+                                                                    : registers[instruction.c];
+            }
+        }
+
+        Variable runChunk(const Chunk &chunk, std::vector<Variable> &globals, std::vector<Variable> &registers) {
+            assert(registers.size() >= chunk.registerCount);
+
+            Variable acc;
+            Variable unresolved;
+            std::vector<Variable *> refs(chunk.refCount);
+            const Instruction *const code = chunk.code.data();
+            const Instruction *ip = code;
+
+            for (;;) {
+                const Instruction &instruction = *ip++;
+                switch (instruction.op) {
+                    case OpCode::LOAD_CONSTANT:
+                        acc = chunk.constants[instruction.b];
+                        break;
+                    case OpCode::LOAD_UNDEFINED:
+                        acc = Variable();
+                        break;
+                    case OpCode::LOAD_REGISTER:
+                        acc = registers[instruction.b];
+                        break;
+                    case OpCode::LOAD_GLOBAL:
+                        acc = globals[instruction.b];
+                        break;
+                    case OpCode::STORE_REGISTER:
+                        registers[instruction.a] = acc;
+                        break;
+                    case OpCode::MOVE_REGISTER:
+                        registers[instruction.a] = std::move(acc);
+                        break;
+                    case OpCode::STORE_GLOBAL:
+                        globals[instruction.b] = acc;
+                        break;
+
+                    case OpCode::REF_REGISTER:
+                        refs[instruction.a] = &registers[instruction.b];
+                        break;
+                    case OpCode::REF_GLOBAL:
+                        refs[instruction.a] = &globals[instruction.b];
+                        break;
+                    case OpCode::REF_UNRESOLVED:
+                        unresolved = Variable();
+                        refs[instruction.a] = &unresolved;
+                        break;
+                    case OpCode::REF_ELEMENT:
+                        refs[instruction.a] = &refs[instruction.a]->getArrayItem(acc.getNumberAsSize());
+                        break;
+                    case OpCode::STORE_REF:
+                        *refs[instruction.a] = registers[instruction.b];
+                        break;
+
+                    case OpCode::ELEMENT:
+                        acc = registers[instruction.b].getItem(acc.getNumberAsSize());
+                        break;
+                    case OpCode::ELEMENT_INTO:
+                        registers[instruction.b] = registers[instruction.b].getItem(acc.getNumberAsSize());
+                        break;
+
+                    case OpCode::EQUAL:
+                        acc = left(instruction, chunk, registers, acc) == right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::NOT_EQUAL:
+                        acc = left(instruction, chunk, registers, acc) != right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::LESS:
+                        acc = left(instruction, chunk, registers, acc) < right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::GREATER:
+                        acc = left(instruction, chunk, registers, acc) > right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::LESS_EQUAL:
+                        acc = left(instruction, chunk, registers, acc) <= right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::GREATER_EQUAL:
+                        acc = left(instruction, chunk, registers, acc) >= right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::ADD:
+                        acc = left(instruction, chunk, registers, acc) + right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::SUBTRACT:
+                        acc = left(instruction, chunk, registers, acc) - right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::MULTIPLY:
+                        acc = left(instruction, chunk, registers, acc) * right(instruction, chunk, registers, acc);
+                        break;
+                    case OpCode::DIVIDE:
+                        acc = left(instruction, chunk, registers, acc) / right(instruction, chunk, registers, acc);
+                        break;
+
+                    case OpCode::NEGATE:
+                        acc = -acc;
+                        break;
+                    case OpCode::NOT:
+                        acc = !acc;
+                        break;
+
+                    case OpCode::JUMP:
+                        ip = code + instruction.b;
+                        break;
+                    case OpCode::JUMP_IF_FALSE:
+                        if (!static_cast<bool>(acc))
+                            ip = code + instruction.b;
+                        break;
+                    case OpCode::JUMP_IF_TRUE:
+                        if (acc)
+                            ip = code + instruction.b;
+                        break;
+
+                    // Arguments are passed in place, the callee may move them out of the registers.
+                    case OpCode::CALL:
+                        acc = acc(Arguments(registers.data() + instruction.b, instruction.c));
+                        break;
+
+                    case OpCode::CALL_GLOBAL:
+                        acc = globals[instruction.c](Arguments(registers.data() + instruction.b, instruction.a));
+                        break;
+
+                    case OpCode::RETURN:
+                        return acc;
+                }
+            }
+        }
+    }
+}
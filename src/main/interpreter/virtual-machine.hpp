@@ -0,0 +1,18 @@
+#ifndef INTERPRETER_VIRTUAL_MACHINE_HPP
+#define INTERPRETER_VIRTUAL_MACHINE_HPP
+
+#include <vector>
+#include "bytecode.hpp"
+
+namespace lang {
+    namespace interpreter {
+        /**
+         * Executes compiled function.
+         * @param registers registerCount of the chunk registers, with arguments in slots of parameters
+         * @return Value of the accumulator when the function ends.
+         */
+        Variable runChunk(const Chunk &chunk, std::vector<Variable> &globals, std::vector<Variable> &registers);
+    }
+}
+
+#endif // INTERPRETER_VIRTUAL_MACHINE_HPP
@@ -1,8 +1,10 @@
 #ifndef LEXER_LEXEME_HPP
 #define LEXER_LEXEME_HPP
 
+#include <boost/utility/string_view.hpp>
 #include <cassert>
 #include <string>
+#include "symbol.hpp"
 
 namespace lang {
     namespace lexer {
@@ -49,12 +51,21 @@ namespace lang {
             IDENTIFIER,
             STRING,
             NUMBER,
+
+            /** Maximal run of static text inside of a template body. */
+            TEXT,
         };
 
+        /**
+         * Lexeme text is a view into the source buffer of the lexer, so it is valid as long as the lexer is.
+         * Identifiers and keywords additionally carry their interned symbol, numbers carry their decoded value.
+         */
         struct Lexeme {
             LexemeType type;
-            std::string text;
+            boost::string_view text;
             int line;
+            Symbol symbol;
+            double number;
         };
     }
 }
@@ -1,27 +1,97 @@
 #include "lexer.hpp"
+#include <algorithm>
+#include "../util/decimal-parser.hpp"
 
 namespace lang {
     namespace lexer {
-        Lexer *Lexer::instance = nullptr;
+        namespace {
+            const std::size_t readChunkSize = 64 * 1024;
 
-        Lexer::Lexer(util::OutputStream<char> &input) : input(input) {
-            assert(instance == nullptr);
-            instance = this;
+            // Flex expects two end-of-buffer characters after scanned content.
+            const std::size_t paddingSize = 2;
+
+            // Rough guess used to reserve token storage up front.
+            const std::size_t averageLexemeSize = 4;
+        }
+
+        Lexer::Lexer(util::OutputStream<char> &input, std::shared_ptr<SymbolTable> symbols)
+                : symbols(move(symbols)) {
+            std::size_t size = 0;
+            do {
+                ownedSource.resize(size + readChunkSize);
+                size += input.read(ownedSource.data() + size, readChunkSize);
+            } while (size == ownedSource.size());
+
+            ownedSource.resize(size);
+            ownedSource.resize(size + paddingSize, '\0');
+            scanBuffer = ownedSource.data();
+            scanBufferSize = size;
+        }
+
+        Lexer::Lexer(util::MmapInputStream &input, std::shared_ptr<SymbolTable> symbols)
+                : symbols(move(symbols)), scanBuffer(input.data()), scanBufferSize(input.size()) {
+        }
+
+        Lexer::Lexer(boost::string_view source, int firstLine, std::shared_ptr<SymbolTable> symbols)
+                : symbols(move(symbols)), currentLine(firstLine) {
+            ownedSource.reserve(source.size() + paddingSize);
+            ownedSource.assign(source.begin(), source.end());
+            ownedSource.resize(source.size() + paddingSize, '\0');
+            scanBuffer = ownedSource.data();
+            scanBufferSize = source.size();
         }
 
         Lexer::~Lexer() {
-            instance = nullptr;
+            endScanning();
         }
 
-        int Lexer::getInput(char *buffer, int maxRead) {
-            int count = 0;
-            while (count < maxRead && instance->input.take(buffer[count]))
-                ++count;
-            return count;
+        TokenArray Lexer::tokenize() {
+            TokenArray tokens;
+            tokens.source = getSource();
+            tokens.symbolTable = symbols;
+            tokens.reserve(scanBufferSize / averageLexemeSize);
+
+            Lexeme lexeme;
+            while (take(lexeme))
+                tokens.push(lexeme);
+            return tokens;
+        }
+
+        const std::shared_ptr<SymbolTable> &Lexer::getSymbols() const {
+            return symbols;
+        }
+
+        boost::string_view Lexer::getSource() const {
+            return boost::string_view(scanBuffer, scanBufferSize);
         }
 
         void Lexer::incrementLine() {
-            ++instance->currentLine;
+            ++currentLine;
+        }
+
+        bool Lexer::opensTemplate() const {
+            return functionHeaderLength == 2;
+        }
+
+        void Lexer::afterLexeme(Lexeme &lexeme) {
+            switch (lexeme.type) {
+                case LexemeType::NUMBER:
+                    lexeme.number = util::parseDecimal(lexeme.text);
+                    functionHeaderLength = 0;
+                    break;
+                case LexemeType::TEXT:
+                    currentLine += static_cast<int>(std::count(lexeme.text.begin(), lexeme.text.end(), '\n'));
+                    functionHeaderLength = 0;
+                    break;
+                case LexemeType::FUNCTION:
+                    functionHeaderLength = 1;
+                    break;
+                case LexemeType::IDENTIFIER:
+                    functionHeaderLength = functionHeaderLength == 1 ? 2 : 0;
+                    break;
+                default:
+                    functionHeaderLength = 0;
+            }
         }
     }
-}
\ No newline at end of file
+}
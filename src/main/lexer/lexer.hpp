@@ -1,38 +1,105 @@
 #ifndef LEXER_LEXER_HPP
 #define LEXER_LEXER_HPP
 
+#include <memory>
+#include <vector>
 #include "../util/output-stream.hpp"
+#include "../util/mmap-input-stream.hpp"
 #include "lexeme.hpp"
+#include "symbol-table.hpp"
+#include "token-array.hpp"
 
 namespace lang {
     namespace lexer {
+        /**
+         * Flex based lexer, also base of alternative scanners sharing its input handling.
+         * Each instance owns its own scanner state, so lexers may run concurrently on separate threads.
+         * Whole input is kept in one stable buffer, which texts of returned lexemes point into.
+         */
         class Lexer : public util::OutputStream<Lexeme> {
-            static Lexer *instance;
-
-            util::OutputStream<char> &input;
+        protected:
+            std::shared_ptr<SymbolTable> symbols;
+            std::vector<char> ownedSource;
+            char *scanBuffer = nullptr;
+            std::size_t scanBufferSize = 0;
             int currentLine = 1;
 
+        private:
+            void *scanner = nullptr;
+
+            /** How many lexemes of `function Name` were just seen, a template body may follow them. */
+            int functionHeaderLength = 0;
+
         public:
-            explicit Lexer(util::OutputStream<char> &input);
+            /**
+             * Reads whole input into buffer owned by the lexer.
+             */
+            explicit Lexer(
+                    util::OutputStream<char> &input,
+                    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>()
+            );
+
+            /**
+             * Scans mapped file in place, without copying it into the scanner buffer.
+             */
+            explicit Lexer(
+                    util::MmapInputStream &input,
+                    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>()
+            );
+
+            /**
+             * Copies part of a larger source into buffer owned by the lexer, counting lines from firstLine.
+             */
+            Lexer(
+                    boost::string_view source,
+                    int firstLine,
+                    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>()
+            );
 
             virtual ~Lexer();
 
+            Lexer(const Lexer &) = delete;
+
+            Lexer &operator=(const Lexer &) = delete;
+
             bool take(Lexeme &out) override;
 
             /**
-             * Reads specified number of characters from input stream of current Lexer instance.
-             *
-             * @param buffer Output buffer.
-             * @param maxRead Buffer size.
-             * @return Number of characters read.
+             * Lexes all remaining input at once.
+             */
+            TokenArray tokenize();
+
+            const std::shared_ptr<SymbolTable> &getSymbols() const;
+
+            boost::string_view getSource() const;
+
+            /**
              * @remarks For internal use in flex file.
              */
-            static int getInput(char *buffer, int maxRead);
+            void incrementLine();
 
             /**
+             * Whether the bracket being scanned opens a template body.
              * @remarks For internal use in flex file.
              */
-            static void incrementLine();
+            bool opensTemplate() const;
+
+        protected:
+            /**
+             * Updates line counter and template detection after a lexeme was scanned, decodes numbers.
+             */
+            void afterLexeme(Lexeme &lexeme);
+
+        private:
+            /**
+             * @remarks Defined in flex file.
+             */
+            void beginScanning();
+
+            /**
+             * @remarks Defined in flex file.
+             */
+            void endScanning();
         };
     }
 }
@@ -0,0 +1,91 @@
+#include "pipelined-lexer.hpp"
+#include <algorithm>
+
+namespace lang {
+    namespace lexer {
+        const std::size_t PipelinedLexer::batchSize;
+        const std::size_t PipelinedLexer::queueCapacity;
+
+        PipelinedLexer::PipelinedLexer(Lexer &lexer) : lexer(lexer) {
+            producer = std::thread(&PipelinedLexer::produce, this);
+        }
+
+        PipelinedLexer::~PipelinedLexer() {
+            stopping.store(true, std::memory_order_relaxed);
+            producer.join();
+        }
+
+        bool PipelinedLexer::take(Lexeme &out) {
+            if (position == current.size() && !nextBatch())
+                return false;
+            out = current[position++];
+            return true;
+        }
+
+        std::size_t PipelinedLexer::read(Lexeme *buffer, std::size_t maxRead) {
+            std::size_t count = 0;
+            while (count < maxRead) {
+                if (position == current.size() && !nextBatch())
+                    break;
+                const auto chunk = std::min(maxRead - count, current.size() - position);
+                std::copy_n(current.begin() + position, chunk, buffer + count);
+                position += chunk;
+                count += chunk;
+            }
+            return count;
+        }
+
+        const std::shared_ptr<SymbolTable> &PipelinedLexer::getSymbols() const {
+            return lexer.getSymbols();
+        }
+
+        void PipelinedLexer::produce() {
+            Batch batch;
+            try {
+                for (;;) {
+                    if (!recycled.tryPop(batch))
+                        batch.clear();
+                    batch.resize(batchSize);
+                    batch.resize(lexer.read(batch.data(), batchSize));
+
+                    const bool last = batch.empty();
+                    if (!publish(batch) || last)
+                        return;
+                }
+            } catch (...) {
+                failure = std::current_exception();
+                Batch end;
+                publish(end);
+            }
+        }
+
+        bool PipelinedLexer::publish(Batch &batch) {
+            while (!filled.tryPush(batch)) {
+                if (stopping.load(std::memory_order_relaxed))
+                    return false;
+                std::this_thread::yield();
+            }
+            return true;
+        }
+
+        bool PipelinedLexer::nextBatch() {
+            if (finished)
+                return false;
+
+            if (!current.empty())
+                recycled.tryPush(current);
+            position = 0;
+
+            while (!filled.tryPop(current))
+                std::this_thread::yield();
+
+            if (current.empty()) {
+                finished = true;
+                if (failure)
+                    std::rethrow_exception(failure);
+                return false;
+            }
+            return true;
+        }
+    }
+}
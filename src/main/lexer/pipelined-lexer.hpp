@@ -0,0 +1,72 @@
+#ifndef LEXER_PIPELINED_LEXER_HPP
+#define LEXER_PIPELINED_LEXER_HPP
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "../util/output-stream.hpp"
+#include "../util/spsc-queue.hpp"
+#include "lexer.hpp"
+
+namespace lang {
+    namespace lexer {
+        /**
+         * Runs given lexer on its own thread, handing lexemes over in batches, so lexing overlaps
+         * with whatever consumes the stream. Lexer must not be used by anyone else meanwhile.
+         * Symbols stay valid across threads, as the symbol table never moves interned names.
+         */
+        class PipelinedLexer : public util::OutputStream<Lexeme> {
+            static const std::size_t batchSize = 1024;
+            static const std::size_t queueCapacity = 64;
+
+            using Batch = std::vector<Lexeme>;
+
+            Lexer &lexer;
+            util::SpscQueue<Batch, queueCapacity> filled;
+            util::SpscQueue<Batch, queueCapacity> recycled;
+            std::atomic<bool> stopping{false};
+            std::exception_ptr failure;
+            std::thread producer;
+
+            Batch current;
+            std::size_t position = 0;
+            bool finished = false;
+
+        public:
+            explicit PipelinedLexer(Lexer &lexer);
+
+            /**
+             * Stops the producer, even if not all input was consumed.
+             */
+            virtual ~PipelinedLexer();
+
+            PipelinedLexer(const PipelinedLexer &) = delete;
+
+            PipelinedLexer &operator=(const PipelinedLexer &) = delete;
+
+            bool take(Lexeme &out) override;
+
+            std::size_t read(Lexeme *buffer, std::size_t maxRead) override;
+
+            const std::shared_ptr<SymbolTable> &getSymbols() const;
+
+        private:
+            void produce();
+
+            /**
+             * Waits for free space in the queue, unless consumer is gone.
+             * @return False if the producer should stop.
+             */
+            bool publish(Batch &batch);
+
+            /**
+             * Waits for next batch; empty batch marks end of input.
+             * @return False at the end of input.
+             */
+            bool nextBatch();
+        };
+    }
+}
+
+#endif // LEXER_PIPELINED_LEXER_HPP
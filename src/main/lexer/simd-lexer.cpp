@@ -0,0 +1,450 @@
+#include "simd-lexer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace lang {
+    namespace lexer {
+        namespace {
+            const std::ptrdiff_t blockSize = 16;
+
+#ifdef __SSE2__
+            inline __m128i inRange(__m128i block, char low, char high) {
+                // Signed comparison, bytes above 0x7f are negative and never fall into ASCII ranges.
+                return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8(static_cast<char>(low - 1))),
+                                     _mm_cmplt_epi8(block, _mm_set1_epi8(static_cast<char>(high + 1))));
+            }
+
+            inline __m128i equal(__m128i block, char c) {
+                return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+            }
+#endif
+
+            struct Digit {
+                static bool match(char c) {
+                    return c >= '0' && c <= '9';
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    return inRange(block, '0', '9');
+                }
+#endif
+            };
+
+            struct Letter {
+                static bool match(char c) {
+                    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+                }
+            };
+
+            struct LetterOrDigit {
+                static bool match(char c) {
+                    return Letter::match(c) || Digit::match(c);
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    return _mm_or_si128(_mm_or_si128(inRange(block, 'a', 'z'), inRange(block, 'A', 'Z')),
+                                        inRange(block, '0', '9'));
+                }
+#endif
+            };
+
+            struct Blank {
+                static bool match(char c) {
+                    return c == ' ' || c == '\t' || c == '\n';
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    return _mm_or_si128(_mm_or_si128(equal(block, ' '), equal(block, '\t')), equal(block, '\n'));
+                }
+#endif
+            };
+
+            struct TemplateBlank {
+                static bool match(char c) {
+                    return Blank::match(c) || c == '\r';
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    return _mm_or_si128(Blank::match(block), equal(block, '\r'));
+                }
+#endif
+            };
+
+            /**
+             * Character of static template text, anything but blanks, tags, brackets and braces.
+             */
+            struct TextChar {
+                static bool match(char c) {
+                    return !TemplateBlank::match(c) && c != '<' && c != ']' && c != '{';
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    const __m128i special = _mm_or_si128(
+                            _mm_or_si128(TemplateBlank::match(block), equal(block, '<')),
+                            _mm_or_si128(equal(block, ']'), equal(block, '{')));
+                    return _mm_andnot_si128(special, _mm_set1_epi8(-1));
+                }
+#endif
+            };
+
+            /**
+             * Character of string literal which needs no attention, anything but quote and backslash.
+             */
+            struct StringChar {
+                static bool match(char c) {
+                    return c != '"' && c != '\\';
+                }
+
+#ifdef __SSE2__
+                static __m128i match(__m128i block) {
+                    const __m128i special = _mm_or_si128(equal(block, '"'), equal(block, '\\'));
+                    return _mm_andnot_si128(special, _mm_set1_epi8(-1));
+                }
+#endif
+            };
+
+            /**
+             * @return First position in [p, end) with character not belonging to given class.
+             */
+            template<typename Class>
+            const char *skip(const char *p, const char *end) {
+#ifdef __SSE2__
+                while (end - p >= blockSize) {
+                    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+                    const auto mismatch = ~static_cast<unsigned>(_mm_movemask_epi8(Class::match(block))) & 0xFFFFu;
+                    if (mismatch)
+                        return p + __builtin_ctz(mismatch);
+                    p += blockSize;
+                }
+#endif
+                while (p < end && Class::match(*p))
+                    ++p;
+                return p;
+            }
+
+            /**
+             * @return Position after closing quote of string starting at p, or nullptr if it is not terminated.
+             */
+            const char *findStringEnd(const char *p, const char *end) {
+                ++p;
+                for (;;) {
+                    p = skip<StringChar>(p, end);
+                    if (p == end)
+                        return nullptr;
+                    if (*p == '"')
+                        return p + 1;
+                    // Escape pair, flex does not let it span a new line.
+                    if (p + 1 == end || p[1] == '\n')
+                        return nullptr;
+                    p += 2;
+                }
+            }
+
+            const char *skipNumber(const char *p, const char *end) {
+                p = *p == '0' ? p + 1 : skip<Digit>(p + 1, end);
+                if (end - p >= 2 && *p == '.' && Digit::match(p[1]))
+                    p = skip<Digit>(p + 2, end);
+                return p;
+            }
+
+            bool startsText(const char *p, const char *end) {
+                if (p == end)
+                    return false;
+                return TextChar::match(*p) || (*p == '{' && end - p >= 2 && TextChar::match(p[1]));
+            }
+
+            /**
+             * @return End of maximal text run starting at p, runs end with text, not with blanks.
+             */
+            const char *skipText(const char *p, const char *end) {
+                for (;;) {
+                    for (;;) {
+                        p = skip<TextChar>(p, end);
+                        if (!startsText(p, end))
+                            break;
+                        p += 2;
+                    }
+
+                    const char *next = skip<TemplateBlank>(p, end);
+                    if (next == p || !startsText(next, end))
+                        return p;
+                    p = next;
+                }
+            }
+
+            LexemeType identifierOrKeyword(const char *p, std::size_t size) {
+                auto is = [p, size](const char *keyword, std::size_t keywordSize) {
+                    return size == keywordSize && std::memcmp(p, keyword, size) == 0;
+                };
+
+                switch (*p) {
+                    case 'e':
+                        return is("else", 4) ? LexemeType::ELSE : LexemeType::IDENTIFIER;
+                    case 'f':
+                        if (is("function", 8))
+                            return LexemeType::FUNCTION;
+                        if (is("for", 3))
+                            return LexemeType::FOR;
+                        return is("false", 5) ? LexemeType::FALSE : LexemeType::IDENTIFIER;
+                    case 'i':
+                        return is("if", 2) ? LexemeType::IF : LexemeType::IDENTIFIER;
+                    case 'l':
+                        return is("let", 3) ? LexemeType::LET : LexemeType::IDENTIFIER;
+                    case 'r':
+                        return is("return", 6) ? LexemeType::RETURN : LexemeType::IDENTIFIER;
+                    case 't':
+                        return is("true", 4) ? LexemeType::TRUE : LexemeType::IDENTIFIER;
+                    default:
+                        return LexemeType::IDENTIFIER;
+                }
+            }
+        }
+
+        bool SimdLexer::take(Lexeme &out) {
+            if (!position) {
+                position = scanBuffer;
+                end = scanBuffer + scanBufferSize;
+            }
+
+            for (;;) {
+                skipBlanks();
+                if (position == end)
+                    return false;
+
+                const char *start = position;
+                LexemeType type;
+                bool matched = false;
+                switch (mode) {
+                    case Mode::DEFAULT:
+                        matched = scanDefault(type);
+                        break;
+                    case Mode::TEMPLATE:
+                        matched = scanTemplate(type);
+                        break;
+                    case Mode::TAG:
+                        matched = scanTag(type);
+                        break;
+                    case Mode::INJECTION:
+                        matched = scanInjection(type);
+                        break;
+                }
+
+                if (!matched) {
+                    // Like the default rule of flex, echoes the character to standard output and goes on.
+                    std::fwrite(position, 1, 1, stdout);
+                    ++position;
+                    continue;
+                }
+
+                out.type = type;
+                out.text = boost::string_view(start, static_cast<std::size_t>(position - start));
+                out.line = currentLine;
+                afterLexeme(out);
+                out.symbol = type == LexemeType::IDENTIFIER ? symbols->intern(out.text) : symbols->keyword(type);
+                return true;
+            }
+        }
+
+        void SimdLexer::skipBlanks() {
+            const char *start = position;
+            position = mode == Mode::TEMPLATE ? skip<TemplateBlank>(position, end) : skip<Blank>(position, end);
+            currentLine += static_cast<int>(std::count(start, position, '\n'));
+        }
+
+        bool SimdLexer::scanDefault(LexemeType &type) {
+            const char c = position[0];
+            const char next = position + 1 < end ? position[1] : '\0';
+            std::ptrdiff_t length = 1;
+
+            switch (c) {
+                case '(':
+                    type = LexemeType::OPEN_PARENTHESIS;
+                    break;
+                case ')':
+                    type = LexemeType::CLOSE_PARENTHESIS;
+                    break;
+                case '{':
+                    type = next == '{' ? LexemeType::DOUBLE_OPEN_BRACE : LexemeType::OPEN_BRACE;
+                    length = next == '{' ? 2 : 1;
+                    break;
+                case '}':
+                    type = next == '}' ? LexemeType::DOUBLE_CLOSE_BRACE : LexemeType::CLOSE_BRACE;
+                    length = next == '}' ? 2 : 1;
+                    break;
+                case '[':
+                    type = LexemeType::OPEN_BRACKET;
+                    if (opensTemplate())
+                        mode = Mode::TEMPLATE;
+                    break;
+                case ']':
+                    type = LexemeType::CLOSE_BRACKET;
+                    break;
+                case '<':
+                    type = next == '/' ? LexemeType::END_ANGLE
+                                       : next == '=' ? LexemeType::LESS_EQ : LexemeType::OPEN_ANGLE;
+                    length = next == '/' || next == '=' ? 2 : 1;
+                    break;
+                case '>':
+                    type = next == '=' ? LexemeType::GREATER_EQ : LexemeType::CLOSE_ANGLE;
+                    length = next == '=' ? 2 : 1;
+                    break;
+                case ';':
+                    type = LexemeType::SEMICOLON;
+                    break;
+                case ',':
+                    type = LexemeType::COMMA;
+                    break;
+                case ':':
+                    type = LexemeType::COLON;
+                    break;
+                case '+':
+                    type = LexemeType::ADD;
+                    break;
+                case '-':
+                    type = LexemeType::SUBTRACT;
+                    break;
+                case '*':
+                    type = LexemeType::MULTIPLY;
+                    break;
+                case '/':
+                    type = LexemeType::DIVIDE;
+                    break;
+                case '=':
+                    type = next == '=' ? LexemeType::EQUAL : LexemeType::ASSIGN;
+                    length = next == '=' ? 2 : 1;
+                    break;
+                case '!':
+                    type = next == '=' ? LexemeType::NOT_EQUAL : LexemeType::NOT;
+                    length = next == '=' ? 2 : 1;
+                    break;
+                case '&':
+                    if (next != '&')
+                        return false;
+                    type = LexemeType::AND;
+                    length = 2;
+                    break;
+                case '|':
+                    if (next != '|')
+                        return false;
+                    type = LexemeType::OR;
+                    length = 2;
+                    break;
+                case '"': {
+                    const char *stringEnd = findStringEnd(position, end);
+                    type = stringEnd ? LexemeType::STRING : LexemeType::APOSTROPHE;
+                    length = stringEnd ? stringEnd - position : 1;
+                    break;
+                }
+                default:
+                    if (Digit::match(c)) {
+                        type = LexemeType::NUMBER;
+                        length = skipNumber(position, end) - position;
+                    } else if (Letter::match(c)) {
+                        length = skip<LetterOrDigit>(position + 1, end) - position;
+                        type = identifierOrKeyword(position, static_cast<std::size_t>(length));
+                    } else {
+                        return false;
+                    }
+            }
+
+            position += length;
+            return true;
+        }
+
+        bool SimdLexer::scanTemplate(LexemeType &type) {
+            const char c = position[0];
+            const char next = position + 1 < end ? position[1] : '\0';
+
+            if (c == '<') {
+                type = next == '/' ? LexemeType::END_ANGLE : LexemeType::OPEN_ANGLE;
+                position += next == '/' ? 2 : 1;
+                mode = Mode::TAG;
+            } else if (c == '{' && next == '{') {
+                type = LexemeType::DOUBLE_OPEN_BRACE;
+                position += 2;
+                enterMode(Mode::INJECTION);
+            } else if (c == ']') {
+                type = LexemeType::CLOSE_BRACKET;
+                ++position;
+                mode = Mode::DEFAULT;
+            } else {
+                type = LexemeType::TEXT;
+                position = startsText(position, end) ? skipText(position, end) : position + 1;
+            }
+            return true;
+        }
+
+        bool SimdLexer::scanTag(LexemeType &type) {
+            const char c = position[0];
+            const char next = position + 1 < end ? position[1] : '\0';
+
+            if (c == '>') {
+                type = LexemeType::CLOSE_ANGLE;
+                ++position;
+                mode = Mode::TEMPLATE;
+            } else if (c == '{' && next == '{') {
+                type = LexemeType::DOUBLE_OPEN_BRACE;
+                position += 2;
+                enterMode(Mode::INJECTION);
+            } else if (c == '=') {
+                type = LexemeType::ASSIGN;
+                ++position;
+            } else if (c == '/') {
+                type = LexemeType::DIVIDE;
+                ++position;
+            } else if (Letter::match(c)) {
+                type = LexemeType::IDENTIFIER;
+                position = skip<LetterOrDigit>(position + 1, end);
+            } else if (Digit::match(c)) {
+                type = LexemeType::NUMBER;
+                position = skipNumber(position, end);
+            } else if (c == '"') {
+                const char *stringEnd = findStringEnd(position, end);
+                if (!stringEnd)
+                    return false;
+                type = LexemeType::STRING;
+                position = stringEnd;
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        bool SimdLexer::scanInjection(LexemeType &type) {
+            const char c = position[0];
+            const char next = position + 1 < end ? position[1] : '\0';
+
+            if (c == '}' && next == '}') {
+                type = LexemeType::DOUBLE_CLOSE_BRACE;
+                position += 2;
+                leaveMode();
+            } else if (Letter::match(c)) {
+                type = LexemeType::IDENTIFIER;
+                position = skip<LetterOrDigit>(position + 1, end);
+            } else {
+                return false;
+            }
+            return true;
+        }
+
+        void SimdLexer::enterMode(Mode next) {
+            modeStack.push_back(mode);
+            mode = next;
+        }
+
+        void SimdLexer::leaveMode() {
+            mode = modeStack.back();
+            modeStack.pop_back();
+        }
+    }
+}
@@ -0,0 +1,55 @@
+#ifndef LEXER_SIMD_LEXER_HPP
+#define LEXER_SIMD_LEXER_HPP
+
+#include <vector>
+#include "lexer.hpp"
+
+namespace lang {
+    namespace lexer {
+        /**
+         * Hand-written scanner producing exactly the same lexemes as the flex one. Whitespace, identifiers,
+         * numbers, strings and template text are classified 16 bytes at a time with SSE2 where available,
+         * with scalar loops otherwise and near the end of input. Characters matching no rule are written
+         * to standard output, as flex does.
+         */
+        class SimdLexer : public Lexer {
+            enum class Mode {
+                DEFAULT,
+                TEMPLATE,
+                TAG,
+                INJECTION,
+            };
+
+            const char *position = nullptr;
+            const char *end = nullptr;
+            Mode mode = Mode::DEFAULT;
+            std::vector<Mode> modeStack;
+
+        public:
+            using Lexer::Lexer;
+
+            bool take(Lexeme &out) override;
+
+        private:
+            void skipBlanks();
+
+            /**
+             * Scans lexeme at current position, advancing past it.
+             * @return false if no rule matches current character, position is left unchanged then.
+             */
+            bool scanDefault(LexemeType &type);
+
+            bool scanTemplate(LexemeType &type);
+
+            bool scanTag(LexemeType &type);
+
+            bool scanInjection(LexemeType &type);
+
+            void enterMode(Mode next);
+
+            void leaveMode();
+        };
+    }
+}
+
+#endif // LEXER_SIMD_LEXER_HPP
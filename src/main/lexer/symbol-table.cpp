@@ -0,0 +1,77 @@
+#include "symbol-table.hpp"
+#include <cassert>
+#include <mutex>
+
+namespace lang {
+    namespace lexer {
+        namespace {
+            const LexemeType firstKeyword = LexemeType::FUNCTION;
+            const LexemeType lastKeyword = LexemeType::FALSE;
+
+            const char *const keywords[] = {
+                    "function",
+                    "if",
+                    "else",
+                    "for",
+                    "let",
+                    "return",
+                    "true",
+                    "false",
+            };
+
+            static_assert(sizeof(keywords) / sizeof(keywords[0]) ==
+                          static_cast<int>(lastKeyword) - static_cast<int>(firstKeyword) + 1,
+                          "every keyword lexeme needs its name");
+        }
+
+        const std::size_t SymbolTable::keywordCount;
+
+        const std::string Symbol::none;
+
+        const std::uint32_t Symbol::invalidId;
+
+        SymbolTable::SymbolTable() {
+            static_assert(sizeof(keywords) / sizeof(keywords[0]) == keywordCount, "keyword symbols need their slots");
+            for (std::size_t i = 0; i < keywordCount; ++i)
+                keywordSymbols[i] = intern(keywords[i]);
+        }
+
+        Symbol SymbolTable::intern(boost::string_view name) {
+            {
+                std::shared_lock<std::shared_timed_mutex> lock(mutex);
+                auto found = index.find(name);
+                if (found != index.end())
+                    return Symbol(&names[found->second], found->second);
+            }
+
+            std::unique_lock<std::shared_timed_mutex> lock(mutex);
+            // Another thread may have interned the name between the locks.
+            auto found = index.find(name);
+            if (found != index.end())
+                return Symbol(&names[found->second], found->second);
+
+            const auto id = static_cast<std::uint32_t>(names.size());
+            names.emplace_back(name.data(), name.size());
+            index.emplace(boost::string_view(names.back()), id);
+            return Symbol(&names.back(), id);
+        }
+
+        Symbol SymbolTable::keyword(LexemeType type) const {
+            if (type < firstKeyword || type > lastKeyword)
+                return Symbol();
+
+            return keywordSymbols[static_cast<int>(type) - static_cast<int>(firstKeyword)];
+        }
+
+        Symbol SymbolTable::operator[](std::uint32_t id) const {
+            std::shared_lock<std::shared_timed_mutex> lock(mutex);
+            assert(id < names.size());
+            return Symbol(&names[id], id);
+        }
+
+        std::size_t SymbolTable::size() const {
+            std::shared_lock<std::shared_timed_mutex> lock(mutex);
+            return names.size();
+        }
+    }
+}
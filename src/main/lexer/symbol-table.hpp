@@ -0,0 +1,49 @@
+#ifndef LEXER_SYMBOL_TABLE_HPP
+#define LEXER_SYMBOL_TABLE_HPP
+
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_view.hpp>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+#include "lexeme.hpp"
+#include "symbol.hpp"
+
+namespace lang {
+    namespace lexer {
+        /**
+         * Owns names of all symbols handed out. Keywords are interned on construction,
+         * so they always take the first ids.
+         * Table may be shared by lexers running on several threads; names never move once interned.
+         * Keyword symbols are kept aside as well, so lexers look them up without taking the lock.
+         */
+        class SymbolTable {
+            static const std::size_t keywordCount = 8;
+
+            mutable std::shared_timed_mutex mutex;
+            std::deque<std::string> names;
+            std::unordered_map<boost::string_view, std::uint32_t, boost::hash<boost::string_view>> index;
+            Symbol keywordSymbols[keywordCount];
+
+        public:
+            SymbolTable();
+
+            SymbolTable(const SymbolTable &) = delete;
+
+            SymbolTable &operator=(const SymbolTable &) = delete;
+
+            Symbol intern(boost::string_view name);
+
+            /**
+             * @return Symbol of given keyword, or invalid symbol for other lexeme types.
+             */
+            Symbol keyword(LexemeType type) const;
+
+            Symbol operator[](std::uint32_t id) const;
+
+            std::size_t size() const;
+        };
+    }
+}
+
+#endif // LEXER_SYMBOL_TABLE_HPP
@@ -0,0 +1,66 @@
+#ifndef LEXER_SYMBOL_HPP
+#define LEXER_SYMBOL_HPP
+
+#include <cstdint>
+#include <string>
+
+namespace lang {
+    namespace lexer {
+        /**
+         * Interned identifier or keyword. Symbols of one table compare by their dense id.
+         */
+        class Symbol {
+            friend class SymbolTable;
+
+            static const std::string none;
+
+            const std::string *name = &none;
+            std::uint32_t id = invalidId;
+
+            Symbol(const std::string *name, std::uint32_t id) : name(name), id(id) {}
+
+        public:
+            static const std::uint32_t invalidId = UINT32_MAX;
+
+            Symbol() = default;
+
+            std::uint32_t getId() const {
+                return id;
+            }
+
+            const std::string &str() const {
+                return *name;
+            }
+
+            operator const std::string &() const {
+                return *name;
+            }
+
+            bool operator==(const Symbol &other) const {
+                return id == other.id;
+            }
+
+            bool operator!=(const Symbol &other) const {
+                return id != other.id;
+            }
+        };
+
+        inline bool operator==(const Symbol &symbol, const std::string &name) {
+            return symbol.str() == name;
+        }
+
+        inline bool operator==(const std::string &name, const Symbol &symbol) {
+            return symbol.str() == name;
+        }
+
+        inline bool operator!=(const Symbol &symbol, const std::string &name) {
+            return symbol.str() != name;
+        }
+
+        inline bool operator!=(const std::string &name, const Symbol &symbol) {
+            return symbol.str() != name;
+        }
+    }
+}
+
+#endif // LEXER_SYMBOL_HPP
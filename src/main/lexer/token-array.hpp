@@ -0,0 +1,91 @@
+#ifndef LEXER_TOKEN_ARRAY_HPP
+#define LEXER_TOKEN_ARRAY_HPP
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "lexeme.hpp"
+#include "symbol-table.hpp"
+
+namespace lang {
+    namespace lexer {
+        /**
+         * Lexemes of whole input in structure-of-arrays layout. Texts are kept as offsets into the source
+         * buffer of the lexer, which has to outlive the array, so the source is limited to 4 GiB.
+         * Symbols are kept as their ids and taken back from the symbol table on read. Values of numbers
+         * are stored only for NUMBER lexemes; lexeme finds its value by the count of numbers before it,
+         * kept for every block of 64 lexemes along with the mask of numbers in the block.
+         */
+        struct TokenArray {
+            boost::string_view source;
+            std::shared_ptr<const SymbolTable> symbolTable;
+
+            std::vector<LexemeType> types;
+            std::vector<std::uint32_t> offsets;
+            std::vector<std::uint32_t> lengths;
+            std::vector<int> lines;
+            std::vector<std::uint32_t> symbols;
+            std::vector<double> numbers;
+            std::vector<std::uint64_t> numberMasks;
+            std::vector<std::uint32_t> numberRanks;
+
+            std::size_t size() const {
+                return types.size();
+            }
+
+            void reserve(std::size_t count) {
+                types.reserve(count);
+                offsets.reserve(count);
+                lengths.reserve(count);
+                lines.reserve(count);
+                symbols.reserve(count);
+                numberMasks.reserve(count / 64 + 1);
+                numberRanks.reserve(count / 64 + 1);
+            }
+
+            /**
+             * @throws std::length_error if the lexeme ends beyond 4 GiB of the source.
+             */
+            void push(const Lexeme &lexeme) {
+                const std::size_t offset = lexeme.text.data() - source.data();
+                if (offset + lexeme.text.size() > UINT32_MAX)
+                    throw std::length_error("source of token array exceeds 4 GiB");
+
+                const std::size_t index = size();
+                if (index % 64 == 0) {
+                    numberMasks.push_back(0);
+                    numberRanks.push_back(static_cast<std::uint32_t>(numbers.size()));
+                }
+                types.push_back(lexeme.type);
+                offsets.push_back(static_cast<std::uint32_t>(offset));
+                lengths.push_back(static_cast<std::uint32_t>(lexeme.text.size()));
+                lines.push_back(lexeme.line);
+                symbols.push_back(lexeme.symbol.getId());
+                if (lexeme.type == LexemeType::NUMBER) {
+                    numberMasks.back() |= std::uint64_t(1) << index % 64;
+                    numbers.push_back(lexeme.number);
+                }
+            }
+
+            Lexeme operator[](std::size_t index) const {
+                const auto type = types[index];
+                const auto id = symbols[index];
+                double number = 0.0;
+                if (type == LexemeType::NUMBER) {
+                    const std::uint64_t before = numberMasks[index / 64] & ((std::uint64_t(1) << index % 64) - 1);
+                    number = numbers[numberRanks[index / 64] + __builtin_popcountll(before)];
+                }
+                return Lexeme{
+                        type,
+                        source.substr(offsets[index], lengths[index]),
+                        lines[index],
+                        id == Symbol::invalidId ? Symbol() : (*symbolTable)[id],
+                        number
+                };
+            }
+        };
+    }
+}
+
+#endif // LEXER_TOKEN_ARRAY_HPP
@@ -0,0 +1,475 @@
+#include "binary-script.hpp"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace lang {
+    namespace parser {
+        namespace {
+            const char magic[8] = {'L', 'A', 'N', 'G', 'T', 'R', 'E', 'E'};
+            const std::size_t alignment = 8;
+
+            enum Pool {
+                UNARIES,
+                BINARIES,
+                QUATERNARIES,
+                COMPOSITES,
+                FUNCTION_DEFS,
+                HTML_TEMPLATES,
+                TEXTS,
+                NUMBERS,
+                LISTS,
+                STRINGS,
+                POOL_COUNT,
+            };
+
+            struct Header {
+                char magic[8];
+                std::uint32_t version;
+                std::uint32_t root;
+                std::uint64_t sourceHash;
+                std::uint32_t symbolCount;
+                std::uint32_t symbolBytes;
+                /** Number of elements in every pool, in order of Pool. */
+                std::uint32_t poolSizes[POOL_COUNT];
+            };
+
+            static_assert(sizeof(Header) % alignment == 0, "sections after header have to stay aligned");
+            static_assert(std::is_trivially_copyable<CompactTree::Quaternary>::value
+                          && std::is_trivially_copyable<CompactTree::HtmlTemplate>::value
+                          && std::is_trivially_copyable<NodeRef>::value, "pools are copied byte for byte");
+
+            /**
+             * Calls action with every pool of the tree, in order of Pool.
+             */
+            template<typename Tree, typename F>
+            void forEachPool(Tree &tree, F action) {
+                action(tree.unaries);
+                action(tree.binaries);
+                action(tree.quaternaries);
+                action(tree.composites);
+                action(tree.functionDefs);
+                action(tree.htmlTemplates);
+                action(tree.texts);
+                action(tree.numbers);
+                action(tree.lists);
+                action(tree.strings);
+            }
+
+            void writeSection(std::ostream &output, const void *data, std::size_t size) {
+                static const char padding[alignment] = {};
+                output.write(static_cast<const char *>(data), size);
+                output.write(padding, (alignment - size % alignment) % alignment);
+            }
+
+            /**
+             * Reads consecutive sections of binary script, refusing to go past its end.
+             */
+            class Reader {
+                boost::string_view data;
+                std::size_t position = 0;
+
+            public:
+                explicit Reader(boost::string_view data) : data(data) {
+                }
+
+                const char *take(std::size_t size) {
+                    const std::size_t padded = size + (alignment - size % alignment) % alignment;
+                    if (padded > data.size() - position)
+                        throw BinaryScriptException("binary script is truncated");
+                    const char *result = data.data() + position;
+                    position += padded;
+                    return result;
+                }
+
+                template<typename T>
+                void takeInto(T &pool, std::size_t count) {
+                    using Element = typename T::value_type;
+                    if (count > data.size() / sizeof(Element))
+                        throw BinaryScriptException("binary script is truncated");
+                    const char *bytes = take(count * sizeof(Element));
+                    pool.resize(count);
+                    if (count > 0)
+                        std::memcpy(&pool[0], bytes, count * sizeof(Element));
+                }
+            };
+
+            Header readHeader(boost::string_view data) {
+                Header header;
+                if (data.size() < sizeof(header))
+                    throw BinaryScriptException("binary script is truncated");
+                std::memcpy(&header, data.data(), sizeof(header));
+                if (!std::equal(magic, magic + sizeof(magic), header.magic))
+                    throw BinaryScriptException("not a binary script");
+                if (header.version != binaryScriptVersion)
+                    throw BinaryScriptException("binary script version " + std::to_string(header.version)
+                                                + " is not supported, expected " + std::to_string(binaryScriptVersion));
+                return header;
+            }
+
+            /**
+             * Checks that every reference and range of the tree stays inside its pool, that every field
+             * holds a node of the kinds the parser stores there and that nodes form a tree reachable
+             * from the root, each with a single parent, so damaged file fails on load instead of
+             * during expansion or traversal.
+             */
+            class Validator {
+                const CompactTree &tree;
+                const std::size_t symbolCount;
+
+                /** Nodes reached so far, by shape and index; inline nodes are not tracked. */
+                std::vector<std::vector<bool>> reached;
+                std::vector<NodeRef> pending;
+
+                void fail() const {
+                    throw BinaryScriptException("binary script is damaged");
+                }
+
+            public:
+                Validator(const CompactTree &tree, std::size_t symbolCount)
+                        : tree(tree), symbolCount(symbolCount) {
+                    reached.resize(static_cast<std::size_t>(NodeShape::NUMBER) + 1);
+                    reached[static_cast<int>(NodeShape::UNARY)].resize(tree.unaries.size());
+                    reached[static_cast<int>(NodeShape::BINARY)].resize(tree.binaries.size());
+                    reached[static_cast<int>(NodeShape::QUATERNARY)].resize(tree.quaternaries.size());
+                    reached[static_cast<int>(NodeShape::COMPOSITE)].resize(tree.composites.size());
+                    reached[static_cast<int>(NodeShape::FUNCTION_DEF)].resize(tree.functionDefs.size());
+                    reached[static_cast<int>(NodeShape::HTML_TEMPLATE)].resize(tree.htmlTemplates.size());
+                    reached[static_cast<int>(NodeShape::TEXT)].resize(tree.texts.size());
+                    reached[static_cast<int>(NodeShape::NUMBER)].resize(tree.numbers.size());
+                }
+
+                void checkAll() {
+                    for (const auto &node : tree.composites)
+                        check(node.items, tree.lists.size());
+                    for (const auto &node : tree.functionDefs)
+                        checkIndex(node.name, symbolCount);
+                    for (const auto &node : tree.htmlTemplates) {
+                        check(node.elements, tree.lists.size());
+                        check(node.content, tree.lists.size());
+                    }
+                    for (const auto &node : tree.texts)
+                        check(node.text, tree.strings.size());
+
+                    expect(tree.root, NodeKind::SCRIPT);
+                    while (!pending.empty()) {
+                        const auto node = pending.back();
+                        pending.pop_back();
+                        checkChildren(node);
+                    }
+                }
+
+            private:
+                void checkIndex(std::size_t index, std::size_t size) const {
+                    if (index >= size)
+                        fail();
+                }
+
+                void check(CompactTree::Range range, std::size_t size) const {
+                    if (range.first > size || range.count > size - range.first)
+                        fail();
+                }
+
+                /**
+                 * Checks the reference against its pool and queues the node; reaching a node twice
+                 * means it is shared or part of a cycle.
+                 */
+                void enter(NodeRef ref) {
+                    const std::size_t index = ref.index();
+                    const auto shape = shapeOf(ref.kind());
+                    if (shape == NodeShape::INLINE) {
+                        if (ref.kind() == NodeKind::IDENTIFIER && index >= symbolCount && index != NodeRef::maxIndex)
+                            fail();
+                        return;
+                    }
+
+                    auto &reachedOfShape = reached[static_cast<int>(shape)];
+                    checkIndex(index, reachedOfShape.size());
+                    if (reachedOfShape[index])
+                        fail();
+                    reachedOfShape[index] = true;
+                    pending.push_back(ref);
+                }
+
+                void expect(NodeRef ref, NodeKind kind) {
+                    if (ref.kind() != kind)
+                        fail();
+                    enter(ref);
+                }
+
+                void expectOptional(NodeRef ref, NodeKind kind) {
+                    if (ref)
+                        expect(ref, kind);
+                }
+
+                void expectExpression(NodeRef ref) {
+                    switch (ref.kind()) {
+                        case NodeKind::RETURN_EXPRESSION:
+                        case NodeKind::BLOCK:
+                        case NodeKind::DECLARATION_EXPRESSION:
+                        case NodeKind::FOR_EXPRESSION:
+                        case NodeKind::ASSIGN_EXPRESSION:
+                        case NodeKind::IF_EXPRESSION:
+                        case NodeKind::FUNCTION_CALL:
+                        case NodeKind::OR:
+                        case NodeKind::AND:
+                        case NodeKind::EQUAL:
+                        case NodeKind::NOT_EQUAL:
+                        case NodeKind::LESS:
+                        case NodeKind::GREATER:
+                        case NodeKind::LESS_EQUAL:
+                        case NodeKind::GREATER_EQUAL:
+                        case NodeKind::ADD:
+                        case NodeKind::SUBTRACT:
+                        case NodeKind::MULTIPLY:
+                        case NodeKind::DIVIDE:
+                        case NodeKind::NEGATE:
+                        case NodeKind::NOT:
+                        case NodeKind::OBJECT_LITERAL:
+                        case NodeKind::VARIABLE:
+                        case NodeKind::STRING_LITERAL:
+                        case NodeKind::NUMBER_LITERAL:
+                        case NodeKind::BOOLEAN_LITERAL:
+                            enter(ref);
+                            break;
+                        default:
+                            fail();
+                    }
+                }
+
+                void expectOptionalExpression(NodeRef ref) {
+                    if (ref)
+                        expectExpression(ref);
+                }
+
+                void expectNone(NodeRef ref) const {
+                    if (ref)
+                        fail();
+                }
+
+                template<typename F>
+                void forEachItem(CompactTree::Range range, F action) {
+                    for (auto it = tree.listBegin(range); it != tree.listEnd(range); ++it)
+                        action(*it);
+                }
+
+                void expectItems(CompactTree::Range range, NodeKind kind) {
+                    forEachItem(range, [this, kind](NodeRef item) {
+                        expect(item, kind);
+                    });
+                }
+
+                /**
+                 * Composite without head, holding only items of the kind.
+                 */
+                void expectList(const CompactTree::Composite &shape, NodeKind kind) {
+                    expectNone(shape.head);
+                    expectItems(shape.items, kind);
+                }
+
+                void checkChildren(NodeRef node) {
+                    const auto index = node.index();
+                    switch (node.kind()) {
+                        case NodeKind::SCRIPT:
+                            expectList(tree.composites[index], NodeKind::FUNCTION_DEF);
+                            break;
+                        case NodeKind::FUNCTION_DEF_PARAMS:
+                            expectList(tree.composites[index], NodeKind::IDENTIFIER);
+                            break;
+                        case NodeKind::ATTRIBUTE_LIST:
+                            expectList(tree.composites[index], NodeKind::ATTRIBUTE);
+                            break;
+                        case NodeKind::OBJECT_LITERAL:
+                            expectList(tree.composites[index], NodeKind::OBJECT_FIELD);
+                            break;
+                        case NodeKind::FUNCTION_DEF: {
+                            const auto &shape = tree.functionDefs[index];
+                            expectOptional(shape.htmlTemplate, NodeKind::HTML_TEMPLATE);
+                            expectOptional(shape.params, NodeKind::FUNCTION_DEF_PARAMS);
+                            expectOptionalExpression(shape.value);
+                            break;
+                        }
+                        case NodeKind::HTML_TEMPLATE: {
+                            const auto &shape = tree.htmlTemplates[index];
+                            expectOptional(shape.identifier, NodeKind::IDENTIFIER);
+                            expectOptional(shape.attributes, NodeKind::ATTRIBUTE_LIST);
+                            expectOptional(shape.closingParams, NodeKind::IDENTIFIER);
+                            expectItems(shape.elements, NodeKind::HTML_TEMPLATE);
+                            expectItems(shape.content, NodeKind::TEXT_CONTENT);
+                            break;
+                        }
+                        case NodeKind::ATTRIBUTE: {
+                            const auto &shape = tree.binaries[index];
+                            expect(shape.left, NodeKind::IDENTIFIER);
+                            expect(shape.right, NodeKind::ATTRIBUTE_VALUE);
+                            break;
+                        }
+                        case NodeKind::ATTRIBUTE_VALUE: {
+                            const auto &shape = tree.binaries[index];
+                            expectOptional(shape.left, NodeKind::INJECTED_VALUE);
+                            expectOptional(shape.right, NodeKind::STRING_LITERAL);
+                            break;
+                        }
+                        case NodeKind::TEXT_CONTENT: {
+                            const auto &shape = tree.binaries[index];
+                            expectOptional(shape.left, NodeKind::INJECTED_VALUE);
+                            expectOptional(shape.right, NodeKind::ANY_TEXT);
+                            break;
+                        }
+                        case NodeKind::INJECTED_VALUE:
+                            expect(tree.unaries[index].value, NodeKind::IDENTIFIER);
+                            break;
+                        case NodeKind::RETURN_EXPRESSION:
+                        case NodeKind::BLOCK:
+                        case NodeKind::INDEX_EXPRESSION:
+                        case NodeKind::NEGATE:
+                        case NodeKind::NOT:
+                            expectExpression(tree.unaries[index].value);
+                            break;
+                        case NodeKind::DECLARATION_EXPRESSION: {
+                            const auto &shape = tree.binaries[index];
+                            expect(shape.left, NodeKind::IDENTIFIER);
+                            expectOptionalExpression(shape.right);
+                            break;
+                        }
+                        case NodeKind::FOR_EXPRESSION: {
+                            const auto &shape = tree.quaternaries[index];
+                            expect(shape.children[0], NodeKind::DECLARATION_EXPRESSION);
+                            expectExpression(shape.children[1]);
+                            expect(shape.children[2], NodeKind::ASSIGN_EXPRESSION);
+                            expect(shape.children[3], NodeKind::BLOCK);
+                            break;
+                        }
+                        case NodeKind::ASSIGN_EXPRESSION: {
+                            const auto &shape = tree.binaries[index];
+                            expectOptional(shape.left, NodeKind::VARIABLE);
+                            expectExpression(shape.right);
+                            break;
+                        }
+                        case NodeKind::IF_EXPRESSION: {
+                            const auto &shape = tree.quaternaries[index];
+                            expectExpression(shape.children[0]);
+                            expect(shape.children[1], NodeKind::BLOCK);
+                            expectOptional(shape.children[2], NodeKind::BLOCK);
+                            expectNone(shape.children[3]);
+                            break;
+                        }
+                        case NodeKind::OR:
+                        case NodeKind::AND:
+                        case NodeKind::EQUAL:
+                        case NodeKind::NOT_EQUAL:
+                        case NodeKind::LESS:
+                        case NodeKind::GREATER:
+                        case NodeKind::LESS_EQUAL:
+                        case NodeKind::GREATER_EQUAL:
+                        case NodeKind::ADD:
+                        case NodeKind::SUBTRACT:
+                        case NodeKind::MULTIPLY:
+                        case NodeKind::DIVIDE:
+                            expectExpression(tree.binaries[index].left);
+                            expectExpression(tree.binaries[index].right);
+                            break;
+                        case NodeKind::FUNCTION_CALL: {
+                            const auto &shape = tree.composites[index];
+                            expect(shape.head, NodeKind::IDENTIFIER);
+                            forEachItem(shape.items, [this](NodeRef item) {
+                                expectExpression(item);
+                            });
+                            break;
+                        }
+                        case NodeKind::OBJECT_FIELD: {
+                            const auto &shape = tree.binaries[index];
+                            expect(shape.left, NodeKind::IDENTIFIER);
+                            expectExpression(shape.right);
+                            break;
+                        }
+                        case NodeKind::VARIABLE: {
+                            const auto &shape = tree.composites[index];
+                            expect(shape.head, NodeKind::IDENTIFIER);
+                            expectItems(shape.items, NodeKind::INDEX_EXPRESSION);
+                            break;
+                        }
+                        default:
+                            // Texts, numbers and inline nodes have no children.
+                            break;
+                    }
+                }
+            };
+        }
+
+        std::uint64_t hashSource(boost::string_view source) {
+            std::uint64_t hash = 14695981039346656037ull;
+            for (char c : source) {
+                hash ^= static_cast<unsigned char>(c);
+                hash *= 1099511628211ull;
+            }
+            return hash;
+        }
+
+        void writeBinaryScript(std::ostream &output, const CompactTree &tree, std::uint64_t sourceHash) {
+            Header header{};
+            std::copy(magic, magic + sizeof(magic), header.magic);
+            header.version = binaryScriptVersion;
+            header.root = tree.root.raw();
+            header.sourceHash = sourceHash;
+            header.symbolCount = static_cast<std::uint32_t>(tree.symbols->size());
+
+            std::vector<std::uint32_t> symbolLengths;
+            std::string symbolNames;
+            for (std::uint32_t id = 0; id < header.symbolCount; ++id) {
+                const std::string &name = (*tree.symbols)[id];
+                symbolLengths.push_back(static_cast<std::uint32_t>(name.size()));
+                symbolNames += name;
+            }
+            header.symbolBytes = static_cast<std::uint32_t>(symbolNames.size());
+
+            std::size_t pool = 0;
+            forEachPool(tree, [&header, &pool](const auto &elements) {
+                header.poolSizes[pool++] = static_cast<std::uint32_t>(elements.size());
+            });
+
+            output.write(reinterpret_cast<const char *>(&header), sizeof(header));
+            writeSection(output, symbolLengths.data(), symbolLengths.size() * sizeof(std::uint32_t));
+            writeSection(output, symbolNames.data(), symbolNames.size());
+            forEachPool(tree, [&output](const auto &elements) {
+                writeSection(output, elements.data(), elements.size() * sizeof(elements[0]));
+            });
+        }
+
+        std::uint64_t readSourceHash(boost::string_view data) {
+            return readHeader(data).sourceHash;
+        }
+
+        CompactTree readBinaryScript(boost::string_view data) {
+            const Header header = readHeader(data);
+            Reader reader(data);
+            reader.take(sizeof(header));
+
+            std::vector<std::uint32_t> symbolLengths;
+            reader.takeInto(symbolLengths, header.symbolCount);
+            const char *names = reader.take(header.symbolBytes);
+
+            // Keywords are interned by the table itself, names in the file have to agree with them.
+            auto symbols = std::make_shared<lexer::SymbolTable>();
+            std::size_t offset = 0;
+            for (std::uint32_t id = 0; id < header.symbolCount; ++id) {
+                if (symbolLengths[id] > header.symbolBytes - offset)
+                    throw BinaryScriptException("binary script is damaged");
+                if (symbols->intern(boost::string_view(names + offset, symbolLengths[id])).getId() != id)
+                    throw BinaryScriptException("binary script was compiled with different keywords");
+                offset += symbolLengths[id];
+            }
+
+            CompactTree tree;
+            tree.symbols = symbols;
+            tree.root = NodeRef::fromRaw(header.root);
+            std::size_t pool = 0;
+            forEachPool(tree, [&reader, &header, &pool](auto &elements) {
+                reader.takeInto(elements, header.poolSizes[pool++]);
+            });
+
+            Validator(tree, header.symbolCount).checkAll();
+            return tree;
+        }
+    }
+}
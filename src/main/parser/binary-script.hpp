@@ -0,0 +1,48 @@
+#ifndef PARSER_BINARY_SCRIPT_HPP
+#define PARSER_BINARY_SCRIPT_HPP
+
+#include <boost/utility/string_view.hpp>
+#include <cstdint>
+#include <ostream>
+#include "../util/generic-exception.hpp"
+#include "compact-tree.hpp"
+
+namespace lang {
+    namespace parser {
+        struct BinaryScriptExceptionTag {
+        };
+        using BinaryScriptException = util::GenericException<BinaryScriptExceptionTag>;
+
+        /**
+         * Bumped whenever layout of the file or of the CompactTree pools changes.
+         */
+        const std::uint32_t binaryScriptVersion = 2;
+
+        /**
+         * 64-bit FNV-1a hash of script source, stored in binary scripts to detect stale ones.
+         */
+        std::uint64_t hashSource(boost::string_view source);
+
+        /**
+         * Writes compact tree as a binary script: fixed header, names of all symbols in id order
+         * and the pools copied byte for byte. Pools only link by indices, so the file does not depend
+         * on where it is loaded.
+         */
+        void writeBinaryScript(std::ostream &output, const CompactTree &tree, std::uint64_t sourceHash);
+
+        /**
+         * @return Hash of the source the binary script was compiled from.
+         * @throws BinaryScriptException if data is not a binary script of the current version.
+         */
+        std::uint64_t readSourceHash(boost::string_view data);
+
+        /**
+         * Rebuilds the tree from binary script, usually a mapped file; pools are copied in bulk
+         * and every reference and range is checked against pool sizes.
+         * @throws BinaryScriptException if data is not a binary script of the current version or is damaged.
+         */
+        CompactTree readBinaryScript(boost::string_view data);
+    }
+}
+
+#endif // PARSER_BINARY_SCRIPT_HPP
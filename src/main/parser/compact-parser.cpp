@@ -0,0 +1,202 @@
+#include "compact-parser.hpp"
+#include <algorithm>
+#include <cassert>
+
+namespace lang {
+    namespace parser {
+        CompactTreeBuilder::Mark CompactTreeBuilder::mark() const {
+            return Mark{tree.unaries.size(), tree.binaries.size(), tree.quaternaries.size(),
+                        tree.composites.size(), tree.functionDefs.size(), tree.htmlTemplates.size(),
+                        tree.texts.size(), tree.numbers.size(), tree.lists.size(), tree.strings.size()};
+        }
+
+        void CompactTreeBuilder::dropSince(const Mark &mark) {
+            tree.unaries.resize(mark.unaries);
+            tree.binaries.resize(mark.binaries);
+            tree.quaternaries.resize(mark.quaternaries);
+            tree.composites.resize(mark.composites);
+            tree.functionDefs.resize(mark.functionDefs);
+            tree.htmlTemplates.resize(mark.htmlTemplates);
+            tree.texts.resize(mark.texts);
+            tree.numbers.resize(mark.numbers);
+            tree.lists.resize(mark.lists);
+            tree.strings.resize(mark.strings);
+        }
+
+        CompactTree::Range CompactTreeBuilder::popList(PendingList list) {
+            assert(list.first <= pendingItems.size());
+            const auto range = tree.addList(pendingItems.data() + list.first, pendingItems.size() - list.first);
+            pendingItems.resize(list.first);
+            return range;
+        }
+
+        NodeRef CompactTreeBuilder::unary(NodeKind kind, NodeRef value) {
+            return tree.add(tree.unaries, kind, CompactTree::Unary{value});
+        }
+
+        NodeRef CompactTreeBuilder::binary(NodeKind kind, NodeRef left, NodeRef right) {
+            return tree.add(tree.binaries, kind, CompactTree::Binary{left, right});
+        }
+
+        NodeRef CompactTreeBuilder::composite(NodeKind kind, NodeRef head, PendingList items) {
+            return tree.add(tree.composites, kind, CompactTree::Composite{head, popList(items)});
+        }
+
+        NodeRef CompactTreeBuilder::script(PendingList functions, std::shared_ptr<const lexer::SymbolTable> symbols) {
+            tree.symbols = move(symbols);
+            return composite(NodeKind::SCRIPT, NodeRef(), functions);
+        }
+
+        NodeRef CompactTreeBuilder::functionDef(
+                const lexer::Symbol &name,
+                NodeRef htmlTemplate,
+                NodeRef params,
+                NodeRef value
+        ) {
+            const CompactTree::FunctionDef result{name.getId(), htmlTemplate, params, value};
+            return tree.add(tree.functionDefs, NodeKind::FUNCTION_DEF, result);
+        }
+
+        NodeRef CompactTreeBuilder::functionDefParams(PendingList params) {
+            return composite(NodeKind::FUNCTION_DEF_PARAMS, NodeRef(), params);
+        }
+
+        NodeRef CompactTreeBuilder::htmlTemplate(
+                NodeRef identifier,
+                NodeRef attributes,
+                PendingList elements,
+                PendingList content,
+                NodeRef closingParams
+        ) {
+            assert(elements.first == content.first);
+            const auto firstContent = std::stable_partition(
+                    pendingItems.begin() + elements.first, pendingItems.end(),
+                    [](NodeRef item) { return item.kind() == NodeKind::HTML_TEMPLATE; });
+            content.first = static_cast<std::size_t>(firstContent - pendingItems.begin());
+
+            CompactTree::HtmlTemplate result{identifier, attributes, closingParams};
+            result.content = popList(content);
+            result.elements = popList(elements);
+            return tree.add(tree.htmlTemplates, NodeKind::HTML_TEMPLATE, result);
+        }
+
+        NodeRef CompactTreeBuilder::attributeList(PendingList attributes) {
+            return composite(NodeKind::ATTRIBUTE_LIST, NodeRef(), attributes);
+        }
+
+        NodeRef CompactTreeBuilder::attribute(NodeRef identifier, NodeRef value) {
+            return binary(NodeKind::ATTRIBUTE, identifier, value);
+        }
+
+        NodeRef CompactTreeBuilder::attributeValue(NodeRef value, NodeRef string) {
+            return binary(NodeKind::ATTRIBUTE_VALUE, value, string);
+        }
+
+        NodeRef CompactTreeBuilder::injectedValue(NodeRef value) {
+            return unary(NodeKind::INJECTED_VALUE, value);
+        }
+
+        NodeRef CompactTreeBuilder::textContent(NodeRef value, NodeRef text) {
+            return binary(NodeKind::TEXT_CONTENT, value, text);
+        }
+
+        NodeRef CompactTreeBuilder::returnExpression(NodeRef value) {
+            return unary(NodeKind::RETURN_EXPRESSION, value);
+        }
+
+        NodeRef CompactTreeBuilder::block(NodeRef value) {
+            return unary(NodeKind::BLOCK, value);
+        }
+
+        NodeRef CompactTreeBuilder::declarationExpression(NodeRef identifier, NodeRef value) {
+            return binary(NodeKind::DECLARATION_EXPRESSION, identifier, value);
+        }
+
+        NodeRef CompactTreeBuilder::forExpression(
+                NodeRef iterator,
+                NodeRef condition,
+                NodeRef expression,
+                NodeRef block
+        ) {
+            const CompactTree::Quaternary result{{iterator, condition, expression, block}};
+            return tree.add(tree.quaternaries, NodeKind::FOR_EXPRESSION, result);
+        }
+
+        NodeRef CompactTreeBuilder::assignExpression(NodeRef variable, NodeRef value) {
+            return binary(NodeKind::ASSIGN_EXPRESSION, variable, value);
+        }
+
+        NodeRef CompactTreeBuilder::ifExpression(NodeRef condition, NodeRef ifBlock, NodeRef elseBlock) {
+            const CompactTree::Quaternary result{{condition, ifBlock, elseBlock, NodeRef()}};
+            return tree.add(tree.quaternaries, NodeKind::IF_EXPRESSION, result);
+        }
+
+        NodeRef CompactTreeBuilder::binaryOperation(BinaryOperator op, NodeRef left, NodeRef right) {
+            return binary(binaryKind(op), left, right);
+        }
+
+        NodeRef CompactTreeBuilder::unaryOperation(UnaryOperator op, NodeRef operand) {
+            return unary(unaryKind(op), operand);
+        }
+
+        NodeRef CompactTreeBuilder::functionCall(NodeRef identifier, PendingList arguments) {
+            return composite(NodeKind::FUNCTION_CALL, identifier, arguments);
+        }
+
+        NodeRef CompactTreeBuilder::objectLiteral(PendingList fields) {
+            return composite(NodeKind::OBJECT_LITERAL, NodeRef(), fields);
+        }
+
+        NodeRef CompactTreeBuilder::objectField(NodeRef identifier, NodeRef expression) {
+            return binary(NodeKind::OBJECT_FIELD, identifier, expression);
+        }
+
+        NodeRef CompactTreeBuilder::variable(NodeRef identifier, PendingList indices) {
+            return composite(NodeKind::VARIABLE, identifier, indices);
+        }
+
+        NodeRef CompactTreeBuilder::indexExpression(NodeRef value) {
+            return unary(NodeKind::INDEX_EXPRESSION, value);
+        }
+
+        NodeRef CompactTreeBuilder::anyText(boost::string_view text) {
+            return tree.add(tree.texts, NodeKind::ANY_TEXT, CompactTree::Text{tree.addText(text)});
+        }
+
+        NodeRef CompactTreeBuilder::identifier(const lexer::Symbol &name) {
+            return CompactTree::identifier(name);
+        }
+
+        NodeRef CompactTreeBuilder::stringLiteral(boost::string_view value) {
+            return tree.add(tree.texts, NodeKind::STRING_LITERAL, CompactTree::Text{tree.addText(value)});
+        }
+
+        NodeRef CompactTreeBuilder::numberLiteral(double value) {
+            return tree.add(tree.numbers, NodeKind::NUMBER_LITERAL, CompactTree::Number{value});
+        }
+
+        NodeRef CompactTreeBuilder::booleanLiteral(bool value) {
+            return NodeRef(NodeKind::BOOLEAN_LITERAL, value ? 1 : 0);
+        }
+
+        CompactParser::CompactParser(
+                logging::Logger &logger,
+                util::OutputStream<lexer::Lexeme> &lexemes,
+                std::shared_ptr<const lexer::SymbolTable> symbols
+        ) : BasicParser(logger, lexemes, move(symbols)) {
+        }
+
+        CompactParser::CompactParser(logging::Logger &logger, lexer::Lexer &lexer)
+                : CompactParser(logger, lexer, lexer.getSymbols()) {
+        }
+
+        CompactParser::CompactParser(logging::Logger &logger, const lexer::TokenArray &tokens)
+                : BasicParser(logger, tokens) {
+        }
+
+        CompactTree CompactParser::getTree() {
+            build.tree.root = parseScript();
+            return std::move(build.tree);
+        }
+    }
+}
@@ -0,0 +1,168 @@
+#ifndef PARSER_COMPACT_PARSER_HPP
+#define PARSER_COMPACT_PARSER_HPP
+
+#include <vector>
+#include "compact-tree.hpp"
+#include "parser.hpp"
+
+namespace lang {
+    namespace parser {
+        /**
+         * Builds nodes for the grammar by appending them to the pools of a CompactTree as soon as
+         * their children are built, so no node is allocated on its own.
+         */
+        class CompactTreeBuilder {
+            /** References of the lists being built, stacked until each list is complete. */
+            std::vector<NodeRef> pendingItems;
+
+        public:
+            template<typename Node>
+            using Ref = NodeRef;
+
+            /** List being built: references pushed since the first one. */
+            struct PendingList {
+                std::size_t first;
+            };
+
+            template<typename Node>
+            using List = PendingList;
+
+            /** Sizes of all pools, to drop nodes appended after them. */
+            struct Mark {
+                std::size_t unaries;
+                std::size_t binaries;
+                std::size_t quaternaries;
+                std::size_t composites;
+                std::size_t functionDefs;
+                std::size_t htmlTemplates;
+                std::size_t texts;
+                std::size_t numbers;
+                std::size_t lists;
+                std::size_t strings;
+            };
+
+            CompactTree tree;
+
+            Mark mark() const;
+
+            void dropSince(const Mark &mark);
+
+            template<typename Node>
+            List<Node> list() const {
+                return PendingList{pendingItems.size()};
+            }
+
+            void push(PendingList &, NodeRef item) {
+                pendingItems.push_back(item);
+            }
+
+            NodeRef script(PendingList functions, std::shared_ptr<const lexer::SymbolTable> symbols);
+
+            NodeRef functionDef(const lexer::Symbol &name, NodeRef htmlTemplate, NodeRef params, NodeRef value);
+
+            NodeRef functionDefParams(PendingList params);
+
+            /**
+             * Elements and content have to be started together; their items come interleaved
+             * and are split into two lists by kind.
+             */
+            NodeRef htmlTemplate(
+                    NodeRef identifier,
+                    NodeRef attributes,
+                    PendingList elements,
+                    PendingList content,
+                    NodeRef closingParams
+            );
+
+            NodeRef attributeList(PendingList attributes);
+
+            NodeRef attribute(NodeRef identifier, NodeRef value);
+
+            NodeRef attributeValue(NodeRef value, NodeRef string);
+
+            NodeRef injectedValue(NodeRef value);
+
+            NodeRef textContent(NodeRef value, NodeRef text);
+
+            NodeRef returnExpression(NodeRef value);
+
+            NodeRef block(NodeRef value);
+
+            NodeRef declarationExpression(NodeRef identifier, NodeRef value);
+
+            NodeRef forExpression(NodeRef iterator, NodeRef condition, NodeRef expression, NodeRef block);
+
+            NodeRef assignExpression(NodeRef variable, NodeRef value);
+
+            NodeRef ifExpression(NodeRef condition, NodeRef ifBlock, NodeRef elseBlock);
+
+            NodeRef binaryOperation(BinaryOperator op, NodeRef left, NodeRef right);
+
+            NodeRef unaryOperation(UnaryOperator op, NodeRef operand);
+
+            NodeRef functionCall(NodeRef identifier, PendingList arguments);
+
+            NodeRef objectLiteral(PendingList fields);
+
+            NodeRef objectField(NodeRef identifier, NodeRef expression);
+
+            NodeRef variable(NodeRef identifier, PendingList indices);
+
+            NodeRef indexExpression(NodeRef value);
+
+            NodeRef anyText(boost::string_view text);
+
+            NodeRef identifier(const lexer::Symbol &name);
+
+            NodeRef stringLiteral(boost::string_view value);
+
+            NodeRef numberLiteral(double value);
+
+            NodeRef booleanLiteral(bool value);
+
+        private:
+            /**
+             * Stores the references pushed since the list was started as one list, and pops them.
+             */
+            CompactTree::Range popList(PendingList list);
+
+            NodeRef unary(NodeKind kind, NodeRef value);
+
+            NodeRef binary(NodeKind kind, NodeRef left, NodeRef right);
+
+            NodeRef composite(NodeKind kind, NodeRef head, PendingList items);
+        };
+
+        /**
+         * Parses the same grammar as Parser straight into the pools of a CompactTree.
+         */
+        class CompactParser : BasicParser<CompactTreeBuilder> {
+        public:
+            /**
+             * @param symbols Table symbols of the lexemes come from; tree keeps it alive.
+             */
+            CompactParser(
+                    logging::Logger &logger,
+                    util::OutputStream<lexer::Lexeme> &lexemes,
+                    std::shared_ptr<const lexer::SymbolTable> symbols
+            );
+
+            CompactParser(
+                    logging::Logger &logger,
+                    lexer::Lexer &lexer
+            );
+
+            /**
+             * Tokens have to outlive the parser.
+             */
+            CompactParser(
+                    logging::Logger &logger,
+                    const lexer::TokenArray &tokens
+            );
+
+            CompactTree getTree();
+        };
+    }
+}
+
+#endif // PARSER_COMPACT_PARSER_HPP
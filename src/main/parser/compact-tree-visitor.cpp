@@ -0,0 +1,217 @@
+#include "compact-tree-visitor.hpp"
+
+namespace lang {
+    namespace parser {
+        void CompactTreeVisitor::visit(NodeRef node) {
+            const auto index = node.index();
+            switch (node.kind()) {
+                case NodeKind::NONE:
+                    break;
+                case NodeKind::SCRIPT:
+                    visitScript(node, tree.composites[index]);
+                    break;
+                case NodeKind::FUNCTION_DEF:
+                    visitFunctionDef(node, tree.functionDefs[index]);
+                    break;
+                case NodeKind::FUNCTION_DEF_PARAMS:
+                    visitFunctionDefParams(node, tree.composites[index]);
+                    break;
+                case NodeKind::HTML_TEMPLATE:
+                    visitHtmlTemplate(node, tree.htmlTemplates[index]);
+                    break;
+                case NodeKind::ATTRIBUTE:
+                    visitAttribute(node, tree.binaries[index]);
+                    break;
+                case NodeKind::ATTRIBUTE_VALUE:
+                    visitAttributeValue(node, tree.binaries[index]);
+                    break;
+                case NodeKind::ATTRIBUTE_LIST:
+                    visitAttributeList(node, tree.composites[index]);
+                    break;
+                case NodeKind::TEXT_CONTENT:
+                    visitTextContent(node, tree.binaries[index]);
+                    break;
+                case NodeKind::INJECTED_VALUE:
+                    visitInjectedValue(node, tree.unaries[index]);
+                    break;
+                case NodeKind::RETURN_EXPRESSION:
+                    visitReturnExpression(node, tree.unaries[index]);
+                    break;
+                case NodeKind::BLOCK:
+                    visitBlock(node, tree.unaries[index]);
+                    break;
+                case NodeKind::DECLARATION_EXPRESSION:
+                    visitDeclarationExpression(node, tree.binaries[index]);
+                    break;
+                case NodeKind::FOR_EXPRESSION:
+                    visitForExpression(node, tree.quaternaries[index]);
+                    break;
+                case NodeKind::ASSIGN_EXPRESSION:
+                    visitAssignExpression(node, tree.binaries[index]);
+                    break;
+                case NodeKind::IF_EXPRESSION:
+                    visitIfExpression(node, tree.quaternaries[index]);
+                    break;
+                case NodeKind::OR:
+                case NodeKind::AND:
+                case NodeKind::EQUAL:
+                case NodeKind::NOT_EQUAL:
+                case NodeKind::LESS:
+                case NodeKind::GREATER:
+                case NodeKind::LESS_EQUAL:
+                case NodeKind::GREATER_EQUAL:
+                case NodeKind::ADD:
+                case NodeKind::SUBTRACT:
+                case NodeKind::MULTIPLY:
+                case NodeKind::DIVIDE:
+                    visitBinaryOperation(node, static_cast<BinaryOperator>(
+                            static_cast<int>(node.kind()) - static_cast<int>(NodeKind::OR)), tree.binaries[index]);
+                    break;
+                case NodeKind::NEGATE:
+                case NodeKind::NOT:
+                    visitUnaryOperation(node, static_cast<UnaryOperator>(
+                            static_cast<int>(node.kind()) - static_cast<int>(NodeKind::NEGATE)), tree.unaries[index]);
+                    break;
+                case NodeKind::FUNCTION_CALL:
+                    visitFunctionCall(node, tree.composites[index]);
+                    break;
+                case NodeKind::OBJECT_LITERAL:
+                    visitObjectLiteral(node, tree.composites[index]);
+                    break;
+                case NodeKind::OBJECT_FIELD:
+                    visitObjectField(node, tree.binaries[index]);
+                    break;
+                case NodeKind::VARIABLE:
+                    visitVariable(node, tree.composites[index]);
+                    break;
+                case NodeKind::INDEX_EXPRESSION:
+                    visitIndexExpression(node, tree.unaries[index]);
+                    break;
+                case NodeKind::ANY_TEXT:
+                    visitAnyText(node, tree.texts[index]);
+                    break;
+                case NodeKind::IDENTIFIER:
+                    visitIdentifier(node, index);
+                    break;
+                case NodeKind::STRING_LITERAL:
+                    visitStringLiteral(node, tree.texts[index]);
+                    break;
+                case NodeKind::NUMBER_LITERAL:
+                    visitNumberLiteral(node, tree.numbers[index].value);
+                    break;
+                case NodeKind::BOOLEAN_LITERAL:
+                    visitBooleanLiteral(node, index != 0);
+                    break;
+            }
+        }
+
+        void CompactTreeVisitor::visitChildren(NodeRef node) {
+            tree.forEachChild(node, [this](NodeRef child) {
+                visit(child);
+            });
+        }
+
+        void CompactTreeVisitor::visitScript(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitFunctionDef(NodeRef node, const CompactTree::FunctionDef &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitFunctionDefParams(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitHtmlTemplate(NodeRef node, const CompactTree::HtmlTemplate &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitAttribute(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitAttributeValue(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitAttributeList(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitTextContent(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitInjectedValue(NodeRef node, const CompactTree::Unary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitReturnExpression(NodeRef node, const CompactTree::Unary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitBlock(NodeRef node, const CompactTree::Unary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitDeclarationExpression(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitForExpression(NodeRef node, const CompactTree::Quaternary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitAssignExpression(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitIfExpression(NodeRef node, const CompactTree::Quaternary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitBinaryOperation(NodeRef node, BinaryOperator, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitUnaryOperation(NodeRef node, UnaryOperator, const CompactTree::Unary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitFunctionCall(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitObjectLiteral(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitObjectField(NodeRef node, const CompactTree::Binary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitVariable(NodeRef node, const CompactTree::Composite &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitIndexExpression(NodeRef node, const CompactTree::Unary &) {
+            visitChildren(node);
+        }
+
+        void CompactTreeVisitor::visitAnyText(NodeRef, const CompactTree::Text &) {
+        }
+
+        void CompactTreeVisitor::visitIdentifier(NodeRef, std::uint32_t) {
+        }
+
+        void CompactTreeVisitor::visitStringLiteral(NodeRef, const CompactTree::Text &) {
+        }
+
+        void CompactTreeVisitor::visitNumberLiteral(NodeRef, double) {
+        }
+
+        void CompactTreeVisitor::visitBooleanLiteral(NodeRef, bool) {
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef PARSER_COMPACT_TREE_VISITOR_HPP
+#define PARSER_COMPACT_TREE_VISITOR_HPP
+
+#include "compact-tree.hpp"
+
+namespace lang {
+    namespace parser {
+        /**
+         * Walks the pools of a compact tree, dispatching on the kind of every reference, with the data
+         * of the node read in place. Every method visits the children of its node by default, so a visitor
+         * overrides only the nodes it is interested in, and calls visitChildren to go on below them.
+         */
+        class CompactTreeVisitor {
+        public:
+            explicit CompactTreeVisitor(const CompactTree &tree) : tree(tree) {
+            }
+
+            virtual ~CompactTreeVisitor() {};
+
+            /**
+             * Visits the node the reference points to; null reference is skipped.
+             */
+            void visit(NodeRef node);
+
+        protected:
+            const CompactTree &tree;
+
+            void visitChildren(NodeRef node);
+
+            virtual void visitScript(NodeRef node, const CompactTree::Composite &script);
+
+            virtual void visitFunctionDef(NodeRef node, const CompactTree::FunctionDef &function);
+
+            virtual void visitFunctionDefParams(NodeRef node, const CompactTree::Composite &params);
+
+            virtual void visitHtmlTemplate(NodeRef node, const CompactTree::HtmlTemplate &htmlTemplate);
+
+            virtual void visitAttribute(NodeRef node, const CompactTree::Binary &attribute);
+
+            virtual void visitAttributeValue(NodeRef node, const CompactTree::Binary &value);
+
+            virtual void visitAttributeList(NodeRef node, const CompactTree::Composite &attributes);
+
+            virtual void visitTextContent(NodeRef node, const CompactTree::Binary &content);
+
+            virtual void visitInjectedValue(NodeRef node, const CompactTree::Unary &value);
+
+            virtual void visitReturnExpression(NodeRef node, const CompactTree::Unary &expression);
+
+            virtual void visitBlock(NodeRef node, const CompactTree::Unary &block);
+
+            virtual void visitDeclarationExpression(NodeRef node, const CompactTree::Binary &declaration);
+
+            virtual void visitForExpression(NodeRef node, const CompactTree::Quaternary &expression);
+
+            virtual void visitAssignExpression(NodeRef node, const CompactTree::Binary &assignment);
+
+            virtual void visitIfExpression(NodeRef node, const CompactTree::Quaternary &expression);
+
+            virtual void visitBinaryOperation(NodeRef node, BinaryOperator op, const CompactTree::Binary &operands);
+
+            virtual void visitUnaryOperation(NodeRef node, UnaryOperator op, const CompactTree::Unary &operand);
+
+            virtual void visitFunctionCall(NodeRef node, const CompactTree::Composite &call);
+
+            virtual void visitObjectLiteral(NodeRef node, const CompactTree::Composite &literal);
+
+            virtual void visitObjectField(NodeRef node, const CompactTree::Binary &field);
+
+            virtual void visitVariable(NodeRef node, const CompactTree::Composite &variable);
+
+            virtual void visitIndexExpression(NodeRef node, const CompactTree::Unary &index);
+
+            virtual void visitAnyText(NodeRef node, const CompactTree::Text &text);
+
+            /**
+             * @param symbol Id of the name in the symbol table of the tree.
+             */
+            virtual void visitIdentifier(NodeRef node, std::uint32_t symbol);
+
+            virtual void visitStringLiteral(NodeRef node, const CompactTree::Text &text);
+
+            virtual void visitNumberLiteral(NodeRef node, double value);
+
+            virtual void visitBooleanLiteral(NodeRef node, bool value);
+        };
+    }
+}
+
+#endif // PARSER_COMPACT_TREE_VISITOR_HPP
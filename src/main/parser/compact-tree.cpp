@@ -0,0 +1,560 @@
+#include "compact-tree.hpp"
+#include "node-visitor.hpp"
+
+namespace lang {
+    namespace parser {
+        NodeShape shapeOf(NodeKind kind) {
+            switch (kind) {
+                case NodeKind::NONE:
+                case NodeKind::IDENTIFIER:
+                case NodeKind::BOOLEAN_LITERAL:
+                    return NodeShape::INLINE;
+
+                case NodeKind::INJECTED_VALUE:
+                case NodeKind::RETURN_EXPRESSION:
+                case NodeKind::BLOCK:
+                case NodeKind::NEGATE:
+                case NodeKind::NOT:
+                case NodeKind::INDEX_EXPRESSION:
+                    return NodeShape::UNARY;
+
+                case NodeKind::ATTRIBUTE:
+                case NodeKind::ATTRIBUTE_VALUE:
+                case NodeKind::TEXT_CONTENT:
+                case NodeKind::DECLARATION_EXPRESSION:
+                case NodeKind::ASSIGN_EXPRESSION:
+                case NodeKind::OR:
+                case NodeKind::AND:
+                case NodeKind::EQUAL:
+                case NodeKind::NOT_EQUAL:
+                case NodeKind::LESS:
+                case NodeKind::GREATER:
+                case NodeKind::LESS_EQUAL:
+                case NodeKind::GREATER_EQUAL:
+                case NodeKind::ADD:
+                case NodeKind::SUBTRACT:
+                case NodeKind::MULTIPLY:
+                case NodeKind::DIVIDE:
+                case NodeKind::OBJECT_FIELD:
+                    return NodeShape::BINARY;
+
+                case NodeKind::FOR_EXPRESSION:
+                case NodeKind::IF_EXPRESSION:
+                    return NodeShape::QUATERNARY;
+
+                case NodeKind::SCRIPT:
+                case NodeKind::FUNCTION_DEF_PARAMS:
+                case NodeKind::ATTRIBUTE_LIST:
+                case NodeKind::FUNCTION_CALL:
+                case NodeKind::OBJECT_LITERAL:
+                case NodeKind::VARIABLE:
+                    return NodeShape::COMPOSITE;
+
+                case NodeKind::FUNCTION_DEF:
+                    return NodeShape::FUNCTION_DEF;
+
+                case NodeKind::HTML_TEMPLATE:
+                    return NodeShape::HTML_TEMPLATE;
+
+                case NodeKind::ANY_TEXT:
+                case NodeKind::STRING_LITERAL:
+                    return NodeShape::TEXT;
+
+                case NodeKind::NUMBER_LITERAL:
+                    return NodeShape::NUMBER;
+            }
+            return NodeShape::INLINE;
+        }
+
+        NodeKind binaryKind(BinaryOperator op) {
+            return static_cast<NodeKind>(static_cast<int>(NodeKind::OR) + static_cast<int>(op));
+        }
+
+        NodeKind unaryKind(UnaryOperator op) {
+            return static_cast<NodeKind>(static_cast<int>(NodeKind::NEGATE) + static_cast<int>(op));
+        }
+
+        namespace {
+            /**
+             * Flattens the node graph into the pools, children first.
+             */
+            class Compactor : public NodeVisitor {
+                CompactTree &tree;
+                NodeRef result;
+
+            public:
+                explicit Compactor(CompactTree &tree) : tree(tree) {
+                }
+
+                template<typename T>
+                NodeRef compact(const std::unique_ptr<T> &node) {
+                    if (!node)
+                        return NodeRef();
+                    node->visit(*this);
+                    return result;
+                }
+
+                NodeRef compact(const Node &node) {
+                    node.visit(*this);
+                    return result;
+                }
+
+                void visit(const ScriptNode &node) override {
+                    composite(NodeKind::SCRIPT, NodeRef(), list(node.functions));
+                }
+
+                void visit(const FunctionDefNode &node) override {
+                    CompactTree::FunctionDef value{};
+                    value.name = node.name.getId();
+                    value.htmlTemplate = compact(node.htmltemplate);
+                    value.params = compact(node.params);
+                    value.value = compact(node.value);
+                    result = tree.add(tree.functionDefs, NodeKind::FUNCTION_DEF, value);
+                }
+
+                void visit(const FunctionDefParamsNode &node) override {
+                    composite(NodeKind::FUNCTION_DEF_PARAMS, NodeRef(), list(node.params));
+                }
+
+                void visit(const HtmlTemplateNode &node) override {
+                    CompactTree::HtmlTemplate value{};
+                    value.identifier = compact(node.identifier);
+                    value.attributes = compact(node.attributes);
+                    value.elements = list(node.htmlValue);
+                    value.content = list(node.value);
+                    value.closingParams = compact(node.closingParams);
+                    result = tree.add(tree.htmlTemplates, NodeKind::HTML_TEMPLATE, value);
+                }
+
+                void visit(const AttributeNode &node) override {
+                    binary(NodeKind::ATTRIBUTE, node.identifier, node.value);
+                }
+
+                void visit(const AttributeValueNode &node) override {
+                    binary(NodeKind::ATTRIBUTE_VALUE, node.value, node.string);
+                }
+
+                void visit(const AttributeListNode &node) override {
+                    composite(NodeKind::ATTRIBUTE_LIST, NodeRef(), list(node.value));
+                }
+
+                void visit(const TextContentNode &node) override {
+                    binary(NodeKind::TEXT_CONTENT, node.value, node.anytext);
+                }
+
+                void visit(const InjectedValueNode &node) override {
+                    unary(NodeKind::INJECTED_VALUE, node.value);
+                }
+
+                void visit(const ReturnExpressionNode &node) override {
+                    unary(NodeKind::RETURN_EXPRESSION, node.returnValue);
+                }
+
+                void visit(const BlockNode &node) override {
+                    unary(NodeKind::BLOCK, node.value);
+                }
+
+                void visit(const DeclarationExpressionNode &node) override {
+                    binary(NodeKind::DECLARATION_EXPRESSION, node.identifier, node.value);
+                }
+
+                void visit(const ForExpressionNode &node) override {
+                    CompactTree::Quaternary value{};
+                    value.children[0] = compact(node.iterator);
+                    value.children[1] = compact(node.condition);
+                    value.children[2] = compact(node.expression);
+                    value.children[3] = compact(node.block);
+                    result = tree.add(tree.quaternaries, NodeKind::FOR_EXPRESSION, value);
+                }
+
+                void visit(const AssignExpressionNode &node) override {
+                    binary(NodeKind::ASSIGN_EXPRESSION, node.variable, node.value);
+                }
+
+                void visit(const IfExpressionNode &node) override {
+                    CompactTree::Quaternary value{};
+                    value.children[0] = compact(node.condition);
+                    value.children[1] = compact(node.ifBlock);
+                    value.children[2] = compact(node.elseBlock);
+                    result = tree.add(tree.quaternaries, NodeKind::IF_EXPRESSION, value);
+                }
+
+                void visit(const BinaryOperationNode &node) override {
+                    binary(binaryKind(node.op), node.left, node.right);
+                }
+
+                void visit(const UnaryOperationNode &node) override {
+                    unary(unaryKind(node.op), node.operand);
+                }
+
+                void visit(const FunctionCallNode &node) override {
+                    const auto identifier = compact(node.identifier);
+                    composite(NodeKind::FUNCTION_CALL, identifier, list(node.value));
+                }
+
+                void visit(const ObjectLiteralNode &node) override {
+                    composite(NodeKind::OBJECT_LITERAL, NodeRef(), list(node.injection));
+                }
+
+                void visit(const ObjectFieldNode &node) override {
+                    binary(NodeKind::OBJECT_FIELD, node.identifier, node.expression);
+                }
+
+                void visit(const VariableNode &node) override {
+                    const auto identifier = compact(node.identifier);
+                    composite(NodeKind::VARIABLE, identifier, list(node.indices));
+                }
+
+                void visit(const IndexExpressionNode &node) override {
+                    unary(NodeKind::INDEX_EXPRESSION, node.value);
+                }
+
+                void visit(const AnyTextNode &node) override {
+                    CompactTree::Text value{};
+                    value.text = tree.addText(node.text);
+                    result = tree.add(tree.texts, NodeKind::ANY_TEXT, value);
+                }
+
+                void visit(const IdentifierNode &node) override {
+                    result = CompactTree::identifier(node.name);
+                }
+
+                void visit(const StringLiteralNode &node) override {
+                    CompactTree::Text value{};
+                    value.text = tree.addText(node.value);
+                    result = tree.add(tree.texts, NodeKind::STRING_LITERAL, value);
+                }
+
+                void visit(const NumberLiteralNode &node) override {
+                    result = tree.add(tree.numbers, NodeKind::NUMBER_LITERAL, CompactTree::Number{node.value});
+                }
+
+                void visit(const BooleanLiteralNode &node) override {
+                    result = NodeRef(NodeKind::BOOLEAN_LITERAL, node.value ? 1 : 0);
+                }
+
+            private:
+                template<typename A>
+                void unary(NodeKind kind, const std::unique_ptr<A> &value) {
+                    const CompactTree::Unary shape{compact(value)};
+                    result = tree.add(tree.unaries, kind, shape);
+                }
+
+                template<typename L, typename R>
+                void binary(NodeKind kind, const std::unique_ptr<L> &left, const std::unique_ptr<R> &right) {
+                    CompactTree::Binary shape{};
+                    shape.left = compact(left);
+                    shape.right = compact(right);
+                    result = tree.add(tree.binaries, kind, shape);
+                }
+
+                void composite(NodeKind kind, NodeRef head, CompactTree::Range items) {
+                    result = tree.add(tree.composites, kind, CompactTree::Composite{head, items});
+                }
+
+                /**
+                 * Compacts items first, as their own lists are appended meanwhile, then stores them contiguously.
+                 */
+                template<typename T>
+                CompactTree::Range list(const std::vector<std::unique_ptr<T>> &items) {
+                    std::vector<NodeRef> refs;
+                    refs.reserve(items.size());
+                    for (const auto &item : items)
+                        refs.push_back(compact(item));
+                    return tree.addList(refs.data(), refs.size());
+                }
+            };
+
+            /**
+             * Recreates heap nodes from the pools.
+             */
+            class Expander {
+                const CompactTree &tree;
+
+            public:
+                explicit Expander(const CompactTree &tree) : tree(tree) {
+                }
+
+                /**
+                 * @throws std::invalid_argument if the node is not of type T, which only a tree that
+                 *     was not built by the parser or checked on load can hold.
+                 */
+                template<typename T>
+                std::unique_ptr<T> expand(NodeRef ref) const {
+                    auto node = expandNode(ref);
+                    if (!node)
+                        return nullptr;
+                    auto *typed = dynamic_cast<T *>(node.get());
+                    if (!typed)
+                        throw std::invalid_argument("compact tree holds node of kind "
+                                                    + std::to_string(static_cast<int>(ref.kind()))
+                                                    + " in a field of other type");
+                    node.release();
+                    return std::unique_ptr<T>(typed);
+                }
+
+            private:
+                template<typename T>
+                std::vector<std::unique_ptr<T>> expandList(CompactTree::Range range) const {
+                    std::vector<std::unique_ptr<T>> result;
+                    result.reserve(range.count);
+                    for (auto it = tree.listBegin(range); it != tree.listEnd(range); ++it)
+                        result.push_back(expand<T>(*it));
+                    return result;
+                }
+
+                lexer::Symbol symbol(std::uint32_t id) const {
+                    if (id == lexer::Symbol::invalidId || id == NodeRef::maxIndex || !tree.symbols)
+                        return lexer::Symbol();
+                    return (*tree.symbols)[id];
+                }
+
+                std::unique_ptr<Node> expandNode(NodeRef ref) const {
+                    const auto index = ref.index();
+                    switch (ref.kind()) {
+                        case NodeKind::NONE:
+                            return nullptr;
+
+                        case NodeKind::SCRIPT: {
+                            auto node = std::unique_ptr<ScriptNode>(new ScriptNode);
+                            node->functions = expandList<FunctionDefNode>(tree.composites[index].items);
+                            node->symbols = tree.symbols;
+                            return move(node);
+                        }
+                        case NodeKind::FUNCTION_DEF: {
+                            const auto &shape = tree.functionDefs[index];
+                            auto node = std::unique_ptr<FunctionDefNode>(new FunctionDefNode);
+                            node->name = symbol(shape.name);
+                            node->htmltemplate = expand<HtmlTemplateNode>(shape.htmlTemplate);
+                            node->params = expand<FunctionDefParamsNode>(shape.params);
+                            node->value = expand<ExpressionNode>(shape.value);
+                            return move(node);
+                        }
+                        case NodeKind::FUNCTION_DEF_PARAMS: {
+                            auto node = std::unique_ptr<FunctionDefParamsNode>(new FunctionDefParamsNode);
+                            node->params = expandList<IdentifierNode>(tree.composites[index].items);
+                            return move(node);
+                        }
+                        case NodeKind::HTML_TEMPLATE: {
+                            const auto &shape = tree.htmlTemplates[index];
+                            auto node = std::unique_ptr<HtmlTemplateNode>(new HtmlTemplateNode);
+                            node->identifier = expand<IdentifierNode>(shape.identifier);
+                            node->attributes = expand<AttributeListNode>(shape.attributes);
+                            node->htmlValue = expandList<HtmlTemplateNode>(shape.elements);
+                            node->value = expandList<TextContentNode>(shape.content);
+                            node->closingParams = expand<IdentifierNode>(shape.closingParams);
+                            return move(node);
+                        }
+                        case NodeKind::ATTRIBUTE: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<AttributeNode>(new AttributeNode);
+                            node->identifier = expand<IdentifierNode>(shape.left);
+                            node->value = expand<AttributeValueNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::ATTRIBUTE_VALUE: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<AttributeValueNode>(new AttributeValueNode);
+                            node->value = expand<InjectedValueNode>(shape.left);
+                            node->string = expand<BaseMathExpressionNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::ATTRIBUTE_LIST: {
+                            auto node = std::unique_ptr<AttributeListNode>(new AttributeListNode);
+                            node->value = expandList<AttributeNode>(tree.composites[index].items);
+                            return move(node);
+                        }
+                        case NodeKind::TEXT_CONTENT: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<TextContentNode>(new TextContentNode);
+                            node->value = expand<TextContentNode>(shape.left);
+                            node->anytext = expand<AnyTextNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::INJECTED_VALUE: {
+                            auto node = std::unique_ptr<InjectedValueNode>(new InjectedValueNode);
+                            node->value = expand<IdentifierNode>(tree.unaries[index].value);
+                            return move(node);
+                        }
+                        case NodeKind::RETURN_EXPRESSION: {
+                            auto node = std::unique_ptr<ReturnExpressionNode>(new ReturnExpressionNode);
+                            node->returnValue = expand<ExpressionNode>(tree.unaries[index].value);
+                            return move(node);
+                        }
+                        case NodeKind::BLOCK: {
+                            auto node = std::unique_ptr<BlockNode>(new BlockNode);
+                            node->value = expand<ExpressionNode>(tree.unaries[index].value);
+                            return move(node);
+                        }
+                        case NodeKind::DECLARATION_EXPRESSION: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<DeclarationExpressionNode>(new DeclarationExpressionNode);
+                            node->identifier = expand<IdentifierNode>(shape.left);
+                            node->value = expand<ExpressionNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::FOR_EXPRESSION: {
+                            const auto &shape = tree.quaternaries[index];
+                            auto node = std::unique_ptr<ForExpressionNode>(new ForExpressionNode);
+                            node->iterator = expand<DeclarationExpressionNode>(shape.children[0]);
+                            node->condition = expand<ExpressionNode>(shape.children[1]);
+                            node->expression = expand<AssignExpressionNode>(shape.children[2]);
+                            node->block = expand<BlockNode>(shape.children[3]);
+                            return move(node);
+                        }
+                        case NodeKind::ASSIGN_EXPRESSION: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<AssignExpressionNode>(new AssignExpressionNode);
+                            node->variable = expand<VariableNode>(shape.left);
+                            node->value = expand<ExpressionNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::IF_EXPRESSION: {
+                            const auto &shape = tree.quaternaries[index];
+                            auto node = std::unique_ptr<IfExpressionNode>(new IfExpressionNode);
+                            node->condition = expand<ExpressionNode>(shape.children[0]);
+                            node->ifBlock = expand<BlockNode>(shape.children[1]);
+                            node->elseBlock = expand<BlockNode>(shape.children[2]);
+                            return move(node);
+                        }
+                        case NodeKind::OR:
+                        case NodeKind::AND:
+                        case NodeKind::EQUAL:
+                        case NodeKind::NOT_EQUAL:
+                        case NodeKind::LESS:
+                        case NodeKind::GREATER:
+                        case NodeKind::LESS_EQUAL:
+                        case NodeKind::GREATER_EQUAL:
+                        case NodeKind::ADD:
+                        case NodeKind::SUBTRACT:
+                        case NodeKind::MULTIPLY:
+                        case NodeKind::DIVIDE: {
+                            const auto &shape = tree.binaries[index];
+                            const auto op = static_cast<BinaryOperator>(
+                                    static_cast<int>(ref.kind()) - static_cast<int>(NodeKind::OR));
+                            return std::unique_ptr<Node>(new BinaryOperationNode(
+                                    op, expand<ExpressionNode>(shape.left), expand<ExpressionNode>(shape.right)));
+                        }
+                        case NodeKind::NEGATE:
+                        case NodeKind::NOT: {
+                            const auto op = static_cast<UnaryOperator>(
+                                    static_cast<int>(ref.kind()) - static_cast<int>(NodeKind::NEGATE));
+                            return std::unique_ptr<Node>(
+                                    new UnaryOperationNode(op, expand<ExpressionNode>(tree.unaries[index].value)));
+                        }
+                        case NodeKind::FUNCTION_CALL: {
+                            const auto &shape = tree.composites[index];
+                            auto node = std::unique_ptr<FunctionCallNode>(new FunctionCallNode);
+                            node->identifier = expand<IdentifierNode>(shape.head);
+                            node->value = expandList<ExpressionNode>(shape.items);
+                            return move(node);
+                        }
+                        case NodeKind::OBJECT_LITERAL: {
+                            auto node = std::unique_ptr<ObjectLiteralNode>(new ObjectLiteralNode);
+                            node->injection = expandList<ObjectFieldNode>(tree.composites[index].items);
+                            return move(node);
+                        }
+                        case NodeKind::OBJECT_FIELD: {
+                            const auto &shape = tree.binaries[index];
+                            auto node = std::unique_ptr<ObjectFieldNode>(new ObjectFieldNode);
+                            node->identifier = expand<IdentifierNode>(shape.left);
+                            node->expression = expand<ExpressionNode>(shape.right);
+                            return move(node);
+                        }
+                        case NodeKind::VARIABLE: {
+                            const auto &shape = tree.composites[index];
+                            auto node = std::unique_ptr<VariableNode>(new VariableNode);
+                            node->identifier = expand<IdentifierNode>(shape.head);
+                            node->indices = expandList<IndexExpressionNode>(shape.items);
+                            return move(node);
+                        }
+                        case NodeKind::INDEX_EXPRESSION: {
+                            auto node = std::unique_ptr<IndexExpressionNode>(new IndexExpressionNode);
+                            node->value = expand<ExpressionNode>(tree.unaries[index].value);
+                            return move(node);
+                        }
+                        case NodeKind::ANY_TEXT: {
+                            const auto &shape = tree.texts[index];
+                            auto node = std::unique_ptr<AnyTextNode>(new AnyTextNode);
+                            node->text = tree.text(shape.text);
+                            return move(node);
+                        }
+                        case NodeKind::IDENTIFIER: {
+                            auto node = std::unique_ptr<IdentifierNode>(new IdentifierNode);
+                            node->name = symbol(index);
+                            return move(node);
+                        }
+                        case NodeKind::STRING_LITERAL: {
+                            const auto &shape = tree.texts[index];
+                            return std::unique_ptr<Node>(new StringLiteralNode(tree.text(shape.text)));
+                        }
+                        case NodeKind::NUMBER_LITERAL: {
+                            return std::unique_ptr<Node>(new NumberLiteralNode(tree.numbers[index].value));
+                        }
+                        case NodeKind::BOOLEAN_LITERAL:
+                            return std::unique_ptr<Node>(new BooleanLiteralNode(index != 0));
+                    }
+                    return nullptr;
+                }
+            };
+        }
+
+        CompactTree CompactTree::fromTree(const ScriptNode &script) {
+            CompactTree tree;
+            tree.symbols = script.symbols;
+            tree.root = Compactor(tree).compact(script);
+            return tree;
+        }
+
+        std::unique_ptr<ScriptNode> CompactTree::expand() const {
+            return Expander(*this).expand<ScriptNode>(root);
+        }
+
+        CompactTree::Range CompactTree::addList(const NodeRef *first, std::size_t count) {
+            const Range range{static_cast<std::uint32_t>(lists.size()), static_cast<std::uint32_t>(count)};
+            lists.insert(lists.end(), first, first + count);
+            return range;
+        }
+
+        CompactTree::Range CompactTree::addText(boost::string_view value) {
+            const Range range{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(value.size())};
+            strings.append(value.data(), value.size());
+            return range;
+        }
+
+        NodeRef CompactTree::identifier(const lexer::Symbol &symbol) {
+            return NodeRef(NodeKind::IDENTIFIER,
+                           symbol.getId() == lexer::Symbol::invalidId ? NodeRef::maxIndex : symbol.getId());
+        }
+
+        std::size_t CompactTree::nodeCount() const {
+            if (!root)
+                return 0;
+
+            std::size_t count = 0;
+            std::vector<NodeRef> pending{root};
+            while (!pending.empty()) {
+                const auto node = pending.back();
+                pending.pop_back();
+                ++count;
+                forEachChild(node, [&pending](NodeRef child) {
+                    pending.push_back(child);
+                });
+            }
+            return count;
+        }
+
+        std::size_t CompactTree::memoryUsage() const {
+            return unaries.capacity() * sizeof(Unary)
+                   + binaries.capacity() * sizeof(Binary)
+                   + quaternaries.capacity() * sizeof(Quaternary)
+                   + composites.capacity() * sizeof(Composite)
+                   + functionDefs.capacity() * sizeof(FunctionDef)
+                   + htmlTemplates.capacity() * sizeof(HtmlTemplate)
+                   + texts.capacity() * sizeof(Text)
+                   + numbers.capacity() * sizeof(Number)
+                   + lists.capacity() * sizeof(NodeRef)
+                   + strings.capacity();
+        }
+    }
+}
@@ -0,0 +1,327 @@
+#ifndef PARSER_COMPACT_TREE_HPP
+#define PARSER_COMPACT_TREE_HPP
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/utility/string_view.hpp>
+#include "../lexer/symbol-table.hpp"
+#include "node.hpp"
+
+namespace lang {
+    namespace parser {
+        enum class NodeKind : std::uint8_t {
+            NONE = 0,
+
+            SCRIPT,
+            FUNCTION_DEF,
+            FUNCTION_DEF_PARAMS,
+            HTML_TEMPLATE,
+            ATTRIBUTE,
+            ATTRIBUTE_VALUE,
+            ATTRIBUTE_LIST,
+            TEXT_CONTENT,
+            INJECTED_VALUE,
+            RETURN_EXPRESSION,
+            BLOCK,
+            DECLARATION_EXPRESSION,
+            FOR_EXPRESSION,
+            ASSIGN_EXPRESSION,
+            IF_EXPRESSION,
+            FUNCTION_CALL,
+
+            /** Binary operations, one kind per operator in order of BinaryOperator. */
+            OR,
+            AND,
+            EQUAL,
+            NOT_EQUAL,
+            LESS,
+            GREATER,
+            LESS_EQUAL,
+            GREATER_EQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
+
+            /** Unary operations, in order of UnaryOperator. */
+            NEGATE,
+            NOT,
+
+            OBJECT_LITERAL,
+            OBJECT_FIELD,
+            VARIABLE,
+            INDEX_EXPRESSION,
+            ANY_TEXT,
+            IDENTIFIER,
+            STRING_LITERAL,
+            NUMBER_LITERAL,
+            BOOLEAN_LITERAL,
+        };
+
+        /**
+         * Layout of node data; nodes of the same shape share one pool, whatever their kind.
+         */
+        enum class NodeShape : std::uint8_t {
+            /** Value is kept in the reference itself (symbol id or boolean). */
+            INLINE,
+            UNARY,
+            BINARY,
+            QUATERNARY,
+            COMPOSITE,
+            FUNCTION_DEF,
+            HTML_TEMPLATE,
+            TEXT,
+            NUMBER,
+        };
+
+        /**
+         * 32-bit link to a node: kind in the upper 8 bits, index into the pool of its shape in the lower 24 bits.
+         * Default constructed reference points to no node.
+         */
+        class NodeRef {
+            std::uint32_t bits = 0;
+
+        public:
+            static const std::uint32_t maxIndex = (std::uint32_t(1) << 24) - 1;
+
+            NodeRef() = default;
+
+            NodeRef(NodeKind kind, std::uint32_t index)
+                    : bits(static_cast<std::uint32_t>(kind) << 24 | index) {
+            }
+
+            NodeKind kind() const {
+                return static_cast<NodeKind>(bits >> 24);
+            }
+
+            std::uint32_t index() const {
+                return bits & maxIndex;
+            }
+
+            std::uint32_t raw() const {
+                return bits;
+            }
+
+            static NodeRef fromRaw(std::uint32_t bits) {
+                NodeRef result;
+                result.bits = bits;
+                return result;
+            }
+
+            explicit operator bool() const {
+                return kind() != NodeKind::NONE;
+            }
+
+            bool operator==(const NodeRef &other) const {
+                return bits == other.bits;
+            }
+
+            bool operator!=(const NodeRef &other) const {
+                return bits != other.bits;
+            }
+        };
+
+        NodeShape shapeOf(NodeKind kind);
+
+        NodeKind binaryKind(BinaryOperator op);
+
+        NodeKind unaryKind(UnaryOperator op);
+
+        /**
+         * Whole syntax tree in a handful of contiguous pools, freed at once with the tree.
+         * Child lists of all nodes are ranges of one shared array of references, texts are ranges
+         * of one shared string. Written by CompactParser straight from the lexemes, or built from a parsed
+         * ScriptNode; children are always stored before their parents. CompactTreeVisitor walks the pools,
+         * expand() recreates the node graph for code written against NodeVisitor.
+         */
+        struct CompactTree {
+            struct Range {
+                std::uint32_t first;
+                std::uint32_t count;
+            };
+
+            /**
+             * Unary operations, return value, blocks, index and injected value.
+             */
+            struct Unary {
+                NodeRef value;
+            };
+
+            /**
+             * Binary operators and other nodes with two children, in order of their fields.
+             */
+            struct Binary {
+                NodeRef left;
+                NodeRef right;
+            };
+
+            /**
+             * For and if expressions, in order of their fields.
+             */
+            struct Quaternary {
+                NodeRef children[4];
+            };
+
+            /**
+             * Node with optional head child followed by a list: calls, variables, object literals
+             * and parameter or attribute lists.
+             */
+            struct Composite {
+                NodeRef head;
+                Range items;
+            };
+
+            struct FunctionDef {
+                std::uint32_t name;
+                NodeRef htmlTemplate;
+                NodeRef params;
+                NodeRef value;
+            };
+
+            struct HtmlTemplate {
+                NodeRef identifier;
+                NodeRef attributes;
+                NodeRef closingParams;
+                Range elements;
+                Range content;
+            };
+
+            /**
+             * Template text or string literal.
+             */
+            struct Text {
+                Range text;
+            };
+
+            struct Number {
+                double value;
+            };
+
+            std::shared_ptr<const lexer::SymbolTable> symbols;
+            NodeRef root;
+
+            std::vector<Unary> unaries;
+            std::vector<Binary> binaries;
+            std::vector<Quaternary> quaternaries;
+            std::vector<Composite> composites;
+            std::vector<FunctionDef> functionDefs;
+            std::vector<HtmlTemplate> htmlTemplates;
+            std::vector<Text> texts;
+            std::vector<Number> numbers;
+            std::vector<NodeRef> lists;
+            std::string strings;
+
+            static CompactTree fromTree(const ScriptNode &script);
+
+            /**
+             * Recreates the node graph, for visitors written against NodeVisitor.
+             * @throws std::invalid_argument if a field holds a node of other type.
+             */
+            std::unique_ptr<ScriptNode> expand() const;
+
+            /**
+             * @return Number of nodes reachable from root, including root.
+             */
+            std::size_t nodeCount() const;
+
+            /**
+             * @return Bytes held by the pools.
+             */
+            std::size_t memoryUsage() const;
+
+            const NodeRef *listBegin(Range range) const {
+                return lists.data() + range.first;
+            }
+
+            const NodeRef *listEnd(Range range) const {
+                return lists.data() + range.first + range.count;
+            }
+
+            std::string text(Range range) const {
+                return strings.substr(range.first, range.count);
+            }
+
+            /**
+             * Appends the node to the pool of its shape.
+             */
+            template<typename Shape>
+            NodeRef add(std::vector<Shape> &pool, NodeKind kind, const Shape &value);
+
+            /**
+             * Copies the references to the end of the shared list array.
+             */
+            Range addList(const NodeRef *first, std::size_t count);
+
+            Range addText(boost::string_view value);
+
+            static NodeRef identifier(const lexer::Symbol &symbol);
+
+            /**
+             * Calls action for every direct child of the node, in order of fields of the node type.
+             */
+            template<typename F>
+            void forEachChild(NodeRef node, F action) const;
+        };
+
+        template<typename Shape>
+        NodeRef CompactTree::add(std::vector<Shape> &pool, NodeKind kind, const Shape &value) {
+            if (pool.size() > NodeRef::maxIndex)
+                throw std::length_error("too many nodes for compact tree");
+            pool.push_back(value);
+            return NodeRef(kind, static_cast<std::uint32_t>(pool.size() - 1));
+        }
+
+        template<typename F>
+        void CompactTree::forEachChild(NodeRef node, F action) const {
+            auto visit = [&action](NodeRef child) {
+                if (child)
+                    action(child);
+            };
+            auto visitList = [this, &visit](Range range) {
+                for (auto it = listBegin(range); it != listEnd(range); ++it)
+                    visit(*it);
+            };
+
+            switch (shapeOf(node.kind())) {
+                case NodeShape::INLINE:
+                case NodeShape::TEXT:
+                case NodeShape::NUMBER:
+                    break;
+                case NodeShape::UNARY:
+                    visit(unaries[node.index()].value);
+                    break;
+                case NodeShape::BINARY:
+                    visit(binaries[node.index()].left);
+                    visit(binaries[node.index()].right);
+                    break;
+                case NodeShape::QUATERNARY:
+                    for (auto child : quaternaries[node.index()].children)
+                        visit(child);
+                    break;
+                case NodeShape::COMPOSITE:
+                    visit(composites[node.index()].head);
+                    visitList(composites[node.index()].items);
+                    break;
+                case NodeShape::FUNCTION_DEF:
+                    visit(functionDefs[node.index()].htmlTemplate);
+                    visit(functionDefs[node.index()].params);
+                    visit(functionDefs[node.index()].value);
+                    break;
+                case NodeShape::HTML_TEMPLATE: {
+                    const auto &htmlTemplate = htmlTemplates[node.index()];
+                    visit(htmlTemplate.identifier);
+                    visit(htmlTemplate.attributes);
+                    visitList(htmlTemplate.elements);
+                    visitList(htmlTemplate.content);
+                    visit(htmlTemplate.closingParams);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+#endif // PARSER_COMPACT_TREE_HPP
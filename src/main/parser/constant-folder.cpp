@@ -0,0 +1,401 @@
+#include "constant-folder.hpp"
+#include <boost/optional.hpp>
+#include "node-visitor.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            /**
+             * Value of a literal, or NONE for expressions only known at run time.
+             */
+            struct Constant {
+                enum class Type {
+                    NONE,
+                    NUMBER,
+                    STRING,
+                    BOOLEAN,
+                };
+
+                Type type = Type::NONE;
+                double number = 0.0;
+                std::string string;
+                bool boolean = false;
+
+                static Constant ofNumber(double value) {
+                    Constant result;
+                    result.type = Type::NUMBER;
+                    result.number = value;
+                    return result;
+                }
+
+                static Constant ofString(std::string value) {
+                    Constant result;
+                    result.type = Type::STRING;
+                    result.string = move(value);
+                    return result;
+                }
+
+                static Constant ofBoolean(bool value) {
+                    Constant result;
+                    result.type = Type::BOOLEAN;
+                    result.boolean = value;
+                    return result;
+                }
+            };
+
+            std::unique_ptr<ExpressionNode> literalOf(const Constant &value) {
+                switch (value.type) {
+                    case Constant::Type::NUMBER:
+                        return std::unique_ptr<ExpressionNode>(new NumberLiteralNode(value.number));
+                    case Constant::Type::STRING:
+                        return std::unique_ptr<ExpressionNode>(new StringLiteralNode(value.string));
+                    case Constant::Type::BOOLEAN:
+                        return std::unique_ptr<ExpressionNode>(new BooleanLiteralNode(value.boolean));
+                    case Constant::Type::NONE:
+                        break;
+                }
+                return nullptr;
+            }
+
+            bool equal(const Constant &left, const Constant &right) {
+                if (left.type != right.type)
+                    return false;
+                switch (left.type) {
+                    case Constant::Type::NUMBER:
+                        return left.number == right.number;
+                    case Constant::Type::STRING:
+                        return left.string == right.string;
+                    case Constant::Type::BOOLEAN:
+                        return left.boolean == right.boolean;
+                    case Constant::Type::NONE:
+                        break;
+                }
+                return false;
+            }
+
+            /**
+             * @return Result of the operator, or none if it is not known before run time or would fail then.
+             * Logical operators are handled by the folder, as they do not need both operands.
+             */
+            boost::optional<Constant> evaluate(BinaryOperator op, const Constant &left, const Constant &right) {
+                if (left.type == Constant::Type::NONE || right.type == Constant::Type::NONE)
+                    return boost::none;
+
+                switch (op) {
+                    case BinaryOperator::EQUAL:
+                        return Constant::ofBoolean(equal(left, right));
+                    case BinaryOperator::NOT_EQUAL:
+                        return Constant::ofBoolean(!equal(left, right));
+                    case BinaryOperator::ADD:
+                        if (left.type == Constant::Type::STRING && right.type == Constant::Type::STRING)
+                            return Constant::ofString(left.string + right.string);
+                        break;
+                    default:
+                        break;
+                }
+
+                if (left.type != Constant::Type::NUMBER || right.type != Constant::Type::NUMBER)
+                    return boost::none;
+
+                switch (op) {
+                    case BinaryOperator::LESS:
+                        return Constant::ofBoolean(left.number < right.number);
+                    case BinaryOperator::GREATER:
+                        return Constant::ofBoolean(left.number > right.number);
+                    case BinaryOperator::LESS_EQUAL:
+                        return Constant::ofBoolean(left.number <= right.number);
+                    case BinaryOperator::GREATER_EQUAL:
+                        return Constant::ofBoolean(left.number >= right.number);
+                    case BinaryOperator::ADD:
+                        return Constant::ofNumber(left.number + right.number);
+                    case BinaryOperator::SUBTRACT:
+                        return Constant::ofNumber(left.number + -right.number);
+                    case BinaryOperator::MULTIPLY:
+                        return Constant::ofNumber(left.number * right.number);
+                    case BinaryOperator::DIVIDE:
+                        return Constant::ofNumber(left.number / right.number);
+                    default:
+                        return boost::none;
+                }
+            }
+
+            boost::optional<Constant> evaluate(UnaryOperator op, const Constant &operand) {
+                if (op == UnaryOperator::NEGATE && operand.type == Constant::Type::NUMBER)
+                    return Constant::ofNumber(-operand.number);
+                if (op == UnaryOperator::NOT && operand.type == Constant::Type::BOOLEAN)
+                    return Constant::ofBoolean(!operand.boolean);
+                return boost::none;
+            }
+
+            /**
+             * Walks function bodies, folding children before their parents. Visitor only tells node types
+             * apart; nodes are changed through `current`, which points to the same node as the visited reference,
+             * and expressions are replaced through `slot`, the pointer owning them.
+             */
+            class Folder : public NodeVisitor {
+                Node *current = nullptr;
+                std::unique_ptr<ExpressionNode> *slot = nullptr;
+
+                /** Value of the last folded node. */
+                Constant constant;
+                /** Number of nodes in the last folded subtree. */
+                std::size_t size = 0;
+
+            public:
+                std::size_t removed = 0;
+
+                void foldFunction(FunctionDefNode &function) {
+                    fold(function.value);
+                }
+
+                void visit(const ScriptNode &) override {
+                    for (auto &function : self<ScriptNode>().functions)
+                        foldFunction(*function);
+                    finish(0);
+                }
+
+                void visit(const FunctionDefNode &) override {
+                    foldFunction(self<FunctionDefNode>());
+                    finish(0);
+                }
+
+                void visit(const FunctionDefParamsNode &node) override {
+                    finish(1 + node.params.size());
+                }
+
+                void visit(const HtmlTemplateNode &) override {
+                    finish(1);
+                }
+
+                void visit(const AttributeNode &) override {
+                    finish(1);
+                }
+
+                void visit(const AttributeValueNode &) override {
+                    finish(1);
+                }
+
+                void visit(const AttributeListNode &) override {
+                    finish(1);
+                }
+
+                void visit(const TextContentNode &) override {
+                    finish(1);
+                }
+
+                void visit(const InjectedValueNode &) override {
+                    finish(1);
+                }
+
+                void visit(const ReturnExpressionNode &) override {
+                    auto &node = self<ReturnExpressionNode>();
+                    finish(1 + fold(node.returnValue));
+                }
+
+                void visit(const BlockNode &) override {
+                    auto &node = self<BlockNode>();
+                    finish(1 + fold(node.value));
+                }
+
+                void visit(const DeclarationExpressionNode &) override {
+                    auto &node = self<DeclarationExpressionNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.identifier);
+                    total += fold(node.value);
+                    finish(total);
+                }
+
+                void visit(const ForExpressionNode &) override {
+                    auto &node = self<ForExpressionNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.iterator);
+                    total += fold(node.condition);
+                    total += foldChild(node.expression);
+                    total += foldChild(node.block);
+                    finish(total);
+                }
+
+                void visit(const AssignExpressionNode &) override {
+                    auto &node = self<AssignExpressionNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.variable);
+                    total += fold(node.value);
+                    finish(total);
+                }
+
+                void visit(const IfExpressionNode &) override {
+                    auto &node = self<IfExpressionNode>();
+                    std::size_t total = 1;
+                    total += fold(node.condition);
+                    total += foldChild(node.ifBlock);
+                    total += foldChild(node.elseBlock);
+                    finish(total);
+                }
+
+                void visit(const BinaryOperationNode &) override {
+                    const auto target = slot;
+                    auto &node = self<BinaryOperationNode>();
+
+                    const auto leftSize = fold(node.left);
+                    const Constant left = constant;
+                    const auto rightSize = fold(node.right);
+                    const Constant right = constant;
+                    const auto total = 1 + leftSize + rightSize;
+
+                    if (node.op == BinaryOperator::OR || node.op == BinaryOperator::AND) {
+                        if (left.type != Constant::Type::BOOLEAN || !target) {
+                            finish(total);
+                            return;
+                        }
+                        // `true || x` and `false && x` give their left operand, otherwise the right one.
+                        const bool keepLeft = (node.op == BinaryOperator::OR) == left.boolean;
+                        auto kept = move(keepLeft ? node.left : node.right);
+                        size = keepLeft ? leftSize : rightSize;
+                        constant = keepLeft ? left : right;
+                        removed += total - size;
+                        *target = move(kept);
+                        return;
+                    }
+
+                    replaceIfKnown(target, evaluate(node.op, left, right), total);
+                }
+
+                void visit(const UnaryOperationNode &) override {
+                    const auto target = slot;
+                    auto &node = self<UnaryOperationNode>();
+
+                    const auto total = 1 + fold(node.operand);
+                    replaceIfKnown(target, evaluate(node.op, constant), total);
+                }
+
+                void visit(const FunctionCallNode &) override {
+                    auto &node = self<FunctionCallNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.identifier);
+                    for (auto &argument : node.value)
+                        total += fold(argument);
+                    finish(total);
+                }
+
+                void visit(const ObjectLiteralNode &) override {
+                    auto &node = self<ObjectLiteralNode>();
+                    std::size_t total = 1;
+                    for (auto &field : node.injection)
+                        total += foldChild(field);
+                    finish(total);
+                }
+
+                void visit(const ObjectFieldNode &) override {
+                    auto &node = self<ObjectFieldNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.identifier);
+                    total += fold(node.expression);
+                    finish(total);
+                }
+
+                void visit(const VariableNode &) override {
+                    auto &node = self<VariableNode>();
+                    std::size_t total = 1;
+                    total += foldChild(node.identifier);
+                    for (auto &index : node.indices)
+                        total += foldChild(index);
+                    finish(total);
+                }
+
+                void visit(const IndexExpressionNode &) override {
+                    auto &node = self<IndexExpressionNode>();
+                    finish(1 + fold(node.value));
+                }
+
+                void visit(const AnyTextNode &) override {
+                    finish(1);
+                }
+
+                void visit(const IdentifierNode &) override {
+                    finish(1);
+                }
+
+                void visit(const StringLiteralNode &node) override {
+                    size = 1;
+                    constant = Constant::ofString(node.value);
+                }
+
+                void visit(const NumberLiteralNode &node) override {
+                    size = 1;
+                    constant = Constant::ofNumber(node.value);
+                }
+
+                void visit(const BooleanLiteralNode &node) override {
+                    size = 1;
+                    constant = Constant::ofBoolean(node.value);
+                }
+
+            private:
+                template<typename T>
+                T &self() {
+                    return static_cast<T &>(*current);
+                }
+
+                /**
+                 * Folds expression which may be replaced as a whole.
+                 * @return Number of nodes in it after folding.
+                 */
+                std::size_t fold(std::unique_ptr<ExpressionNode> &expression) {
+                    if (!expression) {
+                        finish(0);
+                        return 0;
+                    }
+                    current = expression.get();
+                    slot = &expression;
+                    expression->visit(*this);
+                    return size;
+                }
+
+                template<typename T>
+                std::size_t foldChild(std::unique_ptr<T> &child) {
+                    if (!child) {
+                        finish(0);
+                        return 0;
+                    }
+                    current = child.get();
+                    slot = nullptr;
+                    child->visit(*this);
+                    return size;
+                }
+
+                void finish(std::size_t nodeCount) {
+                    size = nodeCount;
+                    constant = Constant();
+                }
+
+                void replaceIfKnown(
+                        std::unique_ptr<ExpressionNode> *target,
+                        const boost::optional<Constant> &value,
+                        std::size_t nodeCount
+                ) {
+                    if (!value || !target) {
+                        finish(nodeCount);
+                        return;
+                    }
+                    *target = literalOf(*value);
+                    removed += nodeCount - 1;
+                    size = 1;
+                    constant = *value;
+                }
+            };
+        }
+
+        std::size_t foldConstants(ScriptNode &script) {
+            Folder folder;
+            for (auto &function : script.functions)
+                folder.foldFunction(*function);
+            return folder.removed;
+        }
+
+        std::size_t foldConstants(FunctionDefNode &function) {
+            Folder folder;
+            folder.foldFunction(function);
+            return folder.removed;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef PARSER_CONSTANT_FOLDER_HPP
+#define PARSER_CONSTANT_FOLDER_HPP
+
+#include <cstddef>
+#include "node.hpp"
+
+namespace lang {
+    namespace parser {
+        /**
+         * Replaces operators applied to number, string and boolean literals with literals of their results,
+         * computed the way Interpreter computes them. Operations which fail at run time, like adding number
+         * to string, are kept so the interpreter still reports them. `||` and `&&` with boolean literal on
+         * the left are replaced by the operand which gives their result.
+         * Functions whose body was deferred by Parser::preParse are skipped.
+         * @return Number of nodes removed from the tree.
+         */
+        std::size_t foldConstants(ScriptNode &script);
+
+        std::size_t foldConstants(FunctionDefNode &function);
+    }
+}
+
+#endif // PARSER_CONSTANT_FOLDER_HPP
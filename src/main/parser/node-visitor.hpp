@@ -41,46 +41,12 @@ namespace lang {
 
             DEF_VISIT(IfExpressionNode);
 
-            DEF_VISIT(MathExpressionAddNode);
+            DEF_VISIT(BinaryOperationNode);
 
-            DEF_VISIT(MathExpressionSubtractNode);
-
-            DEF_VISIT(MathExpressionSingleNode);
-
-            DEF_VISIT(MultiplyExpressionNode);
-
-            DEF_VISIT(DivideExpressionNode);
-
-            DEF_VISIT(MultiplicativeExpressionSingleNode);
-
-            DEF_VISIT(BaseMathExpressionNode);
+            DEF_VISIT(UnaryOperationNode);
 
             DEF_VISIT(FunctionCallNode);
 
-            DEF_VISIT(ParenthesisExpressionNode);
-
-            DEF_VISIT(LogicExpressionOrNode);
-
-            DEF_VISIT(LogicExpressionSingleNode);
-
-            DEF_VISIT(LogicExpressionAndAndNode);
-
-            DEF_VISIT(LogicExpressionAndSingleNode);
-
-            DEF_VISIT(LogicExpressionEqualEqualNode);
-
-            DEF_VISIT(LogicExpressionEqualSingleNode);
-
-            DEF_VISIT(LogicExpressionRelationalLessNode);
-
-            DEF_VISIT(LogicExpressionRelationalGreaterNode);
-
-            DEF_VISIT(LogicExpressionRelationalLessEqualNode);
-
-            DEF_VISIT(LogicExpressionRelationalGreaterEqualNode);
-
-            DEF_VISIT(LogicExpressionRelationalSingleNode);
-
             DEF_VISIT(ObjectLiteralNode);
 
             DEF_VISIT(ObjectFieldNode);
@@ -91,8 +57,6 @@ namespace lang {
 
             DEF_VISIT(AnyTextNode);
 
-            DEF_VISIT(AnyCharNode);
-
             DEF_VISIT(IdentifierNode);
 
             DEF_VISIT(StringLiteralNode);
@@ -38,46 +38,12 @@ namespace lang {
 
         DEF_VISIT_IMPL(IfExpressionNode);
 
-        DEF_VISIT_IMPL(MathExpressionAddNode);
+        DEF_VISIT_IMPL(BinaryOperationNode);
 
-        DEF_VISIT_IMPL(MathExpressionSubtractNode);
-
-        DEF_VISIT_IMPL(MathExpressionSingleNode);
-
-        DEF_VISIT_IMPL(MultiplyExpressionNode);
-
-        DEF_VISIT_IMPL(DivideExpressionNode);
-
-        DEF_VISIT_IMPL(MultiplicativeExpressionSingleNode);
-
-        DEF_VISIT_IMPL(BaseMathExpressionNode);
+        DEF_VISIT_IMPL(UnaryOperationNode);
 
         DEF_VISIT_IMPL(FunctionCallNode);
 
-        DEF_VISIT_IMPL(ParenthesisExpressionNode);
-
-        DEF_VISIT_IMPL(LogicExpressionOrNode);
-
-        DEF_VISIT_IMPL(LogicExpressionSingleNode);
-
-        DEF_VISIT_IMPL(LogicExpressionAndAndNode);
-
-        DEF_VISIT_IMPL(LogicExpressionAndSingleNode);
-
-        DEF_VISIT_IMPL(LogicExpressionEqualEqualNode);
-
-        DEF_VISIT_IMPL(LogicExpressionEqualSingleNode);
-
-        DEF_VISIT_IMPL(LogicExpressionRelationalLessNode);
-
-        DEF_VISIT_IMPL(LogicExpressionRelationalGreaterNode);
-
-        DEF_VISIT_IMPL(LogicExpressionRelationalLessEqualNode);
-
-        DEF_VISIT_IMPL(LogicExpressionRelationalGreaterEqualNode);
-
-        DEF_VISIT_IMPL(LogicExpressionRelationalSingleNode);
-
         DEF_VISIT_IMPL(ObjectLiteralNode);
 
         DEF_VISIT_IMPL(ObjectFieldNode);
@@ -88,8 +54,6 @@ namespace lang {
 
         DEF_VISIT_IMPL(AnyTextNode);
 
-        DEF_VISIT_IMPL(AnyCharNode);
-
         DEF_VISIT_IMPL(IdentifierNode);
 
         DEF_VISIT_IMPL(StringLiteralNode);
@@ -1,8 +1,12 @@
 #ifndef PARSER_NODE_HPP
 #define PARSER_NODE_HPP
 
+#include <cstdint>
 #include <vector>
 #include <memory>
+#include <string>
+#include <utility>
+#include "../lexer/symbol-table.hpp"
 
 
 namespace lang {
@@ -37,38 +41,16 @@ public:
         struct ForExpressionNode;
         struct AssignExpressionNode;
         struct IfExpressionNode;
-        struct MathExpressionNode;
-        struct MathExpressionAddNode;
-        struct MathExpressionSubtractNode;
-        struct MathExpressionSingleNode;
-        struct MultiplicativeExpressionNode;
-        struct MultiplyExpressionNode;
-        struct DivideExpressionNode;
+        struct BinaryOperationNode;
+        struct UnaryOperationNode;
         struct BaseMathExpressionNode;
         struct FunctionCallNode;
-        struct ParenthesisExpressionNode;
-        struct LogicExpressionNode;
-        struct LogicExpressionOrNode;
-        struct LogicExpressionSingleNode;
-        struct LogicExpressionAndNode;
-        struct LogicExpressionAndAndNode;
-        struct LogicExpressionAndSingleNode;
-        struct LogicExpressionEqualNode;
-        struct LogicExpressionEqualEqualNode;
-        struct LogicExpressionEqualSingleNode;
-        struct LogicExpressionRelationalNode;
-        struct LogicExpressionRelationalLessNode;
-        struct LogicExpressionRelationalGreaterNode;
-        struct LogicExpressionRelationalLessEqualNode;
-        struct LogicExpressionRelationalGreaterEqualNode;
-        struct LogicExpressionRelationalSingleNode;
         struct ObjectLiteralNode;
         struct ObjectFieldNode;
         struct VariableNode;
         struct IndexExpressionNode;
         struct IdentifierNode;
         struct AnyTextNode;
-        struct AnyCharNode;
         struct LiteralNode;
         struct StringLiteralNode;
         struct NumberLiteralNode;
@@ -77,14 +59,37 @@ public:
         struct ScriptNode : Node {
             DEF_VISIT_DECL();
             std::vector<std::unique_ptr<FunctionDefNode>> functions;
+            std::shared_ptr<const lexer::SymbolTable> symbols;
+        };
+
+        /**
+         * Copy of pre-parsed script, with the table its symbols are interned in.
+         */
+        struct DeferredSource {
+            std::string text;
+            std::shared_ptr<lexer::SymbolTable> symbols;
+        };
+
+        /**
+         * Whole definition of a function whose template and body were skipped by Parser::preParse.
+         */
+        struct DeferredDefinition {
+            std::shared_ptr<const DeferredSource> source;
+            std::uint32_t offset;
+            std::uint32_t length;
+            int firstLine;
         };
 
         struct FunctionDefNode : Node {
             DEF_VISIT_DECL();
-            std::string name;
+            lexer::Symbol name;
             std::unique_ptr<HtmlTemplateNode> htmltemplate;
             std::unique_ptr<FunctionDefParamsNode> params;
             std::unique_ptr<ExpressionNode> value;
+            /** Set while template and body are not parsed yet, see parseDeferred. */
+            std::unique_ptr<DeferredDefinition> deferred;
+            /** Number of slots in a call frame of the function, set together with bindings of its names. */
+            std::uint32_t frameSize = 0;
         };
 
         struct FunctionDefParamsNode : Node {
@@ -141,7 +146,7 @@ public:
 
         struct ReturnExpressionNode : ExpressionNode {
             DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionNode> returnValue;
+            std::unique_ptr<ExpressionNode> returnValue;
         };
 
         struct DeclarationExpressionNode : ExpressionNode {
@@ -153,7 +158,7 @@ public:
         struct ForExpressionNode : ExpressionNode {
             DEF_VISIT_DECL();
             std::unique_ptr<DeclarationExpressionNode> iterator;
-            std::unique_ptr<LogicExpressionNode> condition;
+            std::unique_ptr<ExpressionNode> condition;
             std::unique_ptr<AssignExpressionNode> expression;
             std::unique_ptr<BlockNode> block;
         };
@@ -171,244 +176,65 @@ public:
             std::unique_ptr<BlockNode> elseBlock;
         };
 
-        struct MathExpressionNode : ExpressionNode {
-        };
-
-        struct MathExpressionAddNode : MathExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MultiplicativeExpressionNode> left;
-            std::unique_ptr<MathExpressionNode> right;
-
-            MathExpressionAddNode() = default;
-
-            MathExpressionAddNode(
-                    std::unique_ptr<MultiplicativeExpressionNode> left,
-                    std::unique_ptr<MathExpressionNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct MathExpressionSubtractNode : MathExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MultiplicativeExpressionNode> left;
-            std::unique_ptr<MathExpressionNode> right;
-
-            MathExpressionSubtractNode() = default;
-
-            MathExpressionSubtractNode(
-                    std::unique_ptr<MultiplicativeExpressionNode> left,
-                    std::unique_ptr<MathExpressionNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct MathExpressionSingleNode : MathExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MultiplicativeExpressionNode> value;
-
-            MathExpressionSingleNode() = default;
-
-            MathExpressionSingleNode(std::unique_ptr<MultiplicativeExpressionNode> value) : value(move(value)) {}
+        enum class BinaryOperator {
+            OR,
+            AND,
+            EQUAL,
+            NOT_EQUAL,
+            LESS,
+            GREATER,
+            LESS_EQUAL,
+            GREATER_EQUAL,
+            ADD,
+            SUBTRACT,
+            MULTIPLY,
+            DIVIDE,
         };
 
-        struct MultiplicativeExpressionNode : Node {
+        enum class UnaryOperator {
+            NEGATE,
+            NOT,
         };
 
-        struct MultiplyExpressionNode : MultiplicativeExpressionNode {
+        /**
+         * Single binary operator with its operands; chains of operators of the same precedence nest to the left.
+         */
+        struct BinaryOperationNode : ExpressionNode {
             DEF_VISIT_DECL();
-            std::unique_ptr<BaseMathExpressionNode> left;
-            std::unique_ptr<MultiplicativeExpressionNode> right;
+            BinaryOperator op;
+            std::unique_ptr<ExpressionNode> left;
+            std::unique_ptr<ExpressionNode> right;
 
-            MultiplyExpressionNode() = default;
+            BinaryOperationNode() = default;
 
-            MultiplyExpressionNode(
-                    std::unique_ptr<BaseMathExpressionNode> left,
-                    std::unique_ptr<MultiplicativeExpressionNode> right
-            ) : left(move(left)), right(move(right)) {}
+            BinaryOperationNode(
+                    BinaryOperator op,
+                    std::unique_ptr<ExpressionNode> left,
+                    std::unique_ptr<ExpressionNode> right
+            ) : op(op), left(move(left)), right(move(right)) {}
         };
 
-        struct DivideExpressionNode : MultiplicativeExpressionNode {
+        struct UnaryOperationNode : ExpressionNode {
             DEF_VISIT_DECL();
-            std::unique_ptr<BaseMathExpressionNode> left;
-            std::unique_ptr<MultiplicativeExpressionNode> right;
+            UnaryOperator op;
+            std::unique_ptr<ExpressionNode> operand;
 
-            DivideExpressionNode() = default;
+            UnaryOperationNode() = default;
 
-            DivideExpressionNode(
-                    std::unique_ptr<BaseMathExpressionNode> left,
-                    std::unique_ptr<MultiplicativeExpressionNode> right
-            ) : left(move(left)), right(move(right)) {}
+            UnaryOperationNode(UnaryOperator op, std::unique_ptr<ExpressionNode> operand)
+                    : op(op), operand(move(operand)) {}
         };
 
-        struct MultiplicativeExpressionSingleNode : MultiplicativeExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<BaseMathExpressionNode> value;
-
-            MultiplicativeExpressionSingleNode() = default;
-
-            MultiplicativeExpressionSingleNode(std::unique_ptr<BaseMathExpressionNode> value)
-                    : value(move(value)) {}
-        };
-
-        struct BaseMathExpressionNode : MathExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionSingleNode> logicUnary;
-            std::unique_ptr<MathExpressionSingleNode> mathLogic;
-            bool negate;
-            double value;
-
-            BaseMathExpressionNode() = default;
-
-            BaseMathExpressionNode(double value) : value(value) {}
+        /**
+         * Operand which is not an operation itself: literal, function call or object literal.
+         */
+        struct BaseMathExpressionNode : ExpressionNode {
         };
 
         struct FunctionCallNode : BaseMathExpressionNode {
             DEF_VISIT_DECL();
             std::unique_ptr<IdentifierNode> identifier;
-            std::vector<std::unique_ptr<LogicExpressionNode>> value;
-        };
-
-        struct ParenthesisExpressionNode : BaseMathExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> expression;
-
-            ParenthesisExpressionNode() = default;
-
-            ParenthesisExpressionNode(std::unique_ptr<MathExpressionNode> expression)
-                    : expression(move(expression)) {}
-        };
-
-        struct LogicExpressionNode : ExpressionNode {
-        };
-
-        struct LogicExpressionOrNode : LogicExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionAndNode> left;
-            std::unique_ptr<LogicExpressionNode> right;
-
-            LogicExpressionOrNode() = default;
-
-            LogicExpressionOrNode(
-                    std::unique_ptr<LogicExpressionAndNode> left,
-                    std::unique_ptr<LogicExpressionNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionSingleNode : LogicExpressionNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionAndNode> value;
-
-            LogicExpressionSingleNode() = default;
-
-            LogicExpressionSingleNode(std::unique_ptr<LogicExpressionAndNode> value) : value(move(value)) {}
-        };
-
-        struct LogicExpressionAndNode : Node {
-        };
-
-        struct LogicExpressionAndAndNode : LogicExpressionAndNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionEqualNode> left;
-            std::unique_ptr<LogicExpressionAndNode> right;
-
-            LogicExpressionAndAndNode() = default;
-
-            LogicExpressionAndAndNode(
-                    std::unique_ptr<LogicExpressionEqualNode> left,
-                    std::unique_ptr<LogicExpressionAndNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionAndSingleNode : LogicExpressionAndNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionEqualNode> value;
-
-            LogicExpressionAndSingleNode() = default;
-
-            LogicExpressionAndSingleNode(std::unique_ptr<LogicExpressionEqualNode> value) : value(move(value)) {}
-        };
-
-        struct LogicExpressionEqualNode : Node {
-        };
-
-        struct LogicExpressionEqualEqualNode : LogicExpressionEqualNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionRelationalNode> left;
-            std::unique_ptr<LogicExpressionEqualNode> right;
-
-            LogicExpressionEqualEqualNode() = default;
-
-            LogicExpressionEqualEqualNode(
-                    std::unique_ptr<LogicExpressionRelationalNode> left,
-                    std::unique_ptr<LogicExpressionEqualNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionEqualSingleNode : LogicExpressionEqualNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<LogicExpressionRelationalNode> value;
-
-            LogicExpressionEqualSingleNode() = default;
-
-            LogicExpressionEqualSingleNode(std::unique_ptr<LogicExpressionRelationalNode> value)
-                    : value(move(value)) {}
-        };
-
-        struct LogicExpressionRelationalNode : Node {
-        };
-
-        struct LogicExpressionRelationalLessNode : LogicExpressionRelationalNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> left;
-            std::unique_ptr<LogicExpressionRelationalNode> right;
-
-            LogicExpressionRelationalLessNode(
-                    std::unique_ptr<MathExpressionNode> left,
-                    std::unique_ptr<LogicExpressionRelationalNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionRelationalGreaterNode : LogicExpressionRelationalNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> left;
-            std::unique_ptr<LogicExpressionRelationalNode> right;
-
-            LogicExpressionRelationalGreaterNode(
-                    std::unique_ptr<MathExpressionNode> left,
-                    std::unique_ptr<LogicExpressionRelationalNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionRelationalLessEqualNode : LogicExpressionRelationalNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> left;
-            std::unique_ptr<LogicExpressionRelationalNode> right;
-
-            LogicExpressionRelationalLessEqualNode(
-                    std::unique_ptr<MathExpressionNode> left,
-                    std::unique_ptr<LogicExpressionRelationalNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionRelationalGreaterEqualNode : LogicExpressionRelationalNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> left;
-            std::unique_ptr<LogicExpressionRelationalNode> right;
-
-            LogicExpressionRelationalGreaterEqualNode() = default;
-
-            LogicExpressionRelationalGreaterEqualNode(
-                    std::unique_ptr<MathExpressionNode> left,
-                    std::unique_ptr<LogicExpressionRelationalNode> right
-            ) : left(move(left)), right(move(right)) {}
-        };
-
-        struct LogicExpressionRelationalSingleNode : LogicExpressionRelationalNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<MathExpressionNode> value;
-
-            LogicExpressionRelationalSingleNode() = default;
-
-            LogicExpressionRelationalSingleNode(std::unique_ptr<MathExpressionNode> value)
-                    : value(move(value)) {}
+            std::vector<std::unique_ptr<ExpressionNode>> value;
         };
 
         struct ObjectLiteralNode : BaseMathExpressionNode {
@@ -419,7 +245,7 @@ public:
         struct ObjectFieldNode : ObjectLiteralNode {
             DEF_VISIT_DECL();
             std::unique_ptr<IdentifierNode> identifier;
-            std::unique_ptr<LogicExpressionNode> expression;
+            std::unique_ptr<ExpressionNode> expression;
         };
 
         struct LiteralNode : ExpressionNode {
@@ -427,13 +253,8 @@ public:
 
         struct AnyTextNode : LiteralNode {
             DEF_VISIT_DECL();
-            std::vector<std::unique_ptr<AnyCharNode>> chars;
-        };
-
-        struct AnyCharNode : AnyTextNode {
-            DEF_VISIT_DECL();
-            std::unique_ptr<IdentifierNode> identifier;
-            std::unique_ptr<BaseMathExpressionNode> number;
+            /** Static template text, exactly as written in source. */
+            std::string text;
         };
 
         struct VariableNode : ExpressionNode {
@@ -447,9 +268,25 @@ public:
             std::unique_ptr<ExpressionNode> value;
         };
 
+        /**
+         * Where the value of a name is stored at run time: slot of the call frame, or index of a global.
+         */
+        struct Binding {
+            enum class Kind : std::uint8_t {
+                UNRESOLVED,
+                LOCAL,
+                GLOBAL,
+            };
+
+            Kind kind = Kind::UNRESOLVED;
+            std::uint32_t index = 0;
+        };
+
         struct IdentifierNode : Node {
             DEF_VISIT_DECL();
-            std::string name;
+            lexer::Symbol name;
+            /** Result of name resolution rather than syntax, so it is filled in on an otherwise const tree. */
+            mutable Binding binding;
         };
 
         struct StringLiteralNode : BaseMathExpressionNode {
@@ -0,0 +1,226 @@
+#include "parallel-parser.hpp"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include "../logging/logger-output.hpp"
+#include "parser.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            // Chunks are grouped into a few batches per thread, so that one long function does not hold
+            // all the others back while thread start-up cost stays negligible.
+            const std::size_t batchesPerThread = 4;
+
+            bool isLetter(char c) {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            }
+
+            bool isLetterOrDigit(char c) {
+                return isLetter(c) || (c >= '0' && c <= '9');
+            }
+
+            /**
+             * @param i Position of opening quote.
+             * @return Position just after closing quote.
+             */
+            std::size_t skipString(boost::string_view source, std::size_t i, int &line) {
+                for (++i; i < source.size(); ++i) {
+                    if (source[i] == '\\' && i + 1 < source.size()) {
+                        ++i;
+                    } else if (source[i] == '"') {
+                        return i + 1;
+                    }
+                    if (source[i] == '\n')
+                        ++line;
+                }
+                return source.size();
+            }
+
+            /**
+             * Template text may hold any brackets, only a closing bracket outside of tags ends it.
+             * @param i Position just after opening bracket.
+             * @return Position just after closing bracket.
+             */
+            std::size_t skipTemplate(boost::string_view source, std::size_t i, int &line) {
+                bool inTag = false;
+                while (i < source.size()) {
+                    const char c = source[i];
+                    if (inTag && c == '"') {
+                        i = skipString(source, i, line);
+                        continue;
+                    }
+
+                    if (c == '\n')
+                        ++line;
+                    else if (!inTag && c == ']')
+                        return i + 1;
+                    else if (c == '<')
+                        inTag = true;
+                    else if (c == '>')
+                        inTag = false;
+                    ++i;
+                }
+                return source.size();
+            }
+
+            struct BufferedOutput : logging::LoggerOutput {
+                std::vector<logging::LogEntry> entries;
+
+                void write(const logging::LogEntry &entry) override {
+                    entries.push_back(entry);
+                }
+            };
+
+            struct BatchResult {
+                std::unique_ptr<ScriptNode> tree;
+                std::vector<logging::LogEntry> messages;
+                std::exception_ptr error;
+            };
+
+            void replay(logging::Logger &log, const std::vector<logging::LogEntry> &messages) {
+                for (const auto &entry : messages) {
+                    switch (entry.level) {
+                        case logging::LogLevel::Info:
+                            log.info(entry.message);
+                            break;
+                        case logging::LogLevel::Warning:
+                            log.warning(entry.message);
+                            break;
+                        case logging::LogLevel::Error:
+                            log.error(entry.message);
+                            break;
+                    }
+                }
+            }
+
+            /**
+             * Joins consecutive chunks into at most batchCount batches of similar size in bytes.
+             */
+            std::vector<SourceChunk> makeBatches(const std::vector<SourceChunk> &chunks, std::size_t batchCount) {
+                std::vector<SourceChunk> batches;
+                if (chunks.empty())
+                    return batches;
+
+                const char *const begin = chunks.front().text.data();
+                const char *const end = chunks.back().text.data() + chunks.back().text.size();
+                const std::size_t targetSize = (end - begin) / batchCount + 1;
+
+                SourceChunk current = chunks.front();
+                for (auto it = chunks.begin() + 1; it != chunks.end(); ++it) {
+                    if (current.text.size() >= targetSize) {
+                        batches.push_back(current);
+                        current = *it;
+                    } else {
+                        current.text = boost::string_view(current.text.data(), current.text.size() + it->text.size());
+                    }
+                }
+                batches.push_back(current);
+                return batches;
+            }
+        }
+
+        std::vector<SourceChunk> splitFunctions(boost::string_view source) {
+            std::vector<SourceChunk> chunks;
+            std::size_t chunkStart = 0;
+            int chunkLine = 1;
+            int line = 1;
+            int depth = 0;
+            bool seenFunction = false;
+
+            std::size_t i = 0;
+            while (i < source.size()) {
+                const char c = source[i];
+                if (c == '"') {
+                    i = skipString(source, i, line);
+                } else if (isLetter(c)) {
+                    std::size_t wordEnd = i + 1;
+                    while (wordEnd < source.size() && isLetterOrDigit(source[wordEnd]))
+                        ++wordEnd;
+                    if (depth == 0 && source.substr(i, wordEnd - i) == "function") {
+                        if (seenFunction) {
+                            chunks.push_back({source.substr(chunkStart, i - chunkStart), chunkLine});
+                            chunkStart = i;
+                            chunkLine = line;
+                        }
+                        seenFunction = true;
+                    }
+                    i = wordEnd;
+                } else if (c == '[' && depth == 0) {
+                    i = skipTemplate(source, i + 1, line);
+                } else {
+                    if (c == '\n')
+                        ++line;
+                    else if (c == '(' || c == '{' || c == '[')
+                        ++depth;
+                    else if ((c == ')' || c == '}' || c == ']') && depth > 0)
+                        --depth;
+                    ++i;
+                }
+            }
+
+            if (chunkStart < source.size() || chunks.empty())
+                chunks.push_back({source.substr(chunkStart), chunkLine});
+            return chunks;
+        }
+
+        ParallelParser::ParallelParser(
+                logging::Logger &logger,
+                boost::string_view source,
+                std::shared_ptr<lexer::SymbolTable> symbols,
+                unsigned threadCount,
+                LexerFactory makeLexer
+        ) : log(logger), source(source), symbols(move(symbols)), threadCount(threadCount),
+            makeLexer(move(makeLexer)) {
+            if (this->threadCount == 0)
+                this->threadCount = std::max(1u, std::thread::hardware_concurrency());
+            if (!this->makeLexer) {
+                this->makeLexer = [](SourceChunk chunk, std::shared_ptr<lexer::SymbolTable> symbols) {
+                    return std::unique_ptr<lexer::Lexer>(new lexer::Lexer(chunk.text, chunk.firstLine, move(symbols)));
+                };
+            }
+        }
+
+        std::unique_ptr<ScriptNode> ParallelParser::getTree() {
+            const auto batches = makeBatches(splitFunctions(source), threadCount * batchesPerThread);
+            std::vector<BatchResult> results(batches.size());
+
+            std::atomic<std::size_t> nextBatch(0);
+            auto work = [&] {
+                for (std::size_t i = nextBatch++; i < batches.size(); i = nextBatch++) {
+                    auto output = new BufferedOutput;
+                    logging::Logger batchLog;
+                    batchLog.addOutput(std::unique_ptr<logging::LoggerOutput>(output));
+                    try {
+                        auto lexer = makeLexer(batches[i], symbols);
+                        Parser parser(batchLog, *lexer);
+                        results[i].tree = parser.getTree();
+                    } catch (...) {
+                        results[i].error = std::current_exception();
+                    }
+                    results[i].messages = move(output->entries);
+                }
+            };
+
+            std::vector<std::thread> threads;
+            const auto helperCount = std::min<std::size_t>(threadCount, batches.size());
+            for (std::size_t i = 1; i < helperCount; ++i)
+                threads.emplace_back(work);
+            work();
+            for (auto &thread : threads)
+                thread.join();
+
+            auto result = std::unique_ptr<ScriptNode>(new ScriptNode);
+            result->symbols = symbols;
+            for (auto &batch : results) {
+                replay(log, batch.messages);
+                if (batch.error)
+                    std::rethrow_exception(batch.error);
+                for (auto &function : batch.tree->functions)
+                    result->functions.push_back(move(function));
+            }
+            return result;
+        }
+    }
+}
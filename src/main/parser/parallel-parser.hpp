@@ -0,0 +1,67 @@
+#ifndef PARSER_PARALLEL_PARSER_HPP
+#define PARSER_PARALLEL_PARSER_HPP
+
+#include <boost/utility/string_view.hpp>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "../lexer/lexer.hpp"
+#include "../logging/logger.hpp"
+#include "node.hpp"
+
+namespace lang {
+    namespace parser {
+        /**
+         * Part of source holding whole top level function definitions.
+         */
+        struct SourceChunk {
+            boost::string_view text;
+            int firstLine;
+        };
+
+        /**
+         * Splits source before every `function` keyword at top level, that is outside of brackets,
+         * string literals and template bodies. Text before the first definition stays in the first chunk.
+         * Scan only balances brackets, it does not validate the source.
+         */
+        std::vector<SourceChunk> splitFunctions(boost::string_view source);
+
+        /**
+         * Parses top level function definitions on several threads and merges them into one tree
+         * in source order. Chunks are lexed separately, interning into one shared symbol table.
+         * Messages of each chunk are passed to the logger in source order once all chunks are parsed;
+         * if some chunk fails, exception of the first failed one is rethrown.
+         */
+        class ParallelParser {
+        public:
+            using LexerFactory = std::function<std::unique_ptr<lexer::Lexer>(
+                    SourceChunk chunk,
+                    std::shared_ptr<lexer::SymbolTable> symbols
+            )>;
+
+        private:
+            logging::Logger &log;
+            boost::string_view source;
+            std::shared_ptr<lexer::SymbolTable> symbols;
+            unsigned threadCount;
+            LexerFactory makeLexer;
+
+        public:
+            /**
+             * @param source Whole script, has to outlive the parser.
+             * @param threadCount Number of threads to parse on, zero to use all hardware threads.
+             */
+            ParallelParser(
+                    logging::Logger &logger,
+                    boost::string_view source,
+                    std::shared_ptr<lexer::SymbolTable> symbols = std::make_shared<lexer::SymbolTable>(),
+                    unsigned threadCount = 0,
+                    LexerFactory makeLexer = LexerFactory()
+            );
+
+            std::unique_ptr<ScriptNode> getTree();
+        };
+    }
+}
+
+#endif // PARSER_PARALLEL_PARSER_HPP
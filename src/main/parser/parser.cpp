@@ -1,30 +1,142 @@
 #include "parser.hpp"
 #include <boost/format.hpp>
-#include <boost/lexical_cast.hpp>
+#include "compact-parser.hpp"
 
 
 using boost::format;
 using lang::lexer::Lexeme;
 using lang::lexer::LexemeType;
+using std::move;
 
 namespace lang {
     namespace parser {
-        Parser::Parser(logging::Logger &logger, util::OutputStream<lexer::Lexeme> &lexemes)
-                : log(logger), lexemes(lexemes) {
+        namespace {
+            struct OperatorInfo {
+                /** Zero for lexemes which are not binary operators. */
+                int precedence;
+                BinaryOperator op;
+            };
+
+            OperatorInfo binaryOperatorOf(LexemeType type) {
+                switch (type) {
+                    case LexemeType::OR:
+                        return {1, BinaryOperator::OR};
+                    case LexemeType::AND:
+                        return {2, BinaryOperator::AND};
+                    case LexemeType::EQUAL:
+                        return {3, BinaryOperator::EQUAL};
+                    case LexemeType::NOT_EQUAL:
+                        return {3, BinaryOperator::NOT_EQUAL};
+                    case LexemeType::OPEN_ANGLE:
+                        return {4, BinaryOperator::LESS};
+                    case LexemeType::CLOSE_ANGLE:
+                        return {4, BinaryOperator::GREATER};
+                    case LexemeType::LESS_EQ:
+                        return {4, BinaryOperator::LESS_EQUAL};
+                    case LexemeType::GREATER_EQ:
+                        return {4, BinaryOperator::GREATER_EQUAL};
+                    case LexemeType::ADD:
+                        return {5, BinaryOperator::ADD};
+                    case LexemeType::SUBTRACT:
+                        return {5, BinaryOperator::SUBTRACT};
+                    case LexemeType::MULTIPLY:
+                        return {6, BinaryOperator::MULTIPLY};
+                    case LexemeType::DIVIDE:
+                        return {6, BinaryOperator::DIVIDE};
+                    default:
+                        return {0, BinaryOperator::OR};
+                }
+            }
+        }
+
+        LexemeReader::LexemeReader(
+                logging::Logger &logger,
+                util::OutputStream<lexer::Lexeme> &lexemes,
+                std::shared_ptr<const lexer::SymbolTable> symbols
+        ) : log(logger), symbols(move(symbols)) {
+            this->lexemes.emplace(lexemes);
+        }
+
+        LexemeReader::LexemeReader(logging::Logger &logger, const lexer::TokenArray &tokens)
+                : log(logger), tokens(&tokens), symbols(tokens.symbolTable) {
+        }
+
+        template<typename Builder>
+        BasicParser<Builder>::BasicParser(
+                logging::Logger &logger,
+                util::OutputStream<lexer::Lexeme> &lexemes,
+                std::shared_ptr<const lexer::SymbolTable> symbols
+        ) : LexemeReader(logger, lexemes, move(symbols)) {
+        }
+
+        template<typename Builder>
+        BasicParser<Builder>::BasicParser(logging::Logger &logger, const lexer::TokenArray &tokens)
+                : LexemeReader(logger, tokens) {
+        }
+
+        Parser::Parser(
+                logging::Logger &logger,
+                util::OutputStream<lexer::Lexeme> &lexemes,
+                std::shared_ptr<const lexer::SymbolTable> symbols
+        ) : BasicParser(logger, lexemes, move(symbols)) {
+        }
+
+        Parser::Parser(logging::Logger &logger, const lexer::TokenArray &tokens) : BasicParser(logger, tokens) {
+        }
+
+        Parser::Parser(logging::Logger &logger, lexer::Lexer &lexer)
+                : Parser(logger, lexer, lexer.getSymbols()) {
+            this->lexer = &lexer;
         }
 
         std::unique_ptr<ScriptNode> Parser::getTree() {
             return parseScript();
         }
 
-        std::unique_ptr<ScriptNode> Parser::parseScript() {
+        std::unique_ptr<ScriptNode> Parser::preParse() {
+            if (!lexer) {
+                log.error("Pre-parsing needs parser created from a lexer; Aborting");
+                throw ParserException();
+            }
+
+            auto source = std::make_shared<DeferredSource>();
+            source->text = lexer->getSource().to_string();
+            source->symbols = lexer->getSymbols();
+
             auto result = std::unique_ptr<ScriptNode>(new ScriptNode);
-            while (lexemes.hasNext())
-                result->functions.emplace_back(parseFunctionDef());
+            result->symbols = symbols;
+            while (hasNextLex())
+                result->functions.emplace_back(preParseFunctionDef(source));
             return move(result);
         }
 
-        std::unique_ptr<FunctionDefNode> Parser::parseFunctionDef() {
+        void parseDeferred(FunctionDefNode &function, logging::Logger &logger) {
+            if (!function.deferred)
+                return;
+
+            const auto &deferred = *function.deferred;
+            lexer::Lexer lexer(
+                    boost::string_view(deferred.source->text).substr(deferred.offset, deferred.length),
+                    deferred.firstLine,
+                    deferred.source->symbols
+            );
+            Parser parser(logger, lexer);
+            auto tree = parser.getTree();
+            if (tree->functions.size() != 1) {
+                logger.error("Deferred definition does not hold exactly one function; Aborting");
+                throw ParserException();
+            }
+
+            auto &parsed = *tree->functions.front();
+            function.htmltemplate = move(parsed.htmltemplate);
+            function.params = move(parsed.params);
+            function.value = move(parsed.value);
+            function.deferred.reset();
+        }
+
+        std::unique_ptr<FunctionDefNode> Parser::preParseFunctionDef(
+                const std::shared_ptr<const DeferredSource> &source
+        ) {
             auto result = std::unique_ptr<FunctionDefNode>(new FunctionDefNode);
 
             auto def = getLex("'function'");
@@ -32,139 +144,196 @@ namespace lang {
                 log.error(str(format("Expected 'function', found %1%") % def.text));
                 enforceLexType(def, LexemeType::IDENTIFIER);
                 log.info(str(format("Assuming %1% is function name") % def.text));
-                result->name = def.text;
-            } else {
-                auto funcName = getLex("function name");
-                enforceLexType(funcName, LexemeType::IDENTIFIER);
-                result->name = funcName.text;
-
-                auto first = lookupLex("open bracket", 1);
-
-                if (first.type == LexemeType::OPEN_BRACKET) {
-                    enforceGetLexType(LexemeType::OPEN_BRACKET);
-                    result->htmltemplate = parseHtmlTemplate();
-                    enforceGetLexType(LexemeType::CLOSE_BRACKET);
+                result->name = def.symbol;
+                return move(result);
+            }
+
+            auto funcName = getLex("function name");
+            enforceLexType(funcName, LexemeType::IDENTIFIER);
+            result->name = funcName.symbol;
+
+            if (lookupLex("open bracket", 1).type == LexemeType::OPEN_BRACKET)
+                skipBalanced(LexemeType::OPEN_BRACKET, LexemeType::CLOSE_BRACKET);
+
+            result->params = parseFunctionDefParams();
+            const auto end = skipBalanced(LexemeType::OPEN_BRACE, LexemeType::CLOSE_BRACE);
+
+            const char *const sourceBegin = lexer->getSource().data();
+            result->deferred = std::unique_ptr<DeferredDefinition>(new DeferredDefinition{
+                    source,
+                    static_cast<std::uint32_t>(def.text.data() - sourceBegin),
+                    static_cast<std::uint32_t>(end.text.data() + end.text.size() - def.text.data()),
+                    def.line
+            });
+            return move(result);
+        }
+
+        lexer::Lexeme Parser::skipBalanced(lexer::LexemeType open, lexer::LexemeType close) {
+            auto lexeme = enforceGetLexType(open);
+            for (int depth = 1; depth > 0;) {
+                // Message is only formatted on failure, skipping is the whole cost of pre-parsing.
+                if (!takeLex(lexeme)) {
+                    log.error(str(format("Expected [LexemeType: %1%], found end of file; Aborting")
+                                  % static_cast<int>(close)));
+                    throw ParserException();
                 }
+                if (lexeme.type == open)
+                    ++depth;
+                else if (lexeme.type == close)
+                    --depth;
+            }
+            return lexeme;
+        }
 
-                result->params = parseFunctionDefParams();
+        template<typename Builder>
+        auto BasicParser<Builder>::parseScript() -> Ref<ScriptNode> {
+            auto functions = list<FunctionDefNode>();
+            while (hasNextLex())
+                build.push(functions, parseFunctionDef());
+            return build.script(move(functions), symbols);
+        }
 
-                enforceGetLexType(LexemeType::OPEN_BRACE);
-                Lexeme semicolon;
-                do {
-                    result->value = parseExpression();
-                    semicolon = lookupLex("semicolon or end of expression list", 1);
-                } while (semicolon.type == LexemeType::SEMICOLON && lexemes.take(semicolon));
+        template<typename Builder>
+        auto BasicParser<Builder>::parseFunctionDef() -> Ref<FunctionDefNode> {
+            auto def = getLex("'function'");
+            if (def.type != LexemeType::FUNCTION) {
+                log.error(str(format("Expected 'function', found %1%") % def.text));
+                enforceLexType(def, LexemeType::IDENTIFIER);
+                log.info(str(format("Assuming %1% is function name") % def.text));
+                return build.functionDef(def.symbol, {}, {}, {});
+            }
 
-                enforceGetLexType(LexemeType::CLOSE_BRACE);
+            auto funcName = getLex("function name");
+            enforceLexType(funcName, LexemeType::IDENTIFIER);
 
+            Ref<HtmlTemplateNode> htmlTemplate;
+            auto first = lookupLex("open bracket", 1);
+
+            if (first.type == LexemeType::OPEN_BRACKET) {
+                enforceGetLexType(LexemeType::OPEN_BRACKET);
+                htmlTemplate = parseHtmlTemplate();
+                enforceGetLexType(LexemeType::CLOSE_BRACKET);
             }
-            return move(result);
+
+            auto params = parseFunctionDefParams();
+
+            enforceGetLexType(LexemeType::OPEN_BRACE);
+            Ref<ExpressionNode> value;
+            const auto body = build.mark();
+            Lexeme semicolon;
+            do {
+                // Only the last expression is the value, nodes of the ones before it are dropped.
+                build.dropSince(body);
+                value = parseExpression();
+                semicolon = lookupLex("semicolon or end of expression list", 1);
+            } while (semicolon.type == LexemeType::SEMICOLON && takeLex(semicolon));
+
+            enforceGetLexType(LexemeType::CLOSE_BRACE);
+            return build.functionDef(funcName.symbol, move(htmlTemplate), move(params), move(value));
         }
 
-        std::unique_ptr<FunctionDefParamsNode> Parser::parseFunctionDefParams() {
-            auto result = std::unique_ptr<FunctionDefParamsNode>(new FunctionDefParamsNode);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseFunctionDefParams() -> Ref<FunctionDefParamsNode> {
+            auto params = list<IdentifierNode>();
             enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
 
             Lexeme next = lookupLex("function params", 1);
             if (next.type == LexemeType::IDENTIFIER) {
                 Lexeme comma;
                 do {
-                    result->params.emplace_back(parseIdentifier());
+                    build.push(params, parseIdentifier());
                     comma = lookupLex("comma or end of argument list", 1);
-                } while (comma.type == LexemeType::COMMA && lexemes.take(comma));
+                } while (comma.type == LexemeType::COMMA && takeLex(comma));
             }
 
             enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
-            return move(result);
+            return build.functionDefParams(move(params));
         }
 
-        std::unique_ptr<HtmlTemplateNode> Parser::parseHtmlTemplate() {
-            auto result = std::unique_ptr<HtmlTemplateNode>(new HtmlTemplateNode);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseHtmlTemplate() -> Ref<HtmlTemplateNode> {
+            Ref<IdentifierNode> identifier;
+            Ref<AttributeListNode> attributes;
+            Ref<IdentifierNode> closingParams;
+            // Both lists are started together, before any of their items is parsed.
+            auto elements = list<HtmlTemplateNode>();
+            auto content = list<TextContentNode>();
             auto first = lookupLex("open angle", 1);
 
             if (first.type == LexemeType::OPEN_ANGLE) {
                 enforceGetLexType(LexemeType::OPEN_ANGLE);
-                result->identifier = parseIdentifier();
-                auto second = lookupLex("identifier", 1);
+                identifier = parseIdentifier();
 
-                if (second.type == LexemeType::IDENTIFIER) {
-                    result->attributes = parseAttributeList();
+                if (lookupLex("identifier", 1).type == LexemeType::IDENTIFIER) {
+                    attributes = parseAttributeList();
                 }
                 enforceGetLexType(LexemeType::CLOSE_ANGLE);
 
-                //auto second = lookupLex("open angle", 1);
-
-                if (second.type == LexemeType::OPEN_ANGLE) {
-                    return parseHtmlTemplate();
-                } else {
-                    result->value.emplace_back(parseTextContent());
+                for (auto next = lookupLex("end angle", 1);
+                     next.type != LexemeType::END_ANGLE;
+                     next = lookupLex("end angle", 1)) {
+                    if (next.type == LexemeType::OPEN_ANGLE) {
+                        build.push(elements, parseHtmlTemplate());
+                    } else {
+                        build.push(content, parseTextContent());
+                    }
                 }
 
                 enforceGetLexType(LexemeType::END_ANGLE);
-                result->closingParams = parseIdentifier();
+                closingParams = parseIdentifier();
                 enforceGetLexType(LexemeType::CLOSE_ANGLE);
             }
 
-            return move(result);
+            return build.htmlTemplate(
+                    move(identifier), move(attributes), move(elements), move(content), move(closingParams));
         }
 
-        std::unique_ptr<AttributeListNode> Parser::parseAttributeList() {
-            auto result = std::unique_ptr<AttributeListNode>(new AttributeListNode);
-            auto endOfAttr = lookupLex("End of argument list", 1);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseAttributeList() -> Ref<AttributeListNode> {
+            auto attributes = list<AttributeNode>();
             do {
-                result->value.emplace_back(parseAttribute());
-            } while (endOfAttr.type == LexemeType::IDENTIFIER && lexemes.take(endOfAttr));
-            return move(result);
+                build.push(attributes, parseAttribute());
+            } while (lookupLex("End of argument list", 1).type == LexemeType::IDENTIFIER);
+            return build.attributeList(move(attributes));
         }
 
-
-        std::unique_ptr<AttributeNode> Parser::parseAttribute() {
-            auto result = std::unique_ptr<AttributeNode>(new AttributeNode);
-
-            result->identifier = parseIdentifier();
+        template<typename Builder>
+        auto BasicParser<Builder>::parseAttribute() -> Ref<AttributeNode> {
+            auto identifier = parseIdentifier();
 
             enforceGetLexType(LexemeType::ASSIGN);
-            result->value = parseAttributeValue();
+            auto value = parseAttributeValue();
 
-            return move(result);
+            return build.attribute(move(identifier), move(value));
         }
 
-
-        std::unique_ptr<AttributeValueNode> Parser::parseAttributeValue() {
-            auto result = std::unique_ptr<AttributeValueNode>(new AttributeValueNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseAttributeValue() -> Ref<AttributeValueNode> {
             auto next = lookupLex("double open brace", 1);
-            if (next.type == LexemeType::DOUBLE_OPEN_BRACE) {
-                result->value = parseInjectedValue();
-            } else {
-                result->string = parseString();
-            }
-
-            return move(result);
+            if (next.type == LexemeType::DOUBLE_OPEN_BRACE)
+                return build.attributeValue(parseInjectedValue(), {});
+            return build.attributeValue({}, parseString());
         }
 
-        std::unique_ptr<InjectedValueNode> Parser::parseInjectedValue() {
-            auto result = std::unique_ptr<InjectedValueNode>(new InjectedValueNode);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseInjectedValue() -> Ref<InjectedValueNode> {
             enforceGetLexType(LexemeType::DOUBLE_OPEN_BRACE);
-            result->value = parseIdentifier();
+            auto value = parseIdentifier();
             enforceGetLexType(LexemeType::DOUBLE_CLOSE_BRACE);
 
-            return move(result);
+            return build.injectedValue(move(value));
         }
 
-        std::unique_ptr<TextContentNode> Parser::parseTextContent() {
-            auto result = std::unique_ptr<TextContentNode>(new TextContentNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseTextContent() -> Ref<TextContentNode> {
             auto next = lookupLex("double open brace", 1);
-            if (next.type == LexemeType::DOUBLE_OPEN_BRACE) {
-                result->value = parseInjectedValue();
-            } else {
-                result->anytext = parseAnyText();
-            }
-            return move(result);
+            if (next.type == LexemeType::DOUBLE_OPEN_BRACE)
+                return build.textContent(parseInjectedValue(), {});
+            return build.textContent({}, parseAnyText());
         }
 
-        std::unique_ptr<ExpressionNode> Parser::parseExpression() {
+        template<typename Builder>
+        auto BasicParser<Builder>::parseExpression() -> Ref<ExpressionNode> {
             auto first = lookupLex("expression", 1);
             switch (first.type) {
                 case LexemeType::LET:
@@ -181,11 +350,12 @@ namespace lang {
 
                 case LexemeType::NOT:
                 case LexemeType::SUBTRACT:
-                    return parseLogicExpression(nullptr);
+                case LexemeType::OPEN_PARENTHESIS:
+                    return parseLogicExpression();
 
                 case LexemeType::STRING:
                 case LexemeType::NUMBER:
-                    return parseLogicExpression(nullptr);
+                    return parseLogicExpression();
 
                 case LexemeType::TRUE:
                 case LexemeType::FALSE:
@@ -200,7 +370,8 @@ namespace lang {
 
         }
 
-        std::unique_ptr<ExpressionNode> Parser::parseExpressionIdentBegins() {
+        template<typename Builder>
+        auto BasicParser<Builder>::parseExpressionIdentBegins() -> Ref<ExpressionNode> {
             auto next = lookupLex("expression", 2);
             if (next.type == LexemeType::OPEN_PARENTHESIS) { return parseFunctionCall(); }
 
@@ -209,446 +380,503 @@ namespace lang {
             auto second = lookupLex("second of expr", 1);
             if (second.type == LexemeType::ASSIGN) { return parseAssignExpression(move(var)); }
 
-            return move(var);
+            return var;
 
         }
 
-        std::unique_ptr<DeclarationExpressionNode> Parser::parseDeclarationExpression() {
-            auto result = std::unique_ptr<DeclarationExpressionNode>(new DeclarationExpressionNode);
-
-            auto let = enforceGetLexType(LexemeType::LET);
-            result->identifier = parseIdentifier();
+        template<typename Builder>
+        auto BasicParser<Builder>::parseDeclarationExpression() -> Ref<DeclarationExpressionNode> {
+            enforceGetLexType(LexemeType::LET);
+            auto identifier = parseIdentifier();
 
+            Ref<ExpressionNode> value;
             auto first = lookupLex("assign", 1);
 
             if (first.type == LexemeType::ASSIGN) {
                 enforceGetLexType(LexemeType::ASSIGN);
-                result->value = parseLogicExpression(std::unique_ptr<LogicExpressionNode>());
+                value = parseLogicExpression();
             }
 
-            return move(result);
+            return build.declarationExpression(move(identifier), move(value));
         }
 
-        std::unique_ptr<ForExpressionNode> Parser::parseForExpression() {
-            auto result = std::unique_ptr<ForExpressionNode>(new ForExpressionNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseForExpression() -> Ref<ForExpressionNode> {
             enforceGetLexType(LexemeType::FOR);
             enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
-            result->iterator = parseDeclarationExpression();
+            auto iterator = parseDeclarationExpression();
             enforceGetLexType(LexemeType::SEMICOLON);
-            result->condition = parseLogicExpression(nullptr);
+            auto condition = parseLogicExpression();
             enforceGetLexType(LexemeType::SEMICOLON);
-            result->expression = parseAssignExpression(nullptr);
+            auto expression = parseAssignExpression({});
             enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
-            result->block = parseBlock();
+            auto block = parseBlock();
 
             enforceGetLexType(LexemeType::SEMICOLON);
-            return move(result);
+            return build.forExpression(move(iterator), move(condition), move(expression), move(block));
         }
 
-        std::unique_ptr<AssignExpressionNode> Parser::parseAssignExpression(std::unique_ptr<VariableNode> var) {
-            auto result = std::unique_ptr<AssignExpressionNode>(new AssignExpressionNode);
-
-            result->variable = move(var);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseAssignExpression(Ref<VariableNode> var) -> Ref<AssignExpressionNode> {
             enforceGetLexType(LexemeType::ASSIGN);
-            result->value = parseExpression();
+            auto value = parseExpression();
 
             enforceGetLexType(LexemeType::SEMICOLON);
-            return move(result);
+            return build.assignExpression(move(var), move(value));
         }
 
-        std::unique_ptr<IfExpressionNode> Parser::parseIfExpression() {
-            auto result = std::unique_ptr<IfExpressionNode>(new IfExpressionNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseIfExpression() -> Ref<IfExpressionNode> {
             enforceGetLexType(LexemeType::IF);
             enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
-            result->condition = parseExpression();
+            auto condition = parseExpression();
             enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
-            result->ifBlock = parseBlock();
+            auto ifBlock = parseBlock();
 
+            Ref<BlockNode> elseBlock;
             auto next = lookupLex("maybe else", 1);
             if (next.type == LexemeType::ELSE) {
                 enforceGetLexType(LexemeType::ELSE);
-                result->elseBlock = parseBlock();
+                elseBlock = parseBlock();
             }
 
             enforceGetLexType(LexemeType::SEMICOLON);
-            return move(result);
+            return build.ifExpression(move(condition), move(ifBlock), move(elseBlock));
         }
 
-        std::unique_ptr<BlockNode> Parser::parseBlock() {
-            auto result = std::unique_ptr<BlockNode>(new BlockNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseBlock() -> Ref<BlockNode> {
             enforceGetLexType(LexemeType::OPEN_BRACE);
-            result->value = parseExpression();
+            auto value = parseExpression();
             enforceGetLexType(LexemeType::CLOSE_BRACE);
 
-            return move(result);
+            return build.block(move(value));
         }
 
-        std::unique_ptr<ReturnExpressionNode> Parser::parseReturnExpression() {
-            auto result = std::unique_ptr<ReturnExpressionNode>(new ReturnExpressionNode);
-
+        template<typename Builder>
+        auto BasicParser<Builder>::parseReturnExpression() -> Ref<ReturnExpressionNode> {
             enforceGetLexType(LexemeType::RETURN);
-            result->returnValue = parseLogicExpression(nullptr);
+            auto value = parseLogicExpression();
 
             enforceGetLexType(LexemeType::SEMICOLON);
-            return move(result);
+            return build.returnExpression(move(value));
         }
 
 
-        std::unique_ptr<MathExpressionNode> Parser::parseMathExpression(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
-        ) {
-            auto firstExpr = parseMultiplicativeExpression(move(maybeFirstVar));
-
-            auto next = lookupLex("maybe additiveOp", 1);
-            switch (next.type) {
-                case LexemeType::ADD:
-                    enforceGetLexType(LexemeType::ADD);
-                    return std::unique_ptr<MathExpressionNode>{
-                            new MathExpressionAddNode(move(firstExpr), parseMathExpression(nullptr))
-                    };
+        template<typename Builder>
+        auto BasicParser<Builder>::parseLogicExpression() -> Ref<ExpressionNode> {
+            auto result = parseOperatorExpression(1);
+            enforceGetLexType(LexemeType::SEMICOLON);
+            return result;
+        }
 
-                case LexemeType::SUBTRACT:
-                    enforceGetLexType(LexemeType::SUBTRACT);
-                    return std::unique_ptr<MathExpressionNode>{
-                            new MathExpressionSubtractNode(move(firstExpr), parseMathExpression(nullptr))
-                    };
+        template<typename Builder>
+        auto BasicParser<Builder>::parseOperatorExpression(int minPrecedence) -> Ref<ExpressionNode> {
+            auto result = parseUnaryExpression();
 
-                default:
-                    return std::unique_ptr<MathExpressionNode>{
-                            new MathExpressionSingleNode(move(firstExpr))
-                    };
+            for (auto next = binaryOperatorOf(lookupLex("operator or end of expression", 1).type);
+                 next.precedence >= minPrecedence;
+                 next = binaryOperatorOf(lookupLex("operator or end of expression", 1).type)) {
+                getLex("operator");
+                auto right = parseOperatorExpression(next.precedence + 1);
+                result = build.binaryOperation(next.op, move(result), move(right));
             }
+
+            return result;
         }
 
-        std::unique_ptr<MultiplicativeExpressionNode> Parser::parseMultiplicativeExpression(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
-        ) {
-            auto firstExpr = parseBaseMathExpression(move(maybeFirstVar));
-
-            const auto next = lookupLex("maybe mutliplicativeOp", 1);
-            switch (next.type) {
-                case LexemeType::MULTIPLY:
-                    enforceGetLexType(LexemeType::MULTIPLY);
-                    return std::unique_ptr<MultiplicativeExpressionNode>{
-                            new MultiplyExpressionNode(move(firstExpr), parseMultiplicativeExpression(nullptr))
-                    };
-
-                case LexemeType::DIVIDE:
-                    enforceGetLexType(LexemeType::DIVIDE);
-                    return std::unique_ptr<MultiplicativeExpressionNode>{
-                            new DivideExpressionNode(move(firstExpr), parseMultiplicativeExpression(nullptr))
-                    };
+        template<typename Builder>
+        auto BasicParser<Builder>::parseUnaryExpression() -> Ref<ExpressionNode> {
+            const auto first = lookupLex("operand", 1);
+            switch (first.type) {
+                case LexemeType::SUBTRACT:
+                    enforceGetLexType(LexemeType::SUBTRACT);
+                    return build.unaryOperation(UnaryOperator::NEGATE, parseUnaryExpression());
+
+                case LexemeType::NOT:
+                    enforceGetLexType(LexemeType::NOT);
+                    return build.unaryOperation(UnaryOperator::NOT, parseUnaryExpression());
 
                 default:
-                    return std::unique_ptr<MultiplicativeExpressionNode>{
-                            new MultiplicativeExpressionSingleNode(move(firstExpr))
-                    };
+                    return parsePrimaryExpression();
             }
         }
 
-        std::unique_ptr<BaseMathExpressionNode> Parser::parseBaseMathExpression(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
-        ) {
-            bool negative = false;
-            std::unique_ptr<BaseMathExpressionNode> result;
-
-            auto maybeUnary = lookupLex("maybe unary", 1);
-            if (!maybeFirstVar && maybeUnary.type == LexemeType::SUBTRACT) {
-                enforceGetLexType(LexemeType::SUBTRACT);
-                negative = true;
-            } else if (!maybeFirstVar && maybeUnary.type == LexemeType::NOT) {
-                enforceGetLexType(LexemeType::NOT);
-                negative = true;
-            }
-            auto first = lookupLex("maybe first", 1);
+        template<typename Builder>
+        auto BasicParser<Builder>::parsePrimaryExpression() -> Ref<ExpressionNode> {
+            const auto first = lookupLex("operand", 1);
             switch (first.type) {
-                case LexemeType::OPEN_PARENTHESIS:
-                    result = std::unique_ptr<BaseMathExpressionNode>{
-                            new ParenthesisExpressionNode(parseMathExpression(nullptr))
-                    };
+                case LexemeType::OPEN_PARENTHESIS: {
+                    enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
+                    auto result = parseOperatorExpression(1);
+                    enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
+                    return result;
+                }
 
                 case LexemeType::OPEN_BRACE:
-                    result = std::unique_ptr<BaseMathExpressionNode>{
-                            new ParenthesisExpressionNode(parseObjectLiteral())
-                    };
-
-                case LexemeType::IDENTIFIER: {
-                    auto second = lookupLex("maybe second", 1);
-                    if (second.type == LexemeType::OPEN_PARENTHESIS)
-                        result = parseFunctionCall();
-                    else result = parseString();
-                };
-                case LexemeType::NUMBER: {
-                    result = parseNumber();
-                };
-
-                default:;
+                    return parseObjectLiteral();
 
-            }
-            result->negate = negative;
-            return move(result);
+                case LexemeType::IDENTIFIER:
+                    if (lookupLex("call or variable", 2).type == LexemeType::OPEN_PARENTHESIS)
+                        return parseFunctionCall();
+                    return parseVariable();
 
-        }
+                case LexemeType::NUMBER:
+                    return parseNumber();
 
-        std::unique_ptr<FunctionCallNode> Parser::parseFunctionCall() {
-            auto result = std::unique_ptr<FunctionCallNode>(new FunctionCallNode);
+                case LexemeType::STRING:
+                    return parseString();
+
+                case LexemeType::TRUE:
+                case LexemeType::FALSE:
+                    return parseLiteral();
+
+                default:
+                    log.error(str(format("Expected operand, found %1%") % first.text));
+                    throw ParserException();
+            }
+        }
 
-            result->identifier = parseIdentifier();
+        template<typename Builder>
+        auto BasicParser<Builder>::parseFunctionCall() -> Ref<FunctionCallNode> {
+            auto identifier = parseIdentifier();
+            auto arguments = list<ExpressionNode>();
             enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
 
             auto next = lookupLex("arguments", 1);
-            if (next.type == LexemeType::CLOSE_PARENTHESIS) {
-                enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
-                return move(result);
+            if (next.type != LexemeType::CLOSE_PARENTHESIS) {
+                Lexeme comma;
+                do {
+                    build.push(arguments, parseLogicExpression());
+                    comma = lookupLex("comma or end of argument list", 1);
+                } while (comma.type == LexemeType::COMMA && takeLex(comma));
             }
 
-            Lexeme comma;
+            enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
+            return build.functionCall(move(identifier), move(arguments));
+        }
 
-            do {
-                result->value.emplace_back(parseLogicExpression(nullptr));
-                comma = lookupLex("comma or end of argument list", 1);
-            } while (comma.type == LexemeType::COMMA && lexemes.take(comma));
+        template<typename Builder>
+        auto BasicParser<Builder>::parseObjectLiteral() -> Ref<ObjectLiteralNode> {
+            auto fields = list<ObjectFieldNode>();
+            enforceGetLexType(LexemeType::OPEN_BRACE);
 
+            Lexeme next = lookupLex("object literal params", 1);
+            if (next.type == LexemeType::IDENTIFIER) {
+                Lexeme comma;
+                do {
+                    build.push(fields, parseObjectField());
+                    comma = lookupLex("comma or end of argument list", 1);
+                } while (comma.type == LexemeType::COMMA && takeLex(comma));
+            }
 
-            enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
-            return move(result);
+            enforceGetLexType(LexemeType::CLOSE_BRACE);
+            return build.objectLiteral(move(fields));
         }
 
-        std::unique_ptr<ParenthesisExpressionNode> Parser::parseParenthesisExpression() {
-            enforceGetLexType(LexemeType::OPEN_PARENTHESIS);
-            std::unique_ptr<ParenthesisExpressionNode> result{
-                    new ParenthesisExpressionNode(parseMathExpression(nullptr))
-            };
-            enforceGetLexType(LexemeType::CLOSE_PARENTHESIS);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseObjectField() -> Ref<ObjectFieldNode> {
+            auto identifier = parseIdentifier();
+            enforceGetLexType(LexemeType::COLON);
+            auto expression = parseLogicExpression();
+            return build.objectField(move(identifier), move(expression));
+        }
 
-            return move(result);
+        template<typename Builder>
+        auto BasicParser<Builder>::parseVariable() -> Ref<VariableNode> {
+            auto identifier = parseIdentifier();
+            auto indices = list<IndexExpressionNode>();
+            while (lookupLex("index expression", 1).type == LexemeType::OPEN_BRACKET)
+                build.push(indices, parseIndexExpression());
+            return build.variable(move(identifier), move(indices));
         }
 
-        std::unique_ptr<LogicExpressionNode> Parser::parseLogicExpression(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
-        ) {
-            auto firstExpr = parseLogicExpressionAnd(move(maybeFirstVar));
+        template<typename Builder>
+        auto BasicParser<Builder>::parseAnyText() -> Ref<AnyTextNode> {
+            auto first = enforceGetLexType(LexemeType::TEXT).text;
+            auto last = first;
+            while (lookupLex("text", 1).type == LexemeType::TEXT)
+                last = getLex("text").text;
 
-            auto maybeOrOp = lookupLex("maybe orOp", 1);
-            switch (maybeOrOp.type) {
-                case LexemeType::OR:
-                    enforceGetLexType(LexemeType::OR);
-                    enforceGetLexType(LexemeType::SEMICOLON);
-                    return std::unique_ptr<LogicExpressionNode>{
-                            new LogicExpressionOrNode(move(firstExpr), parseLogicExpression(nullptr))
+            // Adjacent runs are views into the same source, so the original text between them is kept.
+            return build.anyText(boost::string_view(
+                    first.data(), static_cast<std::size_t>(last.data() + last.size() - first.data())));
+        }
 
-                    };
+        template<typename Builder>
+        auto BasicParser<Builder>::parseIndexExpression() -> Ref<IndexExpressionNode> {
+            enforceGetLexType(LexemeType::OPEN_BRACKET);
+            auto value = parseExpression();
+            enforceGetLexType(LexemeType::CLOSE_BRACKET);
+            return build.indexExpression(move(value));
+        }
 
-                default:
-                    enforceGetLexType(LexemeType::SEMICOLON);
-                    return std::unique_ptr<LogicExpressionNode>{
-                            new LogicExpressionSingleNode(move(firstExpr))
-                    };
-            }
+        template<typename Builder>
+        auto BasicParser<Builder>::parseIdentifier() -> Ref<IdentifierNode> {
+            return build.identifier(enforceGetLexType(LexemeType::IDENTIFIER).symbol);
+        }
 
+        template<typename Builder>
+        auto BasicParser<Builder>::parseString() -> Ref<StringLiteralNode> {
+            auto item = getLex("string");
+            return build.stringLiteral(item.text.substr(1, item.text.length() - 2));
         }
 
-        std::unique_ptr<LogicExpressionAndNode> Parser::parseLogicExpressionAnd(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
-        ) {
-            auto firstExpr = parseLogicExpressionEqual(move(maybeFirstVar));
+        template<typename Builder>
+        auto BasicParser<Builder>::parseNumber() -> Ref<NumberLiteralNode> {
+            return build.numberLiteral(getLex("number").number);
+        }
 
-            auto maybeAndOp = lookupLex("maybe andOp", 1);
-            switch (maybeAndOp.type) {
-                case LexemeType::AND:
-                    enforceGetLexType(LexemeType::AND);
-                    return std::unique_ptr<LogicExpressionAndNode>{
-                            new LogicExpressionAndAndNode(move(firstExpr), parseLogicExpressionAnd(nullptr))
-                    };
+        template<typename Builder>
+        auto BasicParser<Builder>::parseLiteral() -> Ref<BooleanLiteralNode> {
+            auto item = getLex("literal");
+            switch (item.type) {
+                case LexemeType::TRUE:
+                    return build.booleanLiteral(true);
+
+                case LexemeType::FALSE:
+                    return build.booleanLiteral(false);
 
                 default:
-                    return std::unique_ptr<LogicExpressionAndNode>{
-                            new LogicExpressionAndSingleNode(move(firstExpr))
-                    };
+                    throw ParserException();
             }
         }
 
-        std::unique_ptr<LogicExpressionEqualNode> Parser::parseLogicExpressionEqual(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
+        template class BasicParser<TreeBuilder>;
+
+        template class BasicParser<CompactTreeBuilder>;
+
+        std::unique_ptr<ScriptNode> TreeBuilder::script(
+                List<FunctionDefNode> functions,
+                std::shared_ptr<const lexer::SymbolTable> symbols
         ) {
-            auto firstExpr = parseLogicExpressionRelational(move(maybeFirstVar));
+            auto result = std::unique_ptr<ScriptNode>(new ScriptNode);
+            result->functions = move(functions);
+            result->symbols = move(symbols);
+            return result;
+        }
 
-            auto maybeEqualOp = lookupLex("maybe equalOp", 1);
-            switch (maybeEqualOp.type) {
-                case LexemeType::EQUAL:
-                    enforceGetLexType(LexemeType::EQUAL);
-                    return std::unique_ptr<LogicExpressionEqualNode>{
-                            new LogicExpressionEqualEqualNode(move(firstExpr), parseLogicExpressionEqual(nullptr))
-                    };
+        std::unique_ptr<FunctionDefNode> TreeBuilder::functionDef(
+                const lexer::Symbol &name,
+                Ref<HtmlTemplateNode> htmlTemplate,
+                Ref<FunctionDefParamsNode> params,
+                Ref<ExpressionNode> value
+        ) {
+            auto result = std::unique_ptr<FunctionDefNode>(new FunctionDefNode);
+            result->name = name;
+            result->htmltemplate = move(htmlTemplate);
+            result->params = move(params);
+            result->value = move(value);
+            return result;
+        }
 
-                default:
-                    return std::unique_ptr<LogicExpressionEqualNode>{
-                            new LogicExpressionEqualSingleNode(move(firstExpr))
-                    };
-            }
+        std::unique_ptr<FunctionDefParamsNode> TreeBuilder::functionDefParams(List<IdentifierNode> params) {
+            auto result = std::unique_ptr<FunctionDefParamsNode>(new FunctionDefParamsNode);
+            result->params = move(params);
+            return result;
         }
 
-        std::unique_ptr<LogicExpressionRelationalNode> Parser::parseLogicExpressionRelational(
-                std::unique_ptr<ExpressionNode> maybeFirstVar
+        std::unique_ptr<HtmlTemplateNode> TreeBuilder::htmlTemplate(
+                Ref<IdentifierNode> identifier,
+                Ref<AttributeListNode> attributes,
+                List<HtmlTemplateNode> elements,
+                List<TextContentNode> content,
+                Ref<IdentifierNode> closingParams
         ) {
-            auto firstExpr = parseMathExpression(move(maybeFirstVar));
-
-            auto maybeRelationalOp = lookupLex("maybe relationalOp", 1);
-            switch (maybeRelationalOp.type) {
-                case LexemeType::OPEN_ANGLE:
-                    enforceGetLexType(LexemeType::OPEN_ANGLE);
-                    return std::unique_ptr<LogicExpressionRelationalNode>{
-                            new LogicExpressionRelationalLessNode(
-                                    move(firstExpr),
-                                    parseLogicExpressionRelational(nullptr)
-                            )
-                    };
-
-                case LexemeType::LESS_EQ:
-                    enforceGetLexType(LexemeType::LESS_EQ);
-                    return std::unique_ptr<LogicExpressionRelationalNode>{
-                            new LogicExpressionRelationalLessEqualNode(
-                                    move(firstExpr),
-                                    parseLogicExpressionRelational(nullptr)
-                            )
-                    };
-
-                case LexemeType::CLOSE_ANGLE :
-                    enforceGetLexType(LexemeType::CLOSE_ANGLE);
-                    return std::unique_ptr<LogicExpressionRelationalNode>{
-                            new LogicExpressionRelationalGreaterNode(
-                                    move(firstExpr),
-                                    parseLogicExpressionRelational(nullptr)
-                            )
-                    };
-
-                case LexemeType::GREATER_EQ:
-                    enforceGetLexType(LexemeType::GREATER_EQ);
-                    return std::unique_ptr<LogicExpressionRelationalNode>{
-                            new LogicExpressionRelationalGreaterEqualNode(
-                                    move(firstExpr),
-                                    parseLogicExpressionRelational(nullptr)
-                            )
-                    };
+            auto result = std::unique_ptr<HtmlTemplateNode>(new HtmlTemplateNode);
+            result->identifier = move(identifier);
+            result->attributes = move(attributes);
+            result->htmlValue = move(elements);
+            result->value = move(content);
+            result->closingParams = move(closingParams);
+            return result;
+        }
 
-                default:
-                    return std::unique_ptr<LogicExpressionRelationalNode>{
-                            new LogicExpressionRelationalSingleNode(move(firstExpr))
-                    };
-            }
+        std::unique_ptr<AttributeListNode> TreeBuilder::attributeList(List<AttributeNode> attributes) {
+            auto result = std::unique_ptr<AttributeListNode>(new AttributeListNode);
+            result->value = move(attributes);
+            return result;
         }
 
-        std::unique_ptr<ObjectLiteralNode> Parser::parseObjectLiteral() {
-            auto result = std::unique_ptr<ObjectLiteralNode>(new ObjectLiteralNode);
-            enforceGetLexType(LexemeType::OPEN_BRACKET);
+        std::unique_ptr<AttributeNode> TreeBuilder::attribute(
+                Ref<IdentifierNode> identifier,
+                Ref<AttributeValueNode> value
+        ) {
+            auto result = std::unique_ptr<AttributeNode>(new AttributeNode);
+            result->identifier = move(identifier);
+            result->value = move(value);
+            return result;
+        }
 
-            Lexeme next = lookupLex("object literal params", 1);
-            if (next.type == LexemeType::IDENTIFIER) {
-                Lexeme comma;
-                do {
-                    result->injection.emplace_back(parseObjectField());
-                    comma = lookupLex("comma or end of argument list", 1);
-                } while (comma.type == LexemeType::COMMA && lexemes.take(comma));
-            }
+        std::unique_ptr<AttributeValueNode> TreeBuilder::attributeValue(
+                Ref<InjectedValueNode> value,
+                Ref<StringLiteralNode> string
+        ) {
+            auto result = std::unique_ptr<AttributeValueNode>(new AttributeValueNode);
+            result->value = move(value);
+            result->string = move(string);
+            return result;
+        }
 
-            enforceGetLexType(LexemeType::CLOSE_BRACKET);
-            return move(result);
+        std::unique_ptr<InjectedValueNode> TreeBuilder::injectedValue(Ref<IdentifierNode> value) {
+            auto result = std::unique_ptr<InjectedValueNode>(new InjectedValueNode);
+            result->value = move(value);
+            return result;
         }
 
-        std::unique_ptr<ObjectFieldNode> Parser::parseObjectField() {
-            auto result = std::unique_ptr<ObjectFieldNode>(new ObjectFieldNode);
-            result->identifier = parseIdentifier();
-            enforceGetLexType(LexemeType::COLON);
-            result->expression = parseLogicExpression(nullptr);
-            return move(result);
+        std::unique_ptr<TextContentNode> TreeBuilder::textContent(Ref<InjectedValueNode> value, Ref<AnyTextNode> text) {
+            auto result = std::unique_ptr<TextContentNode>(new TextContentNode);
+            result->value = move(value);
+            result->anytext = move(text);
+            return result;
         }
 
-        std::unique_ptr<VariableNode> Parser::parseVariable() {
-            auto result = std::unique_ptr<VariableNode>(new VariableNode);
-            result->identifier = parseIdentifier();
-            while (lookupLex("index expression", 1).type == LexemeType::OPEN_BRACKET)
-                result->indices.emplace_back(parseIndexExpression());
-            return move(result);
+        std::unique_ptr<ReturnExpressionNode> TreeBuilder::returnExpression(Ref<ExpressionNode> value) {
+            auto result = std::unique_ptr<ReturnExpressionNode>(new ReturnExpressionNode);
+            result->returnValue = move(value);
+            return result;
         }
 
-        std::unique_ptr<AnyTextNode> Parser::parseAnyText() {
-            auto result = std::unique_ptr<AnyTextNode>(new AnyTextNode);
-            while ((lookupLex("any char", 1).type == LexemeType::IDENTIFIER) ||
-                   (lookupLex("any number", 1).type == LexemeType::NUMBER))
-                result->chars.emplace_back(parseAnyChar());
-            return move(result);
+        std::unique_ptr<BlockNode> TreeBuilder::block(Ref<ExpressionNode> value) {
+            auto result = std::unique_ptr<BlockNode>(new BlockNode);
+            result->value = move(value);
+            return result;
         }
 
-        std::unique_ptr<AnyCharNode> Parser::parseAnyChar() {
-            auto result = std::unique_ptr<AnyCharNode>(new AnyCharNode);
-            auto item = getLex("any char");
-            switch (item.type) {
-                case LexemeType::IDENTIFIER:
-                    result->identifier = parseIdentifier();
-                    return move(result);
-                case LexemeType::NUMBER:
-                    result->number = parseNumber();
-                    return move(result);
-                default:
-                    throw ParserException();
-            }
+        std::unique_ptr<DeclarationExpressionNode> TreeBuilder::declarationExpression(
+                Ref<IdentifierNode> identifier,
+                Ref<ExpressionNode> value
+        ) {
+            auto result = std::unique_ptr<DeclarationExpressionNode>(new DeclarationExpressionNode);
+            result->identifier = move(identifier);
+            result->value = move(value);
+            return result;
         }
 
-        std::unique_ptr<IndexExpressionNode> Parser::parseIndexExpression() {
-            auto result = std::unique_ptr<IndexExpressionNode>(new IndexExpressionNode);
-            enforceGetLexType(LexemeType::OPEN_BRACKET);
-            result->value = parseExpression();
-            enforceGetLexType(LexemeType::CLOSE_BRACKET);
-            return move(result);
+        std::unique_ptr<ForExpressionNode> TreeBuilder::forExpression(
+                Ref<DeclarationExpressionNode> iterator,
+                Ref<ExpressionNode> condition,
+                Ref<AssignExpressionNode> expression,
+                Ref<BlockNode> block
+        ) {
+            auto result = std::unique_ptr<ForExpressionNode>(new ForExpressionNode);
+            result->iterator = move(iterator);
+            result->condition = move(condition);
+            result->expression = move(expression);
+            result->block = move(block);
+            return result;
         }
 
-        std::unique_ptr<IdentifierNode> Parser::parseIdentifier() {
-            auto result = std::unique_ptr<IdentifierNode>(new IdentifierNode);
-            result->name = enforceGetLexType(LexemeType::IDENTIFIER).text;
-            return move(result);
+        std::unique_ptr<AssignExpressionNode> TreeBuilder::assignExpression(
+                Ref<VariableNode> variable,
+                Ref<ExpressionNode> value
+        ) {
+            auto result = std::unique_ptr<AssignExpressionNode>(new AssignExpressionNode);
+            result->variable = move(variable);
+            result->value = move(value);
+            return result;
         }
 
-        std::unique_ptr<BaseMathExpressionNode> Parser::parseString() {
-            auto item = getLex("string");
-            auto withoutQuotes = item.text.substr(1, item.text.length() - 2);
-            return std::unique_ptr<BaseMathExpressionNode>{new StringLiteralNode(move(withoutQuotes))};
+        std::unique_ptr<IfExpressionNode> TreeBuilder::ifExpression(
+                Ref<ExpressionNode> condition,
+                Ref<BlockNode> ifBlock,
+                Ref<BlockNode> elseBlock
+        ) {
+            auto result = std::unique_ptr<IfExpressionNode>(new IfExpressionNode);
+            result->condition = move(condition);
+            result->ifBlock = move(ifBlock);
+            result->elseBlock = move(elseBlock);
+            return result;
+        }
 
+        std::unique_ptr<ExpressionNode> TreeBuilder::binaryOperation(
+                BinaryOperator op,
+                Ref<ExpressionNode> left,
+                Ref<ExpressionNode> right
+        ) {
+            return std::unique_ptr<ExpressionNode>{new BinaryOperationNode(op, move(left), move(right))};
         }
 
-        std::unique_ptr<BaseMathExpressionNode> Parser::parseNumber() {
-            auto item = getLex("number");
-            return std::unique_ptr<BaseMathExpressionNode>{
-                    new NumberLiteralNode(boost::lexical_cast<double>(item.text))};
+        std::unique_ptr<ExpressionNode> TreeBuilder::unaryOperation(UnaryOperator op, Ref<ExpressionNode> operand) {
+            return std::unique_ptr<ExpressionNode>{new UnaryOperationNode(op, move(operand))};
+        }
 
+        std::unique_ptr<FunctionCallNode> TreeBuilder::functionCall(
+                Ref<IdentifierNode> identifier,
+                List<ExpressionNode> arguments
+        ) {
+            auto result = std::unique_ptr<FunctionCallNode>(new FunctionCallNode);
+            result->identifier = move(identifier);
+            result->value = move(arguments);
+            return result;
         }
 
-        std::unique_ptr<LiteralNode> Parser::parseLiteral() {
-            auto item = getLex("literal");
-            switch (item.type) {
-                case LexemeType::TRUE:
-                    return std::unique_ptr<LiteralNode>{new BooleanLiteralNode(true)};
+        std::unique_ptr<ObjectLiteralNode> TreeBuilder::objectLiteral(List<ObjectFieldNode> fields) {
+            auto result = std::unique_ptr<ObjectLiteralNode>(new ObjectLiteralNode);
+            result->injection = move(fields);
+            return result;
+        }
 
-                case LexemeType::FALSE:
-                    return std::unique_ptr<LiteralNode>{new BooleanLiteralNode(false)};
+        std::unique_ptr<ObjectFieldNode> TreeBuilder::objectField(
+                Ref<IdentifierNode> identifier,
+                Ref<ExpressionNode> expression
+        ) {
+            auto result = std::unique_ptr<ObjectFieldNode>(new ObjectFieldNode);
+            result->identifier = move(identifier);
+            result->expression = move(expression);
+            return result;
+        }
 
-                default:
-                    throw ParserException();
-            }
+        std::unique_ptr<VariableNode> TreeBuilder::variable(
+                Ref<IdentifierNode> identifier,
+                List<IndexExpressionNode> indices
+        ) {
+            auto result = std::unique_ptr<VariableNode>(new VariableNode);
+            result->identifier = move(identifier);
+            result->indices = move(indices);
+            return result;
+        }
+
+        std::unique_ptr<IndexExpressionNode> TreeBuilder::indexExpression(Ref<ExpressionNode> value) {
+            auto result = std::unique_ptr<IndexExpressionNode>(new IndexExpressionNode);
+            result->value = move(value);
+            return result;
+        }
+
+        std::unique_ptr<AnyTextNode> TreeBuilder::anyText(boost::string_view text) {
+            auto result = std::unique_ptr<AnyTextNode>(new AnyTextNode);
+            result->text = text.to_string();
+            return result;
+        }
+
+        std::unique_ptr<IdentifierNode> TreeBuilder::identifier(const lexer::Symbol &name) {
+            auto result = std::unique_ptr<IdentifierNode>(new IdentifierNode);
+            result->name = name;
+            return result;
+        }
+
+        std::unique_ptr<StringLiteralNode> TreeBuilder::stringLiteral(boost::string_view value) {
+            return std::unique_ptr<StringLiteralNode>{new StringLiteralNode(value.to_string())};
         }
 
-        lexer::Lexeme Parser::getLex(const std::string &expected) {
+        std::unique_ptr<NumberLiteralNode> TreeBuilder::numberLiteral(double value) {
+            return std::unique_ptr<NumberLiteralNode>{new NumberLiteralNode(value)};
+        }
+
+        std::unique_ptr<BooleanLiteralNode> TreeBuilder::booleanLiteral(bool value) {
+            return std::unique_ptr<BooleanLiteralNode>{new BooleanLiteralNode(value)};
+        }
+
+        lexer::Lexeme LexemeReader::getLex(const char *expected) {
             Lexeme lexeme;
-            if (!lexemes.take(lexeme)) {
+            if (!takeLex(lexeme)) {
                 log.error(str(format("Expected %1%, found end of file; Aborting") % expected));
                 throw ParserException();
             }
             return lexeme;
         }
 
-        void Parser::enforceLexType(const lexer::Lexeme &lexeme, lexer::LexemeType lexemeType) {
+        void LexemeReader::enforceLexType(const lexer::Lexeme &lexeme, lexer::LexemeType lexemeType) {
             if (lexeme.type != lexemeType) {
                 log.error(str(format("Expected lexeme type %1%, got %2%; Aborting")
                               % static_cast<int>(lexemeType) % lexeme.text));
@@ -656,19 +884,53 @@ namespace lang {
             }
         }
 
-        lexer::Lexeme Parser::enforceGetLexType(lexer::LexemeType lexemeType) {
-            auto result = getLex(str(format("[LexemeType: %1%]") % static_cast<int>(lexemeType)));
+        lexer::Lexeme LexemeReader::enforceGetLexType(lexer::LexemeType lexemeType) {
+            Lexeme result;
+            // Message is only formatted on failure, most expected lexemes are there.
+            if (!takeLex(result)) {
+                log.error(str(format("Expected [LexemeType: %1%], found end of file; Aborting")
+                              % static_cast<int>(lexemeType)));
+                throw ParserException();
+            }
             enforceLexType(result, lexemeType);
             return result;
         }
 
-        lexer::Lexeme Parser::lookupLex(const std::string &expected, std::size_t index) {
+        lexer::Lexeme LexemeReader::lookupLex(const char *expected, std::size_t index) {
             Lexeme lexeme;
-            if (!lexemes.lookup(index, lexeme)) {
+            if (!peekLex(index, lexeme)) {
                 log.error(str(format("Expected %1%, found end of file; Aborting") % expected));
                 throw ParserException();
             }
             return lexeme;
         }
+    
+        bool LexemeReader::takeLex(lexer::Lexeme &out) {
+            if (!tokens)
+                return lexemes->take(out);
+
+            if (position >= tokens->size())
+                return false;
+            out = (*tokens)[position++];
+            return true;
+        }
+
+        bool LexemeReader::peekLex(std::size_t index, lexer::Lexeme &out) {
+            if (!tokens)
+                return lexemes->lookup(index, out);
+
+            assert(index > 0);
+            if (position + index > tokens->size())
+                return false;
+            out = (*tokens)[position + index - 1];
+            return true;
+        }
+
+        bool LexemeReader::hasNextLex() {
+            if (!tokens)
+                return lexemes->hasNext();
+
+            return position < tokens->size();
+        }
     }
-}
+}
\ No newline at end of file
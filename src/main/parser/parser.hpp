@@ -4,122 +4,326 @@
 #include "../logging/logger.hpp"
 #include "../util/output-stream-lookup-buffer.hpp"
 #include "../lexer/lexeme.hpp"
+#include "../lexer/lexer.hpp"
+#include "../lexer/token-array.hpp"
 #include "node.hpp"
+#include <boost/optional.hpp>
+#include <boost/utility/string_view.hpp>
 #include <memory>
 #include <exception>
+#include <vector>
 
 namespace lang {
     namespace parser {
         struct ParserException : std::exception {
         };
 
-        class Parser {
+        /**
+         * Parses template and body of a definition left by Parser::preParse; parsed definitions are left as they are.
+         */
+        void parseDeferred(FunctionDefNode &function, logging::Logger &logger);
+
+        /**
+         * Lexemes of a parser, pulled from a stream or indexed in a token array, with the checks
+         * which log and throw ParserException when the input does not match the grammar.
+         */
+        class LexemeReader {
+        protected:
             logging::Logger &log;
-            util::OutputStreamLookupBuffer<lexer::Lexeme> lexemes;
+            boost::optional<util::OutputStreamLookupBuffer<lexer::Lexeme>> lexemes;
+            const lexer::TokenArray *tokens = nullptr;
+            std::size_t position = 0;
+            std::shared_ptr<const lexer::SymbolTable> symbols;
 
-        public:
-            Parser(
+            LexemeReader(
                     logging::Logger &logger,
-                    util::OutputStream<lexer::Lexeme> &lexemes
+                    util::OutputStream<lexer::Lexeme> &lexemes,
+                    std::shared_ptr<const lexer::SymbolTable> symbols
             );
 
-            std::unique_ptr<ScriptNode> getTree();
+            LexemeReader(
+                    logging::Logger &logger,
+                    const lexer::TokenArray &tokens
+            );
 
-        private:
-            std::unique_ptr<ScriptNode> parseScript();
+            lexer::Lexeme getLex(const char *expected);
 
-            std::unique_ptr<FunctionDefNode> parseFunctionDef();
+            void enforceLexType(const lexer::Lexeme &lexeme, lexer::LexemeType lexemeType);
 
-            std::unique_ptr<FunctionDefParamsNode> parseFunctionDefParams();
+            lexer::Lexeme enforceGetLexType(lexer::LexemeType lexemeType);
 
-            std::unique_ptr<HtmlTemplateNode> parseHtmlTemplate();
+            lexer::Lexeme lookupLex(const char *expected, std::size_t index);
 
-            std::unique_ptr<AttributeNode> parseAttribute();
+            bool takeLex(lexer::Lexeme &out);
 
-            std::unique_ptr<AttributeValueNode> parseAttributeValue();
+            bool peekLex(std::size_t index, lexer::Lexeme &out);
 
-            std::unique_ptr<AttributeListNode> parseAttributeList();
+            bool hasNextLex();
+        };
 
-            std::unique_ptr<TextContentNode> parseTextContent();
+        /**
+         * Builds the node graph: every node is allocated on its own and owns its children.
+         */
+        class TreeBuilder {
+        public:
+            template<typename Node>
+            using Ref = std::unique_ptr<Node>;
 
-            std::unique_ptr<InjectedValueNode> parseInjectedValue();
+            template<typename Node>
+            using List = std::vector<std::unique_ptr<Node>>;
 
-            std::unique_ptr<ExpressionNode> parseExpression();
+            /** Nothing has to be dropped, a replaced node is freed by its owner. */
+            struct Mark {
+            };
 
-            std::unique_ptr<ExpressionNode> parseExpressionIdentBegins();
+            Mark mark() const {
+                return {};
+            }
 
-            std::unique_ptr<ReturnExpressionNode> parseReturnExpression();
+            void dropSince(Mark) {
+            }
 
-            std::unique_ptr<BlockNode> parseBlock();
+            template<typename Node>
+            List<Node> list() const {
+                return {};
+            }
 
-            std::unique_ptr<DeclarationExpressionNode> parseDeclarationExpression();
+            template<typename Node, typename Item>
+            void push(List<Node> &list, Item item) {
+                list.emplace_back(std::move(item));
+            }
 
-            std::unique_ptr<ForExpressionNode> parseForExpression();
+            Ref<ScriptNode> script(List<FunctionDefNode> functions, std::shared_ptr<const lexer::SymbolTable> symbols);
 
-            std::unique_ptr<AssignExpressionNode> parseAssignExpression(std::unique_ptr<VariableNode> var);
+            Ref<FunctionDefNode> functionDef(
+                    const lexer::Symbol &name,
+                    Ref<HtmlTemplateNode> htmlTemplate,
+                    Ref<FunctionDefParamsNode> params,
+                    Ref<ExpressionNode> value
+            );
 
-            std::unique_ptr<IfExpressionNode> parseIfExpression();
+            Ref<FunctionDefParamsNode> functionDefParams(List<IdentifierNode> params);
 
-            std::unique_ptr<MathExpressionNode> parseMathExpression(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
+            Ref<HtmlTemplateNode> htmlTemplate(
+                    Ref<IdentifierNode> identifier,
+                    Ref<AttributeListNode> attributes,
+                    List<HtmlTemplateNode> elements,
+                    List<TextContentNode> content,
+                    Ref<IdentifierNode> closingParams
             );
 
-            std::unique_ptr<MultiplicativeExpressionNode> parseMultiplicativeExpression(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
-            );
+            Ref<AttributeListNode> attributeList(List<AttributeNode> attributes);
 
-            std::unique_ptr<BaseMathExpressionNode> parseBaseMathExpression(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
-            );
+            Ref<AttributeNode> attribute(Ref<IdentifierNode> identifier, Ref<AttributeValueNode> value);
 
-            std::unique_ptr<BaseMathExpressionNode> parseString();
+            Ref<AttributeValueNode> attributeValue(Ref<InjectedValueNode> value, Ref<StringLiteralNode> string);
 
-            std::unique_ptr<BaseMathExpressionNode> parseNumber();
+            Ref<InjectedValueNode> injectedValue(Ref<IdentifierNode> value);
 
-            std::unique_ptr<FunctionCallNode> parseFunctionCall();
+            Ref<TextContentNode> textContent(Ref<InjectedValueNode> value, Ref<AnyTextNode> text);
 
-            std::unique_ptr<ParenthesisExpressionNode> parseParenthesisExpression();
+            Ref<ReturnExpressionNode> returnExpression(Ref<ExpressionNode> value);
 
-            std::unique_ptr<LogicExpressionNode> parseLogicExpression(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
+            Ref<BlockNode> block(Ref<ExpressionNode> value);
+
+            Ref<DeclarationExpressionNode> declarationExpression(
+                    Ref<IdentifierNode> identifier,
+                    Ref<ExpressionNode> value
             );
 
-            std::unique_ptr<LogicExpressionAndNode> parseLogicExpressionAnd(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
+            Ref<ForExpressionNode> forExpression(
+                    Ref<DeclarationExpressionNode> iterator,
+                    Ref<ExpressionNode> condition,
+                    Ref<AssignExpressionNode> expression,
+                    Ref<BlockNode> block
             );
 
-            std::unique_ptr<LogicExpressionEqualNode> parseLogicExpressionEqual(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
+            Ref<AssignExpressionNode> assignExpression(Ref<VariableNode> variable, Ref<ExpressionNode> value);
+
+            Ref<IfExpressionNode> ifExpression(
+                    Ref<ExpressionNode> condition,
+                    Ref<BlockNode> ifBlock,
+                    Ref<BlockNode> elseBlock
             );
 
-            std::unique_ptr<LogicExpressionRelationalNode> parseLogicExpressionRelational(
-                    std::unique_ptr<ExpressionNode> maybeFirstVar
+            Ref<ExpressionNode> binaryOperation(
+                    BinaryOperator op,
+                    Ref<ExpressionNode> left,
+                    Ref<ExpressionNode> right
             );
 
-            std::unique_ptr<ObjectLiteralNode> parseObjectLiteral();
+            Ref<ExpressionNode> unaryOperation(UnaryOperator op, Ref<ExpressionNode> operand);
 
-            std::unique_ptr<ObjectFieldNode> parseObjectField();
+            Ref<FunctionCallNode> functionCall(Ref<IdentifierNode> identifier, List<ExpressionNode> arguments);
 
-            std::unique_ptr<VariableNode> parseVariable();
+            Ref<ObjectLiteralNode> objectLiteral(List<ObjectFieldNode> fields);
 
-            std::unique_ptr<IndexExpressionNode> parseIndexExpression();
+            Ref<ObjectFieldNode> objectField(Ref<IdentifierNode> identifier, Ref<ExpressionNode> expression);
 
-            std::unique_ptr<AnyTextNode> parseAnyText();
+            Ref<VariableNode> variable(Ref<IdentifierNode> identifier, List<IndexExpressionNode> indices);
 
-            std::unique_ptr<AnyCharNode> parseAnyChar();
+            Ref<IndexExpressionNode> indexExpression(Ref<ExpressionNode> value);
 
-            std::unique_ptr<IdentifierNode> parseIdentifier();
+            Ref<AnyTextNode> anyText(boost::string_view text);
 
-            std::unique_ptr<LiteralNode> parseLiteral();
+            Ref<IdentifierNode> identifier(const lexer::Symbol &name);
 
-            lexer::Lexeme getLex(const std::string &expected);
+            Ref<StringLiteralNode> stringLiteral(boost::string_view value);
 
-            void enforceLexType(const lexer::Lexeme &lexeme, lexer::LexemeType lexemeType);
+            Ref<NumberLiteralNode> numberLiteral(double value);
 
-            lexer::Lexeme enforceGetLexType(lexer::LexemeType lexemeType);
+            Ref<BooleanLiteralNode> booleanLiteral(bool value);
+        };
+
+        /**
+         * The grammar, written once for every representation of the tree. Builder makes the nodes:
+         * Ref<Node> is what a parsed node is held by, List<Node> collects the items of a node
+         * until the node is built. Children are always built before their parents.
+         * Instantiated in parser.cpp for TreeBuilder and CompactTreeBuilder.
+         */
+        template<typename Builder>
+        class BasicParser : protected LexemeReader {
+        protected:
+            template<typename Node>
+            using Ref = typename Builder::template Ref<Node>;
+
+            template<typename Node>
+            using List = typename Builder::template List<Node>;
+
+            Builder build;
+
+            BasicParser(
+                    logging::Logger &logger,
+                    util::OutputStream<lexer::Lexeme> &lexemes,
+                    std::shared_ptr<const lexer::SymbolTable> symbols
+            );
+
+            BasicParser(
+                    logging::Logger &logger,
+                    const lexer::TokenArray &tokens
+            );
+
+            template<typename Node>
+            List<Node> list() const {
+                return build.template list<Node>();
+            }
+
+            Ref<ScriptNode> parseScript();
+
+            Ref<FunctionDefNode> parseFunctionDef();
+
+            Ref<FunctionDefParamsNode> parseFunctionDefParams();
+
+            Ref<HtmlTemplateNode> parseHtmlTemplate();
+
+            Ref<AttributeNode> parseAttribute();
+
+            Ref<AttributeValueNode> parseAttributeValue();
+
+            Ref<AttributeListNode> parseAttributeList();
+
+            Ref<TextContentNode> parseTextContent();
+
+            Ref<InjectedValueNode> parseInjectedValue();
+
+            Ref<ExpressionNode> parseExpression();
+
+            Ref<ExpressionNode> parseExpressionIdentBegins();
+
+            Ref<ReturnExpressionNode> parseReturnExpression();
 
-            lexer::Lexeme lookupLex(const std::string &expected, std::size_t index);
+            Ref<BlockNode> parseBlock();
+
+            Ref<DeclarationExpressionNode> parseDeclarationExpression();
+
+            Ref<ForExpressionNode> parseForExpression();
+
+            Ref<AssignExpressionNode> parseAssignExpression(Ref<VariableNode> var);
+
+            Ref<IfExpressionNode> parseIfExpression();
+
+            /**
+             * Operator expression terminated by semicolon.
+             */
+            Ref<ExpressionNode> parseLogicExpression();
+
+            /**
+             * Precedence climbing: operand followed by operators binding at least as tight as minPrecedence.
+             * Operators of equal precedence associate to the left.
+             */
+            Ref<ExpressionNode> parseOperatorExpression(int minPrecedence);
+
+            Ref<ExpressionNode> parseUnaryExpression();
+
+            Ref<ExpressionNode> parsePrimaryExpression();
+
+            Ref<StringLiteralNode> parseString();
+
+            Ref<NumberLiteralNode> parseNumber();
+
+            Ref<FunctionCallNode> parseFunctionCall();
+
+            Ref<ObjectLiteralNode> parseObjectLiteral();
+
+            Ref<ObjectFieldNode> parseObjectField();
+
+            Ref<VariableNode> parseVariable();
+
+            Ref<IndexExpressionNode> parseIndexExpression();
+
+            Ref<AnyTextNode> parseAnyText();
+
+            Ref<IdentifierNode> parseIdentifier();
+
+            Ref<BooleanLiteralNode> parseLiteral();
+        };
+
+        class Parser : BasicParser<TreeBuilder> {
+            lexer::Lexer *lexer = nullptr;
+
+        public:
+            /**
+             * @param symbols Table symbols of the lexemes come from; tree keeps it alive.
+             */
+            Parser(
+                    logging::Logger &logger,
+                    util::OutputStream<lexer::Lexeme> &lexemes,
+                    std::shared_ptr<const lexer::SymbolTable> symbols
+            );
+
+            Parser(
+                    logging::Logger &logger,
+                    lexer::Lexer &lexer
+            );
+
+            /**
+             * Parses already lexed input, indexing the token array directly instead of pulling lexemes
+             * one by one. Tokens have to outlive the parser.
+             */
+            Parser(
+                    logging::Logger &logger,
+                    const lexer::TokenArray &tokens
+            );
+
+            std::unique_ptr<ScriptNode> getTree();
+
+            /**
+             * Parses only names and parameters of functions. Templates and bodies are skipped by balancing
+             * brackets and braces, and the definitions keep a copy of their source for parseDeferred.
+             * Available for parsers created from a lexer.
+             */
+            std::unique_ptr<ScriptNode> preParse();
+
+        private:
+            std::unique_ptr<FunctionDefNode> preParseFunctionDef(
+                    const std::shared_ptr<const DeferredSource> &source
+            );
 
+            /**
+             * Takes lexemes up to the close lexeme matching the open one taken first.
+             * @return The close lexeme.
+             */
+            lexer::Lexeme skipBalanced(lexer::LexemeType open, lexer::LexemeType close);
         };
     }
 }
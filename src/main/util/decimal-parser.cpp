@@ -0,0 +1,65 @@
+#include "decimal-parser.hpp"
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <locale.h>
+#include <string>
+
+namespace lang {
+    namespace util {
+        namespace {
+            // Every integer up to 2^53 and every power of ten up to 10^22 is exact in double, so a single
+            // multiplication or division of them is correctly rounded (Clinger's fast path).
+            const std::uint64_t maxExactMantissa = std::uint64_t(1) << 53;
+            const int maxExactPowerOfTen = 22;
+
+            const double powersOfTen[maxExactPowerOfTen + 1] = {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+            };
+
+            const std::size_t maxStackLiteral = 128;
+
+            locale_t classicLocale() {
+                static const locale_t locale = newlocale(LC_ALL_MASK, "C", static_cast<locale_t>(0));
+                return locale;
+            }
+
+            /**
+             * Slow path for literals with too many significant digits, still independent of current locale.
+             */
+            double parseSlow(boost::string_view text) {
+                if (text.size() < maxStackLiteral) {
+                    char buffer[maxStackLiteral];
+                    std::memcpy(buffer, text.data(), text.size());
+                    buffer[text.size()] = '\0';
+                    return strtod_l(buffer, nullptr, classicLocale());
+                }
+                return strtod_l(text.to_string().c_str(), nullptr, classicLocale());
+            }
+        }
+
+        double parseDecimal(boost::string_view text) {
+            std::uint64_t mantissa = 0;
+            int exponent = 0;
+            bool fraction = false;
+
+            for (char c : text) {
+                if (c == '.') {
+                    fraction = true;
+                    continue;
+                }
+                const auto digit = static_cast<std::uint64_t>(c - '0');
+                if (mantissa > (maxExactMantissa - digit) / 10)
+                    return parseSlow(text);
+                mantissa = mantissa * 10 + digit;
+                if (fraction)
+                    --exponent;
+            }
+
+            if (exponent < -maxExactPowerOfTen)
+                return parseSlow(text);
+            return static_cast<double>(mantissa) / powersOfTen[-exponent];
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef UTIL_DECIMAL_PARSER_HPP
+#define UTIL_DECIMAL_PARSER_HPP
+
+#include <boost/utility/string_view.hpp>
+
+namespace lang {
+    namespace util {
+        /**
+         * Converts unsigned decimal number (digits with optional fraction) into correctly rounded double.
+         * Does not depend on current locale and does not allocate for literals of reasonable length.
+         */
+        double parseDecimal(boost::string_view text);
+    }
+}
+
+#endif // UTIL_DECIMAL_PARSER_HPP
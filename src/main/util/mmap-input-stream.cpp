@@ -0,0 +1,81 @@
+#include "mmap-input-stream.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lang {
+    namespace util {
+        namespace {
+            const std::size_t paddingSize = 2;
+
+            std::string describeError(const std::string &action, const std::string &path) {
+                return action + " " + path + ": " + std::strerror(errno);
+            }
+        }
+
+        MmapInputStream::MmapInputStream(const std::string &path) {
+            const int fd = open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                throw IoException(describeError("cannot open", path));
+
+            struct stat info;
+            if (fstat(fd, &info) < 0) {
+                close(fd);
+                throw IoException(describeError("cannot stat", path));
+            }
+            contentSize = static_cast<std::size_t>(info.st_size);
+
+            // Anonymous pages are reserved first, so the padding after the file is zeroed even
+            // when file size is a multiple of the page size.
+            const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            mappingSize = (contentSize + paddingSize + pageSize - 1) / pageSize * pageSize;
+
+            void *reserved = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (reserved == MAP_FAILED) {
+                close(fd);
+                throw IoException(describeError("cannot reserve memory for", path));
+            }
+            mapping = static_cast<char *>(reserved);
+
+            if (contentSize > 0 && mmap(mapping, contentSize, PROT_READ | PROT_WRITE,
+                                        MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+                const std::string message = describeError("cannot map", path);
+                munmap(mapping, mappingSize);
+                close(fd);
+                throw IoException(message);
+            }
+            close(fd);
+        }
+
+        MmapInputStream::~MmapInputStream() {
+            munmap(mapping, mappingSize);
+        }
+
+        bool MmapInputStream::take(char &out) {
+            if (position < contentSize) {
+                out = mapping[position++];
+                return true;
+            }
+            return false;
+        }
+
+        std::size_t MmapInputStream::read(char *buffer, std::size_t maxRead) {
+            const auto count = std::min(maxRead, contentSize - position);
+            std::copy_n(mapping + position, count, buffer);
+            position += count;
+            return count;
+        }
+
+        char *MmapInputStream::data() {
+            return mapping;
+        }
+
+        std::size_t MmapInputStream::size() const {
+            return contentSize;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#ifndef UTIL_MMAP_INPUT_STREAM_HPP
+#define UTIL_MMAP_INPUT_STREAM_HPP
+
+#include <string>
+#include "generic-exception.hpp"
+#include "output-stream.hpp"
+
+namespace lang {
+    namespace util {
+        struct IoExceptionTag {
+        };
+        using IoException = GenericException<IoExceptionTag>;
+
+        /**
+         * Maps whole file into memory. Mapping is private and writable and is always followed by two zero
+         * bytes, so it can be handed to the scanner in place of a copied buffer.
+         */
+        class MmapInputStream : public OutputStream<char> {
+            char *mapping = nullptr;
+            std::size_t mappingSize = 0;
+            std::size_t contentSize = 0;
+            std::size_t position = 0;
+
+        public:
+            explicit MmapInputStream(const std::string &path);
+
+            MmapInputStream(const MmapInputStream &) = delete;
+
+            MmapInputStream &operator=(const MmapInputStream &) = delete;
+
+            virtual ~MmapInputStream();
+
+            bool take(char &out) override;
+
+            std::size_t read(char *buffer, std::size_t maxRead) override;
+
+            char *data();
+
+            std::size_t size() const;
+        };
+    }
+}
+
+#endif // UTIL_MMAP_INPUT_STREAM_HPP
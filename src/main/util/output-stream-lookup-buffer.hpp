@@ -2,45 +2,86 @@
 #define UTIL_OUTPUT_STREAM_LOOKUP_BUFFER_HPP
 
 #include "output-stream.hpp"
-#include <deque>
+#include <array>
 #include <cassert>
+#include <stdexcept>
+#include <utility>
 
 namespace lang {
     namespace util {
-        template<typename T>
+        /**
+         * Fixed-capacity ring buffer of items read ahead from the stream.
+         *
+         * @tparam Capacity Maximal lookup distance; has to be a power of two.
+         */
+        template<typename T, std::size_t Capacity = 4>
         class OutputStreamLookupBuffer {
+            static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
             OutputStream <T> &stream;
-            std::deque<T> bufferedItems;
+            std::array<T, Capacity> bufferedItems;
+            std::size_t first = 0;
+            std::size_t count = 0;
 
         public:
             explicit OutputStreamLookupBuffer(OutputStream <T> &stream) : stream(stream) {
             }
 
-            bool lookup(std::size_t index, T &outItem) {
-                assert(index > 0);
+            /**
+             * Reads ahead so that index-th item is buffered.
+             *
+             * @return False if stream ends earlier.
+             * @throws std::out_of_range if index is zero or beyond the capacity.
+             */
+            bool available(std::size_t index) {
+                if (index == 0 || index > Capacity)
+                    throw std::out_of_range("lookup beyond capacity of the buffer");
 
-                T item;
-                for (std::size_t i = bufferedItems.size(); i < index; ++i) {
-                    if (!stream.take(item)) {
+                for (; count < index; ++count) {
+                    if (!stream.take(bufferedItems[slot(count)])) {
                         return false;
                     }
-                    bufferedItems.emplace_back(std::move(item));
                 }
-                outItem = bufferedItems[index - 1];
+                return true;
+            }
+
+            /**
+             * @return Reference to index-th buffered item, valid until it is taken.
+             * @remarks Item has to be available.
+             */
+            const T &peek(std::size_t index) const {
+                assert(index > 0 && index <= count);
+                return bufferedItems[slot(index - 1)];
+            }
+
+            /**
+             * @throws std::out_of_range if index is zero or beyond the capacity.
+             */
+            bool lookup(std::size_t index, T &outItem) {
+                if (!available(index)) {
+                    return false;
+                }
+                outItem = peek(index);
                 return true;
             }
 
             bool take(T &outItem) {
-                if (lookup(1, outItem)) {
-                    bufferedItems.erase(bufferedItems.begin());
-                    return true;
+                if (!available(1)) {
+                    return false;
                 }
-                return false;
+                outItem = std::move(bufferedItems[first]);
+                first = slot(1);
+                --count;
+                return true;
             }
 
             bool hasNext() {
-                T dummy;
-                return lookup(1, dummy);
+                return available(1);
+            }
+
+        private:
+            std::size_t slot(std::size_t offset) const {
+                return (first + offset) & (Capacity - 1);
             }
         };
     }
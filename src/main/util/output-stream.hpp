@@ -1,6 +1,8 @@
 #ifndef UTIL_STREAM_HPP
 #define UTIL_STREAM_HPP
 
+#include <cstddef>
+
 namespace lang {
     namespace util {
         template<typename Item>
@@ -8,6 +10,22 @@ namespace lang {
             virtual ~OutputStream() {}
 
             virtual bool take(Item &out) = 0;
+
+            /**
+             * Takes up to maxRead items at once.
+             *
+             * @param buffer Output buffer.
+             * @param maxRead Buffer size.
+             * @return Number of items read; less than maxRead only at the end of the stream.
+             * @remarks Default implementation falls back to take, streams backed by a block
+             *          source should override it.
+             */
+            virtual std::size_t read(Item *buffer, std::size_t maxRead) {
+                std::size_t count = 0;
+                while (count < maxRead && take(buffer[count]))
+                    ++count;
+                return count;
+            }
         };
     }
 }
@@ -0,0 +1,66 @@
+#ifndef UTIL_SPSC_QUEUE_HPP
+#define UTIL_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+namespace lang {
+    namespace util {
+        /**
+         * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+         *
+         * @tparam Capacity Maximal number of queued items; has to be a power of two.
+         */
+        template<typename T, std::size_t Capacity>
+        class SpscQueue {
+            static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity has to be a power of two");
+
+            static const std::size_t cacheLineSize = 64;
+
+            std::unique_ptr<T[]> items{new T[Capacity]};
+
+            // Producer and consumer indices live on separate cache lines, so the threads do not fight over them.
+            alignas(cacheLineSize) std::atomic<std::size_t> head{0};
+            alignas(cacheLineSize) std::atomic<std::size_t> tail{0};
+
+        public:
+            SpscQueue() = default;
+
+            SpscQueue(const SpscQueue &) = delete;
+
+            SpscQueue &operator=(const SpscQueue &) = delete;
+
+            /**
+             * @remarks Producer side.
+             * @return False if queue is full, item is left untouched then.
+             */
+            bool tryPush(T &item) {
+                const auto currentTail = tail.load(std::memory_order_relaxed);
+                if (currentTail - head.load(std::memory_order_acquire) == Capacity)
+                    return false;
+
+                items[currentTail & (Capacity - 1)] = std::move(item);
+                tail.store(currentTail + 1, std::memory_order_release);
+                return true;
+            }
+
+            /**
+             * @remarks Consumer side.
+             * @return False if queue is empty.
+             */
+            bool tryPop(T &out) {
+                const auto currentHead = head.load(std::memory_order_relaxed);
+                if (currentHead == tail.load(std::memory_order_acquire))
+                    return false;
+
+                out = std::move(items[currentHead & (Capacity - 1)]);
+                head.store(currentHead + 1, std::memory_order_release);
+                return true;
+            }
+        };
+    }
+}
+
+#endif // UTIL_SPSC_QUEUE_HPP
@@ -6,5 +6,10 @@ namespace lang {
         bool StdinOutputStream::take(char &out) {
             return (bool) std::cin.get(out);
         }
+
+        std::size_t StdinOutputStream::read(char *buffer, std::size_t maxRead) {
+            std::cin.read(buffer, maxRead);
+            return static_cast<std::size_t>(std::cin.gcount());
+        }
     }
 }
\ No newline at end of file
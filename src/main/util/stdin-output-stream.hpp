@@ -7,6 +7,8 @@ namespace lang {
     namespace util {
         struct StdinOutputStream : OutputStream<char> {
             bool take(char &out) override;
+
+            std::size_t read(char *buffer, std::size_t maxRead) override;
         };
     }
 }
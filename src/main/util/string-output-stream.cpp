@@ -1,4 +1,5 @@
 #include "string-output-stream.hpp"
+#include <algorithm>
 #include <iostream>
 
 namespace lang {
@@ -14,5 +15,12 @@ namespace lang {
             }
             return false;
         }
+
+        std::size_t StringOutputStream::read(char *buffer, std::size_t maxRead) {
+            const auto count = std::min(maxRead, static_cast<std::size_t>(content.end() - position));
+            std::copy_n(position, count, buffer);
+            position += count;
+            return count;
+        }
     }
 }
\ No newline at end of file
@@ -14,6 +14,8 @@ namespace lang {
             explicit StringOutputStream(std::string content);
 
             bool take(char &out) override;
+
+            std::size_t read(char *buffer, std::size_t maxRead) override;
         };
     }
 }
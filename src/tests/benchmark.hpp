@@ -0,0 +1,27 @@
+#ifndef TEST_BENCHMARK_HPP
+#define TEST_BENCHMARK_HPP
+
+#include <chrono>
+#include <cstddef>
+
+/**
+ * Timing helpers of benchmarks. Benchmarks are disabled tests, so they stay out of regular runs;
+ * run them with test-all --gtest_also_run_disabled_tests --gtest_filter='*DISABLED_*'.
+ */
+namespace lang {
+    template<typename F>
+    double measureMilliseconds(F action) {
+        const auto start = std::chrono::steady_clock::now();
+        action();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    template<typename F>
+    double measureMegabytesPerSecond(std::size_t bytes, F action) {
+        const double milliseconds = measureMilliseconds(action);
+        return bytes / (1024. * 1024.) / (milliseconds / 1000.);
+    }
+}
+
+#endif // TEST_BENCHMARK_HPP
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "interpreter/closure-compiler.hpp"
+#include "interpreter/exceptions.hpp"
+#include "interpreter/resolver.hpp"
+#include "engine-runner.hpp"
+
+namespace lang {
+    namespace interpreter {
+        TEST(ClosureCompilerTest, matches_tree_walker_on_sample_scripts) {
+            for (const auto &test : sampleCases()) {
+                for (bool lazy : {false, true}) {
+                    const auto tree = run(*parse(test.code, lazy), Engine::TREE, test.function, test.arguments);
+                    const auto closure = run(*parse(test.code, lazy), Engine::CLOSURE, test.function, test.arguments);
+                    EXPECT_EQ(tree, closure) << test.code;
+                }
+            }
+        }
+
+        TEST(ClosureCompilerTest, matches_tree_walker_on_generated_scripts) {
+            ScriptGenerator generator(7);
+            for (int i = 0; i < 200; ++i) {
+                const auto code = generator.script(4);
+                for (const auto &arguments : generatedArguments()) {
+                    const auto tree = run(*parse(code), Engine::TREE, "f0", arguments);
+                    const auto closure = run(*parse(code), Engine::CLOSURE, "f0", arguments);
+                    ASSERT_EQ(tree, closure) << code;
+                }
+            }
+        }
+
+        TEST(ClosureCompilerTest, runs_compiled_body_on_frame) {
+            auto tree = parse("function f(a, b) {let c = (a * 2 + b);}");
+            resolveNames(*tree->functions[0], {});
+            const auto closure = compileClosure(*tree->functions[0]);
+
+            std::vector<Variable> globals;
+            std::vector<Variable> slots{numberOf(3), numberOf(1), Variable()};
+            ClosureFrame frame(globals, slots);
+            EXPECT_EQ("7.000000", closure(frame).toString());
+            EXPECT_EQ("7.000000", frame.slots[2].toString());
+        }
+
+        TEST(ClosureCompilerTest, rejects_nodes_it_cannot_execute) {
+            auto tree = parse("function f() {missing}");
+            resolveNames(*tree->functions[0], {});
+            auto loop = new parser::ForExpressionNode();
+            loop->expression.reset(new parser::AssignExpressionNode());
+            tree->functions[0]->value.reset(loop);
+            EXPECT_THROW(compileClosure(*tree->functions[0]), InterpreterFailure);
+        }
+
+        TEST(ClosureCompilerTest, DISABLED_engines_benchmark) {
+            // Recursion, arithmetic on locals and array building, like functions of test.lang.
+            auto tree = parse("function fib(n) {if ((2 > n);) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                                      "function fill(n, a) {if ((0 < n);) {fill(n - 1;, push(a;, n * 2;);)} else {a};}"
+                                      "function total(a, i, s) {if ((i < len(a;));) {total(a;, i + 1;, s + a[i];)}"
+                                      " else {s};}"
+                                      "function work() {total(fill(150;, array(0;););, 0;, 0;)}");
+
+            std::string results[3];
+            double times[3];
+            const Engine engines[] = {Engine::TREE, Engine::VM, Engine::CLOSURE};
+            for (int i = 0; i < 3; ++i) {
+                times[i] = measureMilliseconds([&] {
+                    Interpreter interpreter(*tree, engines[i]);
+                    results[i] = interpreter.execute("fib", {numberOf(22)}).toString();
+                    for (int j = 0; j < 10; ++j)
+                        results[i] += " " + interpreter.execute("work").toString();
+                });
+            }
+
+            EXPECT_EQ(results[0], results[1]);
+            EXPECT_EQ(results[0], results[2]);
+            std::cout << "[ BENCHMARK] tree: " << times[0] << " ms, vm: " << times[1] << " ms, closure: "
+                      << times[2] << " ms, speedup over tree " << times[0] / times[2] << std::endl;
+        }
+    }
+}
@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "interpreter/cpp-emitter.hpp"
+#include "interpreter/exceptions.hpp"
+#include "engine-runner.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            const char *const BENCHMARK_SCRIPT =
+                    "function fib(n) {if ((2 > n);) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                    "function fill(n, a) {if ((0 < n);) {fill(n - 1;, push(a;, n * 2;);)} else {a};}"
+                    "function total(a, i, s) {if ((i < len(a;));) {total(a;, i + 1;, s + a[i];)} else {s};}"
+                    "function work() {total(fill(150;, array(0;););, 0;, 0;)}";
+
+            struct NativeCase {
+                std::string code;
+                std::string function;
+                std::vector<Variable> arguments;
+                std::string module;
+            };
+
+            /**
+             * Sample and generated scripts, all emitted to one translation unit and built once with the system
+             * compiler, which takes much longer than running them.
+             */
+            class CppEmitterTest : public ::testing::Test {
+            protected:
+                static std::string directory;
+                static std::string library;
+                static std::string buildOutput;
+                static std::vector<NativeCase> cases;
+
+                static void SetUpTestCase() {
+                    char path[] = "/tmp/lang-native-XXXXXX";
+                    if (!mkdtemp(path))
+                        return;
+                    directory = path;
+
+                    for (auto &test : sampleCases())
+                        cases.push_back({test.code, test.function, test.arguments, ""});
+                    ScriptGenerator generator(11);
+                    for (int i = 0; i < 20; ++i)
+                        cases.push_back({generator.script(4), "f0", {}, ""});
+                    cases.push_back({BENCHMARK_SCRIPT, "fib", {}, ""});
+
+                    std::ofstream source(directory + "/modules.cpp");
+                    for (std::size_t i = 0; i < cases.size(); ++i) {
+                        cases[i].module = "Case" + std::to_string(i);
+                        auto script = parse(cases[i].code);
+                        Interpreter(*script).emitCpp(source, cases[i].module);
+                    }
+                    source.close();
+
+                    library = directory + "/modules.so";
+                    const auto command = "c++ -std=c++14 -O1 -shared -fPIC -I" TEST_SOURCE_DIR "/main " + directory
+                                         + "/modules.cpp -o " + library + " 2>&1";
+                    std::FILE *compiler = popen(command.c_str(), "r");
+                    char buffer[4096];
+                    while (std::size_t read = std::fread(buffer, 1, sizeof(buffer), compiler))
+                        buildOutput.append(buffer, read);
+                    if (pclose(compiler) != 0)
+                        library.clear();
+                }
+
+                static void TearDownTestCase() {
+                    if (!directory.empty())
+                        std::system(("rm -rf " + directory).c_str());
+                }
+
+                void SetUp() override {
+                    ASSERT_FALSE(library.empty()) << buildOutput;
+                }
+            };
+
+            std::string CppEmitterTest::directory;
+            std::string CppEmitterTest::library;
+            std::string CppEmitterTest::buildOutput;
+            std::vector<NativeCase> CppEmitterTest::cases;
+        }
+
+        TEST_F(CppEmitterTest, matches_tree_walker_on_sample_scripts) {
+            const auto count = sampleCases().size();
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto &test = cases[i];
+                const auto tree = run(*parse(test.code), Engine::TREE, test.function, test.arguments);
+                const auto native = run(*parse(test.code), Engine::TREE, test.function, test.arguments, library,
+                                        test.module);
+                EXPECT_EQ(tree, native) << test.code;
+            }
+        }
+
+        TEST_F(CppEmitterTest, matches_tree_walker_on_generated_scripts) {
+            for (std::size_t i = sampleCases().size(); i + 1 < cases.size(); ++i) {
+                const auto &test = cases[i];
+                for (const auto &arguments : generatedArguments()) {
+                    const auto tree = run(*parse(test.code), Engine::TREE, test.function, arguments);
+                    const auto native = run(*parse(test.code), Engine::TREE, test.function, arguments, library,
+                                            test.module);
+                    ASSERT_EQ(tree, native) << test.code;
+                }
+            }
+        }
+
+        TEST_F(CppEmitterTest, rejects_module_of_another_script) {
+            auto script = parse("function f(a) {a}");
+            Interpreter interpreter(*script);
+            EXPECT_THROW(interpreter.loadNative(library, cases.back().module), InterpreterFailure);
+            EXPECT_THROW(interpreter.loadNative(library, "Missing"), InterpreterFailure);
+            EXPECT_THROW(interpreter.loadNative(directory + "/missing.so"), InterpreterFailure);
+        }
+
+        TEST_F(CppEmitterTest, DISABLED_engines_benchmark) {
+            auto tree = parse(BENCHMARK_SCRIPT);
+            std::string results[2];
+            double times[2];
+            for (int i = 0; i < 2; ++i) {
+                times[i] = measureMilliseconds([&] {
+                    Interpreter interpreter(*tree);
+                    if (i == 1)
+                        interpreter.loadNative(library, cases.back().module);
+                    results[i] = interpreter.execute("fib", {numberOf(22)}).toString();
+                    for (int j = 0; j < 10; ++j)
+                        results[i] += " " + interpreter.execute("work").toString();
+                });
+            }
+
+            EXPECT_EQ(results[0], results[1]);
+            std::cout << "[ BENCHMARK] tree: " << times[0] << " ms, native: " << times[1] << " ms, speedup "
+                      << times[0] / times[1] << std::endl;
+        }
+
+        TEST(CppEmitterNamesTest, rejects_invalid_module_name) {
+            auto script = parse("function f(a) {a}");
+            std::ostringstream out;
+            EXPECT_THROW(Interpreter(*script).emitCpp(out, "a-b"), InterpreterFailure);
+        }
+
+        TEST(CppEmitterStringsTest, keeps_embedded_zeros) {
+            auto script = parse(std::string("function f() {\"a\0b\" ;}", 23));
+            std::ostringstream out;
+            Interpreter(*script).emitCpp(out, "Strings");
+
+            EXPECT_NE(std::string::npos, out.str().find("Variable(std::string(\"a\\000b\", 3))")) << out.str();
+        }
+    }
+}
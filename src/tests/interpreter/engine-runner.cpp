@@ -0,0 +1,200 @@
+#include "engine-runner.hpp"
+#include <iostream>
+#include <sstream>
+#include <typeinfo>
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+
+namespace lang {
+    namespace interpreter {
+        std::unique_ptr<parser::ScriptNode> parse(const std::string &code, bool lazy) {
+            util::StringOutputStream codeStream(code);
+            lexer::Lexer lexer(codeStream);
+            logging::Logger logger;
+            parser::Parser parser(logger, lexer);
+            return lazy ? parser.preParse() : parser.getTree();
+        }
+
+        Variable numberOf(double value) {
+            double numeric[] = {value};
+            return Variable(numeric, 1);
+        }
+
+        std::string run(
+                parser::ScriptNode &script,
+                Engine engine,
+                const std::string &function,
+                const std::vector<Variable> &arguments,
+                const std::string &nativeLibrary,
+                const std::string &moduleName
+        ) {
+            std::ostringstream output;
+            const auto previous = std::cout.rdbuf(output.rdbuf());
+            std::string result;
+            try {
+                Interpreter interpreter(script, engine);
+                if (!nativeLibrary.empty())
+                    interpreter.loadNative(nativeLibrary, moduleName);
+                const auto value = interpreter.execute(function, arguments);
+                result = std::to_string(static_cast<int>(value.getType())) + " " + value.toString();
+            } catch (const std::exception &e) {
+                result = std::string("exception ") + typeid(e).name();
+            }
+            std::cout.rdbuf(previous);
+            return output.str() + "| " + result;
+        }
+
+        std::vector<Case> sampleCases() {
+            const auto numbers = std::vector<Variable>{numberOf(7), numberOf(3)};
+            const auto booleans = std::vector<Variable>{Variable(true), Variable(false)};
+            const auto array = std::vector<Variable>{
+                    Variable(std::vector<Variable>{numberOf(1), Variable(std::vector<Variable>{numberOf(2), numberOf(3)})}),
+                    numberOf(0)
+            };
+            double components[] = {1, 2};
+            const auto vector = std::vector<Variable>{Variable(components, 2), numberOf(5)};
+            return {
+                    {"function f(a, b) {((a + b) * (a - b) / 2);}", "f", numbers},
+                    {"function f(a, b) {(-a <= b == !(a > b));}", "f", numbers},
+                    {"function f(a) {(a + \"!\" == \"x!\");}", "f", {Variable(std::string("x"))}},
+                    {"function f(a, b) {if ((a > 5);) {(a * 2);} else {-a;};}", "f", numbers},
+                    {"function f(a, b) {if ((b > 5);) {(a * 2);};}", "f", numbers},
+                    {"function f(a, b) {(a || b && !a);}", "f", booleans},
+                    {"function f(a, b) {(b && a || b);}", "f", booleans},
+                    {"function f(a, b) {(a || b);}", "f", numbers},
+                    {"function f(a, b) {(a + true);}", "f", numbers},
+                    {"function f(a) {b = a;}", "f", numbers},
+                    {"function f() {missing}", "f", {}},
+                    {"function f() {let x}", "f", {}},
+                    {"function f(a) {let x = (a * a);}", "f", numbers},
+                    {"function set() {g = 5;;} function g() {1;} function f() {(set() + g);}", "f", {}},
+                    {"function f() {push(array(1;, 2;);, 3;)}", "f", {}},
+                    {"function f() {len(array(1;, 2;);)}", "f", {}},
+                    {"function f(a) {a[1;][0;]}", "f", array},
+                    {"function f(a) {a[5;]}", "f", array},
+                    {"function f(a, b) {a[b]}", "f", booleans},
+                    {"function f(a) {a[1;][1;] = 9;;}", "f", array},
+                    {"function g(a) {a} function f(a) {g(a[a[0;] = 4;;];)}", "f", array},
+                    {"function f(a, b) {(b + a[b = 1;;][0;]);}", "f", array},
+                    {"function f(a, b) {(b + a[0;] + b);}", "f", array},
+                    {"function f(a, b) {(a[b = 1;;][0;] + b);}", "f", array},
+                    {"function id(x) {x} function f() {({x: 1;, y: id;});}", "f", {}},
+                    {"function id(x) {x} function f(a) {(a + {});}", "f", {numberOf(1)}},
+                    {"function id(x) {x} function f(a) {id({};)}", "f", numbers},
+                    {"function id(x) {x} function f(a) {id(a;, id({};);)}", "f", numbers},
+                    {"function id(x) {x} function f() {({x: {};});}", "f", {}},
+                    {"function id(x) {x} function f(a) {a[0;][({});]}", "f", array},
+                    {"function id(x) {x} function f(a) {if ((a);) {({});} else {({});};}", "f", {Variable(true)}},
+                    {"function f(a) {a(1;)}", "f", numbers},
+                    {"function f(a, b) {print(a;, \"x\";, b;)}", "f", numbers},
+                    {"function g(v) {v[2;]} function f(a, b) {g((vec3(a;, 2;, 3;) + vec3(b;, 1;, 1;));)}", "f", numbers},
+                    {"function f(a, b) {((vec2(a;, b;) * vec2(2;, 3;) - -vec2(1;, 1;)) / vec2(b;, a;));}", "f", numbers},
+                    {"function f(a, b) {(vec4(a;, b;, a;, b;) == vec4(a;, b;, a;, b;));}", "f", numbers},
+                    {"function f(a, b) {len(vec3(a;, b;, 1;);)}", "f", numbers},
+                    {"function f(a) {vec4(a;, a;)}", "f", numbers},
+                    {"function f(a, b) {(vec2(a;, b;) + a);}", "f", numbers},
+                    {"function f(a, b) {(a[1;] * b);}", "f", vector},
+                    {"function f(a, b) {a[2;]}", "f", vector},
+                    {"function f(a, b) {a[0;] = b;}", "f", vector},
+                    {"function g(a, b, c, d, e, x) {(a + x * e);} function f(a, b) {g(a;, b;, a;, b;, a;, b;)}", "f", numbers},
+                    {"function fib(n) {if ((2 > n);) {n} else {(fib(n - 1;) + fib(n - 2;));};}", "fib", {numberOf(12)}},
+            };
+        }
+
+        std::vector<std::vector<Variable>> generatedArguments() {
+            return {
+                    {numberOf(1), numberOf(2), numberOf(3)},
+                    {numberOf(0), numberOf(-4), numberOf(0.5)},
+                    {Variable(true), Variable(false), Variable(true)},
+                    {Variable(std::string("s")), Variable(std::string("t")), numberOf(1)},
+                    {Variable(std::vector<Variable>{numberOf(1), numberOf(2), numberOf(3)}), numberOf(1), Variable(false)},
+            };
+        }
+
+        ScriptGenerator::ScriptGenerator(unsigned seed) : random(seed) {
+        }
+
+        std::size_t ScriptGenerator::pick(std::size_t count) {
+            return std::uniform_int_distribution<std::size_t>(0, count - 1)(random);
+        }
+
+        std::string ScriptGenerator::operand(int depth) {
+            static const char *const params[] = {"a", "b", "c"};
+            switch (pick(depth > 0 ? 10 : 5)) {
+                case 0:
+                case 1:
+                    return std::to_string(pick(10));
+                case 2:
+                case 3:
+                    return params[pick(3)];
+                case 4:
+                    switch (pick(4)) {
+                        case 0:
+                            return "true";
+                        case 1:
+                            return "false";
+                        case 2:
+                            return "\"s\"";
+                        default:
+                            return "zz";
+                    }
+                case 5:
+                    return "(" + expression(depth - 1) + ")";
+                case 6:
+                    return (pick(2) ? "-" : "!") + operand(depth - 1);
+                case 7:
+                    return std::string(params[pick(3)]) + "[" + std::to_string(pick(3)) + ";]";
+                default:
+                    return call(depth - 1);
+            }
+        }
+
+        std::string ScriptGenerator::call(int depth) {
+            if (current + 1 >= functionCount) {
+                static const char *const builtins[] = {"len", "array"};
+                return std::string(builtins[pick(2)]) + "(" + expression(depth) + ";)";
+            }
+            const auto callee = current + 1 + pick(functionCount - current - 1);
+            return "f" + std::to_string(callee) + "(" + expression(depth) + ";, " + expression(depth) + ";, "
+                   + expression(depth) + ";)";
+        }
+
+        std::string ScriptGenerator::expression(int depth) {
+            static const char *const operators[] = {
+                    "+", "-", "*", "/", "==", "!=", "<", ">", "<=", ">=", "||", "&&"
+            };
+            std::string result = operand(depth);
+            for (std::size_t i = pick(3); i > 0; --i)
+                result += std::string(" ") + operators[pick(12)] + " " + operand(depth);
+            return result;
+        }
+
+        std::string ScriptGenerator::body() {
+            switch (pick(6)) {
+                case 0:
+                    return "if ((" + expression(2) + ");) {(" + expression(2) + ");} else {("
+                           + expression(2) + ");};";
+                case 1:
+                    return "if ((" + expression(2) + ");) {(" + expression(2) + ");};";
+                case 2:
+                    return "let d = (" + expression(2) + ");";
+                case 3:
+                    return "c = (" + expression(2) + ");;";
+                case 4:
+                    return "a[" + std::to_string(pick(3)) + ";] = (" + expression(2) + ");;";
+                default:
+                    return "(" + expression(3) + ");";
+            }
+        }
+
+        std::string ScriptGenerator::script(std::size_t functions) {
+            functionCount = functions;
+            std::string result;
+            for (current = 0; current < functionCount; ++current)
+                result += "function f" + std::to_string(current) + "(a, b, c) {" + body() + "}\n";
+            return result;
+        }
+    }
+}
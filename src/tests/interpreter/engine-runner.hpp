@@ -0,0 +1,74 @@
+#ifndef TEST_INTERPRETER_ENGINE_RUNNER_HPP
+#define TEST_INTERPRETER_ENGINE_RUNNER_HPP
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "interpreter/interpreter.hpp"
+#include "parser/node.hpp"
+#include "../benchmark.hpp"
+
+namespace lang {
+    namespace interpreter {
+        std::unique_ptr<parser::ScriptNode> parse(const std::string &code, bool lazy = false);
+
+        Variable numberOf(double value);
+
+        /**
+         * Everything observable about a call: printed text, and the result or type of the exception.
+         * With a native library its module is loaded before the call.
+         */
+        std::string run(
+                parser::ScriptNode &script,
+                Engine engine,
+                const std::string &function,
+                const std::vector<Variable> &arguments,
+                const std::string &nativeLibrary = "",
+                const std::string &moduleName = ""
+        );
+
+        struct Case {
+            std::string code;
+            std::string function;
+            std::vector<Variable> arguments;
+        };
+
+        /**
+         * Scripts covering every kind of expression, along with the order in which Executor evaluates them.
+         */
+        std::vector<Case> sampleCases();
+
+        /**
+         * Argument sets for functions of generated scripts, each with three parameters.
+         */
+        std::vector<std::vector<Variable>> generatedArguments();
+
+        /**
+         * Generates scripts of random expressions. Functions only call the ones defined after them,
+         * so every script terminates.
+         */
+        class ScriptGenerator {
+            std::mt19937 random;
+            std::size_t functionCount = 0;
+            std::size_t current = 0;
+
+            std::size_t pick(std::size_t count);
+
+            std::string operand(int depth);
+
+            std::string call(int depth);
+
+            std::string expression(int depth);
+
+            std::string body();
+
+        public:
+            explicit ScriptGenerator(unsigned seed);
+
+            std::string script(std::size_t functions);
+        };
+    }
+}
+
+#endif // TEST_INTERPRETER_ENGINE_RUNNER_HPP
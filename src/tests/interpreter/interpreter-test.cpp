@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include "interpreter/interpreter.hpp"
+#include "engine-runner.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            const Engine engines[] = {Engine::TREE, Engine::VM, Engine::CLOSURE};
+
+            /**
+             * Returned value as written by run, after the printed text.
+             */
+            std::string returned(VariableType type, const std::string &text) {
+                return "| " + std::to_string(static_cast<int>(type)) + " " + text;
+            }
+        }
+
+        TEST(InterpreterTest, identifier_operands_read_variables) {
+            auto tree = parse("function f(a, b) {(a * 2 + b);}");
+
+            for (auto engine : engines) {
+                Interpreter interpreter(*tree, engine);
+                const Variable result = interpreter.execute("f", {numberOf(3), numberOf(4)});
+                ASSERT_EQ(VariableType::Number, result.getType());
+                EXPECT_EQ(10.0, result.getNumeric()) << static_cast<int>(engine);
+            }
+        }
+
+        TEST(InterpreterTest, and_evaluates_right_operand_only_when_left_holds) {
+            auto tree = parse("function f(a) {(a && print(\"right\";));}");
+
+            for (auto engine : engines) {
+                EXPECT_EQ(returned(VariableType::Boolean, "false"),
+                          run(*tree, engine, "f", {Variable(false)})) << static_cast<int>(engine);
+                EXPECT_EQ("right\n" + returned(VariableType::Undefined, "undefined"),
+                          run(*tree, engine, "f", {Variable(true)})) << static_cast<int>(engine);
+            }
+        }
+
+        TEST(InterpreterTest, not_equal_negates_equality) {
+            auto tree = parse("function f(a, b) {(a != b);}");
+            const std::vector<std::vector<Variable>> arguments{
+                    {numberOf(1), numberOf(1)},
+                    {numberOf(1), numberOf(2)},
+                    {Variable(std::string("x")), Variable(std::string("x"))},
+                    {Variable(std::string("x")), Variable(std::string("y"))},
+                    {Variable(true), Variable(false)},
+            };
+            const bool expected[] = {false, true, false, true, true};
+
+            for (auto engine : engines) {
+                Interpreter interpreter(*tree, engine);
+                for (std::size_t i = 0; i < arguments.size(); ++i) {
+                    const Variable result = interpreter.execute("f", arguments[i]);
+                    ASSERT_EQ(VariableType::Boolean, result.getType());
+                    EXPECT_EQ(expected[i], static_cast<bool>(result)) << static_cast<int>(engine) << " " << i;
+                }
+            }
+        }
+    }
+}
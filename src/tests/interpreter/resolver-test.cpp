@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "interpreter/exceptions.hpp"
+#include "interpreter/interpreter.hpp"
+#include "interpreter/resolver.hpp"
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "../parser/fake-visitor.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            using parser::Binding;
+
+            std::unique_ptr<parser::ScriptNode> parse(const std::string &code) {
+                util::StringOutputStream codeStream(code);
+                lexer::Lexer lexer(codeStream);
+                logging::Logger logger;
+                parser::Parser parser(logger, lexer);
+                return parser.getTree();
+            }
+
+            Variable numberOf(double value) {
+                double numeric[] = {value};
+                return Variable(numeric, 1);
+            }
+
+            double number(const Variable &variable) {
+                EXPECT_EQ(VariableType::Number, variable.getType());
+                return variable.getNumeric();
+            }
+        }
+
+        TEST(ResolverTest, binds_params_and_declarations_to_slots) {
+            auto tree = parse("function foo(a, b) {let c = (a + b + bar(c;) + missing);}"
+                                      "function bar(x) {x}");
+            const std::unordered_map<std::string, std::uint32_t> globals{{"foo", 0}, {"bar", 1}};
+            resolveNames(*tree->functions[0], globals);
+
+            parser::FakeVisitor visitor;
+            tree->functions[0]->visit(visitor);
+
+            EXPECT_EQ(3, tree->functions[0]->frameSize);
+            ASSERT_EQ(1, visitor.DeclarationExpressionNode_visited.size());
+            const auto &declared = visitor.DeclarationExpressionNode_visited[0]->identifier->binding;
+            EXPECT_EQ(Binding::Kind::LOCAL, declared.kind);
+            EXPECT_EQ(2, declared.index);
+
+            ASSERT_EQ(4, visitor.VariableNode_visited.size());
+            const Binding::Kind kinds[] = {
+                    Binding::Kind::LOCAL, Binding::Kind::LOCAL, Binding::Kind::LOCAL, Binding::Kind::UNRESOLVED
+            };
+            const std::uint32_t indices[] = {0, 1, 2, 0};
+            for (std::size_t i = 0; i < 4; ++i) {
+                const auto &binding = visitor.VariableNode_visited[i]->identifier->binding;
+                EXPECT_EQ(kinds[i], binding.kind) << i;
+                EXPECT_EQ(indices[i], binding.index) << i;
+            }
+
+            ASSERT_EQ(1, visitor.FunctionCallNode_visited.size());
+            const auto &called = visitor.FunctionCallNode_visited[0]->identifier->binding;
+            EXPECT_EQ(Binding::Kind::GLOBAL, called.kind);
+            EXPECT_EQ(1, called.index);
+        }
+
+        TEST(ResolverTest, locals_shadow_globals) {
+            auto tree = parse("function foo(bar) {bar(1;)}"
+                                      "function bar(x) {x}");
+            const std::unordered_map<std::string, std::uint32_t> globals{{"foo", 0}, {"bar", 1}};
+            resolveNames(*tree->functions[0], globals);
+
+            parser::FakeVisitor visitor;
+            tree->functions[0]->visit(visitor);
+
+            ASSERT_EQ(1, visitor.FunctionCallNode_visited.size());
+            const auto &called = visitor.FunctionCallNode_visited[0]->identifier->binding;
+            EXPECT_EQ(Binding::Kind::LOCAL, called.kind);
+            EXPECT_EQ(0, called.index);
+        }
+
+        TEST(ResolverTest, interpreter_calls_through_frames) {
+            auto tree = parse("function fib(n) {if (2 > n;) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                                      "function twice(f, x) {f(f(x;);)}"
+                                      "function inc(x) {(x + 1);}"
+                                      "function main() {twice(inc;, fib(15;);)}");
+            Interpreter interpreter(*tree);
+
+            EXPECT_EQ(610.0, number(interpreter.execute("fib", {numberOf(15)})));
+            EXPECT_EQ(612.0, number(interpreter.execute("main")));
+        }
+
+        TEST(ResolverTest, frames_are_reused_after_failed_calls) {
+            auto tree = parse("function fib(n) {if (2 > n;) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                                      "function fail(n) {if (0 < n;) {fail(n - 1;)} else {(n + true);};}"
+                                      "function last(a, b, c, d, e, f) {f}");
+            const std::vector<Variable> six{numberOf(1), numberOf(2), numberOf(3), numberOf(4), numberOf(5), numberOf(6)};
+            for (auto engine : {Engine::TREE, Engine::VM, Engine::CLOSURE}) {
+                Interpreter interpreter(*tree, engine);
+
+                EXPECT_THROW(interpreter.execute("fail", {numberOf(5)}), TypeException);
+                EXPECT_EQ(610.0, number(interpreter.execute("fib", {numberOf(15)})));
+                EXPECT_EQ(6.0, number(interpreter.execute("last", six)));
+            }
+        }
+
+        TEST(ResolverTest, deferred_functions_are_resolved_on_first_call) {
+            util::StringOutputStream codeStream("function inc(x) {(x + 1);}"
+                                                        "function main() {let y = inc(inc(2;););}");
+            lexer::Lexer lexer(codeStream);
+            logging::Logger logger;
+            parser::Parser parser(logger, lexer);
+            auto tree = parser.preParse();
+            Interpreter interpreter(*tree);
+
+            EXPECT_EQ(0, tree->functions[1]->frameSize);
+            EXPECT_EQ(4.0, number(interpreter.execute("main")));
+            EXPECT_EQ(1, tree->functions[1]->frameSize);
+        }
+    }
+}
@@ -0,0 +1,211 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "interpreter/exceptions.hpp"
+#include "engine-runner.hpp"
+
+namespace lang {
+    namespace interpreter {
+        TEST(VariableTest, fits_tag_and_payload_in_sixteen_bytes) {
+            EXPECT_EQ(16, sizeof(Variable));
+        }
+
+        TEST(VariableTest, copies_values_of_every_type) {
+            const Variable values[] = {
+                    Variable(), numberOf(1.5), Variable(std::string("text")), Variable(true),
+                    Variable(std::function<Variable(Arguments)>([](Arguments arguments) {
+                        return arguments[0];
+                    })),
+                    Variable(std::vector<Variable>{numberOf(1), Variable(std::string("a"))}),
+            };
+            for (const auto &value : values) {
+                Variable copy = value;
+                Variable assigned = numberOf(0);
+                assigned = copy;
+                Variable moved = std::move(copy);
+                EXPECT_EQ(value.getType(), assigned.getType());
+                EXPECT_EQ(value.getType(), moved.getType());
+                EXPECT_EQ(value.toString(), moved.toString());
+            }
+            Variable seven = numberOf(7);
+            EXPECT_EQ("7.000000", Variable(values[4])(Arguments(&seven, 1)).toString());
+        }
+
+        TEST(VariableTest, copies_of_arrays_are_independent) {
+            Variable array(std::vector<Variable>{numberOf(1), Variable(std::vector<Variable>{numberOf(2)})});
+            Variable copy = array;
+            copy.getArrayItem(0) = numberOf(5);
+            copy.getArrayItem(1).getArrayItem(0) = Variable(std::string("x"));
+
+            EXPECT_EQ("[1.000000, [2.000000]]", array.toString());
+            EXPECT_EQ("[5.000000, [x]]", copy.toString());
+        }
+
+        TEST(VariableTest, shares_arrays_until_changed) {
+            Variable array(std::vector<Variable>{numberOf(1), Variable(std::vector<Variable>{numberOf(2)})});
+            Variable copy = array;
+            const Variable &original = array;
+            const Variable &shared = copy;
+            EXPECT_EQ(&original.getArrayItem(1), &shared.getArrayItem(1));
+
+            copy.getArrayItem(0) = numberOf(5);
+            EXPECT_NE(&original.getArrayItem(1), &shared.getArrayItem(1));
+            // Items are shared by both arrays, until changed themselves.
+            EXPECT_EQ(&original.getArrayItem(1).getArrayItem(0), &shared.getArrayItem(1).getArrayItem(0));
+            EXPECT_EQ("[1.000000, [2.000000]]", array.toString());
+        }
+
+        TEST(VariableTest, argument_list_keeps_order_past_inline_values) {
+            ArgumentList list;
+            for (int i = 0; i < 6; ++i)
+                list.push(numberOf(i));
+            const auto arguments = list.arguments();
+
+            ASSERT_EQ(6, arguments.size());
+            for (std::size_t i = 0; i < arguments.size(); ++i)
+                EXPECT_EQ(static_cast<double>(i), arguments[i].getNumeric());
+            EXPECT_EQ(0, ArgumentList().arguments().size());
+        }
+
+        TEST(VariableTest, push_keeps_values_of_arguments) {
+            auto script = parse("function f(a) {(len(push(a;, 2;);) + len(a;));}");
+            const auto result = Interpreter(*script).execute(
+                    "f", {Variable(std::vector<Variable>{numberOf(1)})});
+            EXPECT_EQ("3.000000", result.toString());
+        }
+
+        TEST(VariableTest, assigns_own_element) {
+            Variable array(std::vector<Variable>{Variable(std::vector<Variable>{numberOf(2)}), numberOf(1)});
+            Variable copy = array;
+
+            array = array.getArrayItem(0);
+            EXPECT_EQ("[2.000000]", array.toString());
+            copy = std::move(copy.getArrayItem(0));
+            EXPECT_EQ("[2.000000]", copy.toString());
+        }
+
+        TEST(VariableTest, keeps_type_checks) {
+            EXPECT_THROW(numberOf(1) + Variable(std::string("a")), TypeException);
+            EXPECT_THROW(Variable(true) < Variable(false), TypeException);
+            EXPECT_THROW(Variable()(Arguments()), TypeException);
+            EXPECT_THROW(numberOf(1).getArrayItem(0), TypeException);
+            EXPECT_THROW(numberOf(-1).getNumberAsSize(), IndexOutOfBoundException);
+            EXPECT_EQ("true", (Variable(std::string("a")) + Variable(std::string("b")) == Variable(std::string("ab")))
+                    .toString());
+        }
+
+        TEST(VariableTest, combines_vectors_by_components) {
+            double first[] = {1, 2, 3, 4};
+            double second[] = {4, 3, 2, 1};
+            const Variable a(first, 3);
+            const Variable b(second, 3);
+
+            EXPECT_EQ(VariableType::Vec3, a.getType());
+            EXPECT_EQ("vec3(5.000000, 5.000000, 5.000000)", (a + b).toString());
+            EXPECT_EQ("vec3(-3.000000, -1.000000, 1.000000)", (a - b).toString());
+            EXPECT_EQ("vec3(4.000000, 6.000000, 6.000000)", (a * b).toString());
+            EXPECT_EQ("vec3(0.250000, 0.666667, 1.500000)", (a / b).toString());
+            EXPECT_EQ("vec4(-1.000000, -2.000000, -3.000000, -4.000000)", (-Variable(first, 4)).toString());
+            EXPECT_EQ("true", (Variable(first, 2) + Variable(second, 2) == Variable(std::vector<double>{5, 5}.data(), 2))
+                    .toString());
+            EXPECT_EQ("false", (a == b).toString());
+            EXPECT_EQ("3.000000", a.getItem(2).toString());
+            EXPECT_EQ(3, a.getLength());
+
+            EXPECT_THROW(a.getItem(3), IndexOutOfBoundException);
+            EXPECT_THROW(a + Variable(first, 4), TypeException);
+            EXPECT_THROW(a + numberOf(1), TypeException);
+            EXPECT_THROW(a < b, TypeException);
+            EXPECT_THROW(Variable(a).getArrayItem(0), TypeException);
+        }
+
+        TEST(VariableTest, DISABLED_vector_benchmark) {
+            const std::size_t count = 1000000;
+            double step[] = {1, 2, 3, 4};
+            const Variable vectorStep(step, 4);
+            const Variable numberSteps[] = {numberOf(1), numberOf(2), numberOf(3), numberOf(4)};
+            Variable vectorSum(std::vector<double>(4).data(), 4);
+            Variable numberSums[] = {numberOf(0), numberOf(0), numberOf(0), numberOf(0)};
+
+            const double vectorTime = measureMilliseconds([&] {
+                for (std::size_t i = 0; i < count; ++i)
+                    vectorSum = vectorSum + vectorStep * vectorStep;
+            });
+            const double numberTime = measureMilliseconds([&] {
+                for (std::size_t i = 0; i < count; ++i) {
+                    for (int j = 0; j < 4; ++j)
+                        numberSums[j] = numberSums[j] + numberSteps[j] * numberSteps[j];
+                }
+            });
+
+            for (std::size_t j = 0; j < 4; ++j)
+                EXPECT_EQ(numberSums[j].toString(), vectorSum.getItem(j).toString());
+            std::cout << "[ BENCHMARK] 1M vec4 multiply-adds: " << vectorTime << " ms, as 4M numbers: "
+                      << numberTime << " ms" << std::endl;
+        }
+
+        TEST(VariableTest, concatenation_keeps_other_strings) {
+            const Variable start(std::string("ab"));
+            const Variable first = start + Variable(std::string("c"));
+            const Variable second = start + Variable(std::string("d"));
+            const Variable twice = first + first;
+
+            EXPECT_EQ("ab", start.toString());
+            EXPECT_EQ("abc", first.toString());
+            EXPECT_EQ("abd", second.toString());
+            EXPECT_EQ("abcabc", twice.toString());
+            EXPECT_EQ(6, twice.getLength());
+            EXPECT_EQ("true", (second == Variable(std::string("abd"))).toString());
+            EXPECT_EQ("false", (first == second).toString());
+            EXPECT_EQ("true", (start + Variable(std::string()) == start).toString());
+        }
+
+        TEST(VariableTest, DISABLED_layout_benchmark) {
+            const std::size_t count = 1000000;
+            std::vector<Variable> numbers;
+            Variable sum = numberOf(0);
+            Variable copy;
+            const double buildTime = measureMilliseconds([&] {
+                numbers.reserve(count);
+                for (std::size_t i = 0; i < count; ++i)
+                    numbers.push_back(numberOf(i % 100));
+            });
+            const Variable array(std::move(numbers));
+            const double copyTime = measureMilliseconds([&] {
+                copy = array;
+            });
+            const double sumTime = measureMilliseconds([&] {
+                const Variable &items = copy;
+                for (std::size_t i = 0; i < count; ++i)
+                    sum = sum + items.getArrayItem(i);
+            });
+
+            auto script = parse("function fib(n) {if ((2 > n);) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                                        "function build(n) {if ((0 < n);) {push(build(n - 1;);, n;)} else {array(0;)};}");
+            Variable fib;
+            const double fibTime = measureMilliseconds([&] {
+                fib = Interpreter(*script).execute("fib", {numberOf(22)});
+            });
+            Variable built;
+            const double pushTime = measureMilliseconds([&] {
+                built = Interpreter(*script).execute("build", {numberOf(1000)});
+            });
+
+            EXPECT_EQ("49500000.000000", sum.toString());
+            EXPECT_EQ("17711.000000", fib.toString());
+            EXPECT_EQ(1001, built.getLength());
+
+            const Variable fragment(std::string(100, 'x'));
+            Variable html(std::string(""));
+            const double concatenationTime = measureMilliseconds([&] {
+                for (int i = 0; i < 10000; ++i)
+                    html = html + fragment;
+            });
+            EXPECT_EQ(1000000, html.getLength());
+            std::cout << "[ BENCHMARK] " << sizeof(Variable) << " bytes per value, " << count * sizeof(Variable) / 1024
+                      << " KiB per " << count << " numbers; building: " << buildTime << " ms, copying: "
+                      << copyTime << " ms, summing: " << sumTime << " ms, tree fib(22): " << fibTime << " ms, 1000 pushes: "
+                      << pushTime << " ms, 1 MB string of 10000 fragments: " << concatenationTime << " ms"
+                      << std::endl;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "interpreter/bytecode-compiler.hpp"
+#include "interpreter/resolver.hpp"
+#include "engine-runner.hpp"
+
+namespace lang {
+    namespace interpreter {
+        namespace {
+            void expectSameOnBothEngines(const Case &test, bool lazy = false) {
+                const auto tree = run(*parse(test.code, lazy), Engine::TREE, test.function, test.arguments);
+                const auto vm = run(*parse(test.code, lazy), Engine::VM, test.function, test.arguments);
+                EXPECT_EQ(tree, vm) << test.code;
+            }
+        }
+
+        TEST(VirtualMachineTest, matches_tree_walker_on_sample_scripts) {
+            for (const auto &test : sampleCases()) {
+                expectSameOnBothEngines(test);
+                expectSameOnBothEngines(test, true);
+            }
+        }
+
+        TEST(VirtualMachineTest, matches_tree_walker_on_generated_scripts) {
+            ScriptGenerator generator(42);
+            std::size_t values = 0;
+            for (int i = 0; i < 200; ++i) {
+                const auto code = generator.script(4);
+                for (const auto &arguments : generatedArguments()) {
+                    const auto tree = run(*parse(code), Engine::TREE, "f0", arguments);
+                    const auto vm = run(*parse(code), Engine::VM, "f0", arguments);
+                    ASSERT_EQ(tree, vm) << code;
+                    if (tree.find("exception") == std::string::npos)
+                        ++values;
+                }
+            }
+            // Most random expressions fail on types, enough of them have to compute a value to be worth comparing.
+            EXPECT_GT(values, 100);
+        }
+
+        TEST(VirtualMachineTest, reads_locals_and_literals_in_place) {
+            auto tree = parse("function f(a, b) {(a * 2 + b);}");
+            resolveNames(*tree->functions[0], {});
+            const auto chunk = compileFunction(*tree->functions[0]);
+
+            ASSERT_EQ(3, chunk.code.size());
+            EXPECT_EQ(OpCode::MULTIPLY, chunk.code[0].op);
+            EXPECT_EQ(OperandFlags::RIGHT_OPERAND | OperandFlags::RIGHT_CONSTANT, chunk.code[0].a);
+            EXPECT_EQ(OpCode::ADD, chunk.code[1].op);
+            EXPECT_EQ(OpCode::RETURN, chunk.code[2].op);
+            EXPECT_EQ(2, chunk.registerCount);
+        }
+
+        TEST(VirtualMachineTest, DISABLED_engines_benchmark) {
+            auto tree = parse("function fib(n) {if ((2 > n);) {n} else {(fib(n - 1;) + fib(n - 2;));};}"
+                                      "function sum(n, a, b) {if ((0 < n);) {sum(n - 1;, (a * 2 + b) / 3;, b - a;)}"
+                                      " else {(a + b);};}");
+
+            Variable treeResult;
+            Variable vmResult;
+            const double treeTime = measureMilliseconds([&] {
+                Interpreter interpreter(*tree, Engine::TREE);
+                treeResult = interpreter.execute("fib", {numberOf(22)});
+                for (int i = 0; i < 10; ++i)
+                    interpreter.execute("sum", {numberOf(200), numberOf(1), numberOf(2)});
+            });
+            const double vmTime = measureMilliseconds([&] {
+                Interpreter interpreter(*tree, Engine::VM);
+                vmResult = interpreter.execute("fib", {numberOf(22)});
+                for (int i = 0; i < 10; ++i)
+                    interpreter.execute("sum", {numberOf(200), numberOf(1), numberOf(2)});
+            });
+
+            EXPECT_EQ(treeResult.toString(), vmResult.toString());
+            std::cout << "[ BENCHMARK] tree: " << treeTime << " ms, vm: " << vmTime << " ms, speedup "
+                      << treeTime / vmTime << std::endl;
+        }
+    }
+}
@@ -1,5 +1,10 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
 #include "../../main/lexer/lexer.hpp"
+#include "../../main/util/mmap-input-stream.hpp"
 #include "../../main/util/string-output-stream.hpp"
 
 using namespace lang::util;
@@ -14,6 +19,18 @@ namespace lang {
         struct LexerTest : ::testing::TestWithParam<LexerTestParams> {
         };
 
+        /**
+         * Lexeme with its own copy of text, still valid after its lexer is destroyed.
+         */
+        struct OwnedLexeme {
+            LexemeType type;
+            std::string text;
+            int line;
+
+            OwnedLexeme(const Lexeme &lexeme)
+                    : type(lexeme.type), text(lexeme.text.to_string()), line(lexeme.line) {}
+        };
+
         TEST_P(LexerTest, check_lexemes) {
             StringOutputStream input(GetParam().input);
             Lexer lexer(input);
@@ -91,6 +108,51 @@ namespace lang {
                                 {LexemeType::CLOSE_BRACE, "}", 1}
                         }},
 
+                LexerTestParams {
+                        "function Row[\n  <td class=\"name\" for={{ id }}>Inne  dane,\n 3 {x}</td>\n]", {
+                                {LexemeType::FUNCTION, "function", 1},
+                                {LexemeType::IDENTIFIER, "Row", 1},
+                                {LexemeType::OPEN_BRACKET, "[", 1},
+                                {LexemeType::OPEN_ANGLE, "<", 2},
+                                {LexemeType::IDENTIFIER, "td", 2},
+                                {LexemeType::IDENTIFIER, "class", 2},
+                                {LexemeType::ASSIGN, "=", 2},
+                                {LexemeType::STRING, "\"name\"", 2},
+                                {LexemeType::IDENTIFIER, "for", 2},
+                                {LexemeType::ASSIGN, "=", 2},
+                                {LexemeType::DOUBLE_OPEN_BRACE, "{{", 2},
+                                {LexemeType::IDENTIFIER, "id", 2},
+                                {LexemeType::DOUBLE_CLOSE_BRACE, "}}", 2},
+                                {LexemeType::CLOSE_ANGLE, ">", 2},
+                                {LexemeType::TEXT, "Inne  dane,\n 3 {x}", 2},
+                                {LexemeType::END_ANGLE, "</", 3},
+                                {LexemeType::IDENTIFIER, "td", 3},
+                                {LexemeType::CLOSE_ANGLE, ">", 3},
+                                {LexemeType::CLOSE_BRACKET, "]", 4}
+                        }},
+                LexerTestParams {
+                        "function A[<p> a {{b}} c { </p>] [1]", {
+                                {LexemeType::FUNCTION, "function", 1},
+                                {LexemeType::IDENTIFIER, "A", 1},
+                                {LexemeType::OPEN_BRACKET, "[", 1},
+                                {LexemeType::OPEN_ANGLE, "<", 1},
+                                {LexemeType::IDENTIFIER, "p", 1},
+                                {LexemeType::CLOSE_ANGLE, ">", 1},
+                                {LexemeType::TEXT, "a", 1},
+                                {LexemeType::DOUBLE_OPEN_BRACE, "{{", 1},
+                                {LexemeType::IDENTIFIER, "b", 1},
+                                {LexemeType::DOUBLE_CLOSE_BRACE, "}}", 1},
+                                {LexemeType::TEXT, "c", 1},
+                                {LexemeType::TEXT, "{", 1},
+                                {LexemeType::END_ANGLE, "</", 1},
+                                {LexemeType::IDENTIFIER, "p", 1},
+                                {LexemeType::CLOSE_ANGLE, ">", 1},
+                                {LexemeType::CLOSE_BRACKET, "]", 1},
+                                {LexemeType::OPEN_BRACKET, "[", 1},
+                                {LexemeType::NUMBER, "1", 1},
+                                {LexemeType::CLOSE_BRACKET, "]", 1}
+                        }},
+
                 LexerTestParams {
                         "result = array();", {
                                 {LexemeType::IDENTIFIER, "result", 1},
@@ -199,5 +261,144 @@ namespace lang {
                         }
                 }
         ));
+    
+        TEST(LexerMmapTest, scans_mapped_file_in_place) {
+            const std::string code = "function map(items, func) {\nreturn \"text\" }";
+
+            char path[] = "/tmp/lexer-mmap-test-XXXXXX";
+            const int fd = mkstemp(path);
+            ASSERT_GE(fd, 0);
+            close(fd);
+            std::ofstream(path, std::ios::binary) << code;
+
+            std::vector<OwnedLexeme> expected;
+            {
+                StringOutputStream input(code);
+                Lexer lexer(input);
+                Lexeme lexeme;
+                while (lexer.take(lexeme))
+                    expected.push_back(lexeme);
+            }
+
+            {
+                MmapInputStream input(path);
+                Lexer lexer(input);
+                for (std::size_t i = 0; i < expected.size(); ++i) {
+                    Lexeme current;
+                    ASSERT_TRUE(lexer.take(current)) << "unexpected end of lexemes for i=" << i;
+                    EXPECT_EQ(expected[i].type, current.type) << "invalid type for i=" << i;
+                    EXPECT_EQ(expected[i].text, current.text) << "invalid text for i=" << i;
+                    EXPECT_EQ(expected[i].line, current.line) << "invalid line for i=" << i;
+                }
+                Lexeme dummy;
+                EXPECT_FALSE(lexer.take(dummy)) << "unexpected tokens";
+            }
+
+            std::remove(path);
+        }
+    
+        TEST(LexerConcurrencyTest, lexers_run_concurrently) {
+            const std::size_t threadCount = 8;
+
+            std::vector<std::string> scripts;
+            for (std::size_t i = 0; i < threadCount; ++i) {
+                std::string script;
+                for (std::size_t j = 0; j < 2000; ++j)
+                    script += "function f" + std::to_string(i) + "(a) {\nreturn a + " + std::to_string(j) + ";;}\n";
+                scripts.push_back(script);
+            }
+
+            auto lexAll = [](const std::string &script, std::vector<OwnedLexeme> &lexemes) {
+                StringOutputStream input(script);
+                Lexer lexer(input);
+                Lexeme lexeme;
+                while (lexer.take(lexeme))
+                    lexemes.push_back(lexeme);
+            };
+
+            std::vector<std::vector<OwnedLexeme>> expected(threadCount);
+            for (std::size_t i = 0; i < threadCount; ++i)
+                lexAll(scripts[i], expected[i]);
+
+            std::vector<std::vector<OwnedLexeme>> actual(threadCount);
+            std::vector<std::thread> threads;
+            for (std::size_t i = 0; i < threadCount; ++i)
+                threads.emplace_back(lexAll, std::cref(scripts[i]), std::ref(actual[i]));
+            for (auto &thread : threads)
+                thread.join();
+
+            for (std::size_t i = 0; i < threadCount; ++i) {
+                ASSERT_EQ(expected[i].size(), actual[i].size()) << "invalid lexeme count for script " << i;
+                for (std::size_t j = 0; j < expected[i].size(); ++j) {
+                    ASSERT_EQ(expected[i][j].type, actual[i][j].type) << "invalid type for script " << i;
+                    ASSERT_EQ(expected[i][j].text, actual[i][j].text) << "invalid text for script " << i;
+                    ASSERT_EQ(expected[i][j].line, actual[i][j].line) << "invalid line for script " << i;
+                }
+            }
+        }
+    
+        TEST(LexerTokenizeTest, token_array_matches_lexeme_stream) {
+            const std::string code = "function map(items, func) {\nreturn \"text\" + 12.5 }";
+
+            StringOutputStream streamInput(code);
+            Lexer streamLexer(streamInput);
+
+            StringOutputStream arrayInput(code);
+            Lexer arrayLexer(arrayInput);
+            const TokenArray tokens = arrayLexer.tokenize();
+
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                Lexeme expected;
+                ASSERT_TRUE(streamLexer.take(expected)) << "unexpected token for i=" << i;
+
+                const Lexeme current = tokens[i];
+                EXPECT_EQ(expected.type, current.type) << "invalid type for i=" << i;
+                EXPECT_EQ(expected.text, current.text) << "invalid text for i=" << i;
+                EXPECT_EQ(expected.line, current.line) << "invalid line for i=" << i;
+                EXPECT_EQ(expected.symbol.str(), current.symbol.str()) << "invalid symbol for i=" << i;
+                if (expected.type == LexemeType::NUMBER) {
+                    EXPECT_EQ(expected.number, current.number) << "invalid number for i=" << i;
+                }
+            }
+
+            Lexeme dummy;
+            EXPECT_FALSE(streamLexer.take(dummy)) << "missing tokens";
+        }
+
+        TEST(LexerTokenizeTest, token_array_finds_numbers_across_blocks) {
+            std::string code;
+            for (int i = 0; i < 1000; ++i)
+                code += i % 7 < 3 ? std::to_string(i) + " " : "x ";
+
+            StringOutputStream input(code);
+            Lexer lexer(input);
+            const TokenArray tokens = lexer.tokenize();
+
+            ASSERT_EQ(1000, tokens.size());
+            EXPECT_EQ(429, tokens.numbers.size());
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                const Lexeme current = tokens[i];
+                if (i % 7 < 3) {
+                    ASSERT_EQ(LexemeType::NUMBER, current.type) << "invalid type for i=" << i;
+                    EXPECT_EQ(i, current.number) << "invalid number for i=" << i;
+                } else {
+                    ASSERT_EQ(LexemeType::IDENTIFIER, current.type) << "invalid type for i=" << i;
+                    EXPECT_EQ("x", current.symbol.str()) << "invalid symbol for i=" << i;
+                }
+            }
+        }
+
+        TEST(LexerNumberTest, numbers_are_decoded_while_scanning) {
+            StringOutputStream input("0 12 3.25 0.1 007");
+            Lexer lexer(input);
+
+            const double expected[] = {0, 12, 3.25, 0.1, 0, 0, 7};
+            for (double value : expected) {
+                Lexeme lexeme;
+                ASSERT_TRUE(lexer.take(lexeme));
+                ASSERT_EQ(LexemeType::NUMBER, lexeme.type);
+                EXPECT_EQ(value, lexeme.number) << lexeme.text;
+            }
+        }
     }
 }
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <boost/lexical_cast.hpp>
+#include "../../main/lexer/lexer.hpp"
+#include "../../main/util/string-output-stream.hpp"
+#include "../benchmark.hpp"
+
+using namespace lang::util;
+
+namespace lang {
+    namespace lexer {
+        namespace {
+            const std::size_t inputSize = 4 * 1024 * 1024;
+
+            std::string generateScript(std::size_t minSize) {
+                const std::string function =
+                        "function Row[\n"
+                                "    <tr class=\"row\">\n"
+                                "        <td> {{ name }} </td>\n"
+                                "        <td> {{ value }} </td>\n"
+                                "    </tr>\n"
+                                "](item) {\n"
+                                "    for (let i = 0; i < len(item); i = i + 1) {print(item[i]);};\n"
+                                "    return { name: item[0], value: 3.25 * 2 };\n"
+                                "}\n";
+
+                std::string result;
+                result.reserve(minSize + function.size());
+                while (result.size() < minSize)
+                    result += function;
+                return result;
+            }
+
+            std::string generateNumericScript(std::size_t minSize) {
+                std::string result = "function data() {\n";
+                for (std::size_t i = 0; result.size() < minSize; ++i) {
+                    result += "    push(values, " + std::to_string(i) + "." + std::to_string(i * 7919 % 100000)
+                              + " * 0.0625 + 1234.5678 - " + std::to_string(i % 1000) + ";);\n";
+                }
+                return result + "}\n";
+            }
+
+            /**
+             * Hides the block read of the wrapped stream, so the lexer falls back to per-character take.
+             */
+            struct CharByCharOutputStream : OutputStream<char> {
+                OutputStream<char> &stream;
+
+                explicit CharByCharOutputStream(OutputStream<char> &stream) : stream(stream) {}
+
+                bool take(char &out) override {
+                    return stream.take(out);
+                }
+            };
+
+            std::size_t countLexemes(OutputStream<char> &input) {
+                Lexer lexer(input);
+                Lexeme lexeme;
+                std::size_t count = 0;
+                while (lexer.take(lexeme))
+                    ++count;
+                return count;
+            }
+        }
+
+        TEST(LexerThroughputTest, DISABLED_block_read_compared_to_char_by_char) {
+            const std::string script = generateScript(inputSize);
+
+            std::size_t charByCharLexemes = 0;
+            const double charByChar = measureMegabytesPerSecond(script.size(), [&] {
+                StringOutputStream input(script);
+                CharByCharOutputStream slowInput(input);
+                charByCharLexemes = countLexemes(slowInput);
+            });
+
+            std::size_t blockLexemes = 0;
+            const double block = measureMegabytesPerSecond(script.size(), [&] {
+                StringOutputStream input(script);
+                blockLexemes = countLexemes(input);
+            });
+
+            EXPECT_EQ(charByCharLexemes, blockLexemes);
+
+            std::cout << "[ BENCHMARK] lexer char-by-char: " << charByChar << " MB/s, "
+                      << "block read: " << block << " MB/s" << std::endl;
+        }
+
+        TEST(LexerThroughputTest, DISABLED_numeric_heavy_script) {
+            const std::string script = generateNumericScript(inputSize);
+
+            StringOutputStream input(script);
+            Lexer lexer(input);
+            TokenArray tokens;
+            const double lexing = measureMegabytesPerSecond(script.size(), [&] {
+                tokens = lexer.tokenize();
+            });
+
+            std::vector<boost::string_view> texts;
+            for (std::size_t i = 0; i < tokens.size(); ++i) {
+                if (tokens.types[i] == LexemeType::NUMBER)
+                    texts.push_back(tokens[i].text);
+            }
+            ASSERT_EQ(texts.size(), tokens.numbers.size());
+
+            double lexicalCastSum = 0;
+            const double lexicalCast = measureMegabytesPerSecond(script.size(), [&] {
+                for (const auto &text : texts)
+                    lexicalCastSum += boost::lexical_cast<double>(text.data(), text.size());
+            });
+
+            double lexerSum = 0;
+            for (double value : tokens.numbers)
+                lexerSum += value;
+            EXPECT_EQ(lexicalCastSum, lexerSum);
+
+            std::cout << "[ BENCHMARK] " << texts.size() << " numbers; lexing with decoding: " << lexing
+                      << " MB/s, decoding them again with lexical_cast alone: " << lexicalCast << " MB/s"
+                      << std::endl;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "../../main/lexer/pipelined-lexer.hpp"
+#include "../../main/logging/logger.hpp"
+#include "../../main/parser/parser.hpp"
+#include "../../main/util/string-output-stream.hpp"
+#include "../benchmark.hpp"
+
+using namespace lang::util;
+
+namespace lang {
+    namespace lexer {
+        namespace {
+            std::string generateScript(std::size_t functionCount) {
+                std::string result;
+                for (std::size_t i = 0; i < functionCount; ++i) {
+                    const auto id = std::to_string(i);
+                    result += "function foo" + id + "(a, b, c) {let x" + id + " = 1 + 3 * 2 ;}\n"
+                            "function bar" + id + "(){if (false){10;} else {print(6;)} ;}\n";
+                }
+                return result;
+            }
+        }
+
+        TEST(PipelinedLexerTest, same_lexemes_as_lexer) {
+            const std::string code = generateScript(2000);
+
+            StringOutputStream expectedInput(code);
+            Lexer expectedLexer(expectedInput);
+            StringOutputStream input(code);
+            Lexer lexer(input);
+            PipelinedLexer pipelined(lexer);
+
+            Lexeme expected;
+            Lexeme actual;
+            for (std::size_t i = 0; expectedLexer.take(expected); ++i) {
+                ASSERT_TRUE(pipelined.take(actual)) << "missing lexeme for i=" << i;
+                ASSERT_EQ(expected.type, actual.type) << "invalid type for i=" << i;
+                ASSERT_EQ(expected.text, actual.text) << "invalid text for i=" << i;
+                ASSERT_EQ(expected.line, actual.line) << "invalid line for i=" << i;
+                ASSERT_EQ(expected.symbol.str(), actual.symbol.str()) << "invalid symbol for i=" << i;
+            }
+            EXPECT_FALSE(pipelined.take(actual));
+            EXPECT_FALSE(pipelined.take(actual));
+        }
+
+        TEST(PipelinedLexerTest, empty_input) {
+            StringOutputStream input("");
+            Lexer lexer(input);
+            PipelinedLexer pipelined(lexer);
+
+            Lexeme dummy;
+            EXPECT_FALSE(pipelined.take(dummy));
+        }
+
+        TEST(PipelinedLexerTest, stops_when_consumer_gives_up) {
+            StringOutputStream input(generateScript(20000));
+            Lexer lexer(input);
+            {
+                PipelinedLexer pipelined(lexer);
+                Lexeme first;
+                ASSERT_TRUE(pipelined.take(first));
+                EXPECT_EQ(LexemeType::FUNCTION, first.type);
+            }
+        }
+
+        TEST(PipelinedLexerTest, DISABLED_parser_on_pipeline_compared_to_synchronous) {
+            const std::size_t functionCount = 20000;
+            const std::string code = generateScript(functionCount);
+            logging::Logger logger;
+
+            std::size_t synchronousFunctions = 0;
+            const double synchronous = measureMilliseconds([&] {
+                StringOutputStream input(code);
+                Lexer lexer(input);
+                parser::Parser parser(logger, lexer);
+                synchronousFunctions = parser.getTree()->functions.size();
+            });
+
+            std::size_t pipelinedFunctions = 0;
+            const double pipelined = measureMilliseconds([&] {
+                StringOutputStream input(code);
+                Lexer lexer(input);
+                PipelinedLexer lexemes(lexer);
+                parser::Parser parser(logger, lexemes, lexemes.getSymbols());
+                pipelinedFunctions = parser.getTree()->functions.size();
+            });
+
+            EXPECT_EQ(2 * functionCount, synchronousFunctions);
+            EXPECT_EQ(2 * functionCount, pipelinedFunctions);
+
+            std::cout << "[ BENCHMARK] synchronous lexing and parsing: " << synchronous
+                      << " ms, pipelined: " << pipelined << " ms" << std::endl;
+        }
+    }
+}
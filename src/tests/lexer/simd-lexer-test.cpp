@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <random>
+#include "../../main/lexer/simd-lexer.hpp"
+#include "../../main/util/mmap-input-stream.hpp"
+#include "../../main/util/string-output-stream.hpp"
+#include "../benchmark.hpp"
+
+using namespace lang::util;
+
+namespace lang {
+    namespace lexer {
+        namespace {
+            /**
+             * Compares whole lexeme streams of both lexers over the same input.
+             */
+            void expectSameLexemes(Lexer &expectedLexer, Lexer &actualLexer) {
+                Lexeme expected;
+                Lexeme actual;
+                for (std::size_t i = 0; expectedLexer.take(expected); ++i) {
+                    ASSERT_TRUE(actualLexer.take(actual)) << "missing lexeme " << expected.text << " for i=" << i;
+                    ASSERT_EQ(expected.type, actual.type) << "invalid type of " << actual.text << " for i=" << i;
+                    ASSERT_EQ(expected.text, actual.text) << "invalid text for i=" << i;
+                    ASSERT_EQ(expected.line, actual.line) << "invalid line for i=" << i;
+                    ASSERT_EQ(expected.symbol, actual.symbol) << "invalid symbol for i=" << i;
+                    if (expected.type == LexemeType::NUMBER) {
+                        ASSERT_EQ(expected.number, actual.number) << "invalid number for i=" << i;
+                    }
+                }
+                EXPECT_FALSE(actualLexer.take(actual)) << "unexpected lexeme " << actual.text;
+            }
+
+            void expectSameLexemes(const std::string &code) {
+                StringOutputStream flexInput(code);
+                Lexer flexLexer(flexInput);
+                StringOutputStream simdInput(code);
+                SimdLexer simdLexer(simdInput, flexLexer.getSymbols());
+                expectSameLexemes(flexLexer, simdLexer);
+            }
+
+            /** Pieces of valid input; characters matching no rule are covered by echoes_characters_matching_no_rule. */
+            const char *const fragments[] = {
+                    "function", "Row", "[", "]", "(", ")", "{", "}", "{{", "}}", "<", "</", ">", "<=", ">=",
+                    "==", "!=", "!", "=", "&&", "||", ";", ",", ":", "+", "-", "*", "/",
+                    "\"text\"", "\"a\\\"b\"", "\"multi\nline\"", "0", "007", "12", "3.25", "0.5",
+                    "x1", "if", "else", "for", "let", "return", "true", "false", "iffy", "letter",
+                    " ", "  ", "\t", "\n", "class", "{x}", "{ x }", "Lorem ipsum,",
+                    "function Row[", "<td class=\"a\">", "</td>"
+            };
+
+            std::string generateCorpus(std::mt19937 &random, std::size_t fragmentCount) {
+                std::uniform_int_distribution<std::size_t> pick(0, sizeof(fragments) / sizeof(*fragments) - 1);
+                std::string result;
+                for (std::size_t i = 0; i < fragmentCount; ++i)
+                    result += fragments[pick(random)];
+                return result;
+            }
+
+            std::string generateScript(std::size_t minSize) {
+                const std::string function =
+                        "function Row[\n"
+                                "    <tr class=\"row\">\n"
+                                "        <td> Lorem ipsum dolor sit amet, {{ name }} </td>\n"
+                                "        <td> {{ value }} </td>\n"
+                                "    </tr>\n"
+                                "](item) {\n"
+                                "    for (let i = 0; i < len(item); i = i + 1) {print(item[i]);};\n"
+                                "    return { name: item[0], value: 3.25 * 2, text: \"some \\\"text\\\"\" };\n"
+                                "}\n";
+
+                std::string result;
+                result.reserve(minSize + function.size());
+                while (result.size() < minSize)
+                    result += function;
+                return result;
+            }
+        }
+
+        TEST(SimdLexerTest, same_lexemes_as_flex_for_test_script) {
+            MmapInputStream flexInput(TEST_SOURCE_DIR "/test.lang");
+            Lexer flexLexer(flexInput);
+            MmapInputStream simdInput(TEST_SOURCE_DIR "/test.lang");
+            SimdLexer simdLexer(simdInput, flexLexer.getSymbols());
+
+            // The script starts with a byte order mark and has characters matching no rule, which are echoed.
+            testing::internal::CaptureStdout();
+            expectSameLexemes(flexLexer, simdLexer);
+            testing::internal::GetCapturedStdout();
+        }
+
+        TEST(SimdLexerTest, same_lexemes_as_flex_for_edge_cases) {
+            expectSameLexemes("");
+            expectSameLexemes("a");
+            expectSameLexemes("\"unterminated");
+            expectSameLexemes("function X[ text {");
+            expectSameLexemes("function X[<a b={{ c }}> {{ d }} e</a>] after");
+            expectSameLexemes("identifierLongerThanSixteenCharacters 12345678901234567890.12345678901234567890");
+            expectSameLexemes("function X[" + std::string(100, ' ') + std::string(100, 'x') + "{y"
+                              + std::string(50, '\n') + "]");
+        }
+
+        TEST(SimdLexerTest, echoes_characters_matching_no_rule) {
+            testing::internal::CaptureStdout();
+            StringOutputStream input("a # b\r& function X[<c #>]");
+            SimdLexer lexer(input);
+            Lexeme lexeme;
+            std::size_t count = 0;
+            while (lexer.take(lexeme))
+                ++count;
+
+            EXPECT_EQ("#\r&#", testing::internal::GetCapturedStdout());
+            EXPECT_EQ(9, count);
+
+            // Both lexers echo here, so only the lexemes are compared.
+            testing::internal::CaptureStdout();
+            expectSameLexemes("0.");
+            expectSameLexemes("\"escaped\\");
+            expectSameLexemes("\"a\\\nb\"");
+            expectSameLexemes("function X[<a b=\"unterminated>");
+            expectSameLexemes("x & y | z # \xc5\xbc\r\n");
+            testing::internal::GetCapturedStdout();
+        }
+
+        TEST(SimdLexerTest, same_lexemes_as_flex_for_generated_corpora) {
+            std::mt19937 random(7);
+            // Random pieces still land inside tags, where most of them match no rule and are echoed.
+            testing::internal::CaptureStdout();
+            for (int i = 0; i < 500; ++i) {
+                const std::string corpus = generateCorpus(random, 200);
+                SCOPED_TRACE(corpus);
+                expectSameLexemes(corpus);
+                if (HasFatalFailure())
+                    break;
+            }
+            testing::internal::GetCapturedStdout();
+        }
+
+        TEST(SimdLexerTest, DISABLED_throughput_compared_to_flex) {
+            const std::string script = generateScript(4 * 1024 * 1024);
+
+            std::size_t flexLexemes = 0;
+            const double flex = measureMegabytesPerSecond(script.size(), [&] {
+                StringOutputStream input(script);
+                Lexer lexer(input);
+                flexLexemes = lexer.tokenize().size();
+            });
+
+            std::size_t simdLexemes = 0;
+            const double simd = measureMegabytesPerSecond(script.size(), [&] {
+                StringOutputStream input(script);
+                SimdLexer lexer(input);
+                simdLexemes = lexer.tokenize().size();
+            });
+
+            EXPECT_EQ(flexLexemes, simdLexemes);
+
+            std::cout << "[ BENCHMARK] flex lexer: " << flex << " MB/s, simd lexer: " << simd << " MB/s" << std::endl;
+        }
+    }
+}
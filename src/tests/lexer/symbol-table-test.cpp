@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "../../main/lexer/lexer.hpp"
+#include "../../main/lexer/symbol-table.hpp"
+#include "../../main/util/string-output-stream.hpp"
+
+namespace lang {
+    namespace lexer {
+        struct SymbolTableTest : ::testing::Test {
+            SymbolTable symbols;
+        };
+
+        TEST_F(SymbolTableTest, interning_same_name_gives_same_symbol) {
+            const std::string first = "items";
+            const std::string second = "items";
+
+            auto a = symbols.intern(first);
+            auto b = symbols.intern(second);
+
+            EXPECT_EQ(a, b);
+            EXPECT_EQ(a.getId(), b.getId());
+            EXPECT_EQ("items", a.str());
+            EXPECT_NE(first.data(), a.str().data());
+        }
+
+        TEST_F(SymbolTableTest, ids_are_dense) {
+            const auto initialSize = symbols.size();
+
+            auto a = symbols.intern("a");
+            auto b = symbols.intern("b");
+            symbols.intern("a");
+
+            EXPECT_EQ(initialSize, a.getId());
+            EXPECT_EQ(initialSize + 1, b.getId());
+            EXPECT_EQ(initialSize + 2, symbols.size());
+            EXPECT_EQ(b, symbols[b.getId()]);
+        }
+
+        TEST_F(SymbolTableTest, keywords_are_interned_first) {
+            auto function = symbols.keyword(LexemeType::FUNCTION);
+
+            EXPECT_EQ("function", function.str());
+            EXPECT_EQ(function, symbols.intern("function"));
+            EXPECT_EQ(&symbols[function.getId()].str(), &function.str());
+            EXPECT_LT(symbols.keyword(LexemeType::FALSE).getId(), symbols.intern("identifier").getId());
+            EXPECT_EQ(Symbol::invalidId, symbols.keyword(LexemeType::IDENTIFIER).getId());
+        }
+
+        TEST_F(SymbolTableTest, concurrent_interning_gives_same_symbols) {
+            const std::size_t nameCount = 1000;
+            const std::size_t threadCount = 4;
+            std::vector<std::vector<Symbol>> interned(threadCount);
+
+            std::vector<std::thread> threads;
+            for (std::size_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([this, t, &interned] {
+                    for (std::size_t i = 0; i < nameCount; ++i)
+                        interned[t].push_back(symbols.intern("name" + std::to_string((i + t * 97) % nameCount)));
+                });
+            }
+            for (auto &thread : threads)
+                thread.join();
+
+            const auto initialSize = SymbolTable().size();
+            EXPECT_EQ(initialSize + nameCount, symbols.size());
+            for (std::size_t t = 0; t < threadCount; ++t) {
+                for (std::size_t i = 0; i < nameCount; ++i) {
+                    const auto &symbol = interned[t][i];
+                    EXPECT_EQ("name" + std::to_string((i + t * 97) % nameCount), symbol.str());
+                    EXPECT_EQ(symbol, symbols[symbol.getId()]);
+                }
+            }
+        }
+
+        TEST_F(SymbolTableTest, lexer_interns_identifiers) {
+            util::StringOutputStream input("foo bar foo let");
+            Lexer lexer(input);
+
+            Lexeme first, second, third, keyword;
+            ASSERT_TRUE(lexer.take(first));
+            ASSERT_TRUE(lexer.take(second));
+            ASSERT_TRUE(lexer.take(third));
+            ASSERT_TRUE(lexer.take(keyword));
+
+            EXPECT_EQ(first.symbol, third.symbol);
+            EXPECT_NE(first.symbol, second.symbol);
+            EXPECT_EQ("bar", second.symbol.str());
+            EXPECT_EQ(lexer.getSymbols()->keyword(LexemeType::LET), keyword.symbol);
+            EXPECT_EQ(lexer.getSource().data() + 4, second.text.data());
+        }
+    }
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include "parser/binary-script.hpp"
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "fake-visitor.hpp"
+#include "../benchmark.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            const std::string script =
+                    "function foo(a, b, c) {let x = 2 * 3 - 4 / 1.5 ;}"
+                    "function bar(){if (false){10;} else {print(6;)} ;}"
+                    "function quux() {return 5 == 5 || -a != !b && c >= 2 ;;}"
+                    "function Row [\n<tr class=\"row\" id={{ id }}><td>Lorem ipsum\n dolor</td>"
+                    "<td> {{ value }} sit { amet </td></tr>\n](id, value) {return \"text\" ;;}";
+
+            std::unique_ptr<ScriptNode> parse(const std::string &code) {
+                util::StringOutputStream input(code);
+                lexer::Lexer lexer(input);
+                logging::Logger logger;
+                Parser parser(logger, lexer);
+                return parser.getTree();
+            }
+
+            std::string compile(const std::string &code) {
+                std::ostringstream output;
+                writeBinaryScript(output, CompactTree::fromTree(*parse(code)), hashSource(code));
+                return output.str();
+            }
+
+            std::string write(const CompactTree &tree) {
+                std::ostringstream output;
+                writeBinaryScript(output, tree, 0);
+                return output.str();
+            }
+
+            std::string generateScript(std::size_t functionCount) {
+                std::string result;
+                for (std::size_t i = 0; i < functionCount; ++i) {
+                    const auto id = std::to_string(i);
+                    result += "function foo" + id + "(a, b, c) {let x" + id + " = 1 + 3 * 2 ;}\n"
+                            "function Row" + id + " [\n<tr class=\"row\"><td>" + id
+                            + "</td><td> {{ value }} </td></tr>\n](value) {return value ;;}\n";
+                }
+                return result;
+            }
+        }
+
+        TEST(BinaryScriptTest, round_trip_keeps_tree) {
+            const auto tree = parse(script);
+            const auto compact = CompactTree::fromTree(*tree);
+
+            const auto loaded = readBinaryScript(compile(script));
+
+            EXPECT_EQ(compact.root, loaded.root);
+            EXPECT_EQ(compact.nodeCount(), loaded.nodeCount());
+            EXPECT_EQ(compact.strings, loaded.strings);
+            ASSERT_EQ(compact.symbols->size(), loaded.symbols->size());
+            for (std::uint32_t id = 0; id < compact.symbols->size(); ++id)
+                EXPECT_EQ((*compact.symbols)[id].str(), (*loaded.symbols)[id].str());
+
+            FakeVisitor expected;
+            tree->visit(expected);
+            const auto expanded = loaded.expand();
+            FakeVisitor actual;
+            expanded->visit(actual);
+            ASSERT_EQ(expected.FunctionDefNode_visited.size(), actual.FunctionDefNode_visited.size());
+            for (std::size_t i = 0; i < expected.FunctionDefNode_visited.size(); ++i)
+                EXPECT_EQ(expected.FunctionDefNode_visited[i]->name.str(), actual.FunctionDefNode_visited[i]->name.str());
+            ASSERT_EQ(expected.NumberLiteralNode_visited.size(), actual.NumberLiteralNode_visited.size());
+            for (std::size_t i = 0; i < expected.NumberLiteralNode_visited.size(); ++i)
+                EXPECT_EQ(expected.NumberLiteralNode_visited[i]->value, actual.NumberLiteralNode_visited[i]->value);
+            EXPECT_EQ(expected.BinaryOperationNode_visited.size(), actual.BinaryOperationNode_visited.size());
+            EXPECT_EQ(expected.AnyTextNode_visited.size(), actual.AnyTextNode_visited.size());
+            EXPECT_EQ(expected.StringLiteralNode_visited.size(), actual.StringLiteralNode_visited.size());
+        }
+
+        TEST(BinaryScriptTest, stores_source_hash) {
+            const auto binary = compile(script);
+
+            EXPECT_EQ(hashSource(script), readSourceHash(binary));
+            EXPECT_NE(hashSource(script), hashSource(script + " "));
+            EXPECT_EQ(14695981039346656037ull, hashSource(""));
+        }
+
+        TEST(BinaryScriptTest, rejects_other_files_and_versions) {
+            auto binary = compile(script);
+
+            EXPECT_THROW(readBinaryScript(script), BinaryScriptException);
+            EXPECT_THROW(readSourceHash(""), BinaryScriptException);
+
+            ++binary[8];
+            EXPECT_THROW(readBinaryScript(binary), BinaryScriptException);
+            EXPECT_THROW(readSourceHash(binary), BinaryScriptException);
+        }
+
+        TEST(BinaryScriptTest, rejects_truncated_file) {
+            const auto binary = compile(script);
+
+            for (std::size_t size = 0; size < binary.size(); size += 8)
+                EXPECT_THROW(readBinaryScript(boost::string_view(binary.data(), size)), BinaryScriptException) << size;
+        }
+
+        TEST(BinaryScriptTest, rejects_references_out_of_pools) {
+            auto binary = compile(script);
+            const std::uint32_t brokenRoot = NodeRef(NodeKind::SCRIPT, 1000).raw();
+            std::memcpy(&binary[12], &brokenRoot, sizeof(brokenRoot));
+
+            EXPECT_THROW(readBinaryScript(binary), BinaryScriptException);
+        }
+
+        TEST(BinaryScriptTest, rejects_references_of_wrong_kind) {
+            auto tree = CompactTree::fromTree(*parse("function foo(a) {return a + 1 ;;}"));
+            ASSERT_NO_THROW(readBinaryScript(write(tree)));
+
+            auto &function = tree.functionDefs.at(0);
+            function.value = function.params;
+
+            EXPECT_THROW(readBinaryScript(write(tree)), BinaryScriptException);
+        }
+
+        TEST(BinaryScriptTest, rejects_cycles) {
+            auto tree = CompactTree::fromTree(*parse("function foo(a) {return a + 1 ;;}"));
+            const auto returned = tree.functionDefs.at(0).value;
+            ASSERT_EQ(NodeKind::RETURN_EXPRESSION, returned.kind());
+
+            auto selfReferencing = tree;
+            selfReferencing.unaries.at(returned.index()).value = returned;
+            EXPECT_THROW(readBinaryScript(write(selfReferencing)), BinaryScriptException);
+
+            auto throughOtherPool = tree;
+            const auto sum = throughOtherPool.unaries.at(returned.index()).value;
+            ASSERT_EQ(NodeKind::ADD, sum.kind());
+            throughOtherPool.binaries.at(sum.index()).left = NodeRef(NodeKind::NEGATE, returned.index());
+            EXPECT_THROW(readBinaryScript(write(throughOtherPool)), BinaryScriptException);
+        }
+
+        TEST(BinaryScriptTest, DISABLED_load_vs_parse_benchmark) {
+            const auto code = generateScript(5000);
+            std::string binary;
+
+            std::size_t parsedFunctions = 0;
+            const double parsing = measureMilliseconds([&] {
+                parsedFunctions = parse(code)->functions.size();
+            });
+            binary = compile(code);
+
+            std::size_t loadedFunctions = 0;
+            const double loading = measureMilliseconds([&] {
+                loadedFunctions = readBinaryScript(binary).functionDefs.size();
+            });
+
+            std::size_t expandedFunctions = 0;
+            const double loadAndExpand = measureMilliseconds([&] {
+                expandedFunctions = readBinaryScript(binary).expand()->functions.size();
+            });
+
+            EXPECT_EQ(parsedFunctions, loadedFunctions);
+            EXPECT_EQ(parsedFunctions, expandedFunctions);
+            std::cout << "[ BENCHMARK] " << parsedFunctions << " functions, " << binary.size() / 1024
+                      << " KiB binary; parse: " << parsing << " ms, load: " << loading << " ms, load and expand: "
+                      << loadAndExpand << " ms" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,272 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <malloc.h>
+#include "parser/compact-parser.hpp"
+#include "parser/compact-tree.hpp"
+#include "parser/compact-tree-visitor.hpp"
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "fake-visitor.hpp"
+#include "../benchmark.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            std::unique_ptr<ScriptNode> parse(const std::string &code) {
+                util::StringOutputStream input(code);
+                lexer::Lexer lexer(input);
+                logging::Logger logger;
+                Parser parser(logger, lexer);
+                return parser.getTree();
+            }
+
+            CompactTree parseCompact(const std::string &code) {
+                util::StringOutputStream input(code);
+                lexer::Lexer lexer(input);
+                logging::Logger logger;
+                CompactParser parser(logger, lexer);
+                return parser.getTree();
+            }
+
+#define EXPECT_SAME_VISITS(type) \
+            EXPECT_EQ(expected.type ## _visited.size(), actual.type ## _visited.size()) << #type
+
+            /**
+             * Visits both trees and compares how many nodes of every type were met.
+             */
+            void expectSameTree(const ScriptNode &expectedTree, const ScriptNode &actualTree) {
+                FakeVisitor expected;
+                expectedTree.visit(expected);
+                FakeVisitor actual;
+                actualTree.visit(actual);
+
+                EXPECT_SAME_VISITS(ScriptNode);
+                EXPECT_SAME_VISITS(FunctionDefNode);
+                EXPECT_SAME_VISITS(FunctionDefParamsNode);
+                EXPECT_SAME_VISITS(HtmlTemplateNode);
+                EXPECT_SAME_VISITS(AttributeNode);
+                EXPECT_SAME_VISITS(AttributeValueNode);
+                EXPECT_SAME_VISITS(AttributeListNode);
+                EXPECT_SAME_VISITS(TextContentNode);
+                EXPECT_SAME_VISITS(InjectedValueNode);
+                EXPECT_SAME_VISITS(ReturnExpressionNode);
+                EXPECT_SAME_VISITS(BlockNode);
+                EXPECT_SAME_VISITS(DeclarationExpressionNode);
+                EXPECT_SAME_VISITS(ForExpressionNode);
+                EXPECT_SAME_VISITS(AssignExpressionNode);
+                EXPECT_SAME_VISITS(IfExpressionNode);
+                EXPECT_SAME_VISITS(BinaryOperationNode);
+                EXPECT_SAME_VISITS(UnaryOperationNode);
+                EXPECT_SAME_VISITS(FunctionCallNode);
+                EXPECT_SAME_VISITS(ObjectLiteralNode);
+                EXPECT_SAME_VISITS(ObjectFieldNode);
+                EXPECT_SAME_VISITS(VariableNode);
+                EXPECT_SAME_VISITS(IndexExpressionNode);
+                EXPECT_SAME_VISITS(AnyTextNode);
+                EXPECT_SAME_VISITS(IdentifierNode);
+                EXPECT_SAME_VISITS(StringLiteralNode);
+                EXPECT_SAME_VISITS(NumberLiteralNode);
+                EXPECT_SAME_VISITS(BooleanLiteralNode);
+
+                ASSERT_EQ(expected.FunctionDefNode_visited.size(), actual.FunctionDefNode_visited.size());
+                for (std::size_t i = 0; i < expected.FunctionDefNode_visited.size(); ++i)
+                    EXPECT_EQ(expected.FunctionDefNode_visited[i]->name, actual.FunctionDefNode_visited[i]->name);
+                ASSERT_EQ(expected.NumberLiteralNode_visited.size(), actual.NumberLiteralNode_visited.size());
+                for (std::size_t i = 0; i < expected.NumberLiteralNode_visited.size(); ++i)
+                    EXPECT_EQ(expected.NumberLiteralNode_visited[i]->value, actual.NumberLiteralNode_visited[i]->value);
+                ASSERT_EQ(expected.BinaryOperationNode_visited.size(), actual.BinaryOperationNode_visited.size());
+                for (std::size_t i = 0; i < expected.BinaryOperationNode_visited.size(); ++i)
+                    EXPECT_EQ(expected.BinaryOperationNode_visited[i]->op, actual.BinaryOperationNode_visited[i]->op);
+                ASSERT_EQ(expected.AnyTextNode_visited.size(), actual.AnyTextNode_visited.size());
+                for (std::size_t i = 0; i < expected.AnyTextNode_visited.size(); ++i)
+                    EXPECT_EQ(expected.AnyTextNode_visited[i]->text, actual.AnyTextNode_visited[i]->text);
+            }
+
+#undef EXPECT_SAME_VISITS
+
+            void expectRoundTrip(const ScriptNode &tree) {
+                const auto compact = CompactTree::fromTree(tree);
+                const auto expanded = compact.expand();
+                ASSERT_TRUE(expanded);
+                EXPECT_EQ(tree.symbols, expanded->symbols);
+                expectSameTree(tree, *expanded);
+            }
+
+            void expectSameParse(const std::string &code) {
+                const auto tree = parse(code);
+                expectSameTree(*tree, *parseCompact(code).expand());
+            }
+
+            /**
+             * Counts nodes and identifiers met walking the pools.
+             */
+            class CountingVisitor : public CompactTreeVisitor {
+            public:
+                std::size_t nodes = 0;
+                std::size_t identifiers = 0;
+
+                using CompactTreeVisitor::CompactTreeVisitor;
+
+                void count(NodeRef node) {
+                    ++nodes;
+                    visitChildren(node);
+                }
+
+            protected:
+                void visitFunctionDef(NodeRef node, const CompactTree::FunctionDef &) override {
+                    count(node);
+                }
+
+                void visitBinaryOperation(NodeRef node, BinaryOperator, const CompactTree::Binary &) override {
+                    count(node);
+                }
+
+                void visitIdentifier(NodeRef node, std::uint32_t) override {
+                    ++identifiers;
+                    count(node);
+                }
+            };
+
+            std::string generateScript(std::size_t functionCount) {
+                std::string result;
+                for (std::size_t i = 0; i < functionCount; ++i) {
+                    const auto id = std::to_string(i);
+                    result += "function foo" + id + "(a, b, c) {let x" + id + " = 1 + 3 * 2 ;}\n"
+                            "function bar" + id + "(){if (false){10;} else {print(6;)} ;}\n";
+                }
+                return result;
+            }
+
+            std::size_t heapInUse() {
+                return mallinfo2().uordblks;
+            }
+
+            std::size_t countNodes(const CompactTree &tree, NodeRef node) {
+                std::size_t count = 1;
+                tree.forEachChild(node, [&tree, &count](NodeRef child) {
+                    count += countNodes(tree, child);
+                });
+                return count;
+            }
+        }
+
+        TEST(CompactTreeTest, node_ref_packs_kind_and_index) {
+            const NodeRef ref(NodeKind::FUNCTION_CALL, 12345);
+
+            EXPECT_EQ(NodeKind::FUNCTION_CALL, ref.kind());
+            EXPECT_EQ(12345u, ref.index());
+            EXPECT_EQ(ref, NodeRef::fromRaw(ref.raw()));
+            EXPECT_TRUE(ref);
+            EXPECT_FALSE(NodeRef());
+            EXPECT_EQ(4u, sizeof(NodeRef));
+        }
+
+        TEST(CompactTreeTest, round_trip_of_expressions) {
+            expectRoundTrip(*parse(
+                    "function foo(a, b, c) {let x = 2 * 3 - 4 / 1 ;}"
+                            "function bar(){if (false){10;} else {print(6;)} ;}"
+                            "function baz() { x[2;] }"
+                            "function qux() {return 1 < 2 ;;}"
+                            "function quux() {return 5 == 5 || -a != !b && c >= 2 ;;}"
+                            "function corge() {x = 3 ;;}"));
+        }
+
+        TEST(CompactTreeTest, round_trip_of_templates) {
+            expectRoundTrip(*parse(
+                    "function Row [\n<tr class=\"row\" id={{ id }}><td>Lorem ipsum\n dolor</td>"
+                            "<td> {{ value }} sit { amet </td></tr>\n](id, value) {return 1 ;;}"));
+        }
+
+        TEST(CompactTreeTest, round_trip_of_generated_script) {
+            expectRoundTrip(*parse(generateScript(100)));
+        }
+
+        TEST(CompactTreeTest, node_count_matches_visits) {
+            const auto tree = parse("function foo() {let a = 1 + 3 ;}");
+            const auto compact = CompactTree::fromTree(*tree);
+
+            EXPECT_EQ(countNodes(compact, compact.root), compact.nodeCount());
+            EXPECT_EQ(NodeKind::SCRIPT, compact.root.kind());
+            EXPECT_EQ(1u, compact.functionDefs.size());
+            EXPECT_EQ("foo", (*compact.symbols)[compact.functionDefs[0].name].str());
+        }
+
+        TEST(CompactTreeTest, expansion_rejects_node_of_wrong_kind) {
+            auto compact = parseCompact("function foo(a) {return a ;;}");
+            auto &function = compact.functionDefs.at(0);
+            function.params = function.value;
+
+            EXPECT_THROW(compact.expand(), std::invalid_argument);
+        }
+
+        TEST(CompactTreeTest, compact_parser_matches_tree_parser) {
+            expectSameParse("function foo(a, b, c) {let x = 2 * 3 - 4 / 1 ;}"
+                                    "function bar(){if (false){10;} else {print(6;)} ;}"
+                                    "function baz() { x[2;][a] = 3;;}"
+                                    "function obj() {let o = {y: 1;, z: \"s\";};}"
+                                    "function quux() {return 5 == 5 || -a != !b && c >= 2 ;;}");
+            expectSameParse("function Row [\n<tr class=\"row\" id={{ id }}><td>Lorem ipsum\n dolor</td>"
+                                    "<td> {{ value }} sit { amet </td>tail</tr>\n](id, value) {return 1 ;;}");
+            expectSameParse(generateScript(100));
+        }
+
+        TEST(CompactTreeTest, compact_parser_keeps_only_last_expression_of_body) {
+            const auto compact = parseCompact("function foo() {let x = 1 + 2 ;; 3 ;}");
+
+            ASSERT_EQ(1u, compact.functionDefs.size());
+            EXPECT_EQ(NodeKind::NUMBER_LITERAL, compact.functionDefs[0].value.kind());
+            ASSERT_EQ(1u, compact.numbers.size());
+            EXPECT_EQ(3, compact.numbers[0].value);
+            EXPECT_TRUE(compact.binaries.empty());
+        }
+
+        TEST(CompactTreeTest, visitor_walks_pools) {
+            const std::string code = "function foo(a, b) {let x = a + b * 2 ;}\nfunction bar() {foo(1;, 2;)}";
+            const auto compact = parseCompact(code);
+
+            CountingVisitor visitor(compact);
+            visitor.visit(compact.root);
+
+            FakeVisitor expected;
+            parse(code)->visit(expected);
+            EXPECT_EQ(expected.IdentifierNode_visited.size(), visitor.identifiers);
+            EXPECT_EQ(expected.FunctionDefNode_visited.size() + expected.BinaryOperationNode_visited.size()
+                      + expected.IdentifierNode_visited.size(), visitor.nodes);
+        }
+
+        TEST(CompactTreeTest, DISABLED_memory_and_traversal_benchmark) {
+            const std::string script = generateScript(5000);
+
+            const auto heapBeforeTree = heapInUse();
+            auto tree = parse(script);
+            const auto treeBytes = heapInUse() - heapBeforeTree;
+
+            const auto heapBeforeCompact = heapInUse();
+            const auto compact = parseCompact(script);
+            const auto compactBytes = heapInUse() - heapBeforeCompact;
+
+            std::size_t visited = 0;
+            const double nodeTraversal = measureMilliseconds([&] {
+                FakeVisitor visitor;
+                tree->visit(visitor);
+                visited = visitor.IdentifierNode_visited.size();
+            });
+
+            std::size_t counted = 0;
+            const double compactTraversal = measureMilliseconds([&] {
+                CountingVisitor visitor(compact);
+                visitor.visit(compact.root);
+                counted = visitor.identifiers;
+            });
+
+            EXPECT_EQ(visited, counted);
+            EXPECT_LT(compactBytes, treeBytes);
+
+            std::cout << "[ BENCHMARK] " << compact.nodeCount() << " nodes; node tree: " << treeBytes / 1024
+                      << " KiB, compact tree: " << compactBytes / 1024 << " KiB; traversal with visitor: "
+                      << nodeTraversal << " ms, compact traversal: " << compactTraversal << " ms" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "parser/constant-folder.hpp"
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "fake-visitor.hpp"
+
+namespace lang {
+    namespace parser {
+        struct ConstantFolderTest : ::testing::Test {
+            std::unique_ptr<ScriptNode> tree;
+            std::size_t removed = 0;
+            FakeVisitor visitor;
+
+            void fold(const std::string &code) {
+                util::StringOutputStream codeStream(code);
+                lexer::Lexer lexer(codeStream);
+                logging::Logger logger;
+                Parser parser(logger, lexer);
+                tree = parser.getTree();
+                removed = foldConstants(*tree);
+                tree->visit(visitor);
+            }
+
+            /**
+             * Folds the expression returned by a function.
+             */
+            void foldReturned(const std::string &expression) {
+                fold("function foo(x) {return " + expression + " ;;}");
+            }
+        };
+
+        TEST_F(ConstantFolderTest, folds_arithmetic) {
+            foldReturned("1 + 2 * 3 - 4 / 2");
+
+            EXPECT_EQ(8, removed);
+            EXPECT_EQ(0, visitor.BinaryOperationNode_visited.size());
+            ASSERT_EQ(1, visitor.NumberLiteralNode_visited.size());
+            EXPECT_EQ(5.0, visitor.NumberLiteralNode_visited[0]->value);
+        }
+
+        TEST_F(ConstantFolderTest, folds_unary_operators) {
+            foldReturned("-(2 - 5) < 4 == !false");
+
+            EXPECT_EQ(0, visitor.UnaryOperationNode_visited.size());
+            EXPECT_EQ(0, visitor.BinaryOperationNode_visited.size());
+            ASSERT_EQ(1, visitor.BooleanLiteralNode_visited.size());
+            EXPECT_TRUE(visitor.BooleanLiteralNode_visited[0]->value);
+            EXPECT_EQ(8, removed);
+        }
+
+        TEST_F(ConstantFolderTest, folds_strings_and_equality) {
+            fold("function foo() {let a = \"ab\" + \"cd\" ;}"
+                         "function bar() {let b = \"ab\" == \"ab\" ;}"
+                         "function baz() {let c = 1 != \"1\" ;}");
+
+            ASSERT_EQ(1, visitor.StringLiteralNode_visited.size());
+            EXPECT_EQ("abcd", visitor.StringLiteralNode_visited[0]->value);
+            ASSERT_EQ(2, visitor.BooleanLiteralNode_visited.size());
+            EXPECT_TRUE(visitor.BooleanLiteralNode_visited[0]->value);
+            EXPECT_TRUE(visitor.BooleanLiteralNode_visited[1]->value);
+            EXPECT_EQ(6, removed);
+        }
+
+        TEST_F(ConstantFolderTest, keeps_operations_failing_at_run_time) {
+            fold("function foo() {let a = 1 + \"a\" ;}"
+                         "function bar() {let b = \"a\" < \"b\" ;}"
+                         "function baz() {let c = !1 ;}"
+                         "function qux() {let d = -\"a\" ;}"
+                         "function quux() {let e = 1 || false ;}");
+
+            EXPECT_EQ(0, removed);
+            EXPECT_EQ(3, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(2, visitor.UnaryOperationNode_visited.size());
+        }
+
+        TEST_F(ConstantFolderTest, folds_parts_of_expressions) {
+            foldReturned("x * (2 + 3) - x");
+
+            EXPECT_EQ(2, removed);
+            ASSERT_EQ(2, visitor.BinaryOperationNode_visited.size());
+            ASSERT_EQ(1, visitor.NumberLiteralNode_visited.size());
+            EXPECT_EQ(5.0, visitor.NumberLiteralNode_visited[0]->value);
+        }
+
+        TEST_F(ConstantFolderTest, logical_operators_keep_deciding_operand) {
+            fold("function foo(x) {let a = true || x ;}"
+                         "function bar(x) {let b = false || x ;}"
+                         "function baz(x) {let c = true && x[1 + 1;] ;}"
+                         "function qux(x) {let d = false && x ;}");
+
+            EXPECT_EQ(0, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(2, visitor.BooleanLiteralNode_visited.size());
+            EXPECT_EQ(2, visitor.VariableNode_visited.size());
+            ASSERT_EQ(1, visitor.NumberLiteralNode_visited.size());
+            EXPECT_EQ(2.0, visitor.NumberLiteralNode_visited[0]->value);
+            // Variable counts as two nodes together with its identifier, index expression adds two more.
+            EXPECT_EQ(3 + 2 + (2 + 2) + 3, removed);
+        }
+
+        TEST_F(ConstantFolderTest, folds_inside_statements) {
+            fold("function foo(){if (1 < 2;){10 + 1;} else {print(6 * 2;)} ;}");
+
+            EXPECT_EQ(0, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(1, visitor.FunctionCallNode_visited.size());
+            EXPECT_EQ(6, removed);
+        }
+
+        TEST_F(ConstantFolderTest, skips_deferred_bodies) {
+            util::StringOutputStream codeStream("function foo() {return 1 + 2 ;;}");
+            lexer::Lexer lexer(codeStream);
+            logging::Logger logger;
+            Parser parser(logger, lexer);
+            auto preParsed = parser.preParse();
+
+            EXPECT_EQ(0, foldConstants(*preParsed));
+            parseDeferred(*preParsed->functions[0], logger);
+            EXPECT_EQ(2, foldConstants(*preParsed->functions[0]));
+        }
+    }
+}
@@ -51,13 +51,17 @@ namespace lang {
         }
 
         FAKE_VISITOR_IMPL_VISIT(AttributeValueNode) {
-            node.value->visit(*this);
-            node.string->visit(*this);
+            if (node.value)
+                node.value->visit(*this);
+            if (node.string)
+                node.string->visit(*this);
         }
 
         FAKE_VISITOR_IMPL_VISIT(TextContentNode) {
-            node.value->visit(*this);
-            node.anytext->visit(*this);
+            if (node.value)
+                node.value->visit(*this);
+            if (node.anytext)
+                node.anytext->visit(*this);
         }
 
         FAKE_VISITOR_IMPL_VISIT(InjectedValueNode) {
@@ -97,39 +101,13 @@ namespace lang {
                 node.elseBlock.get()->visit(*this);
         }
 
-        FAKE_VISITOR_IMPL_VISIT(MathExpressionAddNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(MathExpressionSubtractNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(MathExpressionSingleNode) {
-            node.value->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(MultiplyExpressionNode) {
+        FAKE_VISITOR_IMPL_VISIT(BinaryOperationNode) {
             node.left->visit(*this);
             node.right->visit(*this);
         }
 
-        FAKE_VISITOR_IMPL_VISIT(DivideExpressionNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(MultiplicativeExpressionSingleNode) {
-            node.value->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(BaseMathExpressionNode) {
-            if (node.logicUnary)
-                node.logicUnary.get()->visit(*this);
-            if (node.mathLogic)
-                node.mathLogic.get()->visit(*this);
+        FAKE_VISITOR_IMPL_VISIT(UnaryOperationNode) {
+            node.operand->visit(*this);
         }
 
         FAKE_VISITOR_IMPL_VISIT(FunctionCallNode) {
@@ -138,61 +116,6 @@ namespace lang {
                 p->visit(*this);
         }
 
-        FAKE_VISITOR_IMPL_VISIT(ParenthesisExpressionNode) {
-            node.expression->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionOrNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionSingleNode) {
-            node.value->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionAndAndNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionAndSingleNode) {
-            node.value->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionEqualEqualNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionEqualSingleNode) {
-            node.value->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionRelationalLessNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionRelationalGreaterNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionRelationalLessEqualNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionRelationalGreaterEqualNode) {
-            node.left->visit(*this);
-            node.right->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(LogicExpressionRelationalSingleNode) {
-            node.value->visit(*this);
-        }
-
         FAKE_VISITOR_IMPL_VISIT(ObjectLiteralNode) {
             for (const auto &it : node.injection)
                 it->visit(*this);
@@ -213,15 +136,7 @@ namespace lang {
             node.value->visit(*this);
         }
 
-        FAKE_VISITOR_IMPL_VISIT(AnyTextNode) {
-            for (const auto &it : node.chars)
-                it->visit(*this);
-        }
-
-        FAKE_VISITOR_IMPL_VISIT(AnyCharNode) {
-            node.identifier->visit(*this);
-            node.number->visit(*this);
-        }
+        FAKE_VISITOR_IMPL_VISIT(AnyTextNode) {}
 
         FAKE_VISITOR_IMPL_VISIT(IdentifierNode) {}
 
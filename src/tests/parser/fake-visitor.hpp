@@ -44,46 +44,12 @@ public: \
 
             FAKE_VISITOR_DECL_VISIT(IfExpressionNode);
 
-            FAKE_VISITOR_DECL_VISIT(MathExpressionAddNode);
+            FAKE_VISITOR_DECL_VISIT(BinaryOperationNode);
 
-            FAKE_VISITOR_DECL_VISIT(MathExpressionSubtractNode);
-
-            FAKE_VISITOR_DECL_VISIT(MathExpressionSingleNode);
-
-            FAKE_VISITOR_DECL_VISIT(MultiplyExpressionNode);
-
-            FAKE_VISITOR_DECL_VISIT(DivideExpressionNode);
-
-            FAKE_VISITOR_DECL_VISIT(MultiplicativeExpressionSingleNode);
-
-            FAKE_VISITOR_DECL_VISIT(BaseMathExpressionNode);
+            FAKE_VISITOR_DECL_VISIT(UnaryOperationNode);
 
             FAKE_VISITOR_DECL_VISIT(FunctionCallNode);
 
-            FAKE_VISITOR_DECL_VISIT(ParenthesisExpressionNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionOrNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionSingleNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionAndAndNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionAndSingleNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionEqualEqualNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionEqualSingleNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionRelationalLessNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionRelationalGreaterNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionRelationalLessEqualNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionRelationalGreaterEqualNode);
-
-            FAKE_VISITOR_DECL_VISIT(LogicExpressionRelationalSingleNode);
-
             FAKE_VISITOR_DECL_VISIT(ObjectLiteralNode);
 
             FAKE_VISITOR_DECL_VISIT(ObjectFieldNode);
@@ -94,8 +60,6 @@ public: \
 
             FAKE_VISITOR_DECL_VISIT(AnyTextNode);
 
-            FAKE_VISITOR_DECL_VISIT(AnyCharNode);
-
             FAKE_VISITOR_DECL_VISIT(IdentifierNode);
 
             FAKE_VISITOR_DECL_VISIT(StringLiteralNode);
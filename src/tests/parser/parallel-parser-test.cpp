@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include <thread>
+#include "parser/parallel-parser.hpp"
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "logging/logger-output.hpp"
+#include "fake-visitor.hpp"
+#include "../benchmark.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            struct CollectingOutput : logging::LoggerOutput {
+                std::vector<std::string> &messages;
+
+                explicit CollectingOutput(std::vector<std::string> &messages) : messages(messages) {
+                }
+
+                void write(const logging::LogEntry &entry) override {
+                    messages.push_back(entry.message);
+                }
+            };
+
+            std::unique_ptr<ScriptNode> parseSerially(const std::string &code) {
+                util::StringOutputStream input(code);
+                lexer::Lexer lexer(input);
+                logging::Logger logger;
+                Parser parser(logger, lexer);
+                return parser.getTree();
+            }
+
+            std::unique_ptr<ScriptNode> parseInParallel(const std::string &code, unsigned threadCount) {
+                logging::Logger logger;
+                ParallelParser parser(logger, code, std::make_shared<lexer::SymbolTable>(), threadCount);
+                return parser.getTree();
+            }
+
+            std::string generateScript(std::size_t functionCount) {
+                std::string result;
+                for (std::size_t i = 0; i < functionCount; ++i) {
+                    const auto id = std::to_string(i);
+                    result += "function foo" + id + "(a, b, c) {let x" + id + " = 1 + 3 * 2 ;}\n"
+                            "function Row" + id + " [\n<tr class=\"function ]\"><td>function { [ " + id
+                            + "</td><td> {{ value }} </td></tr>\n](value) {return value ;;}\n"
+                            "function bar" + id + "(){if (false){10;} else {print(6;)} ;}\n"
+                            "function baz" + id + "() {let s = \"function } \" ;}\n";
+                }
+                return result;
+            }
+
+            std::vector<std::string> names(const ScriptNode &tree) {
+                std::vector<std::string> result;
+                for (const auto &function : tree.functions)
+                    result.push_back(function->name.str());
+                return result;
+            }
+        }
+
+        TEST(ParallelParserTest, splits_at_top_level_functions) {
+            const std::string code = " \nfunction a() {x = \"function\" ;;}\n"
+                    "function T[ <td class=\"]\">function } { [ </td> ](n) {return 1 ;;}\n"
+                    "function myfunction() {return 2 ;;}";
+
+            const auto chunks = splitFunctions(code);
+
+            ASSERT_EQ(3, chunks.size());
+            EXPECT_EQ(" \nfunction a() {x = \"function\" ;;}\n", chunks[0].text);
+            EXPECT_EQ(1, chunks[0].firstLine);
+            EXPECT_EQ(0, chunks[1].text.find("function T["));
+            EXPECT_EQ(3, chunks[1].firstLine);
+            EXPECT_EQ("function myfunction() {return 2 ;;}", chunks[2].text);
+            EXPECT_EQ(4, chunks[2].firstLine);
+        }
+
+        TEST(ParallelParserTest, source_without_functions_is_one_chunk) {
+            EXPECT_EQ(1, splitFunctions("").size());
+            EXPECT_EQ(1, splitFunctions("  \n ").size());
+        }
+
+        TEST(ParallelParserTest, same_tree_as_serial_parser) {
+            const auto code = generateScript(50);
+            const auto serial = parseSerially(code);
+
+            for (unsigned threadCount : {1u, 2u, 4u}) {
+                const auto parallel = parseInParallel(code, threadCount);
+                EXPECT_EQ(names(*serial), names(*parallel));
+
+                FakeVisitor expected;
+                serial->visit(expected);
+                FakeVisitor actual;
+                parallel->visit(actual);
+                EXPECT_EQ(expected.HtmlTemplateNode_visited.size(), actual.HtmlTemplateNode_visited.size());
+                EXPECT_EQ(expected.BinaryOperationNode_visited.size(), actual.BinaryOperationNode_visited.size());
+                EXPECT_EQ(expected.IdentifierNode_visited.size(), actual.IdentifierNode_visited.size());
+                EXPECT_EQ(expected.StringLiteralNode_visited.size(), actual.StringLiteralNode_visited.size());
+            }
+        }
+
+        TEST(ParallelParserTest, chunks_share_symbols) {
+            const auto code = generateScript(20);
+            const auto symbols = std::make_shared<lexer::SymbolTable>();
+            logging::Logger logger;
+            ParallelParser parser(logger, code, symbols, 4);
+            const auto tree = parser.getTree();
+
+            FakeVisitor visitor;
+            tree->visit(visitor);
+
+            std::vector<lexer::Symbol> values;
+            for (auto identifier : visitor.IdentifierNode_visited)
+                if (identifier->name == "value")
+                    values.push_back(identifier->name);
+            ASSERT_EQ(20 * 2, values.size());
+            for (const auto &value : values)
+                EXPECT_EQ(values.front().getId(), value.getId());
+            EXPECT_EQ(values.front(), symbols->intern("value"));
+        }
+
+        TEST(ParallelParserTest, failure_is_reported_in_source_order) {
+            std::string code = generateScript(10) + "function broken( {}\n" + generateScript(10);
+            std::vector<std::string> messages;
+            logging::Logger logger;
+            logger.addOutput(std::unique_ptr<logging::LoggerOutput>(new CollectingOutput(messages)));
+
+            ParallelParser parser(logger, code, std::make_shared<lexer::SymbolTable>(), 4);
+            EXPECT_THROW(parser.getTree(), ParserException);
+            EXPECT_FALSE(messages.empty());
+        }
+
+        TEST(ParallelParserTest, DISABLED_speedup_benchmark) {
+            const auto code = generateScript(3000);
+            const auto threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+            std::size_t serialFunctions = 0;
+            const double serial = measureMilliseconds([&] {
+                serialFunctions = parseSerially(code)->functions.size();
+            });
+
+            std::size_t parallelFunctions = 0;
+            const double parallel = measureMilliseconds([&] {
+                parallelFunctions = parseInParallel(code, threadCount)->functions.size();
+            });
+
+            EXPECT_EQ(serialFunctions, parallelFunctions);
+            std::cout << "[ BENCHMARK] " << parallelFunctions << " functions; serial: " << serial << " ms, "
+                      << threadCount << " threads: " << parallel << " ms" << std::endl;
+        }
+    }
+}
@@ -3,10 +3,24 @@
 #include "lexer/lexer.hpp"
 #include "util/string-output-stream.hpp"
 #include "logging/logger.hpp"
+#include "logging/logger-output.hpp"
 #include "fake-visitor.hpp"
 
 namespace lang {
     namespace parser {
+        namespace {
+            struct CollectingOutput : logging::LoggerOutput {
+                std::vector<std::string> &messages;
+
+                explicit CollectingOutput(std::vector<std::string> &messages) : messages(messages) {
+                }
+
+                void write(const logging::LogEntry &entry) override {
+                    messages.push_back(entry.message);
+                }
+            };
+        }
+
         struct ParserTest : ::testing::Test {
             std::unique_ptr<ScriptNode> getTree(const std::string &code) {
                 util::StringOutputStream codeStream(code);
@@ -15,6 +29,14 @@ namespace lang {
                 Parser parser(logger, lexer);
                 return parser.getTree();
             }
+
+            std::unique_ptr<ScriptNode> preParse(const std::string &code) {
+                util::StringOutputStream codeStream(code);
+                lexer::Lexer lexer(codeStream);
+                logging::Logger logger;
+                Parser parser(logger, lexer);
+                return parser.preParse();
+            }
         };
 
         TEST_F(ParserTest, declaration_expression) {
@@ -52,10 +74,36 @@ namespace lang {
 
             ASSERT_EQ(1, visitor.HtmlTemplateNode_visited.size());
             ASSERT_EQ(1, visitor.ReturnExpressionNode_visited.size());
-            ASSERT_EQ(1, visitor.LogicExpressionRelationalGreaterNode_visited.size());
+            ASSERT_EQ(1, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(BinaryOperator::GREATER, visitor.BinaryOperationNode_visited[0]->op);
         }
 
 
+        TEST_F(ParserTest, html_template_text_runs) {
+            auto tree = getTree("function Row [\n"
+                                "  <tr class=\"row\">\n"
+                                "    <td>Inne dane { x }</td>\n"
+                                "    <td> {{ name }} </td>\n"
+                                "  </tr>\n"
+                                "] (node) {return 1 ;;}");
+
+            const auto &row = *tree->functions[0]->htmltemplate;
+            ASSERT_EQ(2, row.htmlValue.size());
+            ASSERT_EQ(1, row.attributes->value.size());
+            EXPECT_TRUE(row.value.empty());
+
+            const auto &text = *row.htmlValue[0];
+            ASSERT_EQ(1, text.value.size());
+            ASSERT_TRUE(text.value[0]->anytext);
+            EXPECT_EQ("Inne dane { x }", text.value[0]->anytext->text);
+
+            const auto &injected = *row.htmlValue[1];
+            ASSERT_EQ(1, injected.value.size());
+            EXPECT_FALSE(injected.value[0]->anytext);
+            const auto &injectedValue = static_cast<const InjectedValueNode &>(*injected.value[0]->value);
+            EXPECT_EQ("name", injectedValue.value->name.str());
+        }
+
         TEST_F(ParserTest, if_expression) {
             auto tree = getTree("function foo(){if (false){10;} else {2;} ;}");
 
@@ -71,8 +119,70 @@ namespace lang {
             FakeVisitor visitor;
             tree->visit(visitor);
 
-            ASSERT_EQ(1, visitor.MultiplicativeExpressionSingleNode_visited.size());
-            ASSERT_EQ(1, visitor.LogicExpressionSingleNode_visited.size());
+            ASSERT_EQ(1, visitor.UnaryOperationNode_visited.size());
+            EXPECT_EQ(UnaryOperator::NEGATE, visitor.UnaryOperationNode_visited[0]->op);
+            ASSERT_EQ(1, visitor.NumberLiteralNode_visited.size());
+            EXPECT_TRUE(visitor.BinaryOperationNode_visited.empty());
+        }
+
+        TEST_F(ParserTest, operators_nest_by_precedence_and_to_the_left) {
+            auto tree = getTree("function foo() {return 1 - 2 - 3 * 4 < 5 || !a && b ;;}");
+
+            const auto &returned = static_cast<const ReturnExpressionNode &>(*tree->functions[0]->value);
+            const auto &orOp = static_cast<const BinaryOperationNode &>(*returned.returnValue);
+            ASSERT_EQ(BinaryOperator::OR, orOp.op);
+
+            const auto &less = static_cast<const BinaryOperationNode &>(*orOp.left);
+            ASSERT_EQ(BinaryOperator::LESS, less.op);
+            const auto &outer = static_cast<const BinaryOperationNode &>(*less.left);
+            ASSERT_EQ(BinaryOperator::SUBTRACT, outer.op);
+            const auto &inner = static_cast<const BinaryOperationNode &>(*outer.left);
+            EXPECT_EQ(BinaryOperator::SUBTRACT, inner.op);
+            EXPECT_EQ(1., static_cast<const NumberLiteralNode &>(*inner.left).value);
+            EXPECT_EQ(BinaryOperator::MULTIPLY, static_cast<const BinaryOperationNode &>(*outer.right).op);
+
+            const auto &andOp = static_cast<const BinaryOperationNode &>(*orOp.right);
+            ASSERT_EQ(BinaryOperator::AND, andOp.op);
+            EXPECT_EQ(UnaryOperator::NOT, static_cast<const UnaryOperationNode &>(*andOp.left).op);
+
+            FakeVisitor visitor;
+            tree->visit(visitor);
+            EXPECT_EQ(6, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(2, visitor.VariableNode_visited.size());
+        }
+
+        TEST_F(ParserTest, not_equal_shares_precedence_of_equal) {
+            auto tree = getTree("function foo(a) {return a != 1 + 2 == false ;;}");
+
+            const auto &returned = static_cast<const ReturnExpressionNode &>(*tree->functions[0]->value);
+            const auto &equal = static_cast<const BinaryOperationNode &>(*returned.returnValue);
+            ASSERT_EQ(BinaryOperator::EQUAL, equal.op);
+            const auto &notEqual = static_cast<const BinaryOperationNode &>(*equal.left);
+            ASSERT_EQ(BinaryOperator::NOT_EQUAL, notEqual.op);
+            EXPECT_EQ(BinaryOperator::ADD, static_cast<const BinaryOperationNode &>(*notEqual.right).op);
+        }
+
+        TEST_F(ParserTest, identifier_operands_are_variables) {
+            auto tree = getTree("function foo(a) {return a + b * a ;;}");
+
+            FakeVisitor visitor;
+            tree->visit(visitor);
+
+            ASSERT_EQ(3, visitor.VariableNode_visited.size());
+            EXPECT_EQ("a", visitor.VariableNode_visited[0]->identifier->name.str());
+            EXPECT_EQ("b", visitor.VariableNode_visited[1]->identifier->name.str());
+            EXPECT_TRUE(visitor.StringLiteralNode_visited.empty());
+        }
+
+        TEST_F(ParserTest, parenthesis_leave_no_node) {
+            auto tree = getTree("function foo() {return (1 + 2) * 3 ;;}");
+
+            FakeVisitor visitor;
+            tree->visit(visitor);
+
+            ASSERT_EQ(2, visitor.BinaryOperationNode_visited.size());
+            EXPECT_EQ(BinaryOperator::MULTIPLY, visitor.BinaryOperationNode_visited[0]->op);
+            EXPECT_EQ(BinaryOperator::ADD, visitor.BinaryOperationNode_visited[1]->op);
         }
 
         TEST_F(ParserTest, argument_list) {
@@ -86,5 +196,120 @@ namespace lang {
             ASSERT_EQ(1, visitor.FunctionCallNode_visited.size());
         }
 
+        TEST_F(ParserTest, token_array_gives_same_tree) {
+            const std::string code =
+                    "function Nodes [ <table> </table> ] (nodes) {return 5>1 ;;}"
+                            "function foo(a, b, c) { print(6;)}"
+                            "function bar(){if (false){10;} else {2;} ;}";
+
+            FakeVisitor streamVisitor;
+            getTree(code)->visit(streamVisitor);
+
+            util::StringOutputStream codeStream(code);
+            lexer::Lexer lexer(codeStream);
+            const auto tokens = lexer.tokenize();
+            logging::Logger logger;
+            Parser parser(logger, tokens);
+            auto tree = parser.getTree();
+
+            FakeVisitor arrayVisitor;
+            tree->visit(arrayVisitor);
+
+            ASSERT_EQ(3, arrayVisitor.FunctionDefNode_visited.size());
+            EXPECT_EQ("foo", arrayVisitor.FunctionDefNode_visited[1]->name.str());
+            EXPECT_EQ(streamVisitor.HtmlTemplateNode_visited.size(), arrayVisitor.HtmlTemplateNode_visited.size());
+            EXPECT_EQ(streamVisitor.FunctionCallNode_visited.size(), arrayVisitor.FunctionCallNode_visited.size());
+            EXPECT_EQ(streamVisitor.IfExpressionNode_visited.size(), arrayVisitor.IfExpressionNode_visited.size());
+            EXPECT_EQ(streamVisitor.IdentifierNode_visited.size(), arrayVisitor.IdentifierNode_visited.size());
+        }
+    
+        TEST_F(ParserTest, pre_parse_keeps_signatures_only) {
+            const std::string code =
+                    "function Nodes [ <table> [ { </table> ] (nodes) {return 5 ;;}\n"
+                            "function foo(a, b, c) { print(6;)}\n"
+                            "\nfunction bar(){if (false){10;} else {2;} ;}";
+
+            auto tree = preParse(code);
+
+            ASSERT_EQ(3, tree->functions.size());
+            const auto &nodes = *tree->functions[0];
+            EXPECT_EQ("Nodes", nodes.name.str());
+            EXPECT_FALSE(nodes.htmltemplate);
+            EXPECT_FALSE(nodes.value);
+            ASSERT_TRUE(nodes.params);
+            ASSERT_EQ(1, nodes.params->params.size());
+            EXPECT_EQ("nodes", nodes.params->params[0]->name.str());
+            ASSERT_TRUE(nodes.deferred);
+            EXPECT_EQ(0, nodes.deferred->offset);
+            EXPECT_EQ(code.find('\n'), nodes.deferred->length);
+            EXPECT_EQ(1, nodes.deferred->firstLine);
+
+            EXPECT_EQ(3, tree->functions[1]->params->params.size());
+            ASSERT_TRUE(tree->functions[2]->deferred);
+            EXPECT_EQ(code.substr(code.rfind("function")),
+                      tree->functions[2]->deferred->source->text.substr(tree->functions[2]->deferred->offset));
+            EXPECT_EQ(4, tree->functions[2]->deferred->firstLine);
+        }
+
+        TEST_F(ParserTest, deferred_bodies_parse_to_same_tree) {
+            const std::string code =
+                    "function Nodes [ <table> {{ nodes }} </table> ] (nodes) {return 5>1 ;;}"
+                            "function foo(a, b, c) { print(6;)}"
+                            "function bar(){if (false){10;} else {2;} ;}";
+
+            FakeVisitor expected;
+            getTree(code)->visit(expected);
+
+            auto tree = preParse(code);
+            logging::Logger logger;
+            for (auto &function : tree->functions) {
+                parseDeferred(*function, logger);
+                EXPECT_FALSE(function->deferred);
+            }
+            FakeVisitor actual;
+            tree->visit(actual);
+
+            EXPECT_EQ(expected.HtmlTemplateNode_visited.size(), actual.HtmlTemplateNode_visited.size());
+            EXPECT_EQ(expected.InjectedValueNode_visited.size(), actual.InjectedValueNode_visited.size());
+            EXPECT_EQ(expected.BinaryOperationNode_visited.size(), actual.BinaryOperationNode_visited.size());
+            EXPECT_EQ(expected.FunctionCallNode_visited.size(), actual.FunctionCallNode_visited.size());
+            EXPECT_EQ(expected.IfExpressionNode_visited.size(), actual.IfExpressionNode_visited.size());
+            EXPECT_EQ(expected.IdentifierNode_visited.size(), actual.IdentifierNode_visited.size());
+            for (auto identifier : actual.IdentifierNode_visited) {
+                if (identifier->name == "nodes") {
+                    EXPECT_EQ(tree->functions[0]->params->params[0]->name.getId(), identifier->name.getId());
+                }
+            }
+        }
+
+        TEST_F(ParserTest, errors_in_deferred_body_surface_on_first_use) {
+            auto tree = preParse("function good() {return 1;;} function bad() {let = 2 ;}");
+            logging::Logger logger;
+
+            ASSERT_EQ(2, tree->functions.size());
+            parseDeferred(*tree->functions[0], logger);
+            EXPECT_TRUE(tree->functions[0]->value);
+            EXPECT_THROW(parseDeferred(*tree->functions[1], logger), ParserException);
+        }
+
+        TEST_F(ParserTest, reports_expected_lexeme_type) {
+            std::vector<std::string> messages;
+            logging::Logger logger;
+            logger.addOutput(std::unique_ptr<logging::LoggerOutput>(new CollectingOutput(messages)));
+
+            util::StringOutputStream truncated("function foo()");
+            lexer::Lexer truncatedLexer(truncated);
+            EXPECT_THROW(Parser(logger, truncatedLexer).getTree(), ParserException);
+
+            util::StringOutputStream mismatched("function foo( {let a = 1 ;}");
+            lexer::Lexer mismatchedLexer(mismatched);
+            EXPECT_THROW(Parser(logger, mismatchedLexer).getTree(), ParserException);
+
+            const auto openBrace = std::to_string(static_cast<int>(lexer::LexemeType::OPEN_BRACE));
+            const auto closeParenthesis = std::to_string(static_cast<int>(lexer::LexemeType::CLOSE_PARENTHESIS));
+            ASSERT_EQ(2, messages.size());
+            EXPECT_EQ("Expected [LexemeType: " + openBrace + "], found end of file; Aborting", messages[0]);
+            EXPECT_EQ("Expected lexeme type " + closeParenthesis + ", got {; Aborting", messages[1]);
+        }
     }
-}
\ No newline at end of file
+}
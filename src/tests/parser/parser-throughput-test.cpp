@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <iostream>
+#include "parser/parser.hpp"
+#include "lexer/lexer.hpp"
+#include "util/string-output-stream.hpp"
+#include "logging/logger.hpp"
+#include "../benchmark.hpp"
+
+namespace lang {
+    namespace parser {
+        namespace {
+            const std::size_t functionCount = 5000;
+
+            std::string generateScript() {
+                std::string result;
+                for (std::size_t i = 0; i < functionCount; ++i) {
+                    const auto id = std::to_string(i);
+                    result += "function foo" + id + "(a, b, c) {let x" + id + " = 1 + 3 * 2 ;}\n"
+                            "function bar" + id + "(){if (false){10;} else {print(6;)} ;}\n";
+                }
+                return result;
+            }
+
+            const std::size_t templateRowCount = 20000;
+
+            std::string generateTemplate() {
+                std::string result = "function Table[\n<table>\n";
+                for (std::size_t i = 0; i < templateRowCount; ++i) {
+                    result += "  <tr class=\"row\"><td>Lorem ipsum dolor sit amet, consectetur adipiscing elit "
+                            + std::to_string(i) + "</td><td> {{ value }} </td></tr>\n";
+                }
+                return result + "</table>\n](value) {return 1 ;;}\n";
+            }
+        }
+
+        TEST(ParserThroughputTest, DISABLED_lexing_and_parsing_measured_separately) {
+            const std::string script = generateScript();
+            logging::Logger logger;
+
+            std::size_t streamFunctions = 0;
+            const double streamed = measureMilliseconds([&] {
+                util::StringOutputStream input(script);
+                lexer::Lexer lexer(input);
+                Parser parser(logger, lexer);
+                streamFunctions = parser.getTree()->functions.size();
+            });
+
+            util::StringOutputStream input(script);
+            lexer::Lexer lexer(input);
+            lexer::TokenArray tokens;
+            const double lexing = measureMilliseconds([&] {
+                tokens = lexer.tokenize();
+            });
+
+            std::size_t arrayFunctions = 0;
+            const double parsing = measureMilliseconds([&] {
+                Parser parser(logger, tokens);
+                arrayFunctions = parser.getTree()->functions.size();
+            });
+
+            EXPECT_EQ(2 * functionCount, streamFunctions);
+            EXPECT_EQ(2 * functionCount, arrayFunctions);
+
+            std::cout << "[ BENCHMARK] " << tokens.size() << " tokens; streamed lexing and parsing: " << streamed
+                      << " ms, token array lexing: " << lexing << " ms, parsing: " << parsing << " ms" << std::endl;
+        }
+
+        TEST(ParserThroughputTest, DISABLED_large_template) {
+            const std::string script = generateTemplate();
+            logging::Logger logger;
+
+            util::StringOutputStream input(script);
+            lexer::Lexer lexer(input);
+            lexer::TokenArray tokens;
+            const double lexing = measureMilliseconds([&] {
+                tokens = lexer.tokenize();
+            });
+
+            std::size_t rows = 0;
+            const double parsing = measureMilliseconds([&] {
+                Parser parser(logger, tokens);
+                rows = parser.getTree()->functions[0]->htmltemplate->htmlValue.size();
+            });
+
+            EXPECT_EQ(templateRowCount, rows);
+
+            std::cout << "[ BENCHMARK] " << script.size() / 1024 << " KB template, " << tokens.size()
+                      << " tokens; lexing: " << lexing << " ms, parsing: " << parsing << " ms" << std::endl;
+        }
+    
+        TEST(ParserThroughputTest, DISABLED_pre_parsing) {
+            const std::string script = generateScript();
+            logging::Logger logger;
+
+            std::size_t parsedFunctions = 0;
+            const double parsing = measureMilliseconds([&] {
+                util::StringOutputStream input(script);
+                lexer::Lexer lexer(input);
+                Parser parser(logger, lexer);
+                parsedFunctions = parser.getTree()->functions.size();
+            });
+
+            std::unique_ptr<ScriptNode> tree;
+            const double preParsing = measureMilliseconds([&] {
+                util::StringOutputStream input(script);
+                lexer::Lexer lexer(input);
+                Parser parser(logger, lexer);
+                tree = parser.preParse();
+            });
+
+            // Typical render touches a small part of the library.
+            const double completing = measureMilliseconds([&] {
+                for (std::size_t i = 0; i < tree->functions.size(); i += 100)
+                    parseDeferred(*tree->functions[i], logger);
+            });
+
+            EXPECT_EQ(parsedFunctions, tree->functions.size());
+            EXPECT_FALSE(tree->functions[0]->deferred);
+            EXPECT_TRUE(tree->functions[1]->deferred);
+
+            std::cout << "[ BENCHMARK] " << parsedFunctions << " functions; parsing: " << parsing
+                      << " ms, pre-parsing: " << preParsing << " ms, parsing every 100th body: " << completing
+                      << " ms" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+#include <clocale>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include "../../main/util/decimal-parser.hpp"
+
+namespace lang {
+    namespace util {
+        struct DecimalParserTest : ::testing::Test {
+        };
+
+        TEST_F(DecimalParserTest, integers) {
+            EXPECT_EQ(0.0, parseDecimal("0"));
+            EXPECT_EQ(7.0, parseDecimal("7"));
+            EXPECT_EQ(1234567.0, parseDecimal("1234567"));
+            EXPECT_EQ(9007199254740992.0, parseDecimal("9007199254740992"));
+        }
+
+        TEST_F(DecimalParserTest, fractions) {
+            EXPECT_EQ(0.5, parseDecimal("0.5"));
+            EXPECT_EQ(3.25, parseDecimal("3.25"));
+            EXPECT_EQ(0.1, parseDecimal("0.1"));
+            EXPECT_EQ(123.456, parseDecimal("123.456"));
+        }
+
+        TEST_F(DecimalParserTest, slow_path_is_correctly_rounded) {
+            EXPECT_EQ(9007199254740993.0, parseDecimal("9007199254740993"));
+            EXPECT_EQ(0.30000000000000004, parseDecimal("0.30000000000000004"));
+            EXPECT_EQ(1e-30, parseDecimal("0.000000000000000000000000000001"));
+            EXPECT_EQ(123456789012345678901234567890.0, parseDecimal("123456789012345678901234567890"));
+            EXPECT_EQ(1.0, parseDecimal("1." + std::string(300, '0')));
+        }
+
+        TEST_F(DecimalParserTest, ignores_text_after_view) {
+            const std::string source = "12.5e3";
+            EXPECT_EQ(12.5, parseDecimal(boost::string_view(source).substr(0, 4)));
+        }
+
+        TEST_F(DecimalParserTest, independent_of_current_locale) {
+            const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+            if (!std::setlocale(LC_NUMERIC, "pl_PL.UTF-8") && !std::setlocale(LC_NUMERIC, "de_DE.UTF-8"))
+                return;
+
+            EXPECT_EQ(2.5, parseDecimal("2.5"));
+            EXPECT_EQ(0.30000000000000004, parseDecimal("0.30000000000000004"));
+            std::setlocale(LC_NUMERIC, previous.c_str());
+        }
+
+        TEST_F(DecimalParserTest, matches_strtod) {
+            std::mt19937_64 random(42);
+            std::uniform_int_distribution<int> length(1, 25);
+            std::uniform_int_distribution<int> digit(0, 9);
+
+            for (int i = 0; i < 100000; ++i) {
+                std::string literal = std::to_string(1 + digit(random));
+                for (int j = length(random); j > 0; --j)
+                    literal += static_cast<char>('0' + digit(random));
+                literal += '.';
+                for (int j = length(random); j > 0; --j)
+                    literal += static_cast<char>('0' + digit(random));
+
+                ASSERT_EQ(std::strtod(literal.c_str(), nullptr), parseDecimal(literal)) << literal;
+            }
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+#include "../../main/util/mmap-input-stream.hpp"
+
+namespace lang {
+    namespace util {
+        struct MmapInputStreamTest : ::testing::Test {
+            std::string path;
+
+            void SetUp() override {
+                char name[] = "/tmp/mmap-input-stream-test-XXXXXX";
+                const int fd = mkstemp(name);
+                ASSERT_GE(fd, 0);
+                close(fd);
+                path = name;
+            }
+
+            void TearDown() override {
+                std::remove(path.c_str());
+            }
+
+            void write(const std::string &content) {
+                std::ofstream(path, std::ios::binary) << content;
+            }
+        };
+
+        TEST_F(MmapInputStreamTest, empty_file) {
+            write("");
+            MmapInputStream stream(path);
+
+            char dummy;
+            EXPECT_EQ(0, stream.size());
+            EXPECT_EQ('\0', stream.data()[0]);
+            EXPECT_FALSE(stream.take(dummy));
+        }
+
+        TEST_F(MmapInputStreamTest, maps_content_followed_by_padding) {
+            write("abcde");
+            MmapInputStream stream(path);
+
+            ASSERT_EQ(5, stream.size());
+            EXPECT_EQ("abcde", std::string(stream.data(), stream.size()));
+            EXPECT_EQ('\0', stream.data()[5]);
+            EXPECT_EQ('\0', stream.data()[6]);
+
+            char content;
+            EXPECT_TRUE(stream.take(content));
+            EXPECT_EQ('a', content);
+
+            char buffer[8];
+            EXPECT_EQ(4, stream.read(buffer, sizeof(buffer)));
+            EXPECT_EQ("bcde", std::string(buffer, 4));
+            EXPECT_FALSE(stream.take(content));
+        }
+
+        TEST_F(MmapInputStreamTest, padding_after_whole_page) {
+            const std::size_t pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+            write(std::string(pageSize, 'x'));
+            MmapInputStream stream(path);
+
+            ASSERT_EQ(pageSize, stream.size());
+            EXPECT_EQ('\0', stream.data()[pageSize]);
+            EXPECT_EQ('\0', stream.data()[pageSize + 1]);
+        }
+
+        TEST_F(MmapInputStreamTest, missing_file) {
+            EXPECT_THROW(MmapInputStream(path + "-missing"), IoException);
+        }
+    }
+}
@@ -1,12 +1,69 @@
 #include <gtest/gtest.h>
+#include <deque>
+#include <iostream>
+#include <stdexcept>
 #include "../../main/util/output-stream-lookup-buffer.hpp"
 #include "../../main/util/string-output-stream.hpp"
+#include "../benchmark.hpp"
 
 namespace lang {
     namespace util {
         struct OutputStreamLookupBufferTest : ::testing::Test {
         };
 
+        namespace {
+            /**
+             * Previous deque based implementation, kept for comparison.
+             */
+            template<typename T>
+            class DequeLookupBuffer {
+                OutputStream <T> &stream;
+                std::deque<T> bufferedItems;
+
+            public:
+                explicit DequeLookupBuffer(OutputStream <T> &stream) : stream(stream) {
+                }
+
+                bool lookup(std::size_t index, T &outItem) {
+                    T item;
+                    for (std::size_t i = bufferedItems.size(); i < index; ++i) {
+                        if (!stream.take(item)) {
+                            return false;
+                        }
+                        bufferedItems.emplace_back(std::move(item));
+                    }
+                    outItem = bufferedItems[index - 1];
+                    return true;
+                }
+
+                bool take(T &outItem) {
+                    if (lookup(1, outItem)) {
+                        bufferedItems.erase(bufferedItems.begin());
+                        return true;
+                    }
+                    return false;
+                }
+            };
+
+            struct GeneratedOutputStream : OutputStream<std::string> {
+                std::size_t remaining;
+                const std::string item;
+
+                explicit GeneratedOutputStream(std::size_t count)
+                        : remaining(count), item("item long enough not to fit into small string") {}
+
+                bool take(std::string &out) override {
+                    if (remaining == 0)
+                        return false;
+                    --remaining;
+                    out = item;
+                    return true;
+                }
+            };
+
+            const std::size_t benchmarkItems = 1000000;
+        }
+
         TEST_F(OutputStreamLookupBufferTest, empty_stream) {
             StringOutputStream internalStream("");
             OutputStreamLookupBuffer<char> stream(internalStream);
@@ -87,5 +144,95 @@ namespace lang {
 
             EXPECT_FALSE(stream.hasNext());
         }
+    
+        TEST_F(OutputStreamLookupBufferTest, peek_returns_reference_to_buffered_item) {
+            StringOutputStream internalStream("abc");
+            OutputStreamLookupBuffer<char> stream(internalStream);
+
+            ASSERT_TRUE(stream.available(2));
+            const char &second = stream.peek(2);
+            EXPECT_EQ('b', second);
+            EXPECT_EQ('a', stream.peek(1));
+
+            char content;
+            EXPECT_TRUE(stream.take(content));
+            EXPECT_EQ('a', content);
+            EXPECT_EQ(&second, &stream.peek(1));
+
+            EXPECT_FALSE(stream.available(3));
+            EXPECT_TRUE(stream.available(2));
+            EXPECT_EQ('c', stream.peek(2));
+        }
+
+        TEST_F(OutputStreamLookupBufferTest, wraps_around_capacity) {
+            StringOutputStream internalStream("abcdefghij");
+            OutputStreamLookupBuffer<char, 2> stream(internalStream);
+
+            std::string result;
+            char content;
+            while (stream.available(2)) {
+                EXPECT_EQ(stream.peek(1) + 1, stream.peek(2));
+                ASSERT_TRUE(stream.take(content));
+                result += content;
+            }
+            ASSERT_TRUE(stream.take(content));
+            result += content;
+
+            EXPECT_EQ("abcdefghij", result);
+            EXPECT_FALSE(stream.hasNext());
+        }
+
+        TEST_F(OutputStreamLookupBufferTest, rejects_lookup_beyond_capacity) {
+            StringOutputStream internalStream("abcdef");
+            OutputStreamLookupBuffer<char, 4> stream(internalStream);
+
+            char content;
+            EXPECT_TRUE(stream.lookup(4, content));
+            EXPECT_EQ('d', content);
+
+            EXPECT_THROW(stream.lookup(5, content), std::out_of_range);
+            EXPECT_THROW(stream.available(0), std::out_of_range);
+
+            std::string result;
+            while (stream.take(content))
+                result += content;
+            EXPECT_EQ("abcdef", result);
+        }
+
+        TEST_F(OutputStreamLookupBufferTest, DISABLED_benchmark_ring_buffer_against_deque) {
+            // Access pattern of the parser: two lookups before each take.
+            std::size_t dequeTaken = 0;
+            const double deque = measureMilliseconds([&] {
+                GeneratedOutputStream internalStream(benchmarkItems);
+                DequeLookupBuffer<std::string> stream(internalStream);
+                std::string item;
+                while (stream.lookup(1, item)) {
+                    stream.lookup(2, item);
+                    stream.take(item);
+                    ++dequeTaken;
+                }
+            });
+
+            std::size_t ringTaken = 0;
+            std::size_t emptyPeeks = 0;
+            const double ring = measureMilliseconds([&] {
+                GeneratedOutputStream internalStream(benchmarkItems);
+                OutputStreamLookupBuffer<std::string> stream(internalStream);
+                std::string item;
+                while (stream.available(1)) {
+                    if (stream.available(2) && stream.peek(2).empty())
+                        ++emptyPeeks;
+                    stream.take(item);
+                    ++ringTaken;
+                }
+            });
+
+            EXPECT_EQ(benchmarkItems, dequeTaken);
+            EXPECT_EQ(benchmarkItems, ringTaken);
+            EXPECT_EQ(0, emptyPeeks);
+
+            std::cout << "[ BENCHMARK] " << benchmarkItems << " items; deque lookup buffer: " << deque
+                      << " ms, ring lookup buffer: " << ring << " ms" << std::endl;
+        }
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include "../../main/util/spsc-queue.hpp"
+
+namespace lang {
+    namespace util {
+        TEST(SpscQueueTest, empty_queue) {
+            SpscQueue<int, 4> queue;
+
+            int dummy;
+            EXPECT_FALSE(queue.tryPop(dummy));
+        }
+
+        TEST(SpscQueueTest, keeps_order_and_capacity) {
+            SpscQueue<int, 4> queue;
+
+            for (int i = 0; i < 4; ++i)
+                ASSERT_TRUE(queue.tryPush(i));
+            int overflow = 4;
+            EXPECT_FALSE(queue.tryPush(overflow));
+
+            for (int i = 0; i < 4; ++i) {
+                int item;
+                ASSERT_TRUE(queue.tryPop(item));
+                EXPECT_EQ(i, item);
+            }
+            int dummy;
+            EXPECT_FALSE(queue.tryPop(dummy));
+        }
+
+        TEST(SpscQueueTest, wraps_around) {
+            SpscQueue<int, 2> queue;
+
+            for (int i = 0; i < 10; ++i) {
+                ASSERT_TRUE(queue.tryPush(i));
+                int item;
+                ASSERT_TRUE(queue.tryPop(item));
+                EXPECT_EQ(i, item);
+            }
+        }
+
+        TEST(SpscQueueTest, transfers_between_threads) {
+            const std::size_t count = 1000000;
+            SpscQueue<std::size_t, 64> queue;
+
+            std::thread producer([&] {
+                for (std::size_t i = 0; i < count; ++i) {
+                    while (!queue.tryPush(i))
+                        std::this_thread::yield();
+                }
+            });
+
+            std::size_t expected = 0;
+            while (expected < count) {
+                std::size_t item;
+                if (!queue.tryPop(item)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                ASSERT_EQ(expected, item);
+                ++expected;
+            }
+            producer.join();
+        }
+    }
+}
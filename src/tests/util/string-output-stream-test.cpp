@@ -29,5 +29,23 @@ namespace lang {
 
             EXPECT_FALSE(stream.take(content));
         }
+
+        TEST_F(StringOutputStreamTest, block_read) {
+            StringOutputStream stream("abcde");
+
+            char buffer[4];
+
+            EXPECT_EQ(1, stream.read(buffer, 1));
+            EXPECT_EQ('a', buffer[0]);
+
+            EXPECT_EQ(3, stream.read(buffer, 3));
+            EXPECT_EQ("bcd", std::string(buffer, 3));
+
+            char content;
+            EXPECT_TRUE(stream.take(content));
+            EXPECT_EQ('e', content);
+
+            EXPECT_EQ(0, stream.read(buffer, 4));
+        }
     }
 }
\ No newline at end of file